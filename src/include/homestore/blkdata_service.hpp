@@ -16,6 +16,7 @@
 #pragma once
 #include <sys/uio.h>
 #include <cstdint>
+#include <vector>
 
 #include <folly/small_vector.h>
 #include <folly/futures/Future.h>
@@ -29,10 +30,15 @@ namespace homestore {
 // callback type for caller to provide
 typedef std::function< void(std::error_condition) > io_completion_cb_t;
 
+// crc32c of each blk written, in the same order as the blks of the MultiBlkId
+typedef uint32_t blk_checksum_t;
+typedef std::vector< blk_checksum_t > blk_checksums_t;
+
 class VirtualDev;
 struct vdev_info;
 struct stream_info_t;
 class BlkReadTracker;
+class BlkReadCache;
 struct blk_alloc_hints;
 class ChunkSelector;
 
@@ -91,6 +97,22 @@ public:
     folly::Future< std::error_code > async_alloc_write(sisl::sg_list const& sgs, blk_alloc_hints const& hints,
                                                        MultiBlkId& out_blkids, bool part_of_batch = false);
 
+    /**
+     * @brief Same as above, but also computes the checksum of each blk written, which the caller is expected to persist
+     * along with the blkids and pass to async_read to verify the data read. If the size of sgs is not a multiple of blk
+     * size, the last blk is written and checksummed padded with zeros.
+     *
+     * @param sgs The scatter-gather list containing the data to write.
+     * @param hints Hints for allocating the block(s) to write to.
+     * @param out_blkids The ID(s) of the block(s) that were allocated and written to.
+     * @param out_checksums Checksum of each blk of out_blkids, in the same order.
+     * @param part_of_batch Whether this operation is part of a batch of operations.
+     * @return A Future that will contain an error code indicating the success or failure of the operation.
+     */
+    folly::Future< std::error_code > async_alloc_write(sisl::sg_list const& sgs, blk_alloc_hints const& hints,
+                                                       MultiBlkId& out_blkids, blk_checksums_t& out_checksums,
+                                                       bool part_of_batch = false);
+
     /**
      * @brief Asynchronously writes the given buffer to the specified block ID.
      *
@@ -114,6 +136,18 @@ public:
     folly::Future< std::error_code > async_write(sisl::sg_list const& sgs, MultiBlkId const& in_blkids,
                                                  bool part_of_batch = false);
 
+    /**
+     * @brief : asynchronous write with input block ids, which also computes the checksum of each blk written;
+     *
+     * @param sgs : the data buffer that needs to be written
+     * @param in_blkids : input block ids that this write should be written to;
+     * @param out_checksums : checksum of each blk of in_blkids, in the same order. If the size of sgs is not a
+     * multiple of blk size, the last blk is written and checksummed padded with zeros;
+     * @param part_of_batch : is this write part of a batch;
+     */
+    folly::Future< std::error_code > async_write(sisl::sg_list const& sgs, MultiBlkId const& in_blkids,
+                                                 blk_checksums_t& out_checksums, bool part_of_batch = false);
+
     /**
      * @brief Asynchronously reads data from the specified block ID into the provided buffer.
      *
@@ -139,6 +173,33 @@ public:
     folly::Future< std::error_code > async_read(MultiBlkId const& bid, sisl::sg_list& sgs, uint32_t size,
                                                 bool part_of_batch = false);
 
+    /**
+     * @brief Same as above, but once the read completes, verifies the data of each blk against the checksum returned
+     * when it was written. All the blks are verified in one pass over the read buffers, without copying them.
+     *
+     * @param bid The block ID to read from, all of its blks are expected to be read.
+     * @param sgs The scatter-gather list to store the read data.
+     * @param size The size of the data to read.
+     * @param checksums Checksum of each blk of bid, as returned by the write.
+     * @param part_of_batch Whether this read is part of a batch.
+     *
+     * @return A `folly::Future` that will contain the error code of the read operation, std::errc::bad_message if the
+     * data of any blk does not match its checksum.
+     */
+    folly::Future< std::error_code > async_read(MultiBlkId const& bid, sisl::sg_list& sgs, uint32_t size,
+                                                blk_checksums_t const& checksums, bool part_of_batch = false);
+
+    /**
+     * @brief Computes the checksum of each blk_size portion of the iovs.
+     *
+     * @param iovs The data, expected to be longer than (nblks - 1) * blk_size. Last blk is padded with zeros, if short.
+     * @param blk_size Size of each blk.
+     * @param nblks Number of blks to compute the checksum for.
+     * @param out_checksums Checksum of each blk.
+     */
+    static void compute_checksums(sisl::sg_iovs_t const& iovs, uint32_t blk_size, uint32_t nblks,
+                                  blk_checksums_t& out_checksums);
+
     /**
      * @brief Commits the block with the given MultiBlkId.
      *
@@ -187,6 +248,13 @@ public:
      */
     BlkReadTracker* read_blk_tracker() { return m_blk_read_tracker.get(); }
 
+    /**
+     * @brief : get the read cache handle;
+     *
+     * @return : the read cache pointer, nullptr if read cache is not enabled;
+     */
+    BlkReadCache* read_cache() { return m_read_cache.get(); }
+
     /**
      * @brief Starts the block data service.
      *
@@ -221,9 +289,31 @@ private:
      */
     static void process_data_completion(std::error_condition ec, void* cookie);
 
+    /**
+     * @brief Reads the blks found in the read cache from it and the rest from the vdev, with consecutive missing blks
+     * read in one vdev read. Blks read from vdev are added to the cache.
+     *
+     * @param blkid The blkids to read, iovs are expected to be as large as the blkids.
+     * @param iovs The iovs to read the data into.
+     * @param part_of_batch Whether the vdev reads are part of batch.
+     * @param checksums If not null, checksum of each blk of blkid, blks read from vdev are cached only if they match.
+     */
+    folly::Future< std::error_code > read_through_cache(MultiBlkId const& blkid, sisl::sg_iovs_t const& iovs,
+                                                        bool part_of_batch, blk_checksums_t const* checksums = nullptr);
+
+    void invalidate_cached(MultiBlkId const& blkid);
+
+    // Appends zeros to sgs upto the end of its last blk into out_sgs, returns the buffer of zeros to be freed after write
+    uint8_t* pad_last_blk(sisl::sg_list const& sgs, uint32_t nblks, sisl::sg_list& out_sgs) const;
+
+    // Invalidates the cached blks of the blkid once the write fut completes, if read cache is enabled
+    folly::Future< std::error_code > invalidate_cached_on_completion(MultiBlkId const& blkid,
+                                                                     folly::Future< std::error_code >&& fut);
+
 private:
     std::shared_ptr< VirtualDev > m_vdev;
     std::unique_ptr< BlkReadTracker > m_blk_read_tracker;
+    std::unique_ptr< BlkReadCache > m_read_cache;
     std::shared_ptr< ChunkSelector > m_custom_chunk_selector;
     uint32_t m_blk_size;
 
@@ -18,6 +18,7 @@
 #include <atomic>
 #include <array>
 
+#include <boost/fiber/fss.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <folly/small_vector.h>
 #include <iomgr/fiber_lib.hpp>
@@ -87,14 +88,18 @@ protected:
 #ifdef _PRERELEASE
     BTREE_FLIPS m_flips;
 #endif
-    // This workaround of BtreeThreadVariables is needed instead of directly declaring statics
-    // to overcome the gcc bug, pointer here: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=66944
+    // Lock tracking of the running fiber is kept in fiber specific storage, which is looked up in the small map of the
+    // running fiber context (instead of a per thread map of all fibers ever run) and is released when the fiber exits.
+    // The fiber_specific_ptr itself is intentionally never destroyed, since fibers could still be running during static
+    // destruction.
     static BtreeThreadVariables* bt_thread_vars() {
-        auto this_id(boost::this_fiber::get_id());
-        static thread_local std::map< boost::fibers::fiber::id, std::unique_ptr< BtreeThreadVariables > > fiber_map;
-        if (fiber_map.count(this_id)) { return fiber_map[this_id].get(); }
-        fiber_map[this_id] = std::make_unique< BtreeThreadVariables >();
-        return fiber_map[this_id].get();
+        static auto* s_fiber_vars = new boost::fibers::fiber_specific_ptr< BtreeThreadVariables >();
+        auto* vars = s_fiber_vars->get();
+        if (sisl_unlikely(vars == nullptr)) {
+            vars = new BtreeThreadVariables();
+            s_fiber_vars->reset(vars);
+        }
+        return vars;
     }
 
 protected:
@@ -116,6 +121,16 @@ public:
 
     btree_status_t query(BtreeQueryRequest< K >& query_req, std::vector< std::pair< K, V > >& out_values) const;
 
+    /// @brief Build the btree bottom up from sorted input, filling each node upto ideal fill size of the config.
+    /// Btree is expected to be empty and is locked exclusively for the duration of the load.
+    btree_status_t bulk_load(bulk_load_cb_t< K, V > const& next_kv, void* context);
+
+    /// @brief Push the messages buffered in interior nodes for the keys within the range, down to the leaves.
+    /// Applicable only to btrees with BUFFERED interior nodes and a no-op otherwise. Get any and queries flush their
+    /// range by themselves before proceeding. Puts other than blind upserts and removes flush the buffers they come
+    /// across on their way down, while single key get and remove resolve the key in the buffer itself.
+    btree_status_t flush_buffers(BtreeKeyRange< K > const& range, void* context);
+
     // bool verify_tree(bool update_debug_bm) const;
     virtual std::pair< btree_status_t, uint64_t > destroy_btree(void* context);
     nlohmann::json get_status(int log_level) const;
@@ -127,6 +142,7 @@ public:
 
     nlohmann::json get_metrics_in_json(bool updated = true);
     bnodeid_t root_node_id() const;
+    uint32_t depth() const; // Number of levels including the leaf level, 0 if root could not be read
 
     uint64_t root_link_version() const;
     void set_root_node_info(const BtreeLinkInfo& info);
@@ -148,6 +164,14 @@ protected:
     virtual BtreeNodePtr alloc_node(bool is_leaf) = 0;
     virtual BtreeNode* init_node(uint8_t* node_buf, bnodeid_t id, bool init_buf, bool is_leaf) const;
     virtual btree_status_t read_node_impl(bnodeid_t id, BtreeNodePtr& node) const = 0;
+    virtual void prefetch_nodes_impl(std::vector< bnodeid_t > const& ids) const {}
+    // Get the node only if it is already resident and not freed, without loading it. Optimistic reads use it, since
+    // the child id they read could be of a node freed concurrently. Stores which can't tell, leave it unsupported.
+    virtual bool get_resident_node_impl(bnodeid_t id, BtreeNodePtr& node) const { return false; }
+    // Bracket the part of an optimistic read which reads nodes without their lock. Stores which replace the physical
+    // buffer of a node, keep the replaced buffer alive until the reads which entered before it have exited.
+    virtual uint64_t enter_optimistic_read() const { return 0; }
+    virtual void exit_optimistic_read(uint64_t epoch) const {}
     virtual btree_status_t write_node_impl(const BtreeNodePtr& node, void* context) = 0;
     virtual btree_status_t refresh_node(const BtreeNodePtr& node, bool for_read_modify_write, void* context) const = 0;
     virtual void free_node_impl(const BtreeNodePtr& node, void* context) = 0;
@@ -155,6 +179,11 @@ protected:
                                           const BtreeNodePtr& left_child_node, const BtreeNodePtr& parent_node,
                                           void* context) = 0;
     virtual btree_status_t on_root_changed(BtreeNodePtr const& root, void* context) = 0;
+    // Flush the buffers on behalf of a read, which doesn't carry an op context of its own. Stores which need a context
+    // to write the nodes are expected to override and supply one.
+    virtual btree_status_t flush_buffers_for_read(BtreeKeyRange< K > const& range) {
+        return flush_buffers(range, nullptr);
+    }
     virtual std::string btree_store_type() const = 0;
 
     /////////////////////////// Methods the application use case is expected to handle ///////////////////////////
@@ -244,6 +273,7 @@ protected:
     ///////// Query Impl Methods
     btree_status_t do_sweep_query(BtreeNodePtr& my_node, BtreeQueryRequest< K >& qreq,
                                   std::vector< std::pair< K, V > >& out_values) const;
+    void slide_read_ahead_window(BtreeNodePtr const& cur_node, BtreeQueryRequest< K >& qreq) const;
     btree_status_t do_traversal_query(const BtreeNodePtr& my_node, BtreeQueryRequest< K >& qreq,
                                       std::vector< std::pair< K, V > >& out_values) const;
 #ifdef SERIALIZABLE_QUERY_IMPLEMENTATION
@@ -254,8 +284,35 @@ protected:
                                       std::vector< std::pair< K, V > >& out_values);
 #endif
 
+    ///////// Bulk Load Impl Methods
+    btree_status_t build_leaf_level(bulk_load_cb_t< K, V > const& next_kv, std::vector< BtreeNodePtr >& leaves,
+                                    uint64_t& nkeys);
+    btree_status_t build_interior_level(std::vector< BtreeNodePtr > const& children,
+                                        std::vector< BtreeNodePtr >& parents);
+    btree_status_t link_loaded_levels(std::vector< std::vector< BtreeNodePtr > > const& levels,
+                                      BtreeNodePtr const& old_root, void* context);
+
+    ///////// Buffered Node Impl Methods
+    bool is_buffered() const { return (m_bt_cfg.interior_node_type() == btree_node_type::BUFFERED); }
+    bool is_buffering_node(const BtreeNodePtr& node) const {
+        return (node->get_node_type() == btree_node_type::BUFFERED) && (node->level() == 1);
+    }
+    template < typename ReqT >
+    bool is_blind_put(ReqT const& req) const;
+    btree_status_t buffer_put(const BtreeNodePtr& my_node, BtreeSinglePutRequest& req);
+    bool buffer_remove(const BtreeNodePtr& my_node, BtreeSingleRemoveRequest& req, btree_status_t& ret);
+    btree_status_t flush_child_msgs(const BtreeNodePtr& my_node, uint32_t child_idx, void* context);
+    template < typename ReqT >
+    btree_status_t flush_path_msgs(const BtreeNodePtr& my_node, uint32_t child_idx, ReqT& req);
+    btree_status_t do_flush_buffers(const BtreeNodePtr& my_node, locktype_t curlock, BtreeKeyRange< K > const& range,
+                                    void* context);
+
     ///////// Get Impl Methods
     template < typename ReqT >
     btree_status_t do_get(const BtreeNodePtr& my_node, ReqT& greq) const;
+    template < typename ReqT >
+    btree_status_t do_get_optimistic(ReqT& greq) const;
+    template < typename ReqT >
+    btree_status_t lock_and_get(const BtreeNodePtr& node, uint64_t version, ReqT& greq) const;
 };
 } // namespace homestore
@@ -32,6 +32,8 @@
 #include <homestore/btree/detail/btree_query_impl.ipp>
 #include <homestore/btree/detail/btree_get_impl.ipp>
 #include <homestore/btree/detail/btree_remove_impl.ipp>
+#include <homestore/btree/detail/btree_bulk_load_impl.ipp>
+#include <homestore/btree/detail/btree_buffer_impl.ipp>
 #include <homestore/btree/detail/btree_node.hpp>
 
 namespace homestore {
@@ -73,14 +75,22 @@ std::pair< btree_status_t, uint64_t > Btree< K, V >::destroy_btree(void* context
 template < typename K, typename V >
 template < typename ReqT >
 btree_status_t Btree< K, V >::put(ReqT& put_req) {
-    static_assert(std::is_same_v< ReqT, BtreeSinglePutRequest > || std::is_same_v< ReqT, BtreeRangePutRequest< K > >,
+    static_assert(std::is_same_v< ReqT, BtreeSinglePutRequest > || std::is_same_v< ReqT, BtreeRangePutRequest< K > > ||
+                      std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >,
                   "put api is called with non put request type");
+    if constexpr (std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) {
+        if (!put_req.is_input_sorted()) {
+            BT_LOG(ERROR, "Batch put input is not strictly sorted by key");
+            return btree_status_t::not_supported;
+        }
+        if (put_req.is_done()) { return btree_status_t::success; }
+    }
     COUNTER_INCREMENT(m_metrics, btree_write_ops_count, 1);
     auto acq_lock = locktype_t::READ;
     bool is_leaf = false;
+    btree_status_t ret = btree_status_t::success;
 
     m_btree_lock.lock_shared();
-    btree_status_t ret = btree_status_t::success;
 
 retry:
 #ifndef NDEBUG
@@ -89,6 +99,8 @@ retry:
     BT_LOG_ASSERT_EQ(bt_thread_vars()->rd_locked_nodes.size(), 0);
     BT_LOG_ASSERT_EQ(bt_thread_vars()->wr_locked_nodes.size(), 0);
 
+    if constexpr (std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) { put_req.reset_leaf_bound(); }
+
     BtreeNodePtr root;
     ret = read_and_lock_node(m_root_node_info.bnode_id(), root, acq_lock, acq_lock, put_req.m_op_context);
     if (ret != btree_status_t::success) { goto out; }
@@ -110,8 +122,8 @@ retry:
         }
 
         goto retry;
-    } else if ((is_leaf) && (acq_lock != locktype_t::WRITE)) {
-        // Root is a leaf, need to take write lock, instead of read, retry
+    } else if ((is_leaf || (is_buffered() && (root->level() == 1))) && (acq_lock != locktype_t::WRITE)) {
+        // Root is a leaf or a node which buffers messages, need to take write lock, instead of read, retry
         unlock_node(root, acq_lock);
         acq_lock = locktype_t::WRITE;
         goto retry;
@@ -147,10 +159,23 @@ btree_status_t Btree< K, V >::get(ReqT& greq) const {
                   "get api is called with non get request type");
 
     btree_status_t ret = btree_status_t::success;
+    if constexpr (std::is_same_v< BtreeGetAnyRequest< K >, ReqT >) {
+        // Buffers are searched only for a specific key on the way down, any key in range needs them flushed
+        if (is_buffered()) {
+            ret = const_cast< Btree* >(this)->flush_buffers_for_read(greq.m_range);
+            if (ret != btree_status_t::success) { return ret; }
+        }
+    }
 
     m_btree_lock.lock_shared();
     BtreeNodePtr root;
 
+    if (m_bt_cfg.m_optimistic_reads && (m_bt_cfg.interior_node_type() == btree_node_type::FIXED)) {
+        ret = do_get_optimistic(greq);
+        if (ret != btree_status_t::retry) { goto out; }
+        COUNTER_INCREMENT(m_metrics, btree_optimistic_read_fallbacks, 1);
+    }
+
     ret = read_and_lock_node(m_root_node_info.bnode_id(), root, locktype_t::READ, locktype_t::READ, greq.m_op_context);
     if (ret != btree_status_t::success) { goto out; }
 
@@ -169,14 +194,24 @@ template < typename ReqT >
 btree_status_t Btree< K, V >::remove(ReqT& req) {
     static_assert(std::is_same_v< ReqT, BtreeSingleRemoveRequest > ||
                       std::is_same_v< ReqT, BtreeRangeRemoveRequest< K > > ||
-                      std::is_same_v< ReqT, BtreeRemoveAnyRequest< K > >,
+                      std::is_same_v< ReqT, BtreeRemoveAnyRequest< K > > ||
+                      std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >,
                   "remove api is called with non remove request type");
+    if constexpr (std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) {
+        if (!req.is_input_sorted()) {
+            BT_LOG(ERROR, "Batch remove input is not strictly sorted");
+            return btree_status_t::not_supported;
+        }
+        if (req.is_done()) { return btree_status_t::success; }
+    }
 
     locktype_t acq_lock = locktype_t::READ;
     m_btree_lock.lock_shared();
 
 retry:
     btree_status_t ret = btree_status_t::success;
+    if constexpr (std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) { req.reset_leaf_bound(); }
+
     BtreeNodePtr root;
     ret = read_and_lock_node(m_root_node_info.bnode_id(), root, acq_lock, acq_lock, req.m_op_context);
     if (ret != btree_status_t::success) { goto out; }
@@ -203,15 +238,29 @@ retry:
         // We must have gotten a new root, need to start from scratch.
         m_btree_lock.lock_shared();
         goto retry;
-    } else if (root->is_leaf() && (acq_lock != locktype_t::WRITE)) {
-        // Root is a leaf, need to take write lock, instead of read, retry
+    } else if ((root->is_leaf() || (is_buffered() && (root->level() == 1))) && (acq_lock != locktype_t::WRITE)) {
+        // Root is a leaf or a node which buffers messages, need to take write lock, instead of read, retry
         unlock_node(root, acq_lock);
         acq_lock = locktype_t::WRITE;
         goto retry;
+    } else if (is_buffered() && (root->level() == 1) && is_split_needed(root, req)) {
+        // Flushing the messages on the way down could need room for the pivots of split leaves
+        unlock_node(root, acq_lock);
+        m_btree_lock.unlock_shared();
+        ret = check_split_root(req);
+        if (ret != btree_status_t::success) {
+            LOGERROR("root split failed btree name {}", m_bt_cfg.name());
+            goto out;
+        }
+
+        m_btree_lock.lock_shared();
+        acq_lock = locktype_t::READ;
+        goto retry;
     } else {
         ret = do_remove(root, acq_lock, req);
-        if (ret == btree_status_t::retry) {
-            // Need to start from top down again, since there was a merge nodes in-between
+        if ((ret == btree_status_t::retry) || (ret == btree_status_t::has_more)) {
+            // Need to start from top down again, since there was a merge nodes in-between or we have more keys to
+            // remove in case of batch remove
             acq_lock = locktype_t::READ;
             goto retry;
         }
@@ -232,6 +281,11 @@ btree_status_t Btree< K, V >::query(BtreeQueryRequest< K >& qreq, std::vector< s
     btree_status_t ret = btree_status_t::success;
     if (qreq.batch_size() == 0) { return ret; }
 
+    if (is_buffered()) {
+        ret = const_cast< Btree* >(this)->flush_buffers_for_read(qreq.working_range());
+        if (ret != btree_status_t::success) { return ret; }
+    }
+
     m_btree_lock.lock_shared();
     BtreeNodePtr root = nullptr;
     ret = read_and_lock_node(m_root_node_info.bnode_id(), root, locktype_t::READ, locktype_t::READ, qreq.m_op_context);
@@ -275,6 +329,66 @@ out:
     return ret;
 }
 
+template < typename K, typename V >
+btree_status_t Btree< K, V >::bulk_load(bulk_load_cb_t< K, V > const& next_kv, void* context) {
+    btree_status_t ret = btree_status_t::success;
+    std::vector< std::vector< BtreeNodePtr > > levels(1);
+    uint64_t nkeys{0};
+    BtreeNodePtr old_root;
+
+    m_btree_lock.lock();
+    ret = read_and_lock_node(m_root_node_info.bnode_id(), old_root, locktype_t::WRITE, locktype_t::WRITE, context);
+    if (ret != btree_status_t::success) { goto out; }
+
+    if (!old_root->is_leaf() || (old_root->total_entries() != 0)) {
+        BT_LOG(ERROR, "Bulk load is supported only on an empty btree");
+        unlock_node(old_root, locktype_t::WRITE);
+        ret = btree_status_t::not_supported;
+        goto out;
+    }
+
+    ret = build_leaf_level(next_kv, levels[0], nkeys);
+    while ((ret == btree_status_t::success) && (levels.back().size() > 1)) {
+        std::vector< BtreeNodePtr > parents;
+        ret = build_interior_level(levels.back(), parents);
+        levels.emplace_back(std::move(parents));
+    }
+
+    if (ret == btree_status_t::success) {
+        if (levels[0].empty()) {
+            // Empty input, nothing to load
+            unlock_node(old_root, locktype_t::WRITE);
+            goto out;
+        }
+        ret = link_loaded_levels(levels, old_root, context);
+    }
+
+    if (ret != btree_status_t::success) {
+        if (m_root_node_info.bnode_id() == old_root->node_id()) {
+            // Failed before the new root is published, release all the nodes built so far and leave btree as is.
+            for (auto const& level : levels) {
+                for (auto const& node : level) {
+                    free_node(node, locktype_t::NONE, context);
+                }
+            }
+            unlock_node(old_root, locktype_t::WRITE);
+        }
+        BT_LOG(ERROR, "Bulk load of btree failed with status={}", enum_name(ret));
+        goto out;
+    }
+
+    COUNTER_INCREMENT(m_metrics, btree_obj_count, nkeys);
+    COUNTER_INCREMENT(m_metrics, btree_depth, levels.size() - 1);
+    BT_LOG(INFO, "Bulk loaded {} keys into {} leaf nodes, depth={}", nkeys, levels[0].size(), levels.size());
+
+out:
+    m_btree_lock.unlock();
+#ifndef NDEBUG
+    check_lock_debug();
+#endif
+    return ret;
+}
+
 #if 0
 /**
  * @brief : verify btree is consistent and no corruption;
@@ -382,6 +496,21 @@ bnodeid_t Btree< K, V >::root_node_id() const {
     return m_root_node_info.bnode_id();
 }
 
+template < typename K, typename V >
+uint32_t Btree< K, V >::depth() const {
+    BtreeNodePtr root;
+    uint32_t ret{0};
+
+    m_btree_lock.lock_shared();
+    if (read_and_lock_node(m_root_node_info.bnode_id(), root, locktype_t::READ, locktype_t::READ, nullptr) ==
+        btree_status_t::success) {
+        ret = root->level() + 1;
+        unlock_node(root, locktype_t::READ);
+    }
+    m_btree_lock.unlock_shared();
+    return ret;
+}
+
 template < typename K, typename V >
 uint64_t Btree< K, V >::root_link_version() const {
     return m_root_node_info.link_version();
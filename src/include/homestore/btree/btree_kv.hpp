@@ -15,7 +15,9 @@
  *********************************************************************************/
 #pragma once
 
+#include <concepts>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <fmt/format.h>
 #include <sisl/fds/buffer.hpp>
@@ -73,6 +75,16 @@ public:
     virtual void deserialize(sisl::blob const& prefix, sisl::blob const& suffix, bool copy) = 0;
 };
 
+// Keys whose serialized form is a single fixed width integer in native byte order (for interval keys, the prefix and
+// suffix integers forming the high and low order parts of it) and whose compare() follows the integer order, can
+// advertise it by defining integral_key_t and integral_key(). Fixed size nodes search such keys without a virtual
+// compare per probe (see btree_node_search.hpp).
+template < typename K >
+concept IntegralBtreeKey = requires(K const& k) {
+    typename K::integral_key_t;
+    { k.integral_key() } -> std::same_as< typename K::integral_key_t >;
+} && std::is_integral_v< typename K::integral_key_t >;
+
 template < typename K >
 class BtreeTraversalState;
 
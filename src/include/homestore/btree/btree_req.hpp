@@ -14,6 +14,10 @@
  *
  *********************************************************************************/
 #pragma once
+#include <deque>
+#include <optional>
+#include <vector>
+
 #include <sisl/fds/buffer.hpp>
 #include <homestore/btree/btree_kv.hpp>
 
@@ -115,6 +119,74 @@ public:
     put_filter_cb_t m_filter_cb;
 };
 
+// Base class for batch operations on a sorted list of keys. Keys which fall on the same leaf node are applied under
+// one descent and one write lock of the leaf. The descent is repeated only when the next key crosses the leaf boundary.
+template < typename K >
+struct BtreeBatchRequest : public BtreeRequest {
+public:
+    uint32_t cur_idx() const { return m_cur_idx; }
+    bool is_done() const { return m_cur_idx >= m_nkeys; }
+    void advance(bool applied) {
+        ++m_cur_idx;
+        if (applied) { ++m_num_applied; }
+    }
+
+    // Upper bound (inclusive) of the keys that the leaf node reached in current descent can hold
+    void reset_leaf_bound() { m_leaf_end_key.reset(); }
+    void set_leaf_bound(K&& end_key) { m_leaf_end_key = std::move(end_key); }
+    bool is_within_leaf_bound(BtreeKey const& key) const {
+        return !m_leaf_end_key.has_value() || (key.compare(*m_leaf_end_key) <= 0);
+    }
+
+    uint32_t num_applied() const { return m_num_applied; }
+    uint32_t num_failed() const { return m_cur_idx - m_num_applied; }
+
+    // Keys out of order would be applied on a wrong leaf, so such requests are rejected upfront
+    bool is_input_sorted() const { return m_input_sorted; }
+
+protected:
+    explicit BtreeBatchRequest(uint32_t nkeys) : m_nkeys{nkeys} {}
+
+    template < typename KeyAt >
+    void validate_sorted(KeyAt&& key_at) {
+        for (uint32_t i{1}; i < m_nkeys; ++i) {
+            if (key_at(i - 1).compare(key_at(i)) >= 0) {
+                m_input_sorted = false;
+                return;
+            }
+        }
+    }
+
+private:
+    uint32_t const m_nkeys;
+    bool m_input_sorted{true};
+    uint32_t m_cur_idx{0};
+    uint32_t m_num_applied{0};
+    std::optional< K > m_leaf_end_key;
+};
+
+template < typename K, typename V >
+struct BtreeBatchPutRequest : public BtreeBatchRequest< K > {
+public:
+    /// @param kvs List of key/values to put, which must be strictly sorted by key (put fails with not_supported
+    /// otherwise). It must remain valid till the request completes.
+    BtreeBatchPutRequest(std::vector< std::pair< K, V > > const& kvs, btree_put_type put_type,
+                         put_filter_cb_t filter_cb = nullptr) :
+            BtreeBatchRequest< K >(uint32_cast(kvs.size())),
+            m_kvs{kvs},
+            m_put_type{put_type},
+            m_filter_cb{std::move(filter_cb)} {
+        this->validate_sorted([this](uint32_t i) -> K const& { return m_kvs[i].first; });
+    }
+
+    const BtreeKey& key() const { return m_kvs[this->cur_idx()].first; }
+    const BtreeValue& value() const { return m_kvs[this->cur_idx()].second; }
+
+    std::vector< std::pair< K, V > > const& m_kvs;
+    const btree_put_type m_put_type;
+    put_filter_cb_t m_filter_cb;
+};
+
 /////////////////////////// 2: Remove Operations /////////////////////////////////////
 struct BtreeSingleRemoveRequest : public BtreeRequest {
 public:
@@ -138,6 +210,21 @@ public:
     BtreeValue* m_outval;
 };
 
+template < typename K >
+struct BtreeBatchRemoveRequest : public BtreeBatchRequest< K > {
+public:
+    /// @param keys List of keys to remove, which must be strictly sorted (remove fails with not_supported otherwise).
+    /// It must remain valid till the request completes.
+    explicit BtreeBatchRemoveRequest(std::vector< K > const& keys) :
+            BtreeBatchRequest< K >(uint32_cast(keys.size())), m_keys{keys} {
+        this->validate_sorted([this](uint32_t i) -> K const& { return m_keys[i]; });
+    }
+
+    const BtreeKey& key() const { return m_keys[this->cur_idx()]; }
+
+    std::vector< K > const& m_keys;
+};
+
 using remove_filter_cb_t = std::function< bool(BtreeKey const&, BtreeValue const&) >;
 
 template < typename K >
@@ -216,9 +303,18 @@ public:
 
     get_filter_cb_t const& filter() const { return m_filter_cb; }
 
+    // Number of leaf nodes to read ahead of the sweep, 0 disables the read ahead
+    uint32_t read_ahead_depth() const { return m_read_ahead_depth; }
+    void set_read_ahead_depth(uint32_t depth) { m_read_ahead_depth = depth; }
+
+    // Leaf nodes ahead of the sweep cursor, whose reads are already issued, in the sibling order
+    std::deque< bnodeid_t >& read_ahead_window() { return m_read_ahead_window; }
+
 protected:
     const BtreeQueryType m_query_type; // Type of the query
     get_filter_cb_t m_filter_cb;
+    uint32_t m_read_ahead_depth{0};
+    std::deque< bnodeid_t > m_read_ahead_window;
 };
 
 /* This class is a top level class to keep track of the locks that are held currently. It is
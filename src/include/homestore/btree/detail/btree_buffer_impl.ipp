@@ -0,0 +1,348 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+#include <homestore/btree/btree.hpp>
+
+namespace homestore {
+
+/* Blind put is the one which doesn't need to look at the existing value of the key to complete. Only those can be
+ * buffered in the interior nodes and be acknowledged without reaching the leaf.
+ */
+template < typename K, typename V >
+template < typename ReqT >
+bool Btree< K, V >::is_blind_put(ReqT const& req) const {
+    if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest >) {
+        return is_buffered() && (req.m_put_type == btree_put_type::UPSERT) && (req.m_existing_val == nullptr) &&
+            !req.m_filter_cb;
+    } else {
+        return false;
+    }
+}
+
+/* Buffer the put as a message in the level 1 node. If the buffer is full, messages of the child which has most
+ * pending are flushed to make room. Returns space_not_avail if room couldn't be made, in which case the caller is
+ * expected to proceed to the leaf as usual.
+ *
+ * NOTE: It expects the node to be write locked and it doesn't unlock it.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::buffer_put(const BtreeNodePtr& my_node, BtreeSinglePutRequest& req) {
+    auto bnode = to_buffered_node(my_node);
+    btree_status_t ret{btree_status_t::success};
+    auto const nmsgs_before = bnode->num_msgs();
+
+    bool const overwrite = bnode->find_msg(req.key()).first;
+    if (!overwrite && !bnode->has_room_for_msg()) {
+        uint32_t const nchildren = my_node->total_entries() + (my_node->has_valid_edge() ? 1 : 0);
+        uint32_t child_idx{0};
+        uint32_t nmsgs{0};
+        for (uint32_t i{0}; i < nchildren; ++i) {
+            auto const n = bnode->msgs_of_child(i).second;
+            if (n > nmsgs) {
+                child_idx = i;
+                nmsgs = n;
+            }
+        }
+        ret = flush_child_msgs(my_node, child_idx, req.m_op_context);
+        if (ret == btree_status_t::space_not_avail) { ret = btree_status_t::success; }
+    }
+
+    bool const buffered = (ret == btree_status_t::success) && (overwrite || bnode->has_room_for_msg());
+    if (buffered) {
+        bnode->upsert_msg(req.key(), req.value());
+        COUNTER_INCREMENT(m_metrics, btree_buffered_puts, 1);
+        if (req.route_tracing) { append_route_trace(req, my_node, btree_event_t::MUTATE); }
+    }
+
+    if (buffered || (bnode->num_msgs() != nmsgs_before)) {
+        auto const wret = write_node(my_node, req.m_op_context);
+        if (ret == btree_status_t::success) { ret = wret; }
+    }
+    if ((ret == btree_status_t::success) && !buffered) { ret = btree_status_t::space_not_avail; }
+    return ret;
+}
+
+/* Remove of a key which has a message pending is completed in the buffer itself, by turning the message into a
+ * tombstone, which removes the key from the leaf whenever it is flushed. Returns false if there is no message for the
+ * key, in which case the caller is expected to proceed to the leaf as usual.
+ *
+ * NOTE: It expects the node to be write locked and it doesn't unlock it.
+ */
+template < typename K, typename V >
+bool Btree< K, V >::buffer_remove(const BtreeNodePtr& my_node, BtreeSingleRemoveRequest& req, btree_status_t& ret) {
+    auto bnode = to_buffered_node(my_node);
+    auto const [found, idx] = bnode->find_msg(req.key());
+    if (!found) { return false; }
+
+    if (bnode->is_nth_msg_tombstone(idx)) {
+        ret = btree_status_t::not_found;
+        return true;
+    }
+
+    if (req.m_outval) { bnode->get_nth_msg_value(idx, req.m_outval); }
+    bnode->tombstone_msg(req.key());
+    ret = write_node(my_node, req.m_op_context);
+    COUNTER_INCREMENT(m_metrics, btree_buffered_removes, 1);
+    if (req.route_tracing) { append_route_trace(req, my_node, btree_event_t::REMOVE); }
+    return true;
+}
+
+/* Apply all the messages of the child at given index to the leaf. Leaf is split if needed, as long as there is room
+ * for the new pivot in this node. Applied messages are removed from the buffer, but it is the caller responsibility to
+ * write this node. Returns space_not_avail if this node ran out of room for pivots before all of them are applied.
+ *
+ * NOTE: It expects the node to be write locked and it doesn't unlock it.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::flush_child_msgs(const BtreeNodePtr& my_node, uint32_t child_idx, void* context) {
+    auto bnode = to_buffered_node(my_node);
+    auto const [start, nmsgs] = bnode->msgs_of_child(child_idx);
+    if (nmsgs == 0) { return btree_status_t::success; }
+
+    btree_status_t ret{btree_status_t::success};
+    uint32_t napplied{0};
+    uint32_t ninserted{0};
+    uint32_t nremoved{0};
+    while (napplied < nmsgs) {
+        BtreeLinkInfo child_info;
+        BtreeNodePtr child_node;
+        ret = get_child_and_lock_node(my_node, child_idx, child_info, child_node, locktype_t::WRITE, locktype_t::WRITE,
+                                      context);
+        if (ret != btree_status_t::success) { break; }
+        BT_NODE_DBG_ASSERT(child_node->is_leaf(), child_node, "Buffered node is expected to be parent of leaves");
+
+        bool modified{false};
+        bool beyond_child{false};
+        while (napplied < nmsgs) {
+            K const key = bnode->get_nth_msg_key(start + napplied);
+            if ((child_idx < my_node->total_entries()) &&
+                (key.compare(my_node->get_nth_key< K >(child_idx, false)) > 0)) {
+                // Leaf was split in earlier round, rest of the messages belong to its right sibling
+                beyond_child = true;
+                break;
+            }
+
+            if (bnode->is_nth_msg_tombstone(start + napplied)) {
+                if (child_node->remove_one(key, nullptr, nullptr)) {
+                    modified = true;
+                    ++nremoved;
+                }
+            } else {
+                V const val = bnode->get_nth_msg_value(start + napplied);
+                if (!child_node->has_room_for_put(btree_put_type::UPSERT, key.serialized_size(),
+                                                  val.serialized_size())) {
+                    break;
+                }
+                if (!child_node->find(key, nullptr, false).first) { ++ninserted; }
+                to_variant_node(child_node)->put(key, val, btree_put_type::UPSERT, nullptr, nullptr);
+                modified = true;
+            }
+            ++napplied;
+        }
+
+        if ((napplied == nmsgs) || beyond_child ||
+            !my_node->has_room_for_put(btree_put_type::UPSERT, K::get_max_size(), BtreeLinkInfo::get_fixed_size())) {
+            if (modified) { ret = write_node(child_node, context); }
+            unlock_node(child_node, locktype_t::WRITE);
+            if ((ret != btree_status_t::success) || !beyond_child) { break; }
+            ++child_idx;
+            continue;
+        }
+
+        // Leaf is full, split it and continue with whichever half the next message belongs to
+        K split_key;
+        ret = split_node(my_node, child_node, child_idx, &split_key, context);
+        unlock_node(child_node, locktype_t::WRITE);
+        if (ret != btree_status_t::success) { break; }
+        COUNTER_INCREMENT(m_metrics, btree_split_count, 1);
+    }
+
+    if (napplied != 0) {
+        bnode->remove_msgs(start, napplied);
+        COUNTER_INCREMENT(m_metrics, btree_obj_count, ninserted);
+        COUNTER_DECREMENT(m_metrics, btree_obj_count, nremoved);
+        COUNTER_INCREMENT(m_metrics, btree_buffer_child_flushes, 1);
+    }
+    return ((ret == btree_status_t::success) && (napplied != nmsgs)) ? btree_status_t::space_not_avail : ret;
+}
+
+/* Ops other than blind puts need the messages pending for the leaf they descend to, applied before they reach it.
+ * Single key ops need it only if the key itself has a message pending. Returns retry if the leaf was split, so that
+ * caller would search this node again, and space_not_avail if this node ran out of room for the pivots, in which case
+ * the op needs to restart from the root, so that this node is split on the way down.
+ *
+ * NOTE: It expects the node to be write locked and it doesn't unlock it.
+ */
+template < typename K, typename V >
+template < typename ReqT >
+btree_status_t Btree< K, V >::flush_path_msgs(const BtreeNodePtr& my_node, uint32_t child_idx, ReqT& req) {
+    auto bnode = to_buffered_node(my_node);
+    if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest > || std::is_same_v< ReqT, BtreeSingleRemoveRequest >) {
+        if (!bnode->find_msg(req.key()).first) { return btree_status_t::success; }
+    } else {
+        if (bnode->msgs_of_child(child_idx).second == 0) { return btree_status_t::success; }
+    }
+
+    auto const nentries = my_node->total_entries();
+    auto ret = flush_child_msgs(my_node, child_idx, req.m_op_context);
+    if ((ret == btree_status_t::success) || (ret == btree_status_t::space_not_avail)) {
+        auto const wret = write_node(my_node, req.m_op_context);
+        if (wret != btree_status_t::success) { ret = wret; }
+    }
+    if ((ret == btree_status_t::success) && (my_node->total_entries() != nentries)) { ret = btree_status_t::retry; }
+    return ret;
+}
+
+template < typename K, typename V >
+btree_status_t Btree< K, V >::flush_buffers(BtreeKeyRange< K > const& range, void* context) {
+    if (!is_buffered()) { return btree_status_t::success; }
+
+    btree_status_t ret{btree_status_t::success};
+    locktype_t acq_lock = locktype_t::READ;
+    BtreeRequest req{nullptr, context};
+    m_btree_lock.lock_shared();
+
+retry:
+    BtreeNodePtr root;
+    ret = read_and_lock_node(m_root_node_info.bnode_id(), root, acq_lock, acq_lock, context);
+    if (ret != btree_status_t::success) { goto out; }
+
+    if (root->is_leaf() || ((root->level() == 1) && (to_buffered_node(root)->msgs_in_range(range).second == 0))) {
+        unlock_node(root, acq_lock);
+        goto out;
+    }
+
+    if ((root->level() == 1) && (acq_lock != locktype_t::WRITE)) {
+        unlock_node(root, acq_lock);
+        acq_lock = locktype_t::WRITE;
+        goto retry;
+    }
+
+    if ((root->level() == 1) && is_split_needed(root, req)) {
+        unlock_node(root, acq_lock);
+        m_btree_lock.unlock_shared();
+        ret = check_split_root(req);
+        m_btree_lock.lock_shared();
+        if (ret != btree_status_t::success) { goto out; }
+        acq_lock = locktype_t::READ;
+        goto retry;
+    }
+
+    ret = do_flush_buffers(root, acq_lock, range, context);
+    if (ret == btree_status_t::retry) {
+        acq_lock = locktype_t::READ;
+        goto retry;
+    }
+
+out:
+    m_btree_lock.unlock_shared();
+#ifndef NDEBUG
+    check_lock_debug();
+#endif
+    return ret;
+}
+
+/* Walk down the nodes covering the range and apply the messages within the range, buffered in the level 1 nodes
+ * underneath. Level 1 nodes are write locked only if they have any such message. Returns retry if the op needs to
+ * start from root again.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::do_flush_buffers(const BtreeNodePtr& my_node, locktype_t curlock,
+                                               BtreeKeyRange< K > const& range, void* context) {
+    btree_status_t ret{btree_status_t::success};
+    if (my_node->level() == 1) {
+        BT_NODE_DBG_ASSERT_EQ(curlock, locktype_t::WRITE, my_node);
+        auto bnode = to_buffered_node(my_node);
+        auto const nmsgs_before = bnode->num_msgs();
+        while (true) {
+            auto const [start, count] = bnode->msgs_in_range(range);
+            if (count == 0) { break; }
+            auto const child_idx = my_node->find(bnode->get_nth_msg_key(start), nullptr, false).second;
+            ret = flush_child_msgs(my_node, child_idx, context);
+            if (ret != btree_status_t::success) { break; }
+        }
+
+        if (bnode->num_msgs() != nmsgs_before) {
+            auto const wret = write_node(my_node, context);
+            if (wret != btree_status_t::success) { ret = wret; }
+        }
+        unlock_node(my_node, curlock);
+        // Ran out of room for pivots, restart so that this node is split on the way down
+        return (ret == btree_status_t::space_not_avail) ? btree_status_t::retry : ret;
+    }
+
+    auto unlock_lambda = [this](const BtreeNodePtr& node, locktype_t& cur_lock) {
+        unlock_node(node, cur_lock);
+        cur_lock = locktype_t::NONE;
+    };
+
+retry:
+    uint32_t start_idx{0};
+    uint32_t end_idx{0};
+    uint32_t curr_idx;
+    if (!my_node->match_range(range, start_idx, end_idx)) { goto out; }
+
+    curr_idx = start_idx;
+    while (curr_idx <= end_idx) {
+        locktype_t child_cur_lock = locktype_t::READ;
+        BtreeLinkInfo child_info;
+        BtreeNodePtr child_node;
+        ret = get_child_and_lock_node(my_node, curr_idx, child_info, child_node, child_cur_lock, child_cur_lock,
+                                      context);
+        if (ret != btree_status_t::success) {
+            if (ret == btree_status_t::not_found) { ret = btree_status_t::retry; }
+            goto out;
+        }
+
+        if (child_node->level() == 1) {
+            if (to_buffered_node(child_node)->msgs_in_range(range).second == 0) {
+                unlock_lambda(child_node, child_cur_lock);
+                ++curr_idx;
+                continue;
+            }
+
+            // Parent is still locked, so the child can be locked again in write mode without looking up again
+            unlock_node(child_node, child_cur_lock);
+            child_cur_lock = locktype_t::WRITE;
+            ret = lock_node(child_node, child_cur_lock, context);
+            if (ret != btree_status_t::success) { goto out; }
+
+            if (!child_node->has_room_for_put(btree_put_type::UPSERT, K::get_max_size(),
+                                              BtreeLinkInfo::get_fixed_size())) {
+                ret = upgrade_node_locks(my_node, child_node, curlock, child_cur_lock, context);
+                if (ret != btree_status_t::success) { goto out; }
+
+                K split_key;
+                ret = split_node(my_node, child_node, curr_idx, &split_key, context);
+                unlock_lambda(child_node, child_cur_lock);
+                if (ret != btree_status_t::success) { goto out; }
+                COUNTER_INCREMENT(m_metrics, btree_split_count, 1);
+                goto retry;
+            }
+        }
+
+        if (curr_idx == end_idx) { unlock_lambda(my_node, curlock); }
+
+        ret = do_flush_buffers(child_node, child_cur_lock, range, context);
+        if (ret != btree_status_t::success) { goto out; }
+        ++curr_idx;
+    }
+
+out:
+    if (curlock != locktype_t::NONE) { unlock_lambda(my_node, curlock); }
+    return ret;
+}
+} // namespace homestore
@@ -0,0 +1,142 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+#include <homestore/btree/btree.hpp>
+
+namespace homestore {
+/* Fill the leaf nodes from the sorted input. Each leaf is filled upto the ideal fill size and then a new leaf is
+ * allocated and chained as the next node of the previous leaf.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::build_leaf_level(bulk_load_cb_t< K, V > const& next_kv,
+                                               std::vector< BtreeNodePtr >& leaves, uint64_t& nkeys) {
+    K key;
+    V val;
+    K last_key;
+    BtreeNodePtr cur_leaf;
+
+    while (next_kv(key, val)) {
+        if ((nkeys != 0) && (key.compare(last_key) <= 0)) {
+            BT_LOG(ERROR, "Bulk load input is not sorted, key={} after key={}", key.to_string(), last_key.to_string());
+            return btree_status_t::not_supported;
+        }
+
+        if (!cur_leaf || (cur_leaf->occupied_size() >= m_bt_cfg.ideal_fill_size()) ||
+            !cur_leaf->has_room_for_put(btree_put_type::INSERT, key.serialized_size(), val.serialized_size())) {
+            auto new_leaf = alloc_leaf_node();
+            if (new_leaf == nullptr) { return btree_status_t::space_not_avail; }
+
+            new_leaf->set_level(0u);
+            if (cur_leaf) { cur_leaf->set_next_bnode(new_leaf->node_id()); }
+            leaves.push_back(new_leaf);
+            cur_leaf = std::move(new_leaf);
+        }
+
+        auto const ret = cur_leaf->insert(cur_leaf->total_entries(), key, val);
+        BT_NODE_REL_ASSERT_EQ(ret, btree_status_t::success, cur_leaf);
+        last_key = key;
+        ++nkeys;
+    }
+    return btree_status_t::success;
+}
+
+/* Build the parent level for the given children. Each child is added with its last key, except the rightmost child
+ * of the level, which is set as the edge of the rightmost parent. This is the same shape regular splits leave behind.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::build_interior_level(std::vector< BtreeNodePtr > const& children,
+                                                   std::vector< BtreeNodePtr >& parents) {
+    BtreeNodePtr cur_parent;
+    uint16_t const level = children[0]->level() + 1;
+
+    for (size_t i{0}; i < children.size(); ++i) {
+        auto const& child = children[i];
+        bool const is_last = (i == children.size() - 1);
+        BtreeLinkInfo const child_info{child->node_id(), child->link_version()};
+
+        // Edge doesn't occupy any entry, so there is no need to look for room for the last child
+        if (!cur_parent ||
+            (!is_last &&
+             ((cur_parent->occupied_size() >= m_bt_cfg.ideal_fill_size()) ||
+              !cur_parent->has_room_for_put(btree_put_type::INSERT, K::get_max_size(),
+                                            BtreeLinkInfo::get_fixed_size())))) {
+            auto new_parent = alloc_interior_node();
+            if (new_parent == nullptr) { return btree_status_t::space_not_avail; }
+
+            new_parent->set_level(level);
+            if (cur_parent) { cur_parent->set_next_bnode(new_parent->node_id()); }
+            parents.push_back(new_parent);
+            cur_parent = std::move(new_parent);
+        }
+
+        if (is_last) {
+            cur_parent->set_edge_value(child_info);
+        } else {
+            auto const ret = cur_parent->insert(cur_parent->total_entries(), child->get_last_key< K >(), child_info);
+            BT_NODE_REL_ASSERT_EQ(ret, btree_status_t::success, cur_parent);
+        }
+    }
+    return btree_status_t::success;
+}
+
+/* Make the top of the loaded levels as the new root and then transact all the loaded nodes with their parents level
+ * by level top down, so that the store can persist them along with the parent. Parents are linked before their
+ * children, since a store like the index wb cache links a node created in this cp to the up buffer of its parent,
+ * which the parent has only once it is transacted itself. Nodes are transacted in batches of children of the same
+ * parent, since a transaction can carry only limited number of new nodes. Old (empty) root is freed along with the root
+ * switch. A failure to switch the root leaves the btree as is; transacting the nodes does not fail past that point.
+ */
+template < typename K, typename V >
+btree_status_t Btree< K, V >::link_loaded_levels(std::vector< std::vector< BtreeNodePtr > > const& levels,
+                                                 BtreeNodePtr const& old_root, void* context) {
+    static constexpr size_t max_nodes_per_txn{200};
+
+    auto const& root = levels.back()[0];
+    btree_status_t ret = write_node(root, context);
+    if (ret != btree_status_t::success) { return ret; }
+
+    ret = on_root_changed(root, context);
+    if (ret != btree_status_t::success) { return ret; }
+    m_root_node_info = BtreeLinkInfo{root->node_id(), root->link_version()};
+
+    ret = transact_nodes({}, {old_root}, root, root, context);
+    if (ret != btree_status_t::success) { return ret; }
+
+    for (size_t lvl{levels.size() - 1}; lvl > 0; --lvl) {
+        auto const& nodes = levels[lvl - 1];
+        size_t child_idx{0};
+
+        // Children are laid out in the parents in the same order they were built, last child of a parent is its edge
+        for (auto const& parent : levels[lvl]) {
+            auto const nchildren = parent->total_entries() + (parent->has_valid_edge() ? 1u : 0u);
+            auto const parent_end = child_idx + nchildren;
+            BT_NODE_REL_ASSERT_LE(parent_end, nodes.size(), parent);
+
+            for (auto start = child_idx; start < parent_end; start += max_nodes_per_txn) {
+                auto const end = std::min(start + max_nodes_per_txn, parent_end);
+                BtreeNodeList new_nodes;
+                for (auto i = start + 1; i < end; ++i) {
+                    new_nodes.push_back(nodes[i]);
+                }
+                ret = transact_nodes(new_nodes, {}, nodes[start], parent, context);
+                if (ret != btree_status_t::success) { return ret; }
+            }
+            child_idx = parent_end;
+        }
+    }
+    return btree_status_t::success;
+}
+} // namespace homestore
@@ -19,6 +19,7 @@
 namespace homestore {
 
 #define to_variant_node(n) boost::static_pointer_cast< VariantNode< K, V > >(n)
+#define to_buffered_node(n) static_cast< BufferedNode< K, V >* >((n).get())
 
 template < typename K, typename V >
 btree_status_t Btree< K, V >::post_order_traversal(locktype_t ltype, const auto& cb) {
@@ -40,6 +40,23 @@ btree_status_t Btree< K, V >::do_get(const BtreeNodePtr& my_node, ReqT& greq) co
         return ret;
     }
 
+    if constexpr (std::is_same_v< BtreeSingleGetRequest, ReqT >) {
+        // Pending message for the key in buffered node is more recent than whatever is there in the leaf
+        if (is_buffering_node(my_node)) {
+            auto const [mfound, midx] = to_buffered_node(my_node)->find_msg(greq.key());
+            if (mfound) {
+                if (to_buffered_node(my_node)->is_nth_msg_tombstone(midx)) {
+                    ret = btree_status_t::not_found;
+                } else if (greq.m_outval) {
+                    to_buffered_node(my_node)->get_nth_msg_value(midx, greq.m_outval);
+                }
+                if (greq.route_tracing) { append_route_trace(greq, my_node, btree_event_t::READ); }
+                unlock_node(my_node, locktype_t::READ);
+                return ret;
+            }
+        }
+    }
+
     BtreeLinkInfo child_info;
     if constexpr (std::is_same_v< BtreeGetAnyRequest< K >, ReqT >) {
         std::tie(found, idx) = my_node->find(greq.m_range.start_key(), &child_info, true);
@@ -61,4 +78,69 @@ out:
     unlock_node(my_node, locktype_t::READ);
     return ret;
 }
+
+// Descend the upper interior nodes without taking their locks. Version of each node is noted before searching it and
+// validated once the child is picked, upon which the child id is known to be current. Child is looked up only among
+// the resident nodes, so that we never load a node whose id was read from a node being concurrently modified. Once we
+// reach the parent of leaf (or the child is not resident), we lock that node and continue with the regular lock
+// coupling. Unlocked part of the descent is bracketed by enter/exit_optimistic_read, so that the store does not free a
+// node buffer it replaces meanwhile. It is exited before locking, since lock could yield. Returns retry if the descent
+// could not be validated in few attempts, so that caller falls back to lock coupling from the root.
+template < typename K, typename V >
+template < typename ReqT >
+btree_status_t Btree< K, V >::do_get_optimistic(ReqT& greq) const {
+    static constexpr uint32_t max_attempts{4};
+
+    for (uint32_t attempt{0}; attempt < max_attempts; ++attempt) {
+        BtreeNodePtr node;
+        if (!get_resident_node_impl(m_root_node_info.bnode_id(), node)) { return btree_status_t::retry; }
+        auto version = node->optimistic_version();
+        auto const epoch = enter_optimistic_read();
+
+        while (true) {
+            if (node->is_leaf() || (node->level() <= 1)) { break; }
+
+            BtreeLinkInfo child_info;
+            BtreeNode::in_optimistic_read() = true;
+            if constexpr (std::is_same_v< BtreeGetAnyRequest< K >, ReqT >) {
+                node->find(greq.m_range.start_key(), &child_info, true);
+            } else if constexpr (std::is_same_v< BtreeSingleGetRequest, ReqT >) {
+                node->find(greq.key(), &child_info, true);
+            }
+            BtreeNode::in_optimistic_read() = false;
+            if (!node->validate_optimistic_version(version)) { break; }
+
+            BtreeNodePtr child_node;
+            if (!get_resident_node_impl(child_info.bnode_id(), child_node)) { break; }
+            auto const child_version = child_node->optimistic_version();
+
+            // Child could have been freed after we validated, in which case we might have picked it up before its
+            // removal. Validating parent again ensures the child was linked when we noted its version.
+            if (!node->validate_optimistic_version(version)) { break; }
+            node = std::move(child_node);
+            version = child_version;
+        }
+        exit_optimistic_read(epoch);
+
+        auto const ret = lock_and_get(node, version, greq);
+        if (ret != btree_status_t::retry) { return ret; }
+        COUNTER_INCREMENT(m_metrics, btree_optimistic_read_restarts, 1);
+    }
+    return btree_status_t::retry;
+}
+
+// Lock the node, which was optimistically reached and continue the get from it with lock coupling. Returns retry if the
+// node is modified since its version was noted.
+template < typename K, typename V >
+template < typename ReqT >
+btree_status_t Btree< K, V >::lock_and_get(const BtreeNodePtr& node, uint64_t version, ReqT& greq) const {
+    auto ret = lock_node(node, locktype_t::READ, greq.m_op_context);
+    if (ret != btree_status_t::success) { return ret; }
+
+    if (!node->validate_optimistic_version(version)) {
+        unlock_node(node, locktype_t::READ);
+        return btree_status_t::retry;
+    }
+    return do_get(node, greq);
+}
 } // namespace homestore
@@ -195,7 +195,8 @@ using bnodeid_t = uint64_t;
 static constexpr bnodeid_t empty_bnodeid = std::numeric_limits< bnodeid_t >::max();
 static constexpr uint16_t bt_init_crc_16 = 0x8005;
 
-VENUM(btree_node_type, uint32_t, FIXED = 0, VAR_VALUE = 1, VAR_KEY = 2, VAR_OBJECT = 3, PREFIX = 4, COMPACT = 5)
+VENUM(btree_node_type, uint32_t, FIXED = 0, VAR_VALUE = 1, VAR_KEY = 2, VAR_OBJECT = 3, PREFIX = 4, COMPACT = 5,
+      BUFFERED = 6)
 
 #ifdef USE_STORE_TYPE
 VENUM(btree_store_type, uint8_t, MEM = 0, SSD = 1)
@@ -218,6 +219,10 @@ void intrusive_ptr_release(BtreeNode* node);
 template < typename K, typename V >
 using to_string_cb_t = std::function< std::string(std::vector< std::pair< K, V > > const&) >;
 
+// Provides next key/value of sorted input to bulk load, returns false once the input is exhausted
+template < typename K, typename V >
+using bulk_load_cb_t = std::function< bool(K&, V&) >;
+
 ENUM(btree_event_t, uint8_t, READ, MUTATE, REMOVE, SPLIT, REPAIR, MERGE);
 
 struct trace_route_entry {
@@ -252,6 +257,10 @@ struct BtreeConfig {
     bool m_rebalance_turned_on{false};
     bool m_merge_turned_on{true};
 
+    // Descend interior nodes of get without locking them, validating their versions instead. Effective only for
+    // fixed size interior nodes and on stores which can look up a resident node without loading it.
+    bool m_optimistic_reads{false};
+
     btree_node_type m_leaf_node_type{btree_node_type::VAR_OBJECT};
     btree_node_type m_int_node_type{btree_node_type::VAR_KEY};
     std::string m_btree_name; // Unique name for the btree
@@ -318,6 +327,11 @@ public:
         REGISTER_HISTOGRAM(btree_leaf_node_occupancy, "Leaf node occupancy", "btree_node_occupancy",
                            {"node_type", "leaf"}, HistogramBucketsType(LinearUpto128Buckets));
         REGISTER_COUNTER(btree_retry_count, "number of retries");
+        REGISTER_COUNTER(btree_optimistic_read_restarts, "number of optimistic reads restarted on version change");
+        REGISTER_COUNTER(btree_optimistic_read_fallbacks, "number of optimistic reads fell back to lock coupling");
+        REGISTER_COUNTER(btree_buffered_puts, "number of puts buffered in interior nodes");
+        REGISTER_COUNTER(btree_buffered_removes, "number of removes buffered in interior nodes as tombstones");
+        REGISTER_COUNTER(btree_buffer_child_flushes, "number of times buffered messages are flushed to a child");
         REGISTER_COUNTER(write_err_cnt, "number of errors in write");
         REGISTER_COUNTER(query_err_cnt, "number of errors in query");
         REGISTER_COUNTER(read_node_count_in_write_ops, "number of nodes read in write_op");
@@ -42,6 +42,18 @@ btree_status_t Btree< K, V >::do_put(const BtreeNodePtr& my_node, locktype_t cur
         return ret;
     }
 
+    if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest >) {
+        if (is_blind_put(req) && (my_node->level() == 1) && (curlock == locktype_t::WRITE)) {
+            ret = buffer_put(my_node, req);
+            if (ret != btree_status_t::space_not_avail) {
+                unlock_node(my_node, curlock);
+                return ret;
+            }
+            // Couldn't make room in buffer, proceed to put in the leaf directly
+            ret = btree_status_t::success;
+        }
+    }
+
     auto unlock_lambda = [this](const BtreeNodePtr& node, locktype_t& cur_lock) {
         unlock_node(node, cur_lock);
         cur_lock = locktype_t::NONE;
@@ -59,7 +71,8 @@ retry:
             ret = btree_status_t::not_found;
             goto out;
         }
-    } else if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest >) {
+    } else if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest > ||
+                         std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) {
         auto const [found, idx] = my_node->find(req.key(), nullptr, true);
         ASSERT_IS_VALID_INTERIOR_CHILD_INDX(found, idx, my_node);
         end_idx = start_idx = idx;
@@ -74,10 +87,22 @@ retry:
     while (curr_idx <= end_idx) { // iterate all matched childrens
         locktype_t child_cur_lock = locktype_t::NONE;
 
+        if (is_buffered() && (my_node->level() == 1)) {
+            ret = flush_path_msgs(my_node, curr_idx, req);
+            if (ret == btree_status_t::retry) { goto retry; }
+            if (ret != btree_status_t::success) {
+                // Ran out of room for pivots, restart from root so that this node is split on the way down
+                if (ret == btree_status_t::space_not_avail) { ret = btree_status_t::retry; }
+                goto out;
+            }
+        }
+
         // Get the childPtr for given key.
         BtreeLinkInfo child_info;
         BtreeNodePtr child_node;
-        ret = get_child_and_lock_node(my_node, curr_idx, child_info, child_node, locktype_t::READ, locktype_t::WRITE,
+        // Puts buffer or flush the messages in level 1 nodes, so they need to be write locked
+        auto const int_lock = (is_buffered() && (my_node->level() == 2)) ? locktype_t::WRITE : locktype_t::READ;
+        ret = get_child_and_lock_node(my_node, curr_idx, child_info, child_node, int_lock, locktype_t::WRITE,
                                       req.m_op_context);
         if (ret != btree_status_t::success) {
             if (ret == btree_status_t::not_found) {
@@ -91,7 +116,7 @@ retry:
         }
 
         // Directly get write lock for leaf, since its an insert.
-        child_cur_lock = (child_node->is_leaf()) ? locktype_t::WRITE : locktype_t::READ;
+        child_cur_lock = (child_node->is_leaf()) ? locktype_t::WRITE : int_lock;
         if (is_split_needed(child_node, req)) {
             ret = upgrade_node_locks(my_node, child_node, curlock, child_cur_lock, req.m_op_context);
             if (ret != btree_status_t::success) {
@@ -125,6 +150,10 @@ retry:
                 BT_NODE_LOG(DEBUG, my_node, "Subrange:idx=[{}-{}],c={},working={}", start_idx, end_idx, curr_idx,
                             req.working_range().to_string());
             }
+        } else if constexpr (std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) {
+            // Child key in this node bounds the keys the leaf underneath can hold. Edge child inherits the bound
+            // from the upper levels.
+            if (curr_idx < my_node->total_entries()) { req.set_leaf_bound(my_node->get_nth_key< K >(curr_idx, true)); }
         }
 
 #ifndef NDEBUG
@@ -185,6 +214,26 @@ btree_status_t Btree< K, V >::mutate_write_leaf_node(const BtreeNodePtr& my_node
         ret = to_variant_node(my_node)->put(req.key(), req.value(), req.m_put_type, req.m_existing_val,
                                             req.m_filter_cb);
         COUNTER_INCREMENT(m_metrics, btree_obj_count, 1);
+    } else if constexpr (std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) {
+        // Apply all the keys which belong to this leaf, as long as there is room. First key is guaranteed to belong
+        // here and also to have room, since the caller has split the node otherwise.
+        uint32_t nput{0};
+        auto const start_idx = req.cur_idx();
+        while (!req.is_done()) {
+            if ((req.cur_idx() != start_idx) &&
+                (!req.is_within_leaf_bound(req.key()) ||
+                 !my_node->has_room_for_put(req.m_put_type, req.key().serialized_size(),
+                                            req.value().serialized_size()))) {
+                break;
+            }
+            auto const status =
+                to_variant_node(my_node)->put(req.key(), req.value(), req.m_put_type, nullptr, req.m_filter_cb);
+            if (status == btree_status_t::success) { ++nput; }
+            req.advance(status == btree_status_t::success);
+        }
+        COUNTER_INCREMENT(m_metrics, btree_obj_count, nput);
+        if (nput == 0) { return req.is_done() ? btree_status_t::success : btree_status_t::has_more; }
+        ret = req.is_done() ? btree_status_t::success : btree_status_t::has_more;
     }
 
     if ((ret == btree_status_t::success) || (ret == btree_status_t::has_more)) {
@@ -264,7 +313,10 @@ btree_status_t Btree< K, V >::split_node(const BtreeNodePtr& parent_node, const
     child_node2->set_next_bnode(child_node1->next_bnode());
     child_node1->set_next_bnode(child_node2->node_id());
     child_node2->set_level(child_node1->level());
-    uint32_t child1_filled_size = child_node1->node_data_size() - child_node1->available_size();
+    // Only the pivots of buffered node are split by size, messages follow the pivots they belong to
+    uint32_t child1_filled_size = (child_node1->get_node_type() == btree_node_type::BUFFERED)
+        ? child_node1->occupied_size()
+        : (child_node1->node_data_size() - child_node1->available_size());
 
     auto split_size = m_bt_cfg.split_size(child1_filled_size);
     uint32_t res = child_node1->move_out_to_right_by_size(m_bt_cfg, *child_node2, split_size);
@@ -309,7 +361,8 @@ bool Btree< K, V >::is_split_needed(const BtreeNodePtr& node, ReqT& req) const {
         return !node->has_room_for_put(btree_put_type::UPSERT, K::get_max_size(), BtreeLinkInfo::get_fixed_size());
     } else if constexpr (std::is_same_v< ReqT, BtreeRangePutRequest< K > >) {
         return !node->has_room_for_put(req.m_put_type, req.first_key_size(), req.m_newval->serialized_size());
-    } else if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest >) {
+    } else if constexpr (std::is_same_v< ReqT, BtreeSinglePutRequest > ||
+                         std::is_same_v< ReqT, BtreeBatchPutRequest< K, V > >) {
         return !node->has_room_for_put(req.m_put_type, req.key().serialized_size(), req.value().serialized_size());
     } else {
         return false;
@@ -15,6 +15,7 @@
  *********************************************************************************/
 
 #pragma once
+#include <atomic>
 #include <iostream>
 #include <queue>
 #include <iomgr/fiber_lib.hpp>
@@ -99,7 +100,12 @@ class BtreeNode : public sisl::ObjLifeCounter< BtreeNode > {
 public:
     sisl::atomic_counter< int32_t > m_refcount{0};
     transient_hdr_t m_trans_hdr;
-    uint8_t* m_phys_node_buf;
+    // Replaced (by the store) under write lock, while optimistic readers could be reading it without one
+    std::atomic< uint8_t* > m_phys_node_buf;
+
+    // Bumped on acquiring and on releasing the write lock, so it is odd while a writer holds the node. Persistent
+    // node_gen/link_version are bumped only after a change is made, hence optimistic readers can't rely on them alone.
+    mutable std::atomic< uint64_t > m_lock_version{0};
 
 public:
     BtreeNode(uint8_t* node_buf, bnodeid_t id, bool init_buf, bool is_leaf, BtreeConfig const& cfg) :
@@ -174,7 +180,7 @@ public:
         auto [found, idx] = bsearch_node(key);
         if (idx == total_entries()) {
             if (!has_valid_edge() || is_leaf()) {
-                DEBUG_ASSERT_EQ(found, false);
+                DEBUG_ASSERT(in_optimistic_read() || !found, "Key found beyond the last entry");
                 return std::make_pair(found, idx);
             }
             if (outval) { *((BtreeLinkInfo*)outval) = get_edge_value(); }
@@ -343,6 +349,8 @@ public:
             m_trans_hdr.lock.lock_shared();
         } else if (l == locktype_t::WRITE) {
             m_trans_hdr.lock.lock();
+            m_lock_version.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
         }
     }
 
@@ -350,10 +358,29 @@ public:
         if (l == locktype_t::READ) {
             m_trans_hdr.lock.unlock_shared();
         } else if (l == locktype_t::WRITE) {
+            m_lock_version.fetch_add(1, std::memory_order_release);
             m_trans_hdr.lock.unlock();
         }
     }
 
+    /// @brief Note the version of the node before reading it without lock. Contents read thereafter are usable only
+    /// if validate_optimistic_version() with this version succeeds after reading them.
+    uint64_t optimistic_version() const { return m_lock_version.load(std::memory_order_acquire); }
+
+    /// @brief Validate that no writer has held the node since the version was noted.
+    bool validate_optimistic_version(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return ((version & 1) == 0) && (m_lock_version.load(std::memory_order_relaxed) == version);
+    }
+
+    /// @brief Whether this thread is searching a node without its lock. Entries (and their count) could change under
+    /// the search then, so the checks on their consistency are skipped; the reader validates the version instead.
+    /// Search never yields, so a thread local is good enough even with fibers.
+    static bool& in_optimistic_read() {
+        static thread_local bool s_in_optimistic_read{false};
+        return s_in_optimistic_read;
+    }
+
     void lock_upgrade() {
         m_trans_hdr.upgraders.increment(1);
         this->unlock(locktype_t::READ);
@@ -445,10 +472,11 @@ public:
     virtual std::string to_dot_keys() const = 0;
 
 protected:
-    node_find_result_t bsearch_node(const BtreeKey& key) const {
+    // Variants which can search their keys faster than the generic compare_nth_key() based binary search override this
+    virtual node_find_result_t bsearch_node(const BtreeKey& key) const {
         DEBUG_ASSERT_EQ(magic(), BTREE_NODE_MAGIC);
         auto [found, idx] = bsearch(-1, total_entries(), key);
-        if (found) { DEBUG_ASSERT_LT(idx, total_entries()); }
+        if (found) { DEBUG_ASSERT(in_optimistic_read() || (idx < total_entries()), "Invalid found idx={}", idx); }
 
         return std::make_pair(found, idx);
     }
@@ -461,7 +489,7 @@ protected:
         if ((end - start) <= 1) { return std::make_pair(found, end_of_search_index); }
         while ((end - start) > 1) {
             mid = start + (end - start) / 2;
-            DEBUG_ASSERT(mid >= 0 && mid < int_cast(total_entries()), "Invalid mid={}", mid);
+            DEBUG_ASSERT(in_optimistic_read() || (mid >= 0 && mid < int_cast(total_entries())), "Invalid mid={}", mid);
             int x = compare_nth_key(key, mid);
             if (x == 0) {
                 found = true;
@@ -478,13 +506,14 @@ protected:
     }
 
 public:
-    void update_phys_buf(uint8_t* buf) { m_phys_node_buf = buf; }
-    persistent_hdr_t* get_persistent_header() { return r_cast< persistent_hdr_t* >(m_phys_node_buf); }
+    void update_phys_buf(uint8_t* buf) { m_phys_node_buf.store(buf, std::memory_order_release); }
+    uint8_t* phys_buf() const { return m_phys_node_buf.load(std::memory_order_acquire); }
+    persistent_hdr_t* get_persistent_header() { return r_cast< persistent_hdr_t* >(phys_buf()); }
     const persistent_hdr_t* get_persistent_header_const() const {
-        return r_cast< const persistent_hdr_t* >(m_phys_node_buf);
+        return r_cast< const persistent_hdr_t* >(phys_buf());
     }
-    uint8_t* node_data_area() { return (m_phys_node_buf + sizeof(persistent_hdr_t)); }
-    const uint8_t* node_data_area_const() const { return (m_phys_node_buf + sizeof(persistent_hdr_t)); }
+    uint8_t* node_data_area() { return (phys_buf() + sizeof(persistent_hdr_t)); }
+    const uint8_t* node_data_area_const() const { return (phys_buf() + sizeof(persistent_hdr_t)); }
 
     uint8_t magic() const { return get_persistent_header_const()->magic; }
     void set_magic() { get_persistent_header()->magic = BTREE_NODE_MAGIC; }
@@ -19,6 +19,7 @@
 #include <homestore/btree/detail/simple_node.hpp>
 #include <homestore/btree/detail/varlen_node.hpp>
 #include <homestore/btree/detail/prefix_node.hpp>
+#include <homestore/btree/detail/buffered_node.hpp>
 #include <sisl/fds/utils.hpp>
 // #include <iomgr/iomgr_flip.hpp>
 
@@ -284,6 +285,11 @@ BtreeNode* Btree< K, V >::init_node(uint8_t* node_buf, bnodeid_t id, bool init_b
                     : create_node< FixedPrefixNode< K, BtreeLinkInfo > >(node_buf, id, init_buf, false, this->m_bt_cfg);
         break;
 
+    case btree_node_type::BUFFERED:
+        BT_REL_ASSERT(!is_leaf, "Buffered node type is supported only for interior nodes");
+        n = create_node< BufferedNode< K, V > >(node_buf, id, init_buf, false, this->m_bt_cfg);
+        break;
+
     default:
         BT_REL_ASSERT(false, "Unsupported node type {}", node_type);
         break;
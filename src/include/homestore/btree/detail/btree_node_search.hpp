@@ -0,0 +1,208 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <sisl/utility/enum.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HS_BTREE_SIMD_SEARCH 1
+#endif
+
+namespace homestore {
+
+// Instruction set used by the fixed key in-node search. It is detected once at runtime, so that binary built without
+// -mavx2 still picks the vectorized path on capable hosts.
+ENUM(node_search_isa_t, uint8_t, SCALAR, SSE42, AVX2)
+
+namespace node_search {
+// Once the binary search narrows down to these many entries, rest of the entries are compared in one vector pass.
+static constexpr uint32_t linear_window{16};
+
+inline node_search_isa_t detect_isa() {
+#ifdef HS_BTREE_SIMD_SEARCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return node_search_isa_t::AVX2; }
+    if (__builtin_cpu_supports("sse4.2")) { return node_search_isa_t::SSE42; }
+#endif
+    return node_search_isa_t::SCALAR;
+}
+
+inline node_search_isa_t& current_isa_ref() {
+    static node_search_isa_t s_isa{detect_isa()};
+    return s_isa;
+}
+
+inline node_search_isa_t current_isa() { return current_isa_ref(); }
+
+// Override the detected isa (primarily for benchmarks and tests). Requests beyond what cpu supports are clamped.
+inline node_search_isa_t set_isa(node_search_isa_t isa) {
+    auto const supported = detect_isa();
+    current_isa_ref() = (uint8_t(isa) > uint8_t(supported)) ? supported : isa;
+    return current_isa_ref();
+}
+
+// Load a native byte order unsigned integer of given size (1, 2, 4 or 8 bytes) from an unaligned location
+inline uint64_t load_uint(uint8_t const* p, uint32_t size) {
+    switch (size) {
+    case 1:
+        return *p;
+    case 2: {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case 4: {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    default: {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    }
+}
+
+// Map the key to an unsigned domain where ordering is preserved, so that unsigned and signed keys share the kernels
+template < typename T >
+inline auto to_ordered(T v) {
+    using U = std::make_unsigned_t< T >;
+    if constexpr (std::is_signed_v< T >) {
+        return U(U(v) ^ (U(1) << (sizeof(U) * 8 - 1)));
+    } else {
+        return U(v);
+    }
+}
+
+template < typename U >
+inline uint32_t count_less_scalar(U const* keys, uint32_t n, U key) {
+    uint32_t cnt{0};
+    for (uint32_t i{0}; i < n; ++i) {
+        cnt += (keys[i] < key);
+    }
+    return cnt;
+}
+
+#ifdef HS_BTREE_SIMD_SEARCH
+// SSE/AVX2 only provide signed compares, flip the sign bit of both sides to compare unsigned values.
+template < typename U >
+__attribute__((target("avx2"))) inline uint32_t count_less_avx2(U const* keys, uint32_t n, U key) {
+    uint32_t cnt{0};
+    uint32_t i{0};
+    if constexpr (sizeof(U) == 8) {
+        auto const bias = _mm256_set1_epi64x(std::numeric_limits< int64_t >::min());
+        auto const kv = _mm256_xor_si256(_mm256_set1_epi64x(int64_t(key)), bias);
+        for (; i + 4 <= n; i += 4) {
+            auto const v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(keys + i)), bias);
+            cnt += std::popcount(uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(kv, v)))));
+        }
+    } else if constexpr (sizeof(U) == 4) {
+        auto const bias = _mm256_set1_epi32(std::numeric_limits< int32_t >::min());
+        auto const kv = _mm256_xor_si256(_mm256_set1_epi32(int32_t(key)), bias);
+        for (; i + 8 <= n; i += 8) {
+            auto const v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(keys + i)), bias);
+            cnt += std::popcount(uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(kv, v)))));
+        }
+    }
+    return cnt + count_less_scalar(keys + i, n - i, key);
+}
+
+template < typename U >
+__attribute__((target("sse4.2"))) inline uint32_t count_less_sse42(U const* keys, uint32_t n, U key) {
+    uint32_t cnt{0};
+    uint32_t i{0};
+    if constexpr (sizeof(U) == 8) {
+        auto const bias = _mm_set1_epi64x(std::numeric_limits< int64_t >::min());
+        auto const kv = _mm_xor_si128(_mm_set1_epi64x(int64_t(key)), bias);
+        for (; i + 2 <= n; i += 2) {
+            auto const v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast< __m128i const* >(keys + i)), bias);
+            cnt += std::popcount(uint32_t(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(kv, v)))));
+        }
+    } else if constexpr (sizeof(U) == 4) {
+        auto const bias = _mm_set1_epi32(std::numeric_limits< int32_t >::min());
+        auto const kv = _mm_xor_si128(_mm_set1_epi32(int32_t(key)), bias);
+        for (; i + 4 <= n; i += 4) {
+            auto const v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast< __m128i const* >(keys + i)), bias);
+            cnt += std::popcount(uint32_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(kv, v)))));
+        }
+    }
+    return cnt + count_less_scalar(keys + i, n - i, key);
+}
+#endif
+
+template < typename U >
+inline uint32_t count_less(U const* keys, uint32_t n, U key) {
+#ifdef HS_BTREE_SIMD_SEARCH
+    if constexpr ((sizeof(U) == 8) || (sizeof(U) == 4)) {
+        switch (current_isa()) {
+        case node_search_isa_t::AVX2:
+            return count_less_avx2(keys, n, key);
+        case node_search_isa_t::SSE42:
+            return count_less_sse42(keys, n, key);
+        default:
+            break;
+        }
+    }
+#endif
+    return count_less_scalar(keys, n, key);
+}
+
+/// @brief Search a node laid out as fixed size integral keys, without going through virtual compare of BtreeKey
+///
+/// Keys are binary searched until the window reduces to linear_window entries. The remaining window is copied into
+/// a contiguous array (keys are strided in the node along with their values) and compared in a single vector pass.
+///
+/// @param nentries Total entries in the node
+/// @param key Integral representation of the search key
+/// @param key_at Callable which returns integral representation of nth key in node
+/// @return Same semantics as BtreeNode::bsearch_node, i.e. whether the key is found and index of the key or the
+/// index of the first key greater than the given key
+template < typename T, typename KeyAtFn >
+inline std::pair< bool, uint32_t > lower_bound(uint32_t nentries, T key, KeyAtFn&& key_at) {
+    using U = decltype(to_ordered(key));
+    U const okey = to_ordered(key);
+
+    uint32_t lo{0};
+    uint32_t n{nentries};
+    while (n > linear_window) {
+        uint32_t const half = n / 2;
+        if (to_ordered(key_at(lo + half)) < okey) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+
+    U window[linear_window];
+    for (uint32_t i{0}; i < n; ++i) {
+        window[i] = to_ordered(key_at(lo + i));
+    }
+    uint32_t const idx = lo + count_less(window, n, okey);
+    bool const found = (idx < nentries) && (to_ordered(key_at(idx)) == okey);
+    return std::make_pair(found, idx);
+}
+} // namespace node_search
+} // namespace homestore
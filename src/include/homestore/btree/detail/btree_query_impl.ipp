@@ -56,6 +56,9 @@ btree_status_t Btree< K, V >::do_sweep_query(BtreeNodePtr& my_node, BtreeQueryRe
                 ret = read_and_lock_node(my_node->next_bnode(), next_node, locktype_t::READ, locktype_t::READ,
                                          qreq.m_op_context);
                 if (ret != btree_status_t::success) { break; }
+
+                // Keep the read ahead going beyond the siblings prefetched from parent node
+                if (qreq.read_ahead_depth()) { slide_read_ahead_window(next_node, qreq); }
             } else {
                 ret = btree_status_t::has_more;
                 break;
@@ -71,6 +74,26 @@ btree_status_t Btree< K, V >::do_sweep_query(BtreeNodePtr& my_node, BtreeQueryRe
     ASSERT_IS_VALID_INTERIOR_CHILD_INDX(isfound, idx, my_node);
     if (qreq.route_tracing) { append_route_trace(qreq, my_node, btree_event_t::READ, idx, idx); }
 
+    // If the children are leaves, issue the reads of the leaves the sweep is going to walk through, all at once. The
+    // sweep then picks them from the cache as it moves over to the sibling nodes.
+    if (qreq.read_ahead_depth() && (my_node->level() == 1)) {
+        auto const [end_found, end_idx] = my_node->find(qreq.input_range().end_key(), nullptr, false);
+        uint32_t last_idx = std::min(idx + qreq.read_ahead_depth() - 1, end_idx);
+        if ((last_idx == my_node->total_entries()) && !my_node->has_valid_edge()) { --last_idx; }
+
+        std::vector< bnodeid_t > ids;
+        ids.reserve(last_idx - idx + 1);
+        auto& window = qreq.read_ahead_window();
+        window.clear();
+        for (uint32_t i{idx}; i <= last_idx; ++i) {
+            BtreeLinkInfo child_info;
+            my_node->get_nth_value(i, &child_info, false);
+            ids.push_back(child_info.bnode_id());
+            if (i != idx) { window.push_back(child_info.bnode_id()); }
+        }
+        prefetch_nodes_impl(ids);
+    }
+
     BtreeNodePtr child_node;
     ret = read_and_lock_node(start_child_info.bnode_id(), child_node, locktype_t::READ, locktype_t::READ,
                              qreq.m_op_context);
@@ -79,6 +102,46 @@ btree_status_t Btree< K, V >::do_sweep_query(BtreeNodePtr& my_node, BtreeQueryRe
     return (do_sweep_query(child_node, qreq, out_values));
 }
 
+// Move the read ahead window past the node the sweep is now at and top it up, so that along with the current node there
+// are read_ahead_depth nodes read ahead. The sibling of the farthest node in the window is known only once that node is
+// resident, so if its read is still in flight, the window is topped up in one of the later moves.
+template < typename K, typename V >
+void Btree< K, V >::slide_read_ahead_window(BtreeNodePtr const& cur_node, BtreeQueryRequest< K >& qreq) const {
+    auto& window = qreq.read_ahead_window();
+    auto const it = std::find(window.begin(), window.end(), cur_node->node_id());
+    if (it == window.end()) {
+        // Sweep moved out of the window (say a split added a new sibling), restart it from the current node
+        window.clear();
+    } else {
+        window.erase(window.begin(), it + 1);
+    }
+
+    std::vector< bnodeid_t > ids;
+    while (window.size() + 1 < qreq.read_ahead_depth()) {
+        bnodeid_t next_id{empty_bnodeid};
+        if (window.empty()) {
+            if ((cur_node->total_entries() != 0) &&
+                (cur_node->get_last_key< K >().compare(qreq.input_range().end_key()) >= 0)) {
+                break;
+            }
+            next_id = cur_node->next_bnode();
+        } else {
+            // Node is looked at without lock, the sibling id read is only a hint for what to read ahead
+            BtreeNodePtr last_node;
+            if (!get_resident_node_impl(window.back(), last_node)) { break; }
+            if ((last_node->total_entries() != 0) &&
+                (last_node->get_last_key< K >().compare(qreq.input_range().end_key()) >= 0)) {
+                break;
+            }
+            next_id = last_node->next_bnode();
+        }
+        if (next_id == empty_bnodeid) { break; }
+        window.push_back(next_id);
+        ids.push_back(next_id);
+    }
+    if (!ids.empty()) { prefetch_nodes_impl(ids); }
+}
+
 template < typename K, typename V >
 btree_status_t Btree< K, V >::do_traversal_query(const BtreeNodePtr& my_node, BtreeQueryRequest< K >& qreq,
                                                  std::vector< std::pair< K, V > >& out_values) const {
@@ -39,6 +39,15 @@ btree_status_t Btree< K, V >::do_remove(const BtreeNodePtr& my_node, locktype_t
             req.shift_working_range();
         } else if constexpr (std::is_same_v< ReqT, BtreeRemoveAnyRequest< K > >) {
             if ((modified = my_node->remove_any(req.m_range, req.m_outkey, req.m_outval))) { ++removed_count; }
+        } else if constexpr (std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) {
+            // Remove all the keys which belong to this leaf, first key is guaranteed to belong here.
+            auto const start_idx = req.cur_idx();
+            while (!req.is_done() && ((req.cur_idx() == start_idx) || req.is_within_leaf_bound(req.key()))) {
+                bool const removed = my_node->remove_one(req.key(), nullptr, nullptr);
+                if (removed) { ++removed_count; }
+                req.advance(removed);
+            }
+            modified = (removed_count != 0);
         }
 #ifndef NDEBUG
         my_node->validate_key_order< K >();
@@ -50,9 +59,19 @@ btree_status_t Btree< K, V >::do_remove(const BtreeNodePtr& my_node, locktype_t
         }
 
         unlock_node(my_node, curlock);
+        if constexpr (std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) {
+            return req.is_done() ? btree_status_t::success : btree_status_t::has_more;
+        }
         return modified ? btree_status_t::success : btree_status_t::not_found;
     }
 
+    if constexpr (std::is_same_v< ReqT, BtreeSingleRemoveRequest >) {
+        if (is_buffered() && (my_node->level() == 1) && buffer_remove(my_node, req, ret)) {
+            unlock_node(my_node, curlock);
+            return ret;
+        }
+    }
+
 retry:
     locktype_t child_cur_lock = locktype_t::NONE;
     uint32_t curr_idx;
@@ -65,7 +84,8 @@ retry:
     };
 
     // Get the childPtr for given key.
-    if constexpr (std::is_same_v< ReqT, BtreeSingleRemoveRequest >) {
+    if constexpr (std::is_same_v< ReqT, BtreeSingleRemoveRequest > ||
+                  std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) {
         auto const [found, idx] = my_node->find(req.key(), nullptr, false);
         ASSERT_IS_VALID_INTERIOR_CHILD_INDX(found, idx, my_node);
         end_idx = start_idx = idx;
@@ -88,14 +108,41 @@ retry:
     if (req.route_tracing) { append_route_trace(req, my_node, btree_event_t::READ, start_idx, end_idx); }
     curr_idx = start_idx;
     while (curr_idx <= end_idx) {
+        if (is_buffered() && (my_node->level() == 1)) {
+            ret = flush_path_msgs(my_node, curr_idx, req);
+            if (ret == btree_status_t::retry) { goto retry; }
+            if (ret != btree_status_t::success) {
+                // Ran out of room for pivots, restart from root so that this node is split on the way down
+                if (ret == btree_status_t::space_not_avail) { ret = btree_status_t::retry; }
+                goto out_return;
+            }
+        }
+
         BtreeLinkInfo child_info;
         BtreeNodePtr child_node;
-        ret = get_child_and_lock_node(my_node, curr_idx, child_info, child_node, locktype_t::READ, locktype_t::WRITE,
+        // Removes resolve or flush the messages in level 1 nodes, so they need to be write locked
+        auto const int_lock = (is_buffered() && (my_node->level() == 2)) ? locktype_t::WRITE : locktype_t::READ;
+        ret = get_child_and_lock_node(my_node, curr_idx, child_info, child_node, int_lock, locktype_t::WRITE,
                                       req.m_op_context);
         if (ret != btree_status_t::success) { goto out_return; }
-        child_cur_lock = child_node->is_leaf() ? locktype_t::WRITE : locktype_t::READ;
+        child_cur_lock = child_node->is_leaf() ? locktype_t::WRITE : int_lock;
+
+        if (is_buffered() && (child_node->level() == 1) && is_split_needed(child_node, req)) {
+            // Level 1 node needs room for the pivots of the leaves, which could be split while flushing its messages
+            ret = upgrade_node_locks(my_node, child_node, curlock, child_cur_lock, req.m_op_context);
+            if (ret != btree_status_t::success) { goto out_return; }
+
+            K split_key;
+            ret = split_node(my_node, child_node, curr_idx, &split_key, req.m_op_context);
+            unlock_lambda(child_node, child_cur_lock);
+            if (ret != btree_status_t::success) { goto out_return; }
+
+            if (req.route_tracing) { append_route_trace(req, child_node, btree_event_t::SPLIT); }
+            COUNTER_INCREMENT(m_metrics, btree_split_count, 1);
+            goto retry;
+        }
 
-        if (child_node->is_merge_needed(m_bt_cfg)) {
+        if (child_node->is_merge_needed(m_bt_cfg) && !is_buffering_node(child_node)) {
             // If child node is minimal and can be merged
             uint32_t node_end_idx = my_node->total_entries();
             if (!my_node->has_valid_edge()) { --node_end_idx; }
@@ -139,6 +186,8 @@ retry:
                                 req.working_range().to_string());
                 }
             }
+        } else if constexpr (std::is_same_v< ReqT, BtreeBatchRemoveRequest< K > >) {
+            if (curr_idx < my_node->total_entries()) { req.set_leaf_bound(my_node->get_nth_key< K >(curr_idx, true)); }
         }
 
 #ifndef NDEBUG
@@ -193,6 +242,19 @@ btree_status_t Btree< K, V >::check_collapse_root(ReqT& req) {
     }
 
     BT_NODE_DBG_ASSERT_EQ(root->has_valid_edge(), true, root);
+    if (is_buffering_node(root) && (to_buffered_node(root)->num_msgs() != 0)) {
+        // Messages pending for the only child need to reach it, before root is collapsed into it. If child had to be
+        // split for them, root is no longer a candidate to collapse.
+        ret = flush_child_msgs(root, 0, req.m_op_context);
+        if (ret == btree_status_t::space_not_avail) { ret = btree_status_t::success; }
+        if (ret == btree_status_t::success) { ret = write_node(root, req.m_op_context); }
+        if ((ret != btree_status_t::success) || (root->total_entries() != 0) ||
+            (to_buffered_node(root)->num_msgs() != 0)) {
+            unlock_node(root, locktype_t::WRITE);
+            goto done;
+        }
+    }
+
     ret = read_and_lock_node(root->edge_id(), child, locktype_t::WRITE, locktype_t::WRITE, req.m_op_context);
     if (ret != btree_status_t::success) {
         unlock_node(root, locktype_t::WRITE);
@@ -222,6 +284,10 @@ template < typename K, typename V >
 btree_status_t Btree< K, V >::merge_nodes(const BtreeNodePtr& parent_node, const BtreeNodePtr& leftmost_node,
                                           uint32_t start_idx, uint32_t end_idx, void* context) {
     if (!m_bt_cfg.m_merge_turned_on) { return btree_status_t::merge_not_required; }
+
+    // Pivot area of buffered nodes is only a part of the node and merging them would need messages to be merged as
+    // well, so they are left as is (see BufferedNode).
+    if (is_buffering_node(leftmost_node)) { return btree_status_t::merge_not_required; }
     btree_status_t ret{btree_status_t::success};
     BtreeNodeList old_nodes;
     BtreeNodeList new_nodes;
@@ -0,0 +1,250 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <homestore/btree/detail/simple_node.hpp>
+
+namespace homestore {
+
+/// @brief Interior node which, in addition to the child pivots, carries a buffer of pending upserts and removes
+/// (messages) for the leaves underneath (Bε-tree style).
+///
+/// Only the nodes in level 1 buffer the messages. For them the data area is split in half, first half holds the fixed
+/// size pivots (same layout as SimpleNode) and the second half holds a header followed by messages sorted by key.
+/// Each message is the key, value and the op, where a remove (tombstone) carries no meaningful value. Interior nodes
+/// in other levels use the entire data area for pivots and never carry messages. Both key and value (of the leaf) are
+/// expected to be fixed size.
+///
+/// Buffering nodes are never merged with their siblings. Merge sizes the nodes by the ideal fill size of the entire
+/// node, whereas the pivots get only half of it, and the messages would need to be merged as well. They can still
+/// shrink to an edge only node and be collapsed if they are the root.
+template < typename K, typename V >
+class BufferedNode : public SimpleNode< K, BtreeLinkInfo > {
+private:
+#pragma pack(1)
+    struct msg_area_header {
+        uint32_t nmsgs{0};
+    };
+#pragma pack()
+
+    enum class msg_op_t : uint8_t { UPSERT = 0, REMOVE = 1 };
+
+public:
+    using base_t = SimpleNode< K, BtreeLinkInfo >;
+
+    BufferedNode(uint8_t* node_buf, bnodeid_t id, bool init, bool is_leaf, const BtreeConfig& cfg) :
+            base_t(node_buf, id, init, is_leaf, cfg) {
+        DEBUG_ASSERT_EQ(is_leaf, false, "Buffered node is supported only for interior nodes");
+        this->set_node_type(btree_node_type::BUFFERED);
+        if (init) { msg_header()->nmsgs = 0; }
+    }
+
+    ///////////////////////////////////// Pivot area overrides ////////////////////////////////////
+    uint32_t available_size() const override {
+        return (pivot_area_size() - (this->total_entries() * this->get_nth_obj_size(0)));
+    }
+
+    uint32_t occupied_size() const override { return (this->total_entries() * this->get_nth_obj_size(0)); }
+
+    void remove_all(const BtreeConfig& cfg) override {
+        base_t::remove_all(cfg);
+        if (is_buffering()) { msg_header()->nmsgs = 0; }
+    }
+
+    // Messages follow the pivots they belong to, so whatever is beyond the last pivot left behind moves along with
+    // the pivots.
+    uint32_t move_out_to_right_by_entries(const BtreeConfig& cfg, BtreeNode& o, uint32_t nentries) override {
+        auto& other_node = s_cast< BufferedNode< K, V >& >(o);
+        auto const nmoved = base_t::move_out_to_right_by_entries(cfg, o, nentries);
+        if (!is_buffering() || (num_msgs() == 0) || (nmoved == 0)) { return nmoved; }
+
+        K const last_key = BtreeNode::get_nth_key< K >(this->total_entries() - 1, false);
+        auto const [found, start] = find_msg(last_key);
+        uint32_t const move_from = found ? start + 1 : start;
+        for (uint32_t i{move_from}; i < num_msgs(); ++i) {
+            if (is_nth_msg_tombstone(i)) {
+                other_node.tombstone_msg(get_nth_msg_key(i));
+            } else {
+                other_node.upsert_msg(get_nth_msg_key(i), get_nth_msg_value(i));
+            }
+        }
+        remove_msgs(move_from, num_msgs() - move_from);
+        return nmoved;
+    }
+
+    uint32_t move_out_to_right_by_size(const BtreeConfig& cfg, BtreeNode& o, uint32_t size) override {
+        return (this->get_nth_obj_size(0) * move_out_to_right_by_entries(cfg, o, size / this->get_nth_obj_size(0)));
+    }
+
+    std::string to_string(bool print_friendly = false) const override {
+        auto str = base_t::to_string(print_friendly);
+        if (is_buffering()) {
+            fmt::format_to(std::back_inserter(str), " nMsgs={}", num_msgs());
+            for (uint32_t i{0}; i < num_msgs(); ++i) {
+                if (is_nth_msg_tombstone(i)) {
+                    fmt::format_to(std::back_inserter(str), "{}Msg{} [Key={} Removed]", (print_friendly ? "\n\t" : " "),
+                                   i + 1, get_nth_msg_key(i).to_string());
+                } else {
+                    fmt::format_to(std::back_inserter(str), "{}Msg{} [Key={} Val={}]", (print_friendly ? "\n\t" : " "),
+                                   i + 1, get_nth_msg_key(i).to_string(), get_nth_msg_value(i).to_string());
+                }
+            }
+        }
+        return str;
+    }
+
+    ///////////////////////////////////// Message buffer APIs ////////////////////////////////////
+    bool is_buffering() const { return (this->level() == 1); }
+    uint32_t num_msgs() const { return is_buffering() ? msg_header_const()->nmsgs : 0; }
+    uint32_t msg_capacity() const {
+        return is_buffering() ? (this->node_data_size() - pivot_area_size() - sizeof(msg_area_header)) / msg_size()
+                              : 0;
+    }
+    bool has_room_for_msg() const { return (num_msgs() < msg_capacity()); }
+
+    /// @brief Binary search the message buffer for the key
+    /// @return Whether the message for the key exists and its index or the index of first message greater than key
+    std::pair< bool, uint32_t > find_msg(BtreeKey const& key) const {
+        uint32_t lo{0};
+        uint32_t hi{num_msgs()};
+        while (lo < hi) {
+            uint32_t const mid = lo + (hi - lo) / 2;
+            int const x = get_nth_msg_key(mid).compare(key);
+            if (x == 0) { return std::make_pair(true, mid); }
+            if (x < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return std::make_pair(false, lo);
+    }
+
+    K get_nth_msg_key(uint32_t ind) const {
+        DEBUG_ASSERT_LT(ind, num_msgs(), "node={}", to_string());
+        K key;
+        key.deserialize(sisl::blob{const_cast< uint8_t* >(nth_msg_const(ind)), msg_key_size()}, true /* copy */);
+        return key;
+    }
+
+    V get_nth_msg_value(uint32_t ind) const {
+        DEBUG_ASSERT_LT(ind, num_msgs(), "node={}", to_string());
+        V val;
+        get_nth_msg_value(ind, &val);
+        return val;
+    }
+
+    void get_nth_msg_value(uint32_t ind, BtreeValue* out_val) const {
+        out_val->deserialize(
+            sisl::blob{const_cast< uint8_t* >(nth_msg_const(ind) + msg_key_size()), msg_value_size()}, true /* copy */);
+    }
+
+    bool is_nth_msg_tombstone(uint32_t ind) const {
+        DEBUG_ASSERT_LT(ind, num_msgs(), "node={}", to_string());
+        return (s_cast< msg_op_t >(*(nth_msg_const(ind) + msg_key_size() + msg_value_size())) == msg_op_t::REMOVE);
+    }
+
+    /// @brief Add the message for the key or overwrite the message if there is one already. Caller is expected to
+    /// ensure there is room in the buffer, if the key is not already buffered.
+    void upsert_msg(BtreeKey const& key, BtreeValue const& val) {
+        auto const ind = reserve_msg(key);
+        sisl::blob const vb = val.serialize();
+        DEBUG_ASSERT_EQ(vb.size(), msg_value_size(), "Only fixed size values can be buffered");
+        std::memcpy(nth_msg(ind) + msg_key_size(), vb.cbytes(), vb.size());
+        *(nth_msg(ind) + msg_key_size() + msg_value_size()) = uint8_t(msg_op_t::UPSERT);
+        this->inc_gen();
+    }
+
+    /// @brief Add the remove message for the key or turn the existing message for the key into one. Caller is expected
+    /// to ensure there is room in the buffer, if the key is not already buffered.
+    void tombstone_msg(BtreeKey const& key) {
+        auto const ind = reserve_msg(key);
+        std::memset(nth_msg(ind) + msg_key_size(), 0, msg_value_size());
+        *(nth_msg(ind) + msg_key_size() + msg_value_size()) = uint8_t(msg_op_t::REMOVE);
+        this->inc_gen();
+    }
+
+    void remove_msgs(uint32_t start, uint32_t count) {
+        if (count == 0) { return; }
+        DEBUG_ASSERT_LE(start + count, num_msgs(), "node={}", to_string());
+        uint32_t const sz = (num_msgs() - start - count) * msg_size();
+        if (sz != 0) { std::memmove(nth_msg(start), nth_msg(start + count), sz); }
+        msg_header()->nmsgs -= count;
+        this->inc_gen();
+    }
+
+    /// @brief Range of messages which belong to the child at the given pivot index
+    /// @return Pair of index of the first message and number of messages
+    std::pair< uint32_t, uint32_t > msgs_of_child(uint32_t child_idx) const {
+        uint32_t start{0};
+        if (child_idx > 0) {
+            auto const [found, ind] = find_msg(BtreeNode::get_nth_key< K >(child_idx - 1, false));
+            start = found ? ind + 1 : ind;
+        }
+
+        uint32_t end{num_msgs()};
+        if (child_idx < this->total_entries()) {
+            auto const [found, ind] = find_msg(BtreeNode::get_nth_key< K >(child_idx, false));
+            end = found ? ind + 1 : ind;
+        }
+        return std::make_pair(start, end - start);
+    }
+
+    /// @brief Range of messages whose keys fall within the range. Range boundaries are treated inclusive.
+    /// @return Pair of index of the first message and number of messages
+    std::pair< uint32_t, uint32_t > msgs_in_range(BtreeKeyRange< K > const& range) const {
+        uint32_t const start = find_msg(range.start_key()).second;
+        auto const [found, ind] = find_msg(range.end_key());
+        uint32_t const end = found ? ind + 1 : ind;
+        return std::make_pair(start, (end > start) ? (end - start) : 0);
+    }
+
+private:
+    // Make room for the message of the key, if it is not already buffered and write the key. Returns its index.
+    uint32_t reserve_msg(BtreeKey const& key) {
+        auto const [found, ind] = find_msg(key);
+        if (!found) {
+            RELEASE_ASSERT(has_room_for_msg(), "Message buffer is full, node={}", to_string());
+            uint32_t const sz = (num_msgs() - ind) * msg_size();
+            if (sz != 0) { std::memmove(nth_msg(ind + 1), nth_msg(ind), sz); }
+            ++(msg_header()->nmsgs);
+
+            sisl::blob const kb = key.serialize();
+            DEBUG_ASSERT_EQ(kb.size(), msg_key_size(), "Only fixed size keys can be buffered");
+            std::memcpy(nth_msg(ind), kb.cbytes(), kb.size());
+        }
+        return ind;
+    }
+
+    uint32_t pivot_area_size() const {
+        return is_buffering() ? (this->node_data_size() / 2) : this->node_data_size();
+    }
+    uint32_t msg_key_size() const { return dummy_key< K >.serialized_size(); }
+    uint32_t msg_value_size() const { return dummy_value< V >.serialized_size(); }
+    uint32_t msg_size() const { return msg_key_size() + msg_value_size() + sizeof(msg_op_t); }
+
+    msg_area_header* msg_header() {
+        return r_cast< msg_area_header* >(this->node_data_area() + (this->node_data_size() / 2));
+    }
+    msg_area_header const* msg_header_const() const {
+        return r_cast< msg_area_header const* >(this->node_data_area_const() + (this->node_data_size() / 2));
+    }
+    uint8_t* nth_msg(uint32_t ind) { return uintptr_cast(msg_header() + 1) + (ind * msg_size()); }
+    uint8_t const* nth_msg_const(uint32_t ind) const {
+        return r_cast< uint8_t const* >(msg_header_const() + 1) + (ind * msg_size());
+    }
+};
+} // namespace homestore
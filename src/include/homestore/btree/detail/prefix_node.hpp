@@ -19,6 +19,7 @@
 #include <sisl/fds/compact_bitset.hpp>
 #include <sisl/logging/logging.h>
 #include "btree_node.hpp"
+#include "btree_node_search.hpp"
 #include <homestore/btree/btree_kv.hpp>
 #include <homestore/index/index_internal.hpp>
 
@@ -311,6 +312,28 @@ public:
     }
 
     ///////////////////////////// All overrides of BtreeNode ///////////////////////////////////
+    std::pair< bool, uint32_t > bsearch_node(const BtreeKey& key) const override {
+        if constexpr (IntegralBtreeKey< K > && std::is_base_of_v< BtreeIntervalKey, K >) {
+            using T = typename K::integral_key_t;
+            uint32_t const sksize = suffix_entry::key_size();
+            DEBUG_ASSERT_EQ(prefix_entry::key_size() + sksize, sizeof(T),
+                            "Integral key size mismatch with its serialized prefix and suffix size");
+
+            // Rebuild the integral key from prefix and suffix area directly, instead of deserializing into K
+            return node_search::lower_bound(this->total_entries(), s_cast< K const& >(key).integral_key(),
+                                            [this, sksize](uint32_t i) {
+                                                suffix_entry const* sentry = get_suffix_entry_c(i);
+                                                prefix_entry const* pentry = get_prefix_entry_c(sentry->prefix_slot);
+                                                return T((node_search::load_uint(pentry->key_buf().cbytes(),
+                                                                                 prefix_entry::key_size())
+                                                          << (sksize * 8)) |
+                                                         node_search::load_uint(sentry->key_buf().cbytes(), sksize));
+                                            });
+        } else {
+            return BtreeNode::bsearch_node(key);
+        }
+    }
+
     void get_nth_key_internal(uint32_t idx, BtreeKey& out_key, bool) const override {
         suffix_entry const* sentry = get_suffix_entry_c(idx);
         prefix_entry const* pentry = get_prefix_entry_c(sentry->prefix_slot);
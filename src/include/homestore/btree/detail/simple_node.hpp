@@ -18,6 +18,7 @@
 #include <homestore/btree/btree_kv.hpp>
 #include <homestore/btree/detail/variant_node.hpp>
 #include <homestore/btree/detail/btree_internal.hpp>
+#include <homestore/btree/detail/btree_node_search.hpp>
 #include "homestore/index/index_internal.hpp"
 
 using namespace std;
@@ -182,8 +183,26 @@ public:
         return (this->node_data_size() - (this->total_entries() * get_nth_obj_size(0)));
     }
 
+    std::pair< bool, uint32_t > bsearch_node(const BtreeKey& key) const override {
+        if constexpr (IntegralBtreeKey< K > && !std::is_base_of_v< BtreeIntervalKey, K >) {
+            using T = typename K::integral_key_t;
+            DEBUG_ASSERT_EQ(get_nth_key_size(0), sizeof(T), "Integral key size mismatch with its serialized size");
+            uint8_t const* base = this->node_data_area_const();
+            uint32_t const stride = get_nth_obj_size(0);
+            return node_search::lower_bound(this->total_entries(), s_cast< K const& >(key).integral_key(),
+                                            [base, stride](uint32_t i) {
+                                                T k;
+                                                std::memcpy(&k, base + (i * stride), sizeof(T));
+                                                return k;
+                                            });
+        } else {
+            return BtreeNode::bsearch_node(key);
+        }
+    }
+
     void get_nth_key_internal(uint32_t ind, BtreeKey& out_key, bool copy) const override {
-        DEBUG_ASSERT_LT(ind, this->total_entries(), "node={}", to_string());
+        DEBUG_ASSERT(BtreeNode::in_optimistic_read() || (ind < this->total_entries()), "ind={} node={}", ind,
+                     to_string());
         sisl::blob b{this->node_data_area_const() + (get_nth_obj_size(ind) * ind), get_nth_key_size(ind)};
         out_key.deserialize(b, copy);
     }
@@ -191,7 +210,7 @@ public:
     void get_nth_value(uint32_t ind, BtreeValue* out_val, bool copy) const override {
         if (ind == this->total_entries()) {
             DEBUG_ASSERT_EQ(this->is_leaf(), false, "setting value outside bounds on leaf node");
-            DEBUG_ASSERT_EQ(this->has_valid_edge(), true, "node={}", to_string());
+            DEBUG_ASSERT(BtreeNode::in_optimistic_read() || this->has_valid_edge(), "node={}", to_string());
             *(BtreeLinkInfo*)out_val = this->get_edge_value();
         } else {
             sisl::blob b{const_cast< uint8_t* >(this->node_data_area_const() + (get_nth_obj_size(ind) * ind) +
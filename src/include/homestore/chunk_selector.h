@@ -26,6 +26,9 @@ public:
     virtual void foreach_chunks(std::function< void(cshared< Chunk >&) >&& cb) = 0;
     virtual cshared< Chunk > select_chunk(blk_count_t nblks, const blk_alloc_hints& hints) = 0;
 
+    // Called by vdev after blks are allocated from or freed to the chunk, for selectors which track free space
+    virtual void on_space_changed(const Chunk*){};
+
     virtual ~ChunkSelector() = default;
 };
 } // namespace homestore
@@ -12,5 +12,8 @@ uint16_t crc16_t10dif(uint16_t seed, const unsigned char* buf, uint64_t len);
 
 // crc32_ieee reference function, slow crc32 from the definition.
 uint32_t crc32_ieee(uint32_t seed, const unsigned char* buf, uint64_t len);
+
+// crc32c (castagnoli, same as used by iSCSI), uses the SSE4.2 crc32 instruction when cpu supports it.
+unsigned int crc32_iscsi(unsigned char* buffer, int len, unsigned int init_crc);
 }
 #endif
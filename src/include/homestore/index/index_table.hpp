@@ -145,6 +145,17 @@ public:
         return ret;
     }
 
+    /// @brief Build an empty index table from sorted key/values bottom up. Nodes are filled upto the ideal fill pct
+    /// of btree config and the entire load is done under one cp, so that it is either fully persisted or not at all.
+    btree_status_t bulk_load(bulk_load_cb_t< K, V > const& next_kv) {
+        if (is_stopping()) return btree_status_t::stopping;
+        incr_pending_request_num();
+        auto cpg = cp_mgr().cp_guard();
+        auto const ret = Btree< K, V >::bulk_load(next_kv, (void*)cpg.context(cp_consumer_t::INDEX_SVC));
+        decr_pending_request_num();
+        return ret;
+    }
+
     template < typename ReqT >
     btree_status_t get(ReqT& greq) const {
         if (is_stopping()) return btree_status_t::stopping;
@@ -275,17 +286,32 @@ protected:
 
     btree_status_t read_node_impl(bnodeid_t id, BtreeNodePtr& node) const override {
         try {
-            wb_cache().read_buf(id, node, [this](const IndexBufferPtr& idx_buf) mutable -> BtreeNodePtr {
-                bool is_leaf = BtreeNode::identify_leaf_node(idx_buf->raw_buffer());
-                BtreeNode* n = this->init_node(idx_buf->raw_buffer(), idx_buf->blkid().to_integer(),
-                                               false /* init_buf */, is_leaf);
-                static_cast< IndexBtreeNode* >(n)->attach_buf(idx_buf);
-                return BtreeNodePtr{n};
-            });
+            wb_cache().read_buf(id, node, [this](const IndexBufferPtr& idx_buf) { return node_from_buf(idx_buf); });
             return btree_status_t::success;
         } catch (std::exception& e) { return btree_status_t::node_read_failed; }
     }
 
+    void prefetch_nodes_impl(std::vector< bnodeid_t > const& ids) const override {
+        wb_cache().prefetch_bufs(ids, [this](const IndexBufferPtr& idx_buf) { return node_from_buf(idx_buf); });
+    }
+
+    // Freed nodes are removed from the cache while their parent is write locked, so a node found in the cache was
+    // linked at the time of lookup
+    bool get_resident_node_impl(bnodeid_t id, BtreeNodePtr& node) const override {
+        return wb_cache().get_cached_node(id, node);
+    }
+
+    uint64_t enter_optimistic_read() const override { return wb_cache().enter_optimistic_read(); }
+    void exit_optimistic_read(uint64_t epoch) const override { wb_cache().exit_optimistic_read(epoch); }
+
+    BtreeNodePtr node_from_buf(const IndexBufferPtr& idx_buf) const {
+        bool is_leaf = BtreeNode::identify_leaf_node(idx_buf->raw_buffer());
+        BtreeNode* n =
+            this->init_node(idx_buf->raw_buffer(), idx_buf->blkid().to_integer(), false /* init_buf */, is_leaf);
+        static_cast< IndexBtreeNode* >(n)->attach_buf(idx_buf);
+        return BtreeNodePtr{n};
+    }
+
     btree_status_t refresh_node(const BtreeNodePtr& node, bool for_read_modify_write, void* context) const override {
         if (context == nullptr || !for_read_modify_write) { return btree_status_t::success; }
         return wb_cache().get_writable_buf(node, r_cast< CPContext* >(context)) ? btree_status_t::success
@@ -314,6 +340,16 @@ protected:
         return btree_status_t::success;
     }
 
+    btree_status_t flush_buffers_for_read(BtreeKeyRange< K > const& range) override {
+        auto ret = btree_status_t::success;
+        do {
+            auto cpg = cp_mgr().cp_guard();
+            ret = this->flush_buffers(range, (void*)cpg.context(cp_consumer_t::INDEX_SVC));
+            if (ret == btree_status_t::cp_mismatch) { LOGTRACEMOD(wbcache, "CP Mismatch, retrying buffer flush"); }
+        } while (ret == btree_status_t::cp_mismatch);
+        return ret;
+    }
+
     btree_status_t repair_links(BtreeNodePtr const& parent_node, void* cp_ctx) {
         BT_LOG(DEBUG, "Repairing links for parent node [{}]", parent_node->to_string());
         // TODO: is it possible that repairing many nodes causes an increase to level of btree? If so, then this needs
@@ -349,7 +385,7 @@ protected:
 
         // Keep a copy of the node buffer, in case we need to revert back
         uint8_t* tmp_buffer = new uint8_t[this->m_node_size];
-        std::memcpy(tmp_buffer, parent_node->m_phys_node_buf, this->m_node_size);
+        std::memcpy(tmp_buffer, parent_node->phys_buf(), this->m_node_size);
 
         // Remove all the entries in parent_node and let walk across child_nodes rebuild this node
         parent_node->remove_all(this->m_bt_cfg);
@@ -477,7 +513,7 @@ protected:
         if (ret != btree_status_t::success) {
             BT_LOG(ERROR, "An error occurred status={} during repair of parent_node={}, aborting the repair",
                    enum_name(ret), parent_node->node_id());
-            std::memcpy(parent_node->m_phys_node_buf, tmp_buffer, this->m_bt_cfg.node_size());
+            std::memcpy(parent_node->phys_buf(), tmp_buffer, this->m_bt_cfg.node_size());
         }
 
         delete[] tmp_buffer;
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <boost/intrusive_ptr.hpp>
 #include <sisl/utility/atomic_counter.hpp>
 #include <homestore/blk.h>
@@ -47,6 +48,24 @@ public:
 
     virtual void read_buf(bnodeid_t id, BtreeNodePtr& node, node_initializer_t&& node_initializer) = 0;
 
+    /// @brief Start reading the nodes into the cache, without waiting for them. Subsequent read_buf on these ids
+    /// either find them in cache or join the read in flight.
+    /// @param ids List of node ids to read ahead
+    /// @param node_initializer Callback to be called upon which buffer is turned into btree node
+    virtual void prefetch_bufs(std::vector< bnodeid_t > const& ids, node_initializer_t const& node_initializer) {}
+
+    /// @brief Get the node only if it is already in the cache, without reading it from the device
+    /// @param id Node id to look up
+    /// @param node [out] Node found in the cache
+    /// @return true if the node is found in the cache
+    virtual bool get_cached_node(bnodeid_t id, BtreeNodePtr& node) { return false; }
+
+    /// @brief Enter the section where node buffers are read without holding the node lock. Buffers replaced while in
+    /// it are not freed until the section is exited.
+    /// @return Epoch which is to be passed to exit_optimistic_read
+    virtual uint64_t enter_optimistic_read() { return 0; }
+    virtual void exit_optimistic_read(uint64_t epoch) {}
+
     virtual bool get_writable_buf(const BtreeNodePtr& node, CPContext* context) = 0;
 
     virtual bool refresh_meta_buf(shared< MetaIndexBuffer >& meta_buf, CPContext* cp_ctx) = 0;
@@ -62,6 +62,9 @@ public:
      * @brief Register callback upon a new log entry is found during recovery. Failing to register for log_found
      * callback is ok as long as log entries are not required to replayed during recovery.
      *
+     * Callback could be called concurrently with the callbacks of log stores on other logdevs, since logdevs are
+     * recovered in parallel. See LogStoreService::open_log_store for the concurrency contract.
+     *
      * @param cb
      */
     void register_log_found_cb(const log_found_cb_t& cb) { m_found_cb = cb; }
@@ -70,6 +73,9 @@ public:
      * @brief Register callback to indicate the replay is done during recovery. Failing to register for log_replay
      * callback is ok as long as user of the log store knows when all logs are replayed.
      *
+     * Callback could be called concurrently with the callbacks of log stores on other logdevs, since logdevs are
+     * recovered in parallel. See LogStoreService::open_log_store for the concurrency contract.
+     *
      * @param cb
      */
     void register_log_replay_done_cb(const log_replay_done_cb_t& cb) { m_replay_done_cb = cb; }
@@ -126,10 +126,20 @@ public:
     /**
      * @brief Open an existing log store and does a recovery. It then creates an instance of this logstore and
      * returns
+     *
+     * Concurrency contract of the recovery callbacks: Logdevs are recovered in parallel (upto
+     * logstore.recovery_max_parallel_logdevs at a time), so the continuation of the returned future, log_found_cb and
+     * log_replay_done_cb of log stores on different logdevs could be called concurrently from different fibers.
+     * Callbacks of all the log stores within a logdev are called from a single fiber, one after the other, and for a
+     * given log store the order is: future is fulfilled, log_found_cb for each log in the order of the log idx and
+     * then log_replay_done_cb. Callers sharing any state across log stores of different logdevs in these callbacks
+     * have to synchronize it themselves, or set recovery_max_parallel_logdevs to 1.
+     *
      * @param logdev_id: Logdev ID of the log store to close
      * @param store_id: Store ID of the log store to open
      * @param append_mode: Append or not.
-     * @param on_open_cb: Callback to be called once log store is opened.
+     * @param log_found_cb: Callback to be called for every log found for this store during recovery.
+     * @param log_replay_done_cb: Callback to be called once all logs of this store are replayed.
      * @return std::shared_ptr< HomeLogStore >
      */
     folly::Future< shared< HomeLogStore > > open_log_store(logdev_id_t logdev_id, logstore_id_t store_id,
@@ -184,6 +194,7 @@ private:
     void logdev_super_blk_found(const sisl::byte_view& buf, void* meta_cookie);
     void rollback_super_blk_found(const sisl::byte_view& buf, void* meta_cookie);
     void start_threads();
+    void start_logdevs_parallel(bool format, uint32_t max_parallel);
     void flush();
 
 private:
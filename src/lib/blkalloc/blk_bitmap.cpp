@@ -0,0 +1,206 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+#include <fmt/format.h>
+
+#include "common/homestore_assert.hpp"
+#include "blk_bitmap.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HS_BLKALLOC_SIMD_SEARCH 1
+#endif
+
+namespace homestore {
+static constexpr uint64_t all_set_word{std::numeric_limits< uint64_t >::max()};
+
+// Index of the first word in [0, n) which is not same as pattern, n if all of them are same.
+static uint64_t find_first_word_not_scalar(uint64_t const* words, uint64_t n, uint64_t pattern) {
+    uint64_t i{0};
+    // Or-ing the difference of 4 words at a time lets compiler keep the loop branch light on long uniform stretches
+    for (; i + 4 <= n; i += 4) {
+        if (((words[i] ^ pattern) | (words[i + 1] ^ pattern) | (words[i + 2] ^ pattern) | (words[i + 3] ^ pattern)) !=
+            0) {
+            break;
+        }
+    }
+    for (; i < n; ++i) {
+        if (words[i] != pattern) { break; }
+    }
+    return i;
+}
+
+#ifdef HS_BLKALLOC_SIMD_SEARCH
+// Compares 8 words (512 bits) per iteration, which is one bitmap cache line
+__attribute__((target("avx2"))) static uint64_t find_first_word_not_avx2(uint64_t const* words, uint64_t n,
+                                                                         uint64_t pattern) {
+    auto const pat = _mm256_set1_epi64x(int64_t(pattern));
+    uint64_t i{0};
+    for (; i + 8 <= n; i += 8) {
+        auto const eq0 = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(words + i)), pat);
+        auto const eq1 =
+            _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(words + i + 4)), pat);
+        auto const mask0 = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(eq0)));
+        auto const mask1 = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(eq1)));
+        auto const mask = mask0 | (mask1 << 4);
+        if (mask != 0xFF) { return i + std::countr_one(mask); }
+    }
+    return i + find_first_word_not_scalar(words + i, n - i, pattern);
+}
+#endif
+
+static bitmap_search_isa_t& current_isa_ref() {
+    static bitmap_search_isa_t s_isa{BlkBitmap::detect_isa()};
+    return s_isa;
+}
+
+static uint64_t find_first_word_not(uint64_t const* words, uint64_t n, uint64_t pattern) {
+#ifdef HS_BLKALLOC_SIMD_SEARCH
+    if (current_isa_ref() == bitmap_search_isa_t::AVX2) { return find_first_word_not_avx2(words, n, pattern); }
+#endif
+    return find_first_word_not_scalar(words, n, pattern);
+}
+
+bitmap_search_isa_t BlkBitmap::detect_isa() {
+#ifdef HS_BLKALLOC_SIMD_SEARCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return bitmap_search_isa_t::AVX2; }
+#endif
+    return bitmap_search_isa_t::SCALAR;
+}
+
+bitmap_search_isa_t BlkBitmap::current_isa() { return current_isa_ref(); }
+
+bitmap_search_isa_t BlkBitmap::set_isa(bitmap_search_isa_t isa) {
+    auto const supported = detect_isa();
+    current_isa_ref() = (uint8_t(isa) > uint8_t(supported)) ? supported : isa;
+    return current_isa_ref();
+}
+
+BlkBitmap::BlkBitmap(blk_num_t nbits) :
+        m_nbits{nbits},
+        m_nwords{(uint64_t{nbits} + bits_per_word - 1) / bits_per_word},
+        m_words{new uint64_t[m_nwords]} {
+    std::memset(m_words.get(), 0, m_nwords * sizeof(uint64_t));
+
+    // Bits beyond the end are marked set, so that they never show up as free
+    if (auto const tail = m_nbits % bits_per_word; tail != 0) { m_words[m_nwords - 1] = (all_set_word << tail); }
+}
+
+void BlkBitmap::copy(sisl::Bitset const& other) {
+    HS_REL_ASSERT_EQ(other.size(), m_nbits, "Bitmap copy requires bitset of same size");
+
+    // Bitset does not expose its words, so start fully set and clear the free runs found in it.
+    std::fill_n(m_words.get(), m_nwords, all_set_word);
+    blk_num_t cur{0};
+    while (cur < m_nbits) {
+        auto const b = other.get_next_contiguous_n_reset_bits(cur, m_nbits - 1, 1, m_nbits - cur);
+        if (b.nbits == 0) { break; }
+        reset_bits(b.start_bit, b.nbits);
+        cur = b.start_bit + b.nbits;
+    }
+}
+
+void BlkBitmap::set_bits(blk_num_t start, blk_num_t nbits) { modify_bits(start, nbits, true); }
+void BlkBitmap::reset_bits(blk_num_t start, blk_num_t nbits) { modify_bits(start, nbits, false); }
+bool BlkBitmap::is_bits_set(blk_num_t start, blk_num_t nbits) const { return check_bits(start, nbits, true); }
+bool BlkBitmap::is_bits_reset(blk_num_t start, blk_num_t nbits) const { return check_bits(start, nbits, false); }
+
+void BlkBitmap::modify_bits(blk_num_t start, blk_num_t nbits, bool set) {
+    HS_DBG_ASSERT_LE(uint64_t{start} + nbits, m_nbits, "Bit range beyond bitmap size");
+    uint64_t cur{start};
+    uint64_t const end{uint64_t{start} + nbits};
+    while (cur < end) {
+        auto const w = cur / bits_per_word;
+        auto const off = cur % bits_per_word;
+        auto const n = std::min< uint64_t >(bits_per_word - off, end - cur);
+        auto const mask = (n == bits_per_word) ? all_set_word : (((uint64_t{1} << n) - 1) << off);
+        if (set) {
+            m_words[w] |= mask;
+        } else {
+            m_words[w] &= ~mask;
+        }
+        cur += n;
+    }
+}
+
+bool BlkBitmap::check_bits(blk_num_t start, blk_num_t nbits, bool set) const {
+    HS_DBG_ASSERT_LE(uint64_t{start} + nbits, m_nbits, "Bit range beyond bitmap size");
+    uint64_t cur{start};
+    uint64_t const end{uint64_t{start} + nbits};
+    while (cur < end) {
+        auto const w = cur / bits_per_word;
+        auto const off = cur % bits_per_word;
+        auto const n = std::min< uint64_t >(bits_per_word - off, end - cur);
+        auto const mask = (n == bits_per_word) ? all_set_word : (((uint64_t{1} << n) - 1) << off);
+        if ((m_words[w] & mask) != (set ? mask : 0)) { return false; }
+        cur += n;
+    }
+    return true;
+}
+
+// Position of the first bit in [start, end) whose value is same as set, end if there is none
+blk_num_t BlkBitmap::next_bit(blk_num_t start, blk_num_t end, bool set) const {
+    if (start >= end) { return end; }
+
+    auto w = start / bits_per_word;
+    auto v = (set ? m_words[w] : ~m_words[w]) & (all_set_word << (start % bits_per_word));
+    if (v == 0) {
+        // Skip all the words which has no bit of interest in one go.
+        auto const last_word = (uint64_t{end} + bits_per_word - 1) / bits_per_word;
+        ++w;
+        w += find_first_word_not(&m_words[w], last_word - w, set ? 0 : all_set_word);
+        if (w >= last_word) { return end; }
+        v = set ? m_words[w] : ~m_words[w];
+    }
+    return std::min(blk_num_t(w * bits_per_word + std::countr_zero(v)), end);
+}
+
+BlkBitmap::bit_run BlkBitmap::get_next_contiguous_n_reset_bits(blk_num_t start, blk_num_t end, blk_num_t min_nbits,
+                                                               blk_num_t max_nbits) const {
+    auto const end_excl = blk_num_t(std::min< uint64_t >(uint64_t{end} + 1, m_nbits));
+    min_nbits = std::max(min_nbits, blk_num_t{1});
+    max_nbits = std::max(max_nbits, min_nbits);
+
+    blk_num_t cur{start};
+    while (cur < end_excl) {
+        auto const run_start = next_bit(cur, end_excl, false /* set */);
+        if (end_excl - run_start < min_nbits) { break; }
+
+        auto const run_end =
+            next_bit(run_start, blk_num_t(std::min< uint64_t >(uint64_t{run_start} + max_nbits, end_excl)), true);
+        if (run_end - run_start >= min_nbits) { return bit_run{run_start, run_end - run_start}; }
+        cur = run_end;
+    }
+    return bit_run{start, 0};
+}
+
+blk_num_t BlkBitmap::get_set_count() const {
+    uint64_t cnt{0};
+    for (uint64_t w{0}; w < m_nwords; ++w) {
+        cnt += std::popcount(m_words[w]);
+    }
+    // Discount the padding bits of the last word, which are always set
+    return blk_num_t(cnt - (m_nwords * bits_per_word - m_nbits));
+}
+
+std::string BlkBitmap::to_string() const {
+    return fmt::format("nbits={} set_count={} isa={}", m_nbits, get_set_count(), enum_name(current_isa()));
+}
+} // namespace homestore
@@ -0,0 +1,89 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <sisl/fds/bitset.hpp>
+#include <sisl/utility/enum.hpp>
+
+#include <homestore/blk.h>
+
+namespace homestore {
+
+// Instruction set used to skip over the words of the bitmap while searching for runs. It is detected once at runtime,
+// so that binary built without -mavx2 still picks the vectorized path on capable hosts.
+ENUM(bitmap_search_isa_t, uint8_t, SCALAR, AVX2)
+
+/* In-memory bitmap of the blks (set means allocated) used by the blk allocators to search for free runs.
+ *
+ * Search for a run of reset bits skips over fully set words (while looking for start of run) and fully reset words
+ * (while looking for end of run) several words at a time using vector compares, and resolves the boundary word with
+ * bit scan instructions, rather than testing bit by bit. Bitmap is not thread safe, callers are expected to serialize
+ * the access to a range of bits (say by portion lock), with ranges aligned to word boundary.
+ */
+class BlkBitmap {
+public:
+    static constexpr uint32_t bits_per_word{64};
+
+    struct bit_run {
+        blk_num_t start_bit{0};
+        blk_num_t nbits{0};
+    };
+
+    explicit BlkBitmap(blk_num_t nbits);
+    BlkBitmap(BlkBitmap const&) = delete;
+    BlkBitmap(BlkBitmap&&) noexcept = delete;
+    BlkBitmap& operator=(BlkBitmap const&) = delete;
+    BlkBitmap& operator=(BlkBitmap&&) noexcept = delete;
+    ~BlkBitmap() = default;
+
+    /// @brief Copy the state of the given bitset (typically the disk bitmap) of same size into this bitmap
+    void copy(sisl::Bitset const& other);
+
+    void set_bits(blk_num_t start, blk_num_t nbits);
+    void reset_bits(blk_num_t start, blk_num_t nbits);
+    bool is_bits_set(blk_num_t start, blk_num_t nbits) const;
+    bool is_bits_reset(blk_num_t start, blk_num_t nbits) const;
+
+    /// @brief Find the first run of reset bits within [start, end] which has at least min_nbits
+    /// @return Start and size of the run, which is capped at max_nbits. nbits is 0, if there is no such run
+    bit_run get_next_contiguous_n_reset_bits(blk_num_t start, blk_num_t end, blk_num_t min_nbits,
+                                             blk_num_t max_nbits) const;
+
+    blk_num_t get_set_count() const;
+    blk_num_t nbits() const { return m_nbits; }
+    uint64_t size() const { return m_nwords * sizeof(uint64_t); }
+    uint32_t word_size() const { return bits_per_word; }
+    std::string to_string() const;
+
+    static bitmap_search_isa_t detect_isa();
+    static bitmap_search_isa_t current_isa();
+    // Override the detected isa (primarily for benchmarks and tests). Requests beyond what cpu supports are clamped.
+    static bitmap_search_isa_t set_isa(bitmap_search_isa_t isa);
+
+private:
+    blk_num_t next_bit(blk_num_t start, blk_num_t end, bool set) const;
+    void modify_bits(blk_num_t start, blk_num_t nbits, bool set);
+    bool check_bits(blk_num_t start, blk_num_t nbits, bool set) const;
+
+private:
+    blk_num_t m_nbits;
+    uint64_t m_nwords;
+    std::unique_ptr< uint64_t[] > m_words;
+};
+} // namespace homestore
@@ -13,6 +13,8 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <iomgr/iomgr_flip.hpp>
 
@@ -21,33 +23,124 @@
 
 namespace homestore {
 FixedBlkAllocator::FixedBlkAllocator(BlkAllocConfig const& cfg, bool is_fresh, chunk_num_t chunk_id) :
-        BitmapBlkAllocator(cfg, is_fresh, chunk_id), m_free_blk_q{get_total_blks()} {
+        BitmapBlkAllocator(cfg, is_fresh, chunk_id) {
+    HS_REL_ASSERT_EQ(get_blks_per_portion() % bits_per_word, 0, "Portions are expected to be word aligned");
+    m_num_words = sisl::round_up(get_total_blks(), bits_per_word) / bits_per_word;
+    m_num_summary_words = sisl::round_up(m_num_words, bits_per_word) / bits_per_word;
+    m_free_words = std::make_unique< std::atomic< uint64_t >[] >(m_num_words);
+    m_summary_words = std::make_unique< std::atomic< uint64_t >[] >(m_num_summary_words);
+    m_portion_ready = std::make_unique< std::atomic< bool >[] >(get_num_portions());
+
+    // Spread the cursors across the device, so that threads start allocating from different words
+    m_num_cursors = std::clamp(std::thread::hardware_concurrency(), 1u, max_alloc_cursors);
+    m_cursors = std::make_unique< alloc_cursor[] >(m_num_cursors);
+    for (uint32_t i{0}; i < m_num_cursors; ++i) {
+        m_cursors[i].word_idx.store((m_num_words * i) / m_num_cursors, std::memory_order_relaxed);
+    }
+
     if (is_fresh || !is_persistent()) { load(); }
 }
 
 void FixedBlkAllocator::load() {
-    blk_num_t blk_num{0};
-    while (blk_num < get_total_blks()) {
-        blk_num = init_portion(blknum_to_portion(blk_num), blk_num);
+    for (uint64_t w{0}; w < m_num_words; ++w) {
+        m_free_words[w].store(0, std::memory_order_relaxed);
+    }
+
+    // All words are hinted to have free blks, so that the portions yet to be initialized are visited by alloc
+    for (uint64_t s{0}; s < m_num_summary_words; ++s) {
+        auto const nwords = std::min(uint64_cast(bits_per_word), m_num_words - (s * bits_per_word));
+        m_summary_words[s].store((nwords == bits_per_word) ? ~0ull : ((1ull << nwords) - 1), std::memory_order_relaxed);
     }
+
+    for (blk_num_t p{0}; p < get_num_portions(); ++p) {
+        m_portion_ready[p].store(false, std::memory_order_relaxed);
+    }
+    m_uninit_portions.store(get_num_portions(), std::memory_order_relaxed);
+    m_free_count.store(0, std::memory_order_relaxed);
+    auto const alloced_on_disk = is_persistent() ? get_alloced_blk_count() : 0;
+    m_uninit_free_estimate.store(static_cast< int64_t >(get_total_blks()) - alloced_on_disk, std::memory_order_release);
+}
+
+void FixedBlkAllocator::ensure_portion_ready(blk_num_t portion_num) {
+    if (!m_portion_ready[portion_num].load(std::memory_order_acquire)) { init_portion(portion_num); }
 }
 
-blk_num_t FixedBlkAllocator::init_portion(BlkAllocPortion& portion, blk_num_t start_blk_num) {
+void FixedBlkAllocator::init_portion(blk_num_t portion_num) {
+    BlkAllocPortion& portion = get_blk_portion(portion_num);
     auto lock{portion.portion_auto_lock()};
+    if (m_portion_ready[portion_num].load(std::memory_order_acquire)) { return; }
+
+    blk_num_t const start_blk_num = portion_num * get_blks_per_portion();
+    blk_num_t const end_blk_num = std::min(start_blk_num + get_blks_per_portion(), get_total_blks());
+    blk_num_t nfree{0};
+    if (!is_persistent()) {
+        set_free_bits(start_blk_num, end_blk_num - start_blk_num);
+        nfree = end_blk_num - start_blk_num;
+    } else {
+        auto cur_blk_num = start_blk_num;
+        while (cur_blk_num < end_blk_num) {
+            auto const b = get_disk_bitmap()->get_next_contiguous_n_reset_bits(cur_blk_num, end_blk_num - 1, 1,
+                                                                               end_blk_num - cur_blk_num);
+            if (b.nbits == 0) { break; }
+            set_free_bits(b.start_bit, b.nbits);
+            nfree += b.nbits;
+            cur_blk_num = b.start_bit + b.nbits;
+        }
+    }
 
+    m_free_count.fetch_add(nfree, std::memory_order_acq_rel);
+    m_portion_ready[portion_num].store(true, std::memory_order_release);
+    if (m_uninit_portions.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Disk bitmap could have changed since load, so estimate is not exact. Once everything is initialized, free
+        // count is all we need.
+        m_uninit_free_estimate.store(0, std::memory_order_release);
+    } else {
+        m_uninit_free_estimate.fetch_sub(nfree, std::memory_order_acq_rel);
+    }
+    BLKALLOC_LOG(DEBUG, "Initialized portion={} with free blks={} chunk number {}", portion_num, nfree, m_chunk_id);
+}
+
+void FixedBlkAllocator::set_free_bits(blk_num_t start_blk_num, blk_num_t nblks) {
     auto blk_num = start_blk_num;
-    while (blk_num < get_total_blks()) {
-        BlkAllocPortion& cur_portion = blknum_to_portion(blk_num);
-        if (portion.get_portion_num() != cur_portion.get_portion_num()) break;
+    auto const end_blk_num = start_blk_num + nblks;
+    while (blk_num < end_blk_num) {
+        auto const w = blk_num / bits_per_word;
+        auto const bit = blk_num % bits_per_word;
+        auto const n = std::min(bits_per_word - bit, end_blk_num - blk_num);
+        auto const mask = (n == bits_per_word) ? ~0ull : (((1ull << n) - 1) << bit);
+        m_free_words[w].fetch_or(mask, std::memory_order_acq_rel);
+        m_summary_words[w / bits_per_word].fetch_or(1ull << (w % bits_per_word), std::memory_order_acq_rel);
+        blk_num += n;
+    }
+}
 
-        if (!is_persistent() || get_disk_bitmap()->is_bits_reset(blk_num, 1)) {
-            const auto pushed = m_free_blk_q.write(blk_num);
-            HS_DBG_ASSERT_EQ(pushed, true, "Expected to be able to push the blk on fixed capacity Q");
+FixedBlkAllocator::alloc_cursor& FixedBlkAllocator::my_cursor() {
+    static std::atomic< uint32_t > s_next_thread_idx{0};
+    static thread_local uint32_t t_thread_idx{s_next_thread_idx.fetch_add(1, std::memory_order_relaxed)};
+    return m_cursors[t_thread_idx % m_num_cursors];
+}
+
+bool FixedBlkAllocator::try_alloc_in_word(uint64_t word_idx, blk_num_t& out_blk_num) {
+    ensure_portion_ready(blknum_to_portion_num(blk_num_t(word_idx * bits_per_word)));
+
+    auto& word = m_free_words[word_idx];
+    auto bits = word.load(std::memory_order_acquire);
+    while (bits != 0) {
+        auto const bit = std::countr_zero(bits);
+        if (word.compare_exchange_weak(bits, bits & ~(1ull << bit), std::memory_order_acq_rel)) {
+            m_free_count.fetch_sub(1, std::memory_order_acq_rel);
+            out_blk_num = blk_num_t(word_idx * bits_per_word + bit);
+            return true;
         }
-        ++blk_num;
     }
 
-    return blk_num;
+    // Word is fully allocated, clear the hint. If a free has raced in between, restore it, since free sets the word
+    // before the hint.
+    auto& summary = m_summary_words[word_idx / bits_per_word];
+    auto const sbit = 1ull << (word_idx % bits_per_word);
+    summary.fetch_and(~sbit, std::memory_order_acq_rel);
+    if (word.load(std::memory_order_acquire) != 0) { summary.fetch_or(sbit, std::memory_order_acq_rel); }
+    return false;
 }
 
 bool FixedBlkAllocator::is_blk_alloced(BlkId const& b, bool use_lock) const { return true; }
@@ -56,67 +149,66 @@ BlkAllocStatus FixedBlkAllocator::alloc([[maybe_unused]] blk_count_t nblks, blk_
 #ifdef _PRERELEASE
     if (iomgr_flip::instance()->test_flip("fixed_blkalloc_no_blks")) { return BlkAllocStatus::SPACE_FULL; }
 #endif
-retry:
-    blk_num_t blk_num;
-    if (!m_free_blk_q.read(blk_num)) { return BlkAllocStatus::SPACE_FULL; }
-
-    if (m_state != state_t::ACTIVE) {
-        // We are not in active state, means we must be recovering. During recovery state, if any of the blks which are
-        // committed, we shouldn't be allocating those blocks. So remove from free blk q and retry another blk
-        std::lock_guard lg(m_reserve_blk_mtx);
-        if ((m_state == state_t::RECOVERING) && (m_reserved_blks.find(blk_num) != m_reserved_blks.end())) {
-            m_reserved_blks.erase(blk_num); // This blk can be removed from reserved, because its no longer free (since
-                                            // we also removed from free_blk q)
-            goto retry;
+    if (available_blks() == 0) { return BlkAllocStatus::SPACE_FULL; }
+
+    // Walk the summary from the cursor (wrapping around the end) once, skipping the words hinted to have no free blks.
+    auto& cursor = my_cursor();
+    uint64_t const nslots = m_num_summary_words * bits_per_word;
+    uint64_t w = cursor.word_idx.load(std::memory_order_relaxed);
+    uint64_t scanned{0};
+    while (scanned < nslots) {
+        auto const sbits = m_summary_words[w / bits_per_word].load(std::memory_order_acquire) >> (w % bits_per_word);
+        uint64_t const skip = (sbits == 0) ? (bits_per_word - (w % bits_per_word)) : std::countr_zero(sbits);
+        w += skip;
+        scanned += skip;
+        if (sbits != 0) {
+            blk_num_t blk_num;
+            if (try_alloc_in_word(w, blk_num)) {
+                cursor.word_idx.store(w, std::memory_order_relaxed);
+                out_blkid = BlkId{blk_num, 1, m_chunk_id};
+                return BlkAllocStatus::SUCCESS;
+            }
+            ++w;
+            ++scanned;
         }
+        if (w >= nslots) { w = 0; }
     }
-    out_blkid = BlkId{blk_num, 1, m_chunk_id};
-    return BlkAllocStatus::SUCCESS;
+    return BlkAllocStatus::SPACE_FULL;
 }
 
 BlkAllocStatus FixedBlkAllocator::alloc_contiguous(BlkId& out_blkid) { return alloc(1, {}, out_blkid); }
 
 BlkAllocStatus FixedBlkAllocator::reserve_on_cache(BlkId const& b) {
-    std::lock_guard lg(m_reserve_blk_mtx);
-    if (m_state == state_t::RECOVERING) { m_reserved_blks.insert(b.blk_num()); }
+    // During recovery state, blks which are committed shouldn't be allocated. Mark them as allocated right away.
+    if (m_state.load(std::memory_order_acquire) == state_t::RECOVERING) {
+        ensure_portion_ready(blknum_to_portion_num(b.blk_num()));
+        auto const mask = 1ull << (b.blk_num() % bits_per_word);
+        auto const prev = m_free_words[b.blk_num() / bits_per_word].fetch_and(~mask, std::memory_order_acq_rel);
+        if (prev & mask) { m_free_count.fetch_sub(1, std::memory_order_acq_rel); }
+    }
     return BlkAllocStatus::SUCCESS;
 }
 
-void FixedBlkAllocator::recovery_completed() {
-    std::lock_guard lg(m_reserve_blk_mtx);
-    if (!m_reserved_blks.empty()) {
-        auto const count = available_blks();
-        for (uint64_t i{0}; ((i < count) && !m_reserved_blks.empty()); ++i) {
-            blk_num_t blk_num;
-            if (!m_free_blk_q.read(blk_num)) { break; }
-
-            if (m_reserved_blks.find(blk_num) == m_reserved_blks.end()) {
-                m_free_blk_q.write(blk_num); // This blk is not marked, put it back at the end of queue
-            }
-        }
-        // We no longer need any reserved blks, since all of them are now marked as allocated
-        m_reserved_blks.clear();
-    }
-    m_state = state_t::ACTIVE;
-}
+void FixedBlkAllocator::recovery_completed() { m_state.store(state_t::ACTIVE, std::memory_order_release); }
 
 void FixedBlkAllocator::free(BlkId const& b) {
     HS_DBG_ASSERT_EQ(b.blk_count(), 1, "Multiple blk free for FixedBlkAllocator? allocated by different allocator?");
 
-    const auto pushed = m_free_blk_q.write(b.blk_num());
-    HS_DBG_ASSERT_EQ(pushed, true, "Expected to be able to push the blk on fixed capacity Q");
+    ensure_portion_ready(blknum_to_portion_num(b.blk_num()));
+    auto const w = b.blk_num() / bits_per_word;
+    auto const mask = 1ull << (b.blk_num() % bits_per_word);
+    [[maybe_unused]] auto const prev = m_free_words[w].fetch_or(mask, std::memory_order_acq_rel);
+    HS_DBG_ASSERT_EQ((prev & mask), 0, "Freeing blk={} which is already free", b.blk_num());
+    m_free_count.fetch_add(1, std::memory_order_acq_rel);
+    m_summary_words[w / bits_per_word].fetch_or(1ull << (w % bits_per_word), std::memory_order_acq_rel);
 
-    if (m_state != state_t::ACTIVE) {
-        std::lock_guard lg(m_reserve_blk_mtx);
-        if (m_state == state_t::RECOVERING) {
-            // If we are in recovering state and freeing blk would removed it from being reserved as well.
-            m_reserved_blks.erase(b.blk_num());
-        }
-    }
     if (is_persistent()) { free_on_disk(b); }
 }
 
-blk_num_t FixedBlkAllocator::available_blks() const { return m_free_blk_q.sizeGuess(); }
+blk_num_t FixedBlkAllocator::available_blks() const {
+    return blk_num_t(std::max(m_free_count.load(std::memory_order_acquire), int64_t{0}) +
+                     std::max(m_uninit_free_estimate.load(std::memory_order_acquire), int64_t{0}));
+}
 
 blk_num_t FixedBlkAllocator::get_defrag_nblks() const {
     // TODO: implement this
@@ -127,6 +219,8 @@ blk_num_t FixedBlkAllocator::get_defrag_nblks() const {
 blk_num_t FixedBlkAllocator::get_used_blks() const { return get_total_blks() - available_blks(); }
 
 std::string FixedBlkAllocator::to_string() const {
-    return fmt::format("Total Blks={} Available_Blks={}", get_total_blks(), available_blks());
+    return fmt::format("Total Blks={} Available_Blks={} Uninitialized_Portions={} Free_Bitmap_Size={}",
+                       get_total_blks(), available_blks(), m_uninit_portions.load(std::memory_order_relaxed),
+                       in_bytes((m_num_words + m_num_summary_words) * sizeof(uint64_t)));
 }
 } // namespace homestore
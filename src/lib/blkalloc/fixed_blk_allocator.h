@@ -17,9 +17,15 @@
 #include "bitmap_blk_allocator.h"
 
 namespace homestore {
-/* FixedBlkAllocator is a fast allocator where it allocates only 1 size block and ALL free blocks are cached instead
- * of selectively caching few blks which are free. Thus there is no sweeping of bitmap or other to refill the cache.
- * It does not support temperature of blocks and allocates simply on first come first serve basis
+/* FixedBlkAllocator is a fast allocator where it allocates only 1 size block and ALL free blocks are tracked in memory
+ * instead of selectively caching few blks which are free. Thus there is no sweeping of bitmap or other to refill the
+ * cache. It does not support temperature of blocks.
+ *
+ * Free blks are kept in a lock-free bitmap (1 bit per blk, set means free), with a summary level having 1 bit per word
+ * of the bitmap hinting that the word might have free blks, so that a mostly allocated device is skipped over 64 words
+ * at a time. Each thread allocates starting from its own cursor, spread across the device, to avoid contention on the
+ * same words. Portions of the bitmap are initialized from the disk bitmap lazily, when they are first touched, so the
+ * allocator is usable immediately after load.
  */
 class FixedBlkAllocator : public BitmapBlkAllocator {
 public:
@@ -46,14 +52,33 @@ public:
     std::string to_string() const override;
 
 private:
-    blk_num_t init_portion(BlkAllocPortion& portion, blk_num_t start_blk_num);
+    static constexpr uint32_t bits_per_word{64};
+    static constexpr uint32_t max_alloc_cursors{64};
+
+    struct alignas(64) alloc_cursor {
+        std::atomic< uint64_t > word_idx{0};
+    };
+
+    void ensure_portion_ready(blk_num_t portion_num);
+    void init_portion(blk_num_t portion_num);
+    void set_free_bits(blk_num_t start_blk_num, blk_num_t nblks);
+    bool try_alloc_in_word(uint64_t word_idx, blk_num_t& out_blk_num);
+    alloc_cursor& my_cursor();
 
 private:
     enum class state_t : uint8_t { RECOVERING, ACTIVE };
 
-    state_t m_state{state_t::RECOVERING};
-    std::unordered_set< blk_num_t > m_reserved_blks; // Keep track of all blks which are reserved as allocated
-    std::mutex m_reserve_blk_mtx;                    // Mutex used while removing marked_blks from blk_q
-    folly::MPMCQueue< blk_num_t > m_free_blk_q;
+    std::atomic< state_t > m_state{state_t::RECOVERING};
+    uint64_t m_num_words;         // Number of words in the free bitmap
+    uint64_t m_num_summary_words; // Number of words in the summary level
+    std::unique_ptr< std::atomic< uint64_t >[] > m_free_words;
+    std::unique_ptr< std::atomic< uint64_t >[] > m_summary_words;
+    std::unique_ptr< std::atomic< bool >[] > m_portion_ready;
+    std::unique_ptr< alloc_cursor[] > m_cursors;
+    uint32_t m_num_cursors;
+
+    std::atomic< int64_t > m_free_count{0};           // Free blks in the portions which are initialized
+    std::atomic< int64_t > m_uninit_free_estimate{0}; // Free blks as per disk bitmap in portions yet to be initialized
+    std::atomic< blk_num_t > m_uninit_portions{0};
 };
 } // namespace homestore
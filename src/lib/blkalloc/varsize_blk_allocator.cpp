@@ -54,14 +54,13 @@ VarsizeBlkAllocator::VarsizeBlkAllocator(VarsizeBlkAllocConfig const& cfg, bool
         BitmapBlkAllocator{cfg, is_fresh, chunk_id},
         m_state{BlkAllocatorState::INIT},
         m_cfg{cfg},
-        m_rand_portion_num_generator{0, s_cast< blk_count_t >(get_num_portions() - 1)},
         m_metrics{get_name().c_str()} {
     BLKALLOC_LOG(INFO, "Creating VarsizeBlkAllocator with config: {}", cfg.to_string());
 
     HS_REL_ASSERT_LT(get_num_portions(), INVALID_PORTION_NUM);
 
     // TODO: Raise exception when blk_size > page_size or total blks is less than some number etc...
-    m_cache_bm = std::make_unique< sisl::Bitset >(get_total_blks(), chunk_id, get_align_size());
+    m_cache_bm = std::make_unique< BlkBitmap >(get_total_blks());
 
     // NOTE: Number of blocks must be modulo word size so locks do not fall on same word
     HS_REL_ASSERT_EQ(get_blks_per_portion() % m_cache_bm->word_size(), 0,
@@ -78,6 +77,8 @@ VarsizeBlkAllocator::VarsizeBlkAllocator(VarsizeBlkAllocConfig const& cfg, bool
         m_segments.push_back(std::move(seg));
     }
 
+    init_arenas();
+
     // Create free blk Cache of type Queue
     if (m_cfg.m_use_slabs) {
         m_fb_cache = std::make_unique< FreeBlkCacheQueue >(cfg.get_slab_config(), &m_metrics);
@@ -235,8 +236,10 @@ void VarsizeBlkAllocator::load() {
     BLKALLOC_DBG_ASSERT_CMP(is_persistent(), ==, true, "Load called on non-persistent blk allocator");
     m_cache_bm->copy(*get_disk_bitmap());
 
-    BLKALLOC_LOG(INFO, "VarSizeBlkAllocator initialized loading bitmap of size={} used blks={} from persistent storage",
-                 in_bytes(m_cache_bm->size()), get_alloced_blk_count());
+    BLKALLOC_LOG(INFO,
+                 "VarSizeBlkAllocator initialized loading bitmap of size={} used blks={} search_isa={} from persistent "
+                 "storage",
+                 in_bytes(m_cache_bm->size()), get_alloced_blk_count(), enum_name(BlkBitmap::current_isa()));
     do_start();
 }
 
@@ -575,63 +578,101 @@ blk_count_t VarsizeBlkAllocator::alloc_blks_slab(blk_count_t nblks, blk_alloc_hi
 
 blk_count_t VarsizeBlkAllocator::alloc_blks_direct(blk_count_t nblks, blk_alloc_hints const& hints,
                                                    MultiBlkId& out_blkid) {
-    // Search all segments starting with some random portion num within each segment
-    static thread_local std::random_device rd{};
-    static thread_local std::default_random_engine re{rd()};
+    auto const max_pieces = hints.is_contiguous ? 1u : MultiBlkId::max_pieces;
+    blk_count_t const min_blks = hints.is_contiguous ? nblks : std::min< blk_count_t >(nblks, hints.min_blks_per_piece);
+    blk_count_t nblks_remain = nblks;
 
-    if (m_start_portion_num == INVALID_PORTION_NUM) { m_start_portion_num = m_rand_portion_num_generator(re); }
+    // Allocate from this thread's arena and only if it is exhausted, steal from other arenas in order.
+    auto const my_idx = my_arena_idx();
+    for (uint32_t i{0}; (i < m_num_arenas) && nblks_remain && (out_blkid.num_pieces() < max_pieces); ++i) {
+        if (i == 1) { COUNTER_INCREMENT(m_metrics, num_arena_steals, 1); }
+        nblks_remain -= alloc_blks_in_arena(m_arenas[(my_idx + i) % m_num_arenas], nblks_remain, min_blks, max_pieces,
+                                            out_blkid);
+    }
 
-    auto portion_num = m_start_portion_num;
-    // save m_start_portion_num to local variable as m_start_portion_num can be changed by other threads.
-    auto start_portion_num = m_start_portion_num;
-    auto const max_pieces = hints.is_contiguous ? 1u : MultiBlkId::max_pieces;
+    COUNTER_INCREMENT(m_metrics, num_blks_alloc_direct, 1);
+    return (nblks - nblks_remain);
+}
 
-    blk_count_t const min_blks = hints.is_contiguous ? nblks : std::min< blk_count_t >(nblks, hints.min_blks_per_piece);
+blk_count_t VarsizeBlkAllocator::alloc_blks_in_arena(alloc_arena& arena, blk_count_t nblks, blk_count_t min_blks,
+                                                     uint32_t max_pieces, MultiBlkId& out_blkid) {
+    auto const start_portion_num = arena.cur_portion_num.load(std::memory_order_relaxed);
+    auto portion_num = start_portion_num;
     blk_count_t nblks_remain = nblks;
     do {
-        BlkAllocPortion& portion = get_blk_portion(portion_num);
-        auto cur_blk_id = portion_num * get_blks_per_portion();
-        auto const end_blk_id = cur_blk_id + get_blks_per_portion() - 1;
-        {
-            auto lock{portion.portion_auto_lock()};
-            while (nblks_remain && (cur_blk_id <= end_blk_id) && out_blkid.has_room()) {
-                // Get next reset bits and insert to cache and then reset those bits
-                auto const b = m_cache_bm->get_next_contiguous_n_reset_bits(
-                    cur_blk_id, end_blk_id, std::min(min_blks, nblks_remain), nblks_remain);
-                if (b.nbits == 0) { break; }
-                HS_DBG_ASSERT_GE(end_blk_id, b.start_bit, "Expected start bit to be smaller than end bit");
-                HS_DBG_ASSERT_LE(b.nbits, nblks_remain);
-                HS_DBG_ASSERT_GE(b.nbits, std::min(min_blks, nblks_remain));
-                HS_DBG_ASSERT_GE(end_blk_id, (b.start_bit + b.nbits - 1),
-                                 "Expected end bit to be smaller than portion end bit");
-
-                nblks_remain -= b.nbits;
-                out_blkid.add(b.start_bit, b.nbits, m_chunk_id);
-
-                BLKALLOC_LOG(DEBUG, "Allocated directly from portion={} nnblks={} Blk_num={} nblks={} set_bit_count={}",
-                             portion_num, nblks, b.start_bit, b.nbits, get_alloced_blk_count());
-
-                // Set the bitmap indicating the blocks are allocated
-                m_cache_bm->set_bits(b.start_bit, b.nbits);
-                cur_blk_id = b.start_bit + b.nbits;
-            }
-        }
+        nblks_remain -= alloc_blks_in_portion(portion_num, nblks_remain, min_blks, out_blkid);
         if (nblks_remain) {
             auto curr_portion = portion_num;
-            if (++portion_num == get_num_portions()) { portion_num = 0; }
-            BLKALLOC_LOG(
-                TRACE, "alloc direct unable to find in curr portion {}, will searching in portion={}, start_portion={},continue={}, out_blkid num_pieces={} , max_pieces={}",
-                curr_portion, portion_num, start_portion_num, hints.is_contiguous, out_blkid.num_pieces(), max_pieces);
+            if (++portion_num == arena.end_portion_num) { portion_num = arena.start_portion_num; }
+            BLKALLOC_LOG(TRACE,
+                         "alloc direct unable to find in curr portion {}, will searching in portion={}, "
+                         "start_portion={}, out_blkid num_pieces={} , max_pieces={}",
+                         curr_portion, portion_num, start_portion_num, out_blkid.num_pieces(), max_pieces);
         }
     } while (nblks_remain && (portion_num != start_portion_num) && (out_blkid.num_pieces() < max_pieces));
 
-    // save which portion we were at for next allocation;
-    m_start_portion_num = portion_num;
+    // save which portion we were at for next allocation from this arena
+    arena.cur_portion_num.store(portion_num, std::memory_order_relaxed);
+    return (nblks - nblks_remain);
+}
 
-    COUNTER_INCREMENT(m_metrics, num_blks_alloc_direct, 1);
+blk_count_t VarsizeBlkAllocator::alloc_blks_in_portion(blk_num_t portion_num, blk_count_t nblks, blk_count_t min_blks,
+                                                       MultiBlkId& out_blkid) {
+    BlkAllocPortion& portion = get_blk_portion(portion_num);
+    auto cur_blk_id = portion_num * get_blks_per_portion();
+    auto const end_blk_id = std::min(cur_blk_id + get_blks_per_portion(), get_total_blks()) - 1;
+    blk_count_t nblks_remain = nblks;
+
+    auto lock{portion.portion_auto_lock()};
+    while (nblks_remain && (cur_blk_id <= end_blk_id) && out_blkid.has_room()) {
+        // Get next reset bits and insert to cache and then reset those bits
+        auto const b = m_cache_bm->get_next_contiguous_n_reset_bits(cur_blk_id, end_blk_id,
+                                                                    std::min(min_blks, nblks_remain), nblks_remain);
+        if (b.nbits == 0) { break; }
+        HS_DBG_ASSERT_GE(end_blk_id, b.start_bit, "Expected start bit to be smaller than end bit");
+        HS_DBG_ASSERT_LE(b.nbits, nblks_remain);
+        HS_DBG_ASSERT_GE(b.nbits, std::min(min_blks, nblks_remain));
+        HS_DBG_ASSERT_GE(end_blk_id, (b.start_bit + b.nbits - 1),
+                         "Expected end bit to be smaller than portion end bit");
+
+        nblks_remain -= b.nbits;
+        out_blkid.add(b.start_bit, b.nbits, m_chunk_id);
+
+        BLKALLOC_LOG(DEBUG, "Allocated directly from portion={} nnblks={} Blk_num={} nblks={} set_bit_count={}",
+                     portion_num, nblks, b.start_bit, b.nbits, get_alloced_blk_count());
+
+        // Set the bitmap indicating the blocks are allocated
+        m_cache_bm->set_bits(b.start_bit, b.nbits);
+        cur_blk_id = b.start_bit + b.nbits;
+    }
     return (nblks - nblks_remain);
 }
 
+/* Split the portions into equal sized contiguous arenas, leftover portions going to the last arena */
+void VarsizeBlkAllocator::init_arenas() {
+    auto const cfg_arenas = HS_DYNAMIC_CONFIG(blkallocator.num_alloc_arenas);
+    m_num_arenas = std::clamp< uint32_t >((cfg_arenas == 0) ? std::thread::hardware_concurrency() : cfg_arenas, 1u,
+                                          get_num_portions());
+    m_arenas = std::make_unique< alloc_arena[] >(m_num_arenas);
+
+    auto const portions_per_arena = get_num_portions() / m_num_arenas;
+    for (uint32_t i{0}; i < m_num_arenas; ++i) {
+        auto& arena = m_arenas[i];
+        arena.start_portion_num = i * portions_per_arena;
+        arena.end_portion_num = (i == m_num_arenas - 1) ? get_num_portions() : (i + 1) * portions_per_arena;
+        arena.cur_portion_num.store(arena.start_portion_num, std::memory_order_relaxed);
+    }
+}
+
+/* Threads are assigned arenas round robin on their first allocation. Since allocations are done by long running
+ * reactor threads, a thread keeps allocating from the same arena.
+ */
+uint32_t VarsizeBlkAllocator::my_arena_idx() const {
+    static std::atomic< uint32_t > s_next_thread_idx{0};
+    static thread_local uint32_t t_thread_idx{s_next_thread_idx.fetch_add(1, std::memory_order_relaxed)};
+    return t_thread_idx % m_num_arenas;
+}
+
 // since this function will only be called during HS recovery, we can safe to update the cache bitmap directly without
 // touching the slab caches.
 BlkAllocStatus VarsizeBlkAllocator::reserve_on_cache(BlkId const& bid) {
@@ -34,6 +34,7 @@
 
 #include <homestore/blk.h>
 #include "bitmap_blk_allocator.h"
+#include "blk_bitmap.h"
 #include "blk_cache.h"
 #include "common/homestore_assert.hpp"
 #include "common/homestore_config.hpp"
@@ -178,6 +179,7 @@ public:
         REGISTER_COUNTER(num_alloc_partial, "Number of blk alloc partial allocations");
         REGISTER_COUNTER(num_retries, "Number of times it retried because of empty cache");
         REGISTER_COUNTER(num_blks_alloc_direct, "Number of blks alloc attempt directly because of empty cache");
+        REGISTER_COUNTER(num_arena_steals, "Number of direct allocs which had to use other thread's arena");
 
         REGISTER_HISTOGRAM(frag_pct_distribution, "Distribution of fragmentation percentage",
                            HistogramBucketsType(LinearUpto64Buckets));
@@ -197,6 +199,8 @@ public:
  * 1. Could allocate variable number of blks in single allocation
  * 2. Provides the option of allocating blocks based on requested temperature.
  * 3. Caching of available blocks instead of scanning during allocation.
+ * 4. Direct allocation (without cache) from per thread arenas of portions, so that threads do not contend with each
+ *    other and blks written by a thread are laid out together.
  *
  */
 class VarsizeBlkAllocator : public BitmapBlkAllocator {
@@ -238,12 +242,19 @@ private:
 
     static constexpr blk_num_t INVALID_PORTION_NUM{UINT_MAX}; // max of type blk_num_t
 
+    // Contiguous range of portions, which a thread allocates from directly
+    struct alignas(64) alloc_arena {
+        blk_num_t start_portion_num{0};
+        blk_num_t end_portion_num{0}; // Exclusive
+        std::atomic< blk_num_t > cur_portion_num{0};
+    };
+
     // per class sweeping logic
     std::mutex m_mutex;           // Mutex to protect regionstate & cb
     std::condition_variable m_cv; // CV to signal thread
     BlkAllocatorState m_state;    // Current state of the blkallocator
 
-    std::unique_ptr< sisl::Bitset > m_cache_bm; // Bitset representing entire blks in this allocator
+    std::unique_ptr< BlkBitmap > m_cache_bm;    // Bitmap representing entire blks in this allocator
     std::unique_ptr< FreeBlkCache > m_fb_cache; // Free Blks cache
 
     VarsizeBlkAllocConfig m_cfg; // Config for Varsize
@@ -253,11 +264,10 @@ private:
     BlkAllocSegment* m_sweep_segment{nullptr};                    // Segment to sweep - if woken up
     std::shared_ptr< blk_cache_fill_session > m_cur_fill_session; // Cache fill requirements while sweeping
 
-    std::uniform_int_distribution< blk_num_t > m_rand_portion_num_generator;
     BlkAllocMetrics m_metrics;
 
-    // TODO: this fields needs to be passed in from hints and persisted in volume's sb;
-    blk_num_t m_start_portion_num{INVALID_PORTION_NUM};
+    std::unique_ptr< alloc_arena[] > m_arenas;
+    uint32_t m_num_arenas{1};
 
     blk_num_t m_blks_per_seg{1};
     blk_num_t m_portions_per_seg{1};
@@ -269,6 +279,12 @@ private:
 
     blk_count_t alloc_blks_slab(blk_count_t nblks, blk_alloc_hints const& hints, MultiBlkId& out_blkid);
     blk_count_t alloc_blks_direct(blk_count_t nblks, blk_alloc_hints const& hints, MultiBlkId& out_blkids);
+    blk_count_t alloc_blks_in_arena(alloc_arena& arena, blk_count_t nblks, blk_count_t min_blks, uint32_t max_pieces,
+                                    MultiBlkId& out_blkid);
+    blk_count_t alloc_blks_in_portion(blk_num_t portion_num, blk_count_t nblks, blk_count_t min_blks,
+                                      MultiBlkId& out_blkid);
+    void init_arenas();
+    uint32_t my_arena_idx() const;
     blk_count_t free_blks_slab(MultiBlkId const& b);
     blk_count_t free_blks_direct(MultiBlkId const& b);
 
@@ -0,0 +1,195 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <algorithm>
+#include <cstring>
+
+#include "common/homestore_assert.hpp"
+#include "common/homestore_config.hpp"
+#include "blk_read_cache.hpp"
+
+namespace homestore {
+// Rough memory taken by the bookkeeping of a cached blk (list node, hash map node, ghost key), counted against budget
+static constexpr uint64_t s_entry_overhead = 128;
+
+BlkReadCache::BlkReadCache(uint64_t size_bytes, uint32_t blk_size) :
+        m_blk_size{blk_size}, m_capacity_blks{size_bytes / (blk_size + s_entry_overhead)}, m_shards(s_num_shards) {
+    auto const small_pct = std::clamp(HS_DYNAMIC_CONFIG(cache.data_read_cache_small_queue_percent), 1u, 100u);
+    for (auto& s : m_shards) {
+        s.capacity = std::max(m_capacity_blks / s_num_shards, uint64_t{1});
+        s.small_capacity = std::max((s.capacity * small_pct) / 100, uint64_t{1});
+    }
+    LOGINFO("Data read cache of size={} created to hold {} blks of size={}", in_bytes(size_bytes), m_capacity_blks,
+            blk_size);
+}
+
+bool BlkReadCache::get(chunk_num_t chunk_num, blk_num_t blk_num, sisl::sg_iovs_t const& iovs) {
+    auto const key = to_key(chunk_num, blk_num);
+    auto& s = shard_of(key);
+    {
+        std::unique_lock lg{s.mtx};
+        auto const it = s.entries.find(key);
+        if (it != s.entries.end()) {
+            auto& e = *(it->second);
+            e.freq = std::min(e.freq + 1, 3);
+            uint8_t const* src = e.data.get();
+            for (auto const& iov : iovs) {
+                std::memcpy(iov.iov_base, src, iov.iov_len);
+                src += iov.iov_len;
+            }
+            COUNTER_INCREMENT(m_metrics, read_cache_hits, 1);
+            return true;
+        }
+    }
+    COUNTER_INCREMENT(m_metrics, read_cache_misses, 1);
+    return false;
+}
+
+uint64_t BlkReadCache::generation(chunk_num_t chunk_num, blk_num_t blk_num) {
+    auto const key = to_key(chunk_num, blk_num);
+    return gen_of(shard_of(key), key).load(std::memory_order_acquire);
+}
+
+void BlkReadCache::put(chunk_num_t chunk_num, blk_num_t blk_num, sisl::sg_iovs_t const& iovs, uint64_t gen) {
+    auto const key = to_key(chunk_num, blk_num);
+    auto& s = shard_of(key);
+    if (gen_of(s, key).load(std::memory_order_acquire) != gen) { return; }
+
+    // Copy the data outside the lock, it is thrown away if someone else has cached it meanwhile
+    auto data = std::make_unique< uint8_t[] >(m_blk_size);
+    uint8_t* dst = data.get();
+    for (auto const& iov : iovs) {
+        std::memcpy(dst, iov.iov_base, iov.iov_len);
+        dst += iov.iov_len;
+    }
+
+    std::unique_lock lg{s.mtx};
+    // Invalidation bumps the generation under the lock, so checking again here closes the race with it
+    if (gen_of(s, key).load(std::memory_order_relaxed) != gen) { return; }
+    if (auto const it = s.entries.find(key); it != s.entries.end()) {
+        it->second->data = std::move(data);
+        return;
+    }
+
+    while (s.entries.size() >= s.capacity) {
+        evict_one(s);
+    }
+
+    // Blk which was evicted from small queue recently, has proven to be read again, so skip the probation
+    bool to_main{false};
+    if (auto const git = s.ghosts.find(key); git != s.ghosts.end()) {
+        s.ghost_q.erase(git->second);
+        s.ghosts.erase(git);
+        to_main = true;
+    }
+
+    auto& q = to_main ? s.main_q : s.small_q;
+    q.push_back(cache_entry{.key = key, .freq = 0, .in_main = to_main, .data = std::move(data)});
+    s.entries.emplace(key, std::prev(q.end()));
+}
+
+void BlkReadCache::invalidate(BlkId const& bid) {
+    for (blk_count_t i{0}; i < bid.blk_count(); ++i) {
+        auto const key = to_key(bid.chunk_num(), bid.blk_num() + i);
+        auto& s = shard_of(key);
+        std::unique_lock lg{s.mtx};
+        gen_of(s, key).fetch_add(1, std::memory_order_acq_rel);
+        if (auto const it = s.entries.find(key); it != s.entries.end()) {
+            remove_entry(s, it->second);
+            COUNTER_INCREMENT(m_metrics, read_cache_invalidations, 1);
+        }
+        if (auto const git = s.ghosts.find(key); git != s.ghosts.end()) {
+            s.ghost_q.erase(git->second);
+            s.ghosts.erase(git);
+        }
+    }
+}
+
+uint64_t BlkReadCache::cached_blks() const {
+    uint64_t n{0};
+    for (auto const& s : m_shards) {
+        std::unique_lock lg{s.mtx};
+        n += s.entries.size();
+    }
+    return n;
+}
+
+BlkReadCache::shard& BlkReadCache::shard_of(uint64_t key) {
+    // Consecutive blks are spread across shards, so that a large read does not pile on one shard's lock
+    return m_shards[std::hash< uint64_t >{}(key) % s_num_shards];
+}
+
+std::atomic< uint64_t >& BlkReadCache::gen_of(shard& s, uint64_t key) {
+    return s.gens[(std::hash< uint64_t >{}(key) / s_num_shards) % s_gens_per_shard];
+}
+
+void BlkReadCache::evict_one(shard& s) {
+    if ((s.small_q.size() >= s.small_capacity) || s.main_q.empty()) {
+        evict_from_small(s);
+    } else {
+        evict_from_main(s);
+    }
+}
+
+void BlkReadCache::evict_from_small(shard& s) {
+    while (!s.small_q.empty()) {
+        auto it = s.small_q.begin();
+        if (it->freq == 0) {
+            add_ghost(s, it->key);
+            remove_entry(s, it);
+            COUNTER_INCREMENT(m_metrics, read_cache_evictions, 1);
+            return;
+        }
+
+        // Read again while on probation, move it to main queue. Iterators stay valid across splice
+        it->freq = 0;
+        it->in_main = true;
+        s.main_q.splice(s.main_q.end(), s.small_q, it);
+        COUNTER_INCREMENT(m_metrics, read_cache_promotions, 1);
+    }
+    evict_from_main(s);
+}
+
+void BlkReadCache::evict_from_main(shard& s) {
+    while (!s.main_q.empty()) {
+        auto it = s.main_q.begin();
+        if (it->freq == 0) {
+            remove_entry(s, it);
+            COUNTER_INCREMENT(m_metrics, read_cache_evictions, 1);
+            return;
+        }
+        --(it->freq);
+        s.main_q.splice(s.main_q.end(), s.main_q, it);
+    }
+}
+
+void BlkReadCache::add_ghost(shard& s, uint64_t key) {
+    // Ghost queue remembers as many keys as main queue could hold
+    while (!s.ghost_q.empty() && (s.ghost_q.size() >= (s.capacity - s.small_capacity + 1))) {
+        s.ghosts.erase(s.ghost_q.front());
+        s.ghost_q.pop_front();
+    }
+    s.ghost_q.push_back(key);
+    s.ghosts[key] = std::prev(s.ghost_q.end());
+}
+
+void BlkReadCache::remove_entry(shard& s, entry_list_t::iterator it) {
+    s.entries.erase(it->key);
+    if (it->in_main) {
+        s.main_q.erase(it);
+    } else {
+        s.small_q.erase(it);
+    }
+}
+} // namespace homestore
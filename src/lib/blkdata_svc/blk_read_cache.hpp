@@ -0,0 +1,141 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <sisl/fds/buffer.hpp>
+#include <sisl/metrics/metrics.hpp>
+#include <homestore/blk.h>
+
+namespace homestore {
+class BlkReadCacheMetrics : public sisl::MetricsGroupWrapper {
+public:
+    explicit BlkReadCacheMetrics() : sisl::MetricsGroupWrapper("BlkReadCache", "DataSvc") {
+        REGISTER_COUNTER(read_cache_hits, "Number of blks read served from cache");
+        REGISTER_COUNTER(read_cache_misses, "Number of blks read which missed the cache");
+        REGISTER_COUNTER(read_cache_evictions, "Number of blks evicted from cache");
+        REGISTER_COUNTER(read_cache_promotions, "Number of blks promoted from small to main queue");
+        REGISTER_COUNTER(read_cache_invalidations, "Number of cached blks invalidated on free/overwrite");
+        register_me_to_farm();
+    }
+
+    BlkReadCacheMetrics(const BlkReadCacheMetrics&) = delete;
+    BlkReadCacheMetrics& operator=(const BlkReadCacheMetrics&) = delete;
+    BlkReadCacheMetrics(BlkReadCacheMetrics&&) noexcept = delete;
+    BlkReadCacheMetrics& operator=(BlkReadCacheMetrics&&) noexcept = delete;
+
+    ~BlkReadCacheMetrics() { deregister_me_from_farm(); }
+};
+
+/* Cache of the blks read through data service, keyed by individual blk (chunk, blk_num).
+ *
+ * It follows S3-FIFO eviction, to resist the scans (blks read once) flushing out the hot blks: newly read blks enter a
+ * small probationary FIFO queue and only those read again while in there are promoted to the main FIFO queue. Blks
+ * evicted from small queue leave their key in a ghost queue, so that a blk read again soon after eviction goes to main
+ * queue directly. Main queue gives a blk which was read while in the queue another round, rather than evicting it.
+ * Hits only bump a small counter, so the queues are never reordered on reads.
+ *
+ * The cache is split into shards by the blk, each with its own lock and share of the capacity.
+ *
+ * A read which misses the cache could race with an overwrite or free of the blk and complete with the old content. To
+ * not cache it, the reader takes the generation of the blk before issuing the read and put() drops the content if the
+ * blk was invalidated since. Generations are kept in a fixed table per shard which blks hash into, so an invalidation
+ * could also drop the put of an unrelated blk sharing the slot, which only costs a cache miss later.
+ */
+class BlkReadCache {
+public:
+    BlkReadCache(uint64_t size_bytes, uint32_t blk_size);
+    BlkReadCache(const BlkReadCache&) = delete;
+    BlkReadCache& operator=(const BlkReadCache&) = delete;
+    BlkReadCache(BlkReadCache&&) noexcept = delete;
+    BlkReadCache& operator=(BlkReadCache&&) noexcept = delete;
+    ~BlkReadCache() = default;
+
+    /**
+     * @brief Copy the cached content of the blk into the iovs, which are expected to be exactly blk sized
+     *
+     * @return true if the blk is found in cache, false otherwise
+     */
+    bool get(chunk_num_t chunk_num, blk_num_t blk_num, sisl::sg_iovs_t const& iovs);
+
+    /**
+     * @brief Generation of the blk, to be taken before issuing the read whose content is to be put in the cache
+     */
+    uint64_t generation(chunk_num_t chunk_num, blk_num_t blk_num);
+
+    /**
+     * @brief Cache (or refresh) the content of the blk from iovs, which are expected to be exactly blk sized. Content
+     * is dropped if the blk was invalidated after the generation was taken, since it could be stale.
+     */
+    void put(chunk_num_t chunk_num, blk_num_t blk_num, sisl::sg_iovs_t const& iovs, uint64_t gen);
+
+    /**
+     * @brief Remove all the blks of the blkid from cache and bump their generation
+     */
+    void invalidate(BlkId const& bid);
+
+    uint64_t capacity_blks() const { return m_capacity_blks; }
+    uint64_t cached_blks() const;
+    uint32_t blk_size() const { return m_blk_size; }
+
+private:
+    static constexpr uint32_t s_num_shards = 16;
+    static constexpr uint32_t s_gens_per_shard = 1024;
+
+    struct cache_entry {
+        uint64_t key;
+        uint8_t freq{0}; // Reads since it was inserted (or last given another round in main), capped at 3
+        bool in_main{false};
+        std::unique_ptr< uint8_t[] > data;
+    };
+    using entry_list_t = std::list< cache_entry >;
+
+    struct shard {
+        mutable std::mutex mtx;
+        entry_list_t small_q; // Front is the oldest
+        entry_list_t main_q;
+        std::unordered_map< uint64_t, entry_list_t::iterator > entries;
+        std::list< uint64_t > ghost_q;
+        std::unordered_map< uint64_t, std::list< uint64_t >::iterator > ghosts;
+        uint64_t capacity{0};
+        uint64_t small_capacity{0};
+        std::array< std::atomic< uint64_t >, s_gens_per_shard > gens{}; // Bumped under mtx, read lock free
+    };
+
+    static uint64_t to_key(chunk_num_t chunk_num, blk_num_t blk_num) {
+        return (uint64_cast(chunk_num) << (sizeof(blk_num_t) * 8)) | blk_num;
+    }
+    shard& shard_of(uint64_t key);
+    static std::atomic< uint64_t >& gen_of(shard& s, uint64_t key);
+    void evict_one(shard& s);
+    void evict_from_small(shard& s);
+    void evict_from_main(shard& s);
+    void add_ghost(shard& s, uint64_t key);
+    void remove_entry(shard& s, entry_list_t::iterator it);
+
+private:
+    uint32_t m_blk_size;
+    uint64_t m_capacity_blks;
+    std::vector< shard > m_shards;
+    BlkReadCacheMetrics m_metrics;
+};
+} // namespace homestore
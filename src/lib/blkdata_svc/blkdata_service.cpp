@@ -13,17 +13,24 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <array>
+#include <cstring>
+
 #include <homestore/blkdata_service.hpp>
 #include <homestore/homestore.hpp>
 #include <homestore/chunk_selector.h>
+#include <homestore/crc.h>
 
 #include "device/chunk.h"
 #include "device/virtual_dev.hpp"
 #include "device/physical_dev.hpp"     // vdev_info_block
 #include "common/homestore_config.hpp" // is_data_drive_hdd
 #include "common/homestore_assert.hpp"
+#include "common/homestore_utils.hpp"
 #include "common/error.h"
+#include "common/resource_mgr.hpp"
 #include "blk_read_tracker.hpp"
+#include "blk_read_cache.hpp"
 #include "data_svc_cp.hpp"
 
 namespace homestore {
@@ -65,6 +72,23 @@ shared< VirtualDev > BlkDataService::open_vdev(const vdev_info& vinfo, bool load
     return m_vdev;
 }
 
+// Portion of the iovs from offset of given length
+static sisl::sg_iovs_t slice_iovs(sisl::sg_iovs_t const& iovs, uint64_t offset, uint64_t len) {
+    sisl::sg_iovs_t ret;
+    for (auto const& iov : iovs) {
+        if (len == 0) { break; }
+        if (offset >= iov.iov_len) {
+            offset -= iov.iov_len;
+            continue;
+        }
+        auto const sz = std::min(iov.iov_len - offset, len);
+        ret.push_back(iovec{.iov_base = uintptr_cast(iov.iov_base) + offset, .iov_len = sz});
+        offset = 0;
+        len -= sz;
+    }
+    return ret;
+}
+
 static auto collect_all_futures(std::vector< folly::Future< std::error_code > >& futs) {
     return folly::collectAllUnsafe(futs).thenValue([](auto&& vf) {
         for (auto const& err_c : vf) {
@@ -77,10 +101,105 @@ static auto collect_all_futures(std::vector< folly::Future< std::error_code > >&
     });
 }
 
+folly::Future< std::error_code > BlkDataService::read_through_cache(MultiBlkId const& blkid,
+                                                                    sisl::sg_iovs_t const& iovs, bool part_of_batch,
+                                                                    blk_checksums_t const* checksums) {
+    static thread_local std::vector< folly::Future< std::error_code > > s_futs;
+    s_futs.clear();
+
+    auto read_missed = [this, &iovs, part_of_batch, checksums](BlkId const& bid, uint64_t offset) {
+        uint32_t const sz = bid.blk_count() * m_blk_size;
+        auto miss_iovs = slice_iovs(iovs, offset, sz);
+        m_blk_read_tracker->insert(bid);
+
+        // Blks whose checksum is known are cached only once verified, so that a corrupt read is never served again
+        blk_checksums_t exp_checksums;
+        if (checksums) {
+            auto const first = checksums->cbegin() + s_cast< int64_t >(offset / m_blk_size);
+            exp_checksums.assign(first, first + bid.blk_count());
+        }
+
+        // An overwrite or free of the blks after this point makes what we read possibly stale, so it is not cached
+        std::vector< uint64_t > gens(bid.blk_count());
+        for (blk_count_t i{0}; i < bid.blk_count(); ++i) {
+            gens[i] = m_read_cache->generation(bid.chunk_num(), bid.blk_num() + i);
+        }
+
+        return m_vdev->async_readv(miss_iovs.data(), miss_iovs.size(), sz, bid, part_of_batch)
+            .thenValue([this, bid, miss_iovs, gens = std::move(gens),
+                        exp_checksums = std::move(exp_checksums)](auto&& ec) {
+                // Cache it before the read is untracked, so that a free waiting on this read, invalidates it after
+                if (!ec) {
+                    static thread_local blk_checksums_t s_read_checksums;
+                    if (!exp_checksums.empty()) {
+                        compute_checksums(miss_iovs, m_blk_size, bid.blk_count(), s_read_checksums);
+                    }
+                    for (blk_count_t i{0}; i < bid.blk_count(); ++i) {
+                        if (!exp_checksums.empty() && (s_read_checksums[i] != exp_checksums[i])) { continue; }
+                        m_read_cache->put(bid.chunk_num(), bid.blk_num() + i,
+                                          slice_iovs(miss_iovs, uint64_cast(i) * m_blk_size, m_blk_size), gens[i]);
+                    }
+                }
+                m_blk_read_tracker->remove(bid);
+                return folly::makeFuture< std::error_code >(std::move(ec));
+            });
+    };
+
+    uint64_t offset{0};
+    auto it = blkid.iterate();
+    while (auto const bid = it.next()) {
+        blk_count_t nmissed{0};
+        for (blk_count_t i{0}; i < bid->blk_count(); ++i, offset += m_blk_size) {
+            if (m_read_cache->get(bid->chunk_num(), bid->blk_num() + i, slice_iovs(iovs, offset, m_blk_size))) {
+                if (nmissed != 0) {
+                    s_futs.emplace_back(read_missed(BlkId{bid->blk_num() + i - nmissed, nmissed, bid->chunk_num()},
+                                                    offset - (uint64_cast(nmissed) * m_blk_size)));
+                    nmissed = 0;
+                }
+            } else {
+                ++nmissed;
+            }
+        }
+        if (nmissed != 0) {
+            blk_num_t const miss_start = bid->blk_num() + bid->blk_count() - nmissed;
+            s_futs.emplace_back(read_missed(BlkId{miss_start, nmissed, bid->chunk_num()},
+                                            offset - (uint64_cast(nmissed) * m_blk_size)));
+        }
+    }
+
+    if (s_futs.empty()) { return folly::makeFuture< std::error_code >(std::error_code{}); }
+    if (s_futs.size() == 1) { return std::move(s_futs[0]); }
+    return collect_all_futures(s_futs);
+}
+
+void BlkDataService::invalidate_cached(MultiBlkId const& blkid) {
+    auto it = blkid.iterate();
+    while (auto const bid = it.next()) {
+        m_read_cache->invalidate(*bid);
+    }
+}
+
+folly::Future< std::error_code > BlkDataService::invalidate_cached_on_completion(MultiBlkId const& blkid,
+                                                                                 folly::Future< std::error_code >&& fut) {
+    if (!m_read_cache) { return std::move(fut); }
+
+    // A read issued while the write was in flight could have cached either content, drop it now that it is settled
+    return std::move(fut).thenValue([this, blkid](auto&& ec) {
+        invalidate_cached(blkid);
+        return ec;
+    });
+}
+
 folly::Future< std::error_code > BlkDataService::async_read(MultiBlkId const& blkid, uint8_t* buf, uint32_t size,
                                                             bool part_of_batch) {
     if (is_stopping()) return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::operation_canceled));
     incr_pending_request_num();
+    if (m_read_cache && (size == blkid.blk_count() * m_blk_size)) {
+        auto ret = read_through_cache(blkid, sisl::sg_iovs_t{iovec{.iov_base = buf, .iov_len = size}}, part_of_batch);
+        decr_pending_request_num();
+        return ret;
+    }
+
     auto do_read = [this](BlkId const& bid, uint8_t* buf, uint32_t size, bool part_of_batch) {
         m_blk_read_tracker->insert(bid);
 
@@ -112,6 +231,12 @@ folly::Future< std::error_code > BlkDataService::async_read(MultiBlkId const& bl
                                                             bool part_of_batch) {
     if (is_stopping()) return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::operation_canceled));
     incr_pending_request_num();
+    if (m_read_cache && (size == blkid.blk_count() * m_blk_size)) {
+        auto ret = read_through_cache(blkid, sgs.iovs, part_of_batch);
+        decr_pending_request_num();
+        return ret;
+    }
+
     // TODO: sg_iovs_t should not be passed by value. We need it pass it as const&, but that is failing because
     // iovs.data() will then return "const iovec*", but unfortunately all the way down to iomgr, we take iovec*
     // instead it can easily take "const iovec*". Until we change this is made as copy by value
@@ -143,6 +268,83 @@ folly::Future< std::error_code > BlkDataService::async_read(MultiBlkId const& bl
     }
 }
 
+folly::Future< std::error_code > BlkDataService::async_read(MultiBlkId const& blkid, sisl::sg_list& sgs, uint32_t size,
+                                                            blk_checksums_t const& checksums, bool part_of_batch) {
+    HS_DBG_ASSERT_EQ(size, blkid.blk_count() * m_blk_size, "Checksum verification requires all blks to be read");
+    HS_DBG_ASSERT_EQ(checksums.size(), blkid.blk_count(), "Expected one checksum per blk");
+
+    folly::Future< std::error_code > read_fut{std::error_code{}};
+    if (m_read_cache) {
+        // Read through the cache here, so that the blks read from vdev are verified before they are cached
+        if (is_stopping()) {
+            return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::operation_canceled));
+        }
+        incr_pending_request_num();
+        read_fut = read_through_cache(blkid, sgs.iovs, part_of_batch, &checksums);
+        decr_pending_request_num();
+    } else {
+        read_fut = async_read(blkid, sgs, size, part_of_batch);
+    }
+
+    return std::move(read_fut)
+        .thenValue([this, blkid, &sgs, checksums](auto&& ec) {
+            if (ec) { return folly::makeFuture< std::error_code >(std::move(ec)); }
+
+            // Compute all blks in one go on the read buffers and then compare, rather than verifying blk by blk
+            static thread_local blk_checksums_t s_read_checksums;
+            compute_checksums(sgs.iovs, m_blk_size, blkid.blk_count(), s_read_checksums);
+            auto const [exp_it, read_it] =
+                std::mismatch(checksums.cbegin(), checksums.cend(), s_read_checksums.cbegin());
+            if (exp_it != checksums.cend()) {
+                HS_LOG(ERROR, device, "Checksum mismatch on read of blkid={} blk_idx={} expected={:#x} read={:#x}",
+                       blkid.to_string(), std::distance(checksums.cbegin(), exp_it), *exp_it, *read_it);
+                // Mismatching blk could have been served from cache, cached by a read which had nothing to verify
+                if (m_read_cache) { invalidate_cached(blkid); }
+                return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::bad_message));
+            }
+            return folly::makeFuture< std::error_code >(std::error_code{});
+        });
+}
+
+void BlkDataService::compute_checksums(sisl::sg_iovs_t const& iovs, uint32_t blk_size, uint32_t nblks,
+                                       blk_checksums_t& out_checksums) {
+    out_checksums.clear();
+    out_checksums.reserve(nblks);
+
+    // Blks could span across iovs, so checksum of the portion in each iov is chained to the next one
+    blk_checksum_t crc{~blk_checksum_t{0}};
+    uint32_t blk_filled{0};
+    for (auto const& iov : iovs) {
+        auto ptr = r_cast< unsigned char* >(iov.iov_base);
+        uint64_t remain{iov.iov_len};
+        while ((remain > 0) && (out_checksums.size() < nblks)) {
+            auto const sz = uint32_cast(std::min< uint64_t >(remain, blk_size - blk_filled));
+            crc = crc32_iscsi(ptr, int_cast(sz), crc);
+            ptr += sz;
+            remain -= sz;
+            blk_filled += sz;
+            if (blk_filled == blk_size) {
+                out_checksums.push_back(crc);
+                crc = ~blk_checksum_t{0};
+                blk_filled = 0;
+            }
+        }
+    }
+
+    // Data ending within the last blk is checksummed as if padded with zeros up to the blk size
+    if ((blk_filled != 0) && (out_checksums.size() < nblks)) {
+        static constexpr uint32_t zeros_sz{4096};
+        static std::array< unsigned char, zeros_sz > s_zeros{};
+        while (blk_filled < blk_size) {
+            auto const sz = std::min(blk_size - blk_filled, zeros_sz);
+            crc = crc32_iscsi(s_zeros.data(), int_cast(sz), crc);
+            blk_filled += sz;
+        }
+        out_checksums.push_back(crc);
+    }
+    HS_DBG_ASSERT_EQ(out_checksums.size(), nblks, "iovs are smaller than the blks to checksum");
+}
+
 folly::Future< std::error_code > BlkDataService::async_alloc_write(const sisl::sg_list& sgs,
                                                                    const blk_alloc_hints& hints, MultiBlkId& out_blkids,
                                                                    bool part_of_batch) {
@@ -158,14 +360,50 @@ folly::Future< std::error_code > BlkDataService::async_alloc_write(const sisl::s
     return ret;
 }
 
+folly::Future< std::error_code > BlkDataService::async_alloc_write(sisl::sg_list const& sgs,
+                                                                   blk_alloc_hints const& hints, MultiBlkId& out_blkids,
+                                                                   blk_checksums_t& out_checksums, bool part_of_batch) {
+    // Computed inline on the caller buffers before submitting, no copy of data is needed for it
+    auto const nblks = uint32_cast(sisl::round_up(sgs.size, m_blk_size) / m_blk_size);
+    if ((sgs.size % m_blk_size) == 0) {
+        compute_checksums(sgs.iovs, m_blk_size, nblks, out_checksums);
+        return async_alloc_write(sgs, hints, out_blkids, part_of_batch);
+    }
+
+    sisl::sg_list padded_sgs;
+    auto tail = pad_last_blk(sgs, nblks, padded_sgs);
+    compute_checksums(padded_sgs.iovs, m_blk_size, nblks, out_checksums);
+    return async_alloc_write(padded_sgs, hints, out_blkids, part_of_batch).thenValue([tail](auto&& ec) {
+        hs_utils::iobuf_free(tail, sisl::buftag::common);
+        return ec;
+    });
+}
+
+// Tail of the last blk is written as zeros, so that what is read back matches the checksum of the padded blk
+uint8_t* BlkDataService::pad_last_blk(sisl::sg_list const& sgs, uint32_t nblks, sisl::sg_list& out_sgs) const {
+    auto const padded_size = uint64_cast(nblks) * m_blk_size;
+    HS_DBG_ASSERT((sgs.size < padded_size) && (sgs.size > padded_size - m_blk_size),
+                  "Data of size={} does not end within the last of nblks={}", sgs.size, nblks);
+    auto const tail_sz = uint32_cast(padded_size - sgs.size);
+    auto tail = hs_utils::iobuf_alloc(tail_sz, sisl::buftag::common, get_align_size());
+    std::memset(tail, 0, tail_sz);
+
+    out_sgs.size = padded_size;
+    out_sgs.iovs = sgs.iovs;
+    out_sgs.iovs.push_back(iovec{.iov_base = tail, .iov_len = tail_sz});
+    return tail;
+}
+
 folly::Future< std::error_code > BlkDataService::async_write(const char* buf, uint32_t size, MultiBlkId const& blkid,
                                                              bool part_of_batch) {
     if (is_stopping()) return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::operation_canceled));
     incr_pending_request_num();
+    if (m_read_cache) { invalidate_cached(blkid); }
     if (blkid.num_pieces() == 1) {
         // Shortcut to most common case
         decr_pending_request_num();
-        return m_vdev->async_write(buf, size, blkid.to_single_blkid(), part_of_batch);
+        return invalidate_cached_on_completion(blkid,
+                                               m_vdev->async_write(buf, size, blkid.to_single_blkid(), part_of_batch));
     } else {
         static thread_local std::vector< folly::Future< std::error_code > > s_futs;
         s_futs.clear();
@@ -178,7 +416,7 @@ folly::Future< std::error_code > BlkDataService::async_write(const char* buf, ui
             ptr += sz;
         }
         decr_pending_request_num();
-        return collect_all_futures(s_futs);
+        return invalidate_cached_on_completion(blkid, collect_all_futures(s_futs));
     }
 }
 
@@ -186,13 +424,15 @@ folly::Future< std::error_code > BlkDataService::async_write(sisl::sg_list const
                                                              bool part_of_batch) {
     if (is_stopping()) return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::operation_canceled));
     incr_pending_request_num();
+    if (m_read_cache) { invalidate_cached(blkid); }
     // TODO: Async write should pass this by value the sgs.size parameter as well, currently vdev write routine
     // walks through again all the iovs and then getting the len to pass it down to iomgr. This defeats the purpose of
     // taking size parameters (which was done exactly done to avoid this walk through)
     if (blkid.num_pieces() == 1) {
         // Shortcut to most common case
         decr_pending_request_num();
-        return m_vdev->async_writev(sgs.iovs.data(), sgs.iovs.size(), blkid.to_single_blkid(), part_of_batch);
+        return invalidate_cached_on_completion(
+            blkid, m_vdev->async_writev(sgs.iovs.data(), sgs.iovs.size(), blkid.to_single_blkid(), part_of_batch));
     } else {
         static thread_local std::vector< folly::Future< std::error_code > > s_futs;
         s_futs.clear();
@@ -204,8 +444,25 @@ folly::Future< std::error_code > BlkDataService::async_write(sisl::sg_list const
             s_futs.emplace_back(m_vdev->async_writev(iovs.data(), iovs.size(), *bid, part_of_batch));
         }
         decr_pending_request_num();
-        return collect_all_futures(s_futs);
+        return invalidate_cached_on_completion(blkid, collect_all_futures(s_futs));
+    }
+}
+
+folly::Future< std::error_code > BlkDataService::async_write(sisl::sg_list const& sgs, MultiBlkId const& blkid,
+                                                             blk_checksums_t& out_checksums, bool part_of_batch) {
+    auto const nblks = uint32_cast(blkid.blk_count());
+    if (sgs.size == uint64_cast(nblks) * m_blk_size) {
+        compute_checksums(sgs.iovs, m_blk_size, nblks, out_checksums);
+        return async_write(sgs, blkid, part_of_batch);
     }
+
+    sisl::sg_list padded_sgs;
+    auto tail = pad_last_blk(sgs, nblks, padded_sgs);
+    compute_checksums(padded_sgs.iovs, m_blk_size, nblks, out_checksums);
+    return async_write(padded_sgs, blkid, part_of_batch).thenValue([tail](auto&& ec) {
+        hs_utils::iobuf_free(tail, sisl::buftag::common);
+        return ec;
+    });
 }
 
 BlkAllocStatus BlkDataService::alloc_blks(uint32_t size, const blk_alloc_hints& hints, MultiBlkId& out_blkids) {
@@ -252,6 +509,8 @@ folly::Future< std::error_code > BlkDataService::async_free_blk(MultiBlkId const
         promise.setValue(std::make_error_code(std::errc::resource_unavailable_try_again));
     } else {
         m_blk_read_tracker->wait_on(bids, [this, bids, p = std::move(promise)]() mutable {
+            // All reads on these blks are done by now (and have cached what they read), so nothing can cache them after
+            if (m_read_cache) { invalidate_cached(bids); }
             {
                 auto cpg = hs()->cp_mgr().cp_guard();
                 m_vdev->free_blk(bids, s_cast< VDevCPContext* >(cpg.context(cp_consumer_t::BLK_DATA_SVC)));
@@ -264,6 +523,10 @@ folly::Future< std::error_code > BlkDataService::async_free_blk(MultiBlkId const
 }
 
 void BlkDataService::start() {
+    if (auto const cache_size = resource_mgr().get_data_read_cache_size(); cache_size > 0) {
+        m_read_cache = std::make_unique< BlkReadCache >(cache_size, m_blk_size);
+    }
+
     // Register to CP for flush dirty buffers underlying virtual device layer;
     hs()->cp_mgr().register_consumer(cp_consumer_t::BLK_DATA_SVC,
                                      std::move(std::make_unique< DataSvcCPCallbacks >(m_vdev)));
@@ -164,11 +164,52 @@ int64_t ResourceMgr::get_mem_used_in_recovery_limit() const {
             100);
 }
 
+/* monitor memory used to keep the images of index leaves for delta journaling */
+void ResourceMgr::inc_index_delta_mem(int64_t size) {
+    m_index_delta_mem.fetch_add(size, std::memory_order_relaxed);
+}
+void ResourceMgr::dec_index_delta_mem(int64_t size) {
+    m_index_delta_mem.fetch_sub(size, std::memory_order_relaxed);
+}
+
+bool ResourceMgr::can_add_index_delta_mem(int64_t size) const {
+    return (cur_index_delta_mem() + size <= get_index_delta_mem_limit());
+}
+
+int64_t ResourceMgr::cur_index_delta_mem() const { return m_index_delta_mem.load(std::memory_order_relaxed); }
+
+int64_t ResourceMgr::get_index_delta_mem_limit() const {
+    return ((HS_DYNAMIC_CONFIG(resource_limits.index_delta_mem_percent) * HS_STATIC_CONFIG(input.app_mem_size)) / 100);
+}
+
+/* monitor memory used by the tail caches of all the logdevs */
+void ResourceMgr::inc_log_tail_cache_mem(int64_t size) {
+    m_log_tail_cache_mem.fetch_add(size, std::memory_order_relaxed);
+}
+void ResourceMgr::dec_log_tail_cache_mem(int64_t size) {
+    m_log_tail_cache_mem.fetch_sub(size, std::memory_order_relaxed);
+}
+
+bool ResourceMgr::can_add_log_tail_cache_mem(int64_t size) const {
+    return (cur_log_tail_cache_mem() + size <= get_log_tail_cache_mem_limit());
+}
+
+int64_t ResourceMgr::cur_log_tail_cache_mem() const { return m_log_tail_cache_mem.load(std::memory_order_relaxed); }
+
+int64_t ResourceMgr::get_log_tail_cache_mem_limit() const {
+    return s_cast< int64_t >(HS_DYNAMIC_CONFIG(logstore.tail_cache_size));
+}
+
 /* get cache size */
 uint64_t ResourceMgr::get_cache_size() const {
     return ((HS_STATIC_CONFIG(input.io_mem_size()) * HS_DYNAMIC_CONFIG(resource_limits.cache_size_percent)) / 100);
 }
 
+/* portion of the cache used by data service to cache the blks read */
+uint64_t ResourceMgr::get_data_read_cache_size() const {
+    return ((get_cache_size() * HS_DYNAMIC_CONFIG(cache.data_read_cache_percent)) / 100);
+}
+
 bool ResourceMgr::check_journal_descriptor_size(const uint64_t used_size) const {
     return (used_size >= get_journal_descriptor_size_limit());
 }
@@ -73,8 +73,25 @@ public:
     int64_t cur_mem_used_in_recovery() const;
     int64_t get_mem_used_in_recovery_limit() const;
 
+    /* monitor memory used to keep the images of index leaves for delta journaling */
+    void inc_index_delta_mem(int64_t size);
+    void dec_index_delta_mem(int64_t size);
+
+    bool can_add_index_delta_mem(int64_t size) const;
+    int64_t cur_index_delta_mem() const;
+    int64_t get_index_delta_mem_limit() const;
+
+    /* monitor memory used by the tail caches of all the logdevs */
+    void inc_log_tail_cache_mem(int64_t size);
+    void dec_log_tail_cache_mem(int64_t size);
+
+    bool can_add_log_tail_cache_mem(int64_t size) const;
+    int64_t cur_log_tail_cache_mem() const;
+    int64_t get_log_tail_cache_mem_limit() const;
+
     /* get cache size */
     uint64_t get_cache_size() const;
+    uint64_t get_data_read_cache_size() const;
 
     /**
      * @brief Checks if the journal virtual device (vdev) size is within the specified limits.
@@ -142,6 +159,8 @@ private:
     std::atomic< int64_t > m_hs_fb_size; // free size
     std::atomic< int64_t > m_hs_ab_cnt;  // alloc count
     std::atomic< int64_t > m_memory_used_in_recovery;
+    std::atomic< int64_t > m_index_delta_mem{0};
+    std::atomic< int64_t > m_log_tail_cache_mem{0};
     std::atomic< uint32_t > m_flush_dirty_buf_q_depth{64};
     uint64_t m_total_cap;
 
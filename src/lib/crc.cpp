@@ -3,6 +3,12 @@
 
 #include <cstdint>
 #include <cstddef>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define HS_CRC32C_HW 1
+#endif
+
 extern "C" {
 #define MAX_ITER 8
 
@@ -39,5 +45,42 @@ uint32_t crc32_ieee(uint32_t seed, const unsigned char* buf, uint64_t len) {
     }
     return ~rem;
 }
+
+#ifdef HS_CRC32C_HW
+__attribute__((target("sse4.2"))) static unsigned int crc32_iscsi_sse42(const unsigned char* buf, uint64_t len,
+                                                                        unsigned int crc) {
+    uint64_t crc64{crc};
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), buf += sizeof(uint64_t)) {
+        uint64_t v;
+        __builtin_memcpy(&v, buf, sizeof(uint64_t));
+        crc64 = _mm_crc32_u64(crc64, v);
+    }
+    crc = (unsigned int)crc64;
+    for (; len > 0; --len) {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+    return crc;
+}
+#endif
+
+// crc32c, same semantics as isa-l (no pre/post inversion, reflected), hardware instruction if cpu supports it.
+unsigned int crc32_iscsi(unsigned char* buffer, int len, unsigned int init_crc) {
+#ifdef HS_CRC32C_HW
+    static bool const s_hw_supported = __builtin_cpu_supports("sse4.2");
+    if (s_hw_supported) { return crc32_iscsi_sse42(buffer, (uint64_t)len, init_crc); }
+#endif
+    unsigned int rem = init_crc;
+    unsigned int i, j;
+
+    unsigned int poly = 0x82F63B78; // castagnoli, reflected
+
+    for (i = 0; i < (unsigned int)len; i++) {
+        rem = rem ^ buffer[i];
+        for (j = 0; j < MAX_ITER; j++) {
+            rem = (rem & 1) ? (rem >> 1) ^ poly : (rem >> 1);
+        }
+    }
+    return rem;
+}
 }
 #endif
@@ -20,13 +20,17 @@
 
 namespace homestore {
 Chunk::Chunk(PhysicalDev* pdev, const chunk_info& cinfo, uint32_t chunk_slot) :
-        m_chunk_info{cinfo}, m_pdev{pdev}, m_chunk_slot{chunk_slot}, m_stream_id{pdev->chunk_to_stream_id(cinfo)} {}
+        m_chunk_info{cinfo},
+        m_pdev{pdev},
+        m_chunk_slot{chunk_slot},
+        m_stream_id{pdev->chunk_to_stream_id(cinfo)},
+        m_mirror_stale{cinfo.mirror_stale != 0x00} {}
 
 std::string Chunk::to_string() const {
     return fmt::format("chunk_id={}, vdev_id={}, start_offset={}, size={}, slot_num_in_pdev={} "
-                       "pdev_ordinal={} vdev_ordinal={} stream_id={}",
+                       "pdev_ordinal={} vdev_ordinal={} stream_id={} primary_chunk_id={} mirror_stale={}",
                        chunk_id(), vdev_id(), start_offset(), in_bytes(size()), slot_number(), pdev_ordinal(),
-                       vdev_ordinal(), stream_id());
+                       vdev_ordinal(), stream_id(), primary_chunk_id(), is_mirror_stale());
 }
 
 void Chunk::set_user_private(const sisl::blob& data) {
@@ -36,6 +40,18 @@ void Chunk::set_user_private(const sisl::blob& data) {
     write_chunk_info();
 }
 
+void Chunk::clear_mirror_stale() {
+    m_mirror_stale.store(false, std::memory_order_release);
+    persist_mirror_state();
+}
+
+void Chunk::persist_mirror_state() {
+    std::unique_lock lg{m_mgmt_mutex};
+    m_chunk_info.mirror_stale = is_mirror_stale() ? 0x01 : 0x00;
+    m_chunk_info.compute_checksum();
+    write_chunk_info();
+}
+
 void Chunk::write_chunk_info() {
     auto buf = hs_utils::iobuf_alloc(chunk_info::size, sisl::buftag::superblk, physical_dev()->align_size());
     auto cinfo = new (buf) chunk_info();
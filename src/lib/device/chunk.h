@@ -27,6 +27,7 @@ private:
     const uint32_t m_stream_id;
     uint32_t m_vdev_ordinal{0};
     shared< BlkAllocator > m_blk_allocator;
+    std::atomic< bool > m_mirror_stale{false};
 
 public:
     static constexpr auto MAX_CHUNK_SIZE = std::numeric_limits< uint32_t >::max();
@@ -57,6 +58,11 @@ public:
     uint32_t vdev_id() const { return m_chunk_info.vdev_id; }
     uint16_t chunk_id() const { return static_cast< uint16_t >(m_chunk_info.chunk_id); }
     uint32_t pdev_ordinal() const { return m_chunk_info.chunk_ordinal; }
+    uint16_t primary_chunk_id() const {
+        return m_chunk_info.primary_chunk_id_valid ? static_cast< uint16_t >(m_chunk_info.primary_chunk_id)
+                                                   : chunk_id();
+    }
+    bool is_mirror_stale() const { return m_mirror_stale.load(std::memory_order_acquire); }
     const uint8_t* user_private() { return &m_chunk_info.user_private[0]; }
     uint32_t stream_id() const { return m_stream_id; }
     uint32_t slot_number() const { return m_chunk_slot; }
@@ -72,6 +78,12 @@ public:
     void set_block_allocator(cshared< BlkAllocator >& blkalloc) { m_blk_allocator = blkalloc; }
     void set_vdev_ordinal(uint32_t vdev_ordinal) { m_vdev_ordinal = vdev_ordinal; }
 
+    /// @brief Mark this replica of mirrored chunk as stale in memory, so that reads skip it right away.
+    /// @return true if it was not stale already, in which case caller has to persist it with persist_mirror_state()
+    bool mark_mirror_stale() { return !m_mirror_stale.exchange(true, std::memory_order_acq_rel); }
+    void clear_mirror_stale();
+    void persist_mirror_state();
+
 private:
     void write_chunk_info();
 };
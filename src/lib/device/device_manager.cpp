@@ -247,6 +247,10 @@ shared< VirtualDev > DeviceManager::create_vdev(vdev_parameters&& vparam) {
             uint32_t min_num_chunks = (vparam.vdev_size - 1) / Chunk::MAX_CHUNK_SIZE + 1;
             vparam.num_chunks = std::max(vparam.num_chunks, min_num_chunks);
             vparam.num_chunks = std::min(vparam.num_chunks, max_num_chunks);
+            if (vparam.multi_pdev_opts == vdev_multi_pdev_opts_t::ALL_PDEV_MIRRORED) {
+                // Every pdev holds a full replica, so chunks have to be split evenly across them
+                vparam.num_chunks = sisl::round_down(vparam.num_chunks, uint32_cast(pdevs.size()));
+            }
 
             if (input_num_chunks != vparam.num_chunks) {
                 LOGINFO("{} Virtual device is attempted to be created with num_chunks={}, it needs to be adjust to "
@@ -337,14 +341,20 @@ shared< VirtualDev > DeviceManager::create_vdev(vdev_parameters&& vparam) {
     LOGINFO("total size of type {} in this homestore is  {}", vparam.dev_type, total_type_size)
 
     uint32_t total_created_chunks{0};
+    bool const is_mirrored = (vparam.multi_pdev_opts == vdev_multi_pdev_opts_t::ALL_PDEV_MIRRORED);
+
+    // For mirrored vdev, chunks of first pdev are the primary and chunk with same ordinal on other pdevs are replica
+    std::vector< uint32_t > primary_chunk_ids;
 
     for (auto& pdev : pdevs) {
         if (total_created_chunks >= vparam.num_chunks) break;
         std::vector< uint32_t > chunk_ids;
 
-        // the total number of chunks will be created in this pdev
-        auto total_chunk_num_in_pdev =
-            static_cast< uint32_t >(vparam.num_chunks * (pdev->data_size() / static_cast< float >(total_type_size)));
+        // the total number of chunks will be created in this pdev. Mirrors need an identical layout on all pdevs
+        // irrespective of their capacity
+        auto total_chunk_num_in_pdev = is_mirrored
+            ? uint32_cast(vparam.num_chunks / pdevs.size())
+            : static_cast< uint32_t >(vparam.num_chunks * (pdev->data_size() / static_cast< float >(total_type_size)));
 
         RELEASE_ASSERT(vparam.num_chunks >= total_chunk_num_in_pdev,
                        "chunks in pdev {} is {},  larger than total chunks {} , which is expected to be created ",
@@ -361,8 +371,10 @@ shared< VirtualDev > DeviceManager::create_vdev(vdev_parameters&& vparam) {
             chunk_ids.push_back(chunk_id);
         }
 
+        if (is_mirrored && primary_chunk_ids.empty()) { primary_chunk_ids = chunk_ids; }
+
         // Create all chunks at one shot and add each one to the vdev
-        auto chunks = pdev->create_chunks(chunk_ids, vdev_id, vparam.chunk_size);
+        auto chunks = pdev->create_chunks(chunk_ids, vdev_id, vparam.chunk_size, primary_chunk_ids);
         for (auto& chunk : chunks) {
             vdev->add_chunk(chunk, true /* fresh_chunk */);
             m_chunks[chunk->chunk_id()] = chunk;
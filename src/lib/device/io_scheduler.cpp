@@ -0,0 +1,161 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <algorithm>
+#include <vector>
+
+#include "common/homestore_config.hpp"
+#include "device/io_scheduler.hpp"
+#include "device/physical_dev.hpp"
+
+namespace homestore {
+static thread_local io_priority_t t_io_priority{io_priority_t::FOREGROUND};
+
+IOPriorityGuard::IOPriorityGuard(io_priority_t priority) : m_prev_priority{t_io_priority} { t_io_priority = priority; }
+IOPriorityGuard::~IOPriorityGuard() { t_io_priority = m_prev_priority; }
+io_priority_t IOPriorityGuard::current() { return t_io_priority; }
+
+static bool is_bg_class(io_priority_t priority) {
+    return (priority == io_priority_t::CP_FLUSH) || (priority == io_priority_t::BACKGROUND);
+}
+
+IOScheduler::IOScheduler(PhysicalDevMetrics& metrics) : m_metrics{metrics} {}
+
+folly::Future< std::error_code > IOScheduler::submit(io_fn_t&& fn, bool part_of_batch, io_priority_t priority) {
+    // Fast path, nothing is waiting ahead of us and device has room
+    if ((m_nqueued.load(std::memory_order_acquire) == 0) && try_admit(priority)) {
+        return dispatch(priority, std::move(fn), part_of_batch);
+    }
+
+    auto const p = s_cast< size_t >(priority);
+    pending_io io{.fn = std::move(fn), .promise = folly::Promise< std::error_code >{}, .queued_at = Clock::now()};
+    auto fut = io.promise.getFuture();
+    {
+        std::unique_lock lg{m_mtx};
+        m_queues[p].push_back(std::move(io));
+        m_class_queued[p].fetch_add(1, std::memory_order_relaxed);
+        m_nqueued.fetch_add(1, std::memory_order_acq_rel);
+        update_queue_gauges();
+    }
+
+    // All of the in flight IOs could have completed before we queued, in which case no one else would drain it
+    drain();
+    return fut;
+}
+
+uint32_t IOScheduler::outstanding_ios() const {
+    return m_total_inflight.load(std::memory_order_relaxed) + m_nqueued.load(std::memory_order_relaxed);
+}
+
+uint32_t IOScheduler::queued_ios(io_priority_t priority) const {
+    return m_class_queued[s_cast< size_t >(priority)].load(std::memory_order_relaxed);
+}
+
+bool IOScheduler::try_admit(io_priority_t priority) {
+    auto const depth = HS_DYNAMIC_CONFIG(device.io_sched_queue_depth);
+    if (depth == 0) {
+        m_total_inflight.fetch_add(1, std::memory_order_relaxed);
+        if (is_bg_class(priority)) { m_bg_inflight.fetch_add(1, std::memory_order_relaxed); }
+        return true;
+    }
+
+    if (is_bg_class(priority)) {
+        auto const bg_depth = std::max((depth * HS_DYNAMIC_CONFIG(device.io_sched_bg_depth_pct)) / 100, 1u);
+        auto cur = m_bg_inflight.load(std::memory_order_relaxed);
+        do {
+            if (cur >= bg_depth) { return false; }
+        } while (!m_bg_inflight.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel));
+    }
+
+    auto cur = m_total_inflight.load(std::memory_order_relaxed);
+    do {
+        if (cur >= depth) {
+            if (is_bg_class(priority)) { m_bg_inflight.fetch_sub(1, std::memory_order_relaxed); }
+            return false;
+        }
+    } while (!m_total_inflight.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel));
+    return true;
+}
+
+void IOScheduler::release(io_priority_t priority) {
+    if (is_bg_class(priority)) { m_bg_inflight.fetch_sub(1, std::memory_order_acq_rel); }
+    m_total_inflight.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// Needs to be called with m_mtx held. Picks the class to dispatch the next IO from and admits it.
+std::optional< io_priority_t > IOScheduler::pick_next() {
+    if (m_nqueued.load(std::memory_order_acquire) == 0) { return std::nullopt; }
+
+    // IO starved beyond its deadline goes ahead of the higher classes, oldest first
+    auto const max_wait = std::chrono::microseconds(HS_DYNAMIC_CONFIG(device.io_sched_max_wait_us));
+    auto const now = Clock::now();
+    std::optional< io_priority_t > expired;
+    for (size_t p{0}; p < num_priorities; ++p) {
+        if (m_queues[p].empty() || ((now - m_queues[p].front().queued_at) < max_wait)) { continue; }
+        if (!expired || (m_queues[p].front().queued_at < m_queues[s_cast< size_t >(*expired)].front().queued_at)) {
+            expired = s_cast< io_priority_t >(p);
+        }
+    }
+    if (expired && try_admit(*expired)) {
+        COUNTER_INCREMENT(m_metrics, io_sched_deadline_dispatch_count, 1);
+        return expired;
+    }
+
+    for (size_t p{0}; p < num_priorities; ++p) {
+        if (!m_queues[p].empty() && try_admit(s_cast< io_priority_t >(p))) { return s_cast< io_priority_t >(p); }
+    }
+    return std::nullopt;
+}
+
+void IOScheduler::drain() {
+    // IOs are issued outside the lock, since a drive completing the IO inline would reenter drain through completion
+    std::vector< std::pair< io_priority_t, pending_io > > ready;
+    {
+        std::unique_lock lg{m_mtx};
+        while (auto const priority = pick_next()) {
+            auto& q = m_queues[s_cast< size_t >(*priority)];
+            ready.emplace_back(*priority, std::move(q.front()));
+            q.pop_front();
+            m_class_queued[s_cast< size_t >(*priority)].fetch_sub(1, std::memory_order_relaxed);
+            m_nqueued.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        if (!ready.empty()) { update_queue_gauges(); }
+    }
+
+    // IOs drained together are issued as one batch, which the last one of them submits to the drive
+    for (size_t i{0}; i < ready.size(); ++i) {
+        auto& [priority, io] = ready[i];
+        HISTOGRAM_OBSERVE(m_metrics, io_sched_queue_wait_latency, get_elapsed_time_us(io.queued_at));
+        dispatch(priority, std::move(io.fn), (i + 1) < ready.size() /* part_of_batch */)
+            .thenValue([promise = std::move(io.promise)](std::error_code ec) mutable { promise.setValue(ec); });
+    }
+}
+
+// IO fn is held till completion, so that whatever it captured (say iovecs) stays valid as long as drive needs it
+folly::Future< std::error_code > IOScheduler::dispatch(io_priority_t priority, io_fn_t&& fn, bool part_of_batch) {
+    auto fut = fn(part_of_batch);
+    return std::move(fut).thenValue([this, priority, fn = std::move(fn)](std::error_code ec) {
+        release(priority);
+        if (m_nqueued.load(std::memory_order_acquire) != 0) { drain(); }
+        return ec;
+    });
+}
+
+void IOScheduler::update_queue_gauges() {
+    GAUGE_UPDATE(m_metrics, io_sched_foreground_queued, m_queues[s_cast< size_t >(io_priority_t::FOREGROUND)].size());
+    GAUGE_UPDATE(m_metrics, io_sched_journal_queued, m_queues[s_cast< size_t >(io_priority_t::JOURNAL)].size());
+    GAUGE_UPDATE(m_metrics, io_sched_cp_flush_queued, m_queues[s_cast< size_t >(io_priority_t::CP_FLUSH)].size());
+    GAUGE_UPDATE(m_metrics, io_sched_background_queued, m_queues[s_cast< size_t >(io_priority_t::BACKGROUND)].size());
+}
+} // namespace homestore
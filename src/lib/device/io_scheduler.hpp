@@ -0,0 +1,106 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <system_error>
+
+#include <folly/futures/Future.h>
+#include <sisl/fds/utils.hpp>
+#include <sisl/utility/enum.hpp>
+#include <homestore/homestore_decl.hpp>
+
+namespace homestore {
+class PhysicalDevMetrics;
+
+// Priority class of an async IO on the physical device, in the order of precedence
+ENUM(io_priority_t, uint8_t, FOREGROUND, JOURNAL, CP_FLUSH, BACKGROUND);
+
+// Sets the priority class for the IOs issued by this thread, until it goes out of scope. Since the class is picked up
+// at the time of issue, the guard is expected to only span the (non blocking) async calls and not fiber yields.
+class IOPriorityGuard {
+public:
+    explicit IOPriorityGuard(io_priority_t priority);
+    IOPriorityGuard(const IOPriorityGuard&) = delete;
+    IOPriorityGuard& operator=(const IOPriorityGuard&) = delete;
+    ~IOPriorityGuard();
+
+    static io_priority_t current();
+
+private:
+    io_priority_t m_prev_priority;
+};
+
+/* Schedules the async IOs of a physical device by their priority class.
+ *
+ * IOs are dispatched right away as long as the device has less than io_sched_queue_depth of them in flight and none
+ * are queued. Beyond that, IOs are queued per class and each completion dispatches the queued ones, highest class
+ * first. CP flush and background IOs together are capped to a fraction of the depth, so that a large CP does not
+ * occupy the device at the cost of foreground latency. To avoid starving them, an IO waiting past io_sched_max_wait_us
+ * is dispatched ahead of the higher classes.
+ */
+class IOScheduler {
+public:
+    // Issues the IO to the drive. The IOs which were queued are dispatched on completion of others, where no one else
+    // submits the batch, so all but the last of the IOs dispatched together are part_of_batch
+    using io_fn_t = std::function< folly::Future< std::error_code >(bool part_of_batch) >;
+
+    explicit IOScheduler(PhysicalDevMetrics& metrics);
+    IOScheduler(const IOScheduler&) = delete;
+    IOScheduler(IOScheduler&&) noexcept = delete;
+    IOScheduler& operator=(const IOScheduler&) = delete;
+    IOScheduler& operator=(IOScheduler&&) noexcept = delete;
+    ~IOScheduler() = default;
+
+    folly::Future< std::error_code > submit(io_fn_t&& fn, bool part_of_batch,
+                                            io_priority_t priority = IOPriorityGuard::current());
+
+    // IOs in flight plus the ones queued
+    uint32_t outstanding_ios() const;
+    uint32_t inflight_ios() const { return m_total_inflight.load(std::memory_order_relaxed); }
+    uint32_t queued_ios(io_priority_t priority) const;
+
+private:
+    static constexpr size_t num_priorities{4};
+
+    struct pending_io {
+        io_fn_t fn;
+        folly::Promise< std::error_code > promise;
+        Clock::time_point queued_at;
+    };
+
+    bool try_admit(io_priority_t priority);
+    void release(io_priority_t priority);
+    std::optional< io_priority_t > pick_next();
+    void drain();
+    folly::Future< std::error_code > dispatch(io_priority_t priority, io_fn_t&& fn, bool part_of_batch);
+    void update_queue_gauges();
+
+private:
+    PhysicalDevMetrics& m_metrics;
+    std::atomic< uint32_t > m_total_inflight{0};
+    std::atomic< uint32_t > m_bg_inflight{0}; // In flight IOs of CP_FLUSH and BACKGROUND classes
+    std::atomic< uint32_t > m_nqueued{0};
+    std::array< std::atomic< uint32_t >, num_priorities > m_class_queued{};
+
+    std::mutex m_mtx;
+    std::array< std::deque< pending_io >, num_priorities > m_queues; // Protected by m_mtx
+};
+} // namespace homestore
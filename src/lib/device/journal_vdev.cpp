@@ -30,6 +30,7 @@
 #include "device/device.h"
 #include "device/physical_dev.hpp"
 #include "device/journal_vdev.hpp"
+#include "device/io_scheduler.hpp"
 #include "common/error.h"
 #include "common/homestore_assert.hpp"
 #include "common/homestore_utils.hpp"
@@ -208,6 +209,7 @@ void JournalVirtualDev::destroy(logdev_id_t logdev_id) {
 void JournalVirtualDev::Descriptor::append_chunk() {
     // Get a new chunk from the pool.
     auto new_chunk = m_vdev.m_chunk_pool->dequeue();
+    std::unique_lock lg{m_chunks_mtx};
 #if 0
     auto* pdev = new_chunk->physical_dev_mutable();
     pdev->sync_write_zero(new_chunk->size(), new_chunk->start_offset());
@@ -331,6 +333,7 @@ folly::Future< std::error_code > JournalVirtualDev::Descriptor::async_append(con
     } else {
         auto const [chunk, _, offset_in_chunk] = process_pwrite_offset(size, m_seek_cursor);
         m_seek_cursor += size;
+        IOPriorityGuard priority_guard{io_priority_t::JOURNAL};
         return m_vdev.async_write(r_cast< const char* >(buf), size, chunk, offset_in_chunk);
     }
 }
@@ -354,6 +357,7 @@ folly::Future< std::error_code > JournalVirtualDev::Descriptor::async_pwrite(con
     m_reserved_sz -= size; // update reserved size
 
     auto const [chunk, _, offset_in_chunk] = process_pwrite_offset(size, offset);
+    IOPriorityGuard priority_guard{io_priority_t::JOURNAL};
     return m_vdev.async_write(r_cast< const char* >(buf), size, chunk, offset_in_chunk);
 }
 
@@ -367,6 +371,7 @@ folly::Future< std::error_code > JournalVirtualDev::Descriptor::async_pwritev(co
 
     m_reserved_sz -= size;
     auto const [chunk, _, offset_in_chunk] = process_pwrite_offset(size, offset);
+    IOPriorityGuard priority_guard{io_priority_t::JOURNAL};
     return m_vdev.async_writev(iov, iovcnt, chunk, offset_in_chunk);
 }
 
@@ -393,26 +398,41 @@ std::error_code JournalVirtualDev::Descriptor::sync_pwritev(const iovec* iov, in
 
 /////////////////////////////// Read Section //////////////////////////////////
 int64_t JournalVirtualDev::Descriptor::sync_next_read(uint8_t* buf, size_t size_rd) {
+    return sync_next_read(buf, size_rd, m_seek_cursor);
+}
+
+int64_t JournalVirtualDev::Descriptor::sync_next_read(uint8_t* buf, size_t size_rd, off_t& cursor) {
+    return next_read(buf, size_rd, cursor, nullptr);
+}
+
+int64_t JournalVirtualDev::Descriptor::async_next_read(uint8_t* buf, size_t size_rd, off_t& cursor,
+                                                       folly::Future< std::error_code >& out_fut) {
+    return next_read(buf, size_rd, cursor, &out_fut);
+}
+
+int64_t JournalVirtualDev::Descriptor::next_read(uint8_t* buf, size_t size_rd, off_t& cursor,
+                                                 folly::Future< std::error_code >* out_fut) {
+    std::shared_lock lg{m_chunks_mtx};
     if (m_journal_chunks.empty()) { return -1; }
 
-    HS_REL_ASSERT_LE(m_seek_cursor, m_end_offset, "seek_cursor {} exceeded end_offset {}", m_seek_cursor, m_end_offset);
-    if (m_seek_cursor >= m_end_offset) {
+    HS_REL_ASSERT_LE(cursor, m_end_offset, "seek_cursor {} exceeded end_offset {}", cursor, m_end_offset);
+    if (cursor >= m_end_offset) {
         LOGTRACEMOD(journalvdev, "sync_next_read reached end of chunks");
         return -1;
     }
 
-    auto [chunk, _, offset_in_chunk] = offset_to_chunk(m_seek_cursor);
+    auto [chunk, _, offset_in_chunk] = offset_to_chunk(cursor);
     auto const end_of_chunk = m_vdev.get_end_of_chunk(chunk);
     auto const chunk_size = std::min< uint64_t >(end_of_chunk, chunk->size());
     bool across_chunk{false};
 
     // LOGINFO("sync_next_read size_rd {} chunk {} seek_cursor {} end_of_chunk {} {}", size_rd, chunk->to_string(),
-    //         m_seek_cursor, end_of_chunk, chunk_size);
+    //         cursor, end_of_chunk, chunk_size);
 
     HS_REL_ASSERT_LE((uint64_t)end_of_chunk, chunk->size(), "Invalid end of chunk: {} detected on chunk num: {}",
                      end_of_chunk, chunk->chunk_id());
     HS_REL_ASSERT_LE((uint64_t)offset_in_chunk, chunk->size(),
-                     "Invalid m_seek_cursor: {} which falls in beyond end of chunk: {}!", m_seek_cursor, end_of_chunk);
+                     "Invalid seek cursor: {} which falls in beyond end of chunk: {}!", cursor, end_of_chunk);
 
     // if read size is larger then what's left in this chunk
     if (size_rd >= (end_of_chunk - offset_in_chunk)) {
@@ -421,28 +441,55 @@ int64_t JournalVirtualDev::Descriptor::sync_next_read(uint8_t* buf, size_t size_
         across_chunk = true;
         if (size_rd == 0) {
             // If there are no more data in the current chunk, move the seek_cursor to the next chunk.
-            m_seek_cursor += (chunk->size() - end_of_chunk);
+            cursor += (chunk->size() - end_of_chunk);
         }
     }
 
     if (buf == nullptr) { return size_rd; }
 
-    auto ec = sync_pread(buf, size_rd, m_seek_cursor);
-    // TODO: Check if we can have tolerate this error and somehow start homestore without replaying or in degraded mode?
-    HS_REL_ASSERT(!ec, "Error in reading next stream of bytes, proceeding could cause some inconsistency, exiting");
+    // Chunk could be truncated and released once the lock is dropped, it stays pinned by the shared_ptr but could be
+    // reused by another logdev. So the read is validated again against the truncation after it completes.
+    if (cursor < m_data_start_offset) {
+        LOGDEBUGMOD(journalvdev, "next_read cursor 0x{} is truncated, desc {}", to_hex(cursor), to_string());
+        return -1;
+    }
+    lg.unlock();
+    if (out_fut) {
+        *out_fut = m_vdev.async_read(r_cast< char* >(buf), size_rd, chunk, offset_in_chunk)
+                       .thenValue([this, offset = cursor](std::error_code ec) {
+                           if (!ec && is_truncated(offset)) { ec = truncated_read_error(); }
+                           return ec;
+                       });
+    } else {
+        auto ec = sync_pread(buf, size_rd, cursor);
+        if (ec == truncated_read_error()) { return -1; }
+        // TODO: Check if we can have tolerate this error and somehow start homestore without replaying or in degraded
+        // mode?
+        HS_REL_ASSERT(!ec, "Error in reading next stream of bytes, proceeding could cause some inconsistency, exiting");
+    }
 
     // Update seek cursor after read;
-    m_seek_cursor += size_rd;
+    cursor += size_rd;
     if (across_chunk) {
-        m_seek_cursor += (chunk->size() - end_of_chunk);
+        cursor += (chunk->size() - end_of_chunk);
         LOGTRACEMOD(journalvdev, "Across size_rd {} chunk {} seek_cursor {} end_of_chunk {}", size_rd,
-                    chunk->to_string(), m_seek_cursor, end_of_chunk);
+                    chunk->to_string(), cursor, end_of_chunk);
     }
     return size_rd;
 }
 
+std::error_code JournalVirtualDev::Descriptor::truncated_read_error() {
+    return std::make_error_code(std::errc::result_out_of_range);
+}
+
+bool JournalVirtualDev::Descriptor::is_truncated(off_t offset) const {
+    std::shared_lock lg{m_chunks_mtx};
+    return offset < m_data_start_offset;
+}
+
 std::error_code JournalVirtualDev::Descriptor::sync_pread(uint8_t* buf, size_t size, off_t offset) {
-    auto [chunk, index, offset_in_chunk] = offset_to_chunk(offset);
+    auto [chunk, index, offset_in_chunk] = offset_to_chunk_for_read(offset);
+    if (chunk == nullptr) { return truncated_read_error(); }
 
     // if the read count is acrossing chunk, only return what's left in this chunk
     if (chunk->size() - offset_in_chunk < size) {
@@ -452,12 +499,17 @@ std::error_code JournalVirtualDev::Descriptor::sync_pread(uint8_t* buf, size_t s
 
     LOGTRACEMOD(journalvdev, "offset: 0x{} size: {} chunk: {} index: {} offset_in_chunk: 0x{} desc {}", to_hex(offset),
                 size, chunk->chunk_id(), index, to_hex(offset_in_chunk), to_string());
-    return m_vdev.sync_read(r_cast< char* >(buf), size, chunk, offset_in_chunk);
+    auto ec = m_vdev.sync_read(r_cast< char* >(buf), size, chunk, offset_in_chunk);
+
+    // Chunk could have been truncated and reused by another logdev while it was being read
+    if (!ec && is_truncated(offset)) { ec = truncated_read_error(); }
+    return ec;
 }
 
 std::error_code JournalVirtualDev::Descriptor::sync_preadv(iovec* iov, int iovcnt, off_t offset) {
     uint64_t len = VirtualDev::get_len(iov, iovcnt);
-    auto [chunk, index, offset_in_chunk] = offset_to_chunk(offset);
+    auto [chunk, index, offset_in_chunk] = offset_to_chunk_for_read(offset);
+    if (chunk == nullptr) { return truncated_read_error(); }
 
     if (chunk->size() - offset_in_chunk < len) {
         if (iovcnt > 1) {
@@ -473,7 +525,9 @@ std::error_code JournalVirtualDev::Descriptor::sync_preadv(iovec* iov, int iovcn
     LOGTRACEMOD(journalvdev, "offset: 0x{} iov: {} len: {} chunk: {} index: {} offset_in_chunk: 0x{} desc {}",
                 to_hex(offset), iovcnt, len, chunk->chunk_id(), index, to_hex(offset_in_chunk), to_string());
 
-    return m_vdev.sync_readv(iov, iovcnt, chunk, offset_in_chunk);
+    auto ec = m_vdev.sync_readv(iov, iovcnt, chunk, offset_in_chunk);
+    if (!ec && is_truncated(offset)) { ec = truncated_read_error(); }
+    return ec;
 }
 
 off_t JournalVirtualDev::Descriptor::lseek(off_t offset, int whence) {
@@ -567,6 +621,7 @@ void JournalVirtualDev::Descriptor::update_tail_offset(off_t tail) {
 }
 
 off_t JournalVirtualDev::Descriptor::truncate(off_t truncate_offset) {
+    std::unique_lock lg{m_chunks_mtx};
     const off_t ds_off = data_start_offset();
     COUNTER_INCREMENT(m_vdev.m_metrics, vdev_truncate_count, 1);
     HS_PERIODIC_LOG(DEBUG, journalvdev, "truncating to logical offset: 0x{} desc {}", to_hex(truncate_offset),
@@ -740,6 +795,16 @@ std::tuple< shared< Chunk >, uint32_t, off_t > JournalVirtualDev::Descriptor::of
     return {nullptr, 0L, 0L};
 }
 
+std::tuple< shared< Chunk >, uint32_t, off_t >
+JournalVirtualDev::Descriptor::offset_to_chunk_for_read(off_t log_offset) const {
+    std::shared_lock lg{m_chunks_mtx};
+    if (log_offset < m_data_start_offset) {
+        LOGDEBUGMOD(journalvdev, "Read offset 0x{} is truncated, desc {}", to_hex(log_offset), to_string());
+        return {nullptr, 0L, 0L};
+    }
+    return offset_to_chunk(log_offset);
+}
+
 bool JournalVirtualDev::Descriptor::is_offset_at_last_chunk(off_t bytes_offset) {
     auto [chunk, chunk_index, _] = offset_to_chunk(bytes_offset, false);
     if (chunk == nullptr) return true;
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <shared_mutex>
 #include <vector>
 #include <condition_variable>
 
@@ -69,6 +70,10 @@ public:
         uint64_t m_total_size{0};                        // Total size of all chunks.
         off_t m_end_offset{0};        // Offset right to window. Never reduced. Increased in multiple of chunk size.
         bool m_end_offset_set{false}; // Adjust the m_end_offset only once during init.
+
+        // Protects the chunk list (and the window offsets) against readers, when appending or truncating chunks. Reads
+        // take it only to locate the chunk and do the io without it, so that reads run concurrently with appends.
+        mutable std::shared_mutex m_chunks_mtx;
         friend class JournalVirtualDev;
 
     public:
@@ -167,10 +172,29 @@ public:
          *
          * @return : On success, the number of bytes read is returned (zero indicates end of file), and the cursor is
          * advanced by this number. it is not an error if this number is smaller than the number requested, because it
-         * can be end of chunk, since read won't across chunk. Returns -1 if there are no bytes available to read.
+         * can be end of chunk, since read won't across chunk. Returns -1 if there are no bytes available to read or if
+         * the bytes are truncated before or while they are read.
          */
         int64_t sync_next_read(uint8_t* buf, size_t count_in);
 
+        /**
+         * @brief : same as above, but reads from and advances the given cursor instead of the seek cursor of the
+         * descriptor. This lets readers stream the journal without disturbing the seek cursor used for appends.
+         */
+        int64_t sync_next_read(uint8_t* buf, size_t count_in, off_t& cursor);
+
+        /**
+         * @brief : same as above, but the read is issued asynchronously. Cursor is advanced right away, so that next
+         * reads can be issued before this one completes. Caller should keep the buffer alive till the future is done.
+         *
+         * @param out_fut : future which is fulfilled once read is completed, valid only if return value is > 0. It
+         * carries truncated_read_error() if the bytes were truncated while being read.
+         *
+         * @return : Number of bytes being read, 0 if cursor just moved to next chunk and -1 on end of journal.
+         */
+        int64_t async_next_read(uint8_t* buf, size_t count_in, off_t& cursor,
+                                folly::Future< std::error_code >& out_fut);
+
         /**
          * @brief : reads up to count bytes at offset into the buffer starting at buf.
          * The curosr is not updated.
@@ -179,7 +203,8 @@ public:
          * @param count : size of buffer
          * @param offset : the start offset to do read
          *
-         * @return : return the error code of the read
+         * @return : return the error code of the read, truncated_read_error() if the offset is truncated before or
+         * while it is read
          */
         std::error_code sync_pread(uint8_t* buf, size_t count_in, off_t offset);
 
@@ -193,10 +218,17 @@ public:
          * @param iovcnt : size of iovev
          * @param offset : the start offset to read
          *
-         * @return : return the error code of the read
+         * @return : return the error code of the read, truncated_read_error() if the offset is truncated before or
+         * while it is read
          */
         std::error_code sync_preadv(iovec* iov, int iovcnt, off_t offset);
 
+        /**
+         * @brief : error returned by the reads of offsets which are truncated, since their chunks could have been
+         * released and reused by other logdevs.
+         */
+        static std::error_code truncated_read_error();
+
         /**
          * @brief : repositions the cusor of the device to the argument offset
          * according to the directive whence as follows:
@@ -386,6 +418,14 @@ public:
         // Return the chunk, its index and offset in the chunk list.
         std::tuple< shared< Chunk >, uint32_t, off_t > offset_to_chunk(off_t log_offset, bool check = true) const;
 
+        // Same as above, but safe to call concurrently with append and truncate of chunks. Returns nullptr chunk if
+        // the offset is already truncated.
+        std::tuple< shared< Chunk >, uint32_t, off_t > offset_to_chunk_for_read(off_t log_offset) const;
+
+        bool is_truncated(off_t offset) const;
+
+        int64_t next_read(uint8_t* buf, size_t size_rd, off_t& cursor, folly::Future< std::error_code >* out_fut);
+
         bool validate_append_size(size_t count) const;
 
         void high_watermark_check();
@@ -0,0 +1,148 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <bit>
+
+#include "blkalloc/blk_allocator.h"
+#include "most_available_space_chunk_selector.h"
+
+namespace homestore {
+// Chunks are mostly added while the vdev is being loaded/created, but could also be added while IO is in progress; the
+// exclusive lock keeps the selects off the containers while they grow.
+void MostAvailableSpaceChunkSelector::add_chunk(cshared< Chunk >& chunk) {
+    std::unique_lock lg{m_chunks_mtx};
+    auto const slot = uint32_cast(m_chunks.size());
+    m_chunks.emplace_back(chunk);
+    m_chunk_slots[chunk->chunk_id()] = slot;
+    if ((slot % slots_per_word) == 0) {
+        for (auto& b : m_buckets) {
+            b.emplace_back(0);
+        }
+    }
+
+    // On load, allocator is yet to recover the blks in use. Its place will be corrected on recovery completion (or
+    // lazily by select_chunk, once it finds the chunk does not have the space the bucket claims)
+    auto const bucket = bucket_of(chunk.get());
+    m_chunk_bucket.emplace_back(bucket);
+    set_slot(bucket, slot);
+}
+
+void MostAvailableSpaceChunkSelector::remove_chunk(cshared< Chunk >& chunk) {
+    std::unique_lock lg{m_chunks_mtx};
+    auto const it = m_chunk_slots.find(chunk->chunk_id());
+    if (it == m_chunk_slots.end()) { return; }
+
+    // Slot is retained (so that the concurrent selects never see the chunk list change), but never selected again
+    auto const slot = it->second;
+    auto const old_bucket = m_chunk_bucket[slot].exchange(removed_bucket);
+    if (old_bucket != removed_bucket) { reset_slot(old_bucket, slot); }
+}
+
+cshared< Chunk > MostAvailableSpaceChunkSelector::select_chunk(blk_count_t nblks, const blk_alloc_hints&) {
+    static thread_local uint32_t t_next_slot{0};
+    static shared< Chunk > const s_no_chunk{nullptr};
+
+    std::shared_lock lg{m_chunks_mtx};
+    auto const nwords = uint32_cast(m_buckets[0].size());
+    if (nwords == 0) { return s_no_chunk; }
+
+    auto const start_slot = (t_next_slot++) % uint32_cast(m_chunks.size());
+    auto const start_word = start_slot / slots_per_word;
+    auto const start_mask = ~uint64_t{0} << (start_slot % slots_per_word);
+
+    shared< Chunk > const* partial_fit{nullptr};
+    for (int b{num_buckets - 1}; b >= 0; --b) {
+        auto const bucket = s_cast< uint8_t >(b);
+
+        // Visit the start word twice, first for the slots at or after start slot and at last for the ones before it
+        for (uint32_t i{0}; i <= nwords; ++i) {
+            auto const w = (start_word + i) % nwords;
+            auto bits = m_buckets[bucket][w].load(std::memory_order_acquire);
+            if (i == 0) {
+                bits &= start_mask;
+            } else if (i == nwords) {
+                bits &= ~start_mask;
+            }
+
+            while (bits != 0) {
+                auto const slot = (w * slots_per_word) + uint32_cast(std::countr_zero(bits));
+                bits &= (bits - 1);
+                if (is_stale(bucket, slot)) { continue; }
+
+                auto const& chunk = m_chunks[slot];
+                auto const avail = chunk->blk_allocator()->available_blks();
+                if (avail >= nblks) { return chunk; }
+
+                // Bucket has overstated the space, which is possible for a chunk not yet recovered. Move it to where
+                // it belongs and look further.
+                if ((avail != 0) && (partial_fit == nullptr)) { partial_fit = &chunk; }
+                move_chunk(slot, bucket_of(chunk.get()));
+            }
+        }
+    }
+    return partial_fit ? *partial_fit : s_no_chunk;
+}
+
+void MostAvailableSpaceChunkSelector::foreach_chunks(std::function< void(cshared< Chunk >&) >&& cb) {
+    std::shared_lock lg{m_chunks_mtx};
+    for (auto& chunk : m_chunks) {
+        cb(chunk);
+    }
+}
+
+void MostAvailableSpaceChunkSelector::on_space_changed(const Chunk* chunk) {
+    std::shared_lock lg{m_chunks_mtx};
+    auto const it = m_chunk_slots.find(chunk->chunk_id());
+    if (it == m_chunk_slots.end()) { return; }
+    move_chunk(it->second, bucket_of(chunk));
+}
+
+uint8_t MostAvailableSpaceChunkSelector::bucket_of(const Chunk* chunk) {
+    auto const* ba = chunk->blk_allocator();
+    auto const total = ba->get_total_blks();
+    if (total == 0) { return 0; }
+    return s_cast< uint8_t >((uint64_t{ba->available_blks()} * (num_buckets - 1)) / total);
+}
+
+void MostAvailableSpaceChunkSelector::move_chunk(uint32_t slot, uint8_t new_bucket) {
+    auto old_bucket = m_chunk_bucket[slot].load(std::memory_order_acquire);
+    if ((old_bucket == new_bucket) || (old_bucket == removed_bucket)) { return; }
+
+    // If some other thread moved it in the meantime, it has accounted it with an equally recent view of the space
+    if (!m_chunk_bucket[slot].compare_exchange_strong(old_bucket, new_bucket, std::memory_order_acq_rel)) { return; }
+    set_slot(new_bucket, slot);
+    reset_slot(old_bucket, slot);
+}
+
+void MostAvailableSpaceChunkSelector::set_slot(uint8_t bucket, uint32_t slot) {
+    m_buckets[bucket][slot / slots_per_word].fetch_or(uint64_t{1} << (slot % slots_per_word),
+                                                      std::memory_order_acq_rel);
+}
+
+void MostAvailableSpaceChunkSelector::reset_slot(uint8_t bucket, uint32_t slot) {
+    m_buckets[bucket][slot / slots_per_word].fetch_and(~(uint64_t{1} << (slot % slots_per_word)),
+                                                       std::memory_order_acq_rel);
+}
+
+// Overlapping moves of a chunk can leave its slot set in a bucket other than the one recorded for it (or missing from
+// the recorded one). Repair it on sight: make sure it is present in recorded bucket before dropping the stale entry.
+bool MostAvailableSpaceChunkSelector::is_stale(uint8_t bucket, uint32_t slot) {
+    auto const cur_bucket = m_chunk_bucket[slot].load(std::memory_order_acquire);
+    if (cur_bucket == bucket) { return false; }
+
+    if (cur_bucket != removed_bucket) { set_slot(cur_bucket, slot); }
+    if (m_chunk_bucket[slot].load(std::memory_order_acquire) != bucket) { reset_slot(bucket, slot); }
+    return true;
+}
+} // namespace homestore
@@ -0,0 +1,76 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <homestore/chunk_selector.h>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <sisl/logging/logging.h>
+
+#include <homestore/vchunk.h>
+#include "device/chunk.h"
+
+namespace homestore {
+/* Picks the chunk which has the most free blks.
+ *
+ * Chunks are indexed into buckets by the fraction of their blks which are free, each bucket being a bitmap of chunk
+ * slots. Selection scans from the fullest free bucket downwards and returns the first chunk which can fit the request,
+ * starting the scan of a bucket at a rotating slot so that chunks (and thereby pdevs) with similar free space share the
+ * IO. The vdev reports every alloc/free to on_space_changed(), which moves the chunk across buckets with atomic ops,
+ * so that the alloc and free paths take only a shared lock, held exclusively just by add/remove of chunks. Concurrent
+ * moves of the same chunk can transiently leave the chunk in a stale bucket, which selection detects (against the
+ * bucket recorded for the chunk) and repairs.
+ */
+class MostAvailableSpaceChunkSelector : public ChunkSelector {
+public:
+    static constexpr uint8_t num_buckets{64};
+
+    MostAvailableSpaceChunkSelector() = default;
+    MostAvailableSpaceChunkSelector(const MostAvailableSpaceChunkSelector&) = delete;
+    MostAvailableSpaceChunkSelector(MostAvailableSpaceChunkSelector&&) noexcept = delete;
+    MostAvailableSpaceChunkSelector& operator=(const MostAvailableSpaceChunkSelector&) = delete;
+    MostAvailableSpaceChunkSelector& operator=(MostAvailableSpaceChunkSelector&&) noexcept = delete;
+    ~MostAvailableSpaceChunkSelector() = default;
+
+    void add_chunk(cshared< Chunk >&) override;
+    void remove_chunk(cshared< Chunk >&) override;
+    cshared< Chunk > select_chunk(blk_count_t nblks, const blk_alloc_hints& hints) override;
+    void foreach_chunks(std::function< void(cshared< Chunk >&) >&& cb) override;
+    void on_space_changed(const Chunk* chunk) override;
+
+private:
+    static constexpr uint8_t removed_bucket{num_buckets};
+    static constexpr uint32_t slots_per_word{64};
+
+    static uint8_t bucket_of(const Chunk* chunk);
+    void move_chunk(uint32_t slot, uint8_t new_bucket);
+    void set_slot(uint8_t bucket, uint32_t slot);
+    void reset_slot(uint8_t bucket, uint32_t slot);
+    bool is_stale(uint8_t bucket, uint32_t slot);
+
+private:
+    mutable std::shared_mutex m_chunks_mtx;                   // Guards the chunk list, slots and bucket words
+    std::vector< shared< Chunk > > m_chunks;                  // Position of the chunk here is its slot in buckets
+    std::unordered_map< uint16_t, uint32_t > m_chunk_slots;    // Chunk id to slot
+    std::deque< std::atomic< uint8_t > > m_chunk_bucket;       // Bucket each slot is currently accounted in
+    std::array< std::deque< std::atomic< uint64_t > >, num_buckets > m_buckets; // Bitmap of slots in each bucket
+};
+
+} // namespace homestore
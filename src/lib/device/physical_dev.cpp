@@ -19,6 +19,7 @@
 #include <system_error>
 
 #include <folly/Exception.h>
+#include <folly/small_vector.h>
 #include <iomgr/iomgr.hpp>
 #include <iomgr/iomgr_flip.hpp>
 #include <sisl/fds/utils.hpp>
@@ -85,7 +86,8 @@ PhysicalDev::PhysicalDev(const dev_info& dinfo, int oflags, const pdev_info_head
         m_devname{dinfo.dev_name},
         m_dev_type{dinfo.dev_type},
         m_dev_info{dinfo},
-        m_pdev_info{pinfo} {
+        m_pdev_info{pinfo},
+        m_io_sched{m_metrics} {
     LOGINFO("Opening device {} with {} mode.", m_devname, oflags & O_DIRECT ? "DIRECT_IO" : "BUFFERED_IO");
 
     m_iodev = open_and_cache_dev(m_devname, oflags);
@@ -138,54 +140,73 @@ void PhysicalDev::close_device() { close_and_uncache_dev(m_devname, m_iodev); }
 
 folly::Future< std::error_code > PhysicalDev::async_write(const char* data, uint32_t size, uint64_t offset,
                                                           bool part_of_batch) {
-    auto const start_time = get_current_time();
-    return m_drive_iface->async_write(m_iodev.get(), data, size, offset, part_of_batch)
-        .thenValue([this, start_time, size](std::error_code ec) {
-            HISTOGRAM_OBSERVE(m_metrics, write_io_sizes, (((size - 1) / 1024) + 1));
-            HISTOGRAM_OBSERVE(m_metrics, drive_write_latency, get_elapsed_time_us(start_time));
-            COUNTER_INCREMENT(m_metrics, drive_async_write_count, 1);
-            return ec;
-        });
+    return m_io_sched.submit(
+        [this, data, size, offset](bool batch) {
+            auto const start_time = get_current_time();
+            return m_drive_iface->async_write(m_iodev.get(), data, size, offset, batch)
+                .thenValue([this, start_time, size](std::error_code ec) {
+                    HISTOGRAM_OBSERVE(m_metrics, write_io_sizes, (((size - 1) / 1024) + 1));
+                    HISTOGRAM_OBSERVE(m_metrics, drive_write_latency, get_elapsed_time_us(start_time));
+                    COUNTER_INCREMENT(m_metrics, drive_async_write_count, 1);
+                    return ec;
+                });
+        },
+        part_of_batch);
 }
 
 folly::Future< std::error_code > PhysicalDev::async_writev(const iovec* iov, int iovcnt, uint32_t size, uint64_t offset,
                                                            bool part_of_batch) {
-    auto const start_time = get_current_time();
-    return m_drive_iface->async_writev(m_iodev.get(), iov, iovcnt, size, offset, part_of_batch)
-        .thenValue([this, start_time, size](std::error_code ec) {
-            HISTOGRAM_OBSERVE(m_metrics, write_io_sizes, (((size - 1) / 1024) + 1));
-            HISTOGRAM_OBSERVE(m_metrics, drive_write_latency, get_elapsed_time_us(start_time));
-            COUNTER_INCREMENT(m_metrics, drive_async_write_count, 1);
-            return ec;
-        });
+    // IO could be queued past the return of this call, so iovecs are copied to be owned by the IO
+    return m_io_sched.submit(
+        [this, iovs = folly::small_vector< iovec, 4 >(iov, iov + iovcnt), size, offset](bool batch) {
+            auto const start_time = get_current_time();
+            return m_drive_iface->async_writev(m_iodev.get(), iovs.data(), int_cast(iovs.size()), size, offset, batch)
+                .thenValue([this, start_time, size](std::error_code ec) {
+                    HISTOGRAM_OBSERVE(m_metrics, write_io_sizes, (((size - 1) / 1024) + 1));
+                    HISTOGRAM_OBSERVE(m_metrics, drive_write_latency, get_elapsed_time_us(start_time));
+                    COUNTER_INCREMENT(m_metrics, drive_async_write_count, 1);
+                    return ec;
+                });
+        },
+        part_of_batch);
 }
 
 folly::Future< std::error_code > PhysicalDev::async_read(char* data, uint32_t size, uint64_t offset,
                                                          bool part_of_batch) {
-    auto const start_time = get_current_time();
-    return m_drive_iface->async_read(m_iodev.get(), data, size, offset, part_of_batch)
-        .thenValue([this, start_time, size](std::error_code ec) {
-            HISTOGRAM_OBSERVE(m_metrics, read_io_sizes, (((size - 1) / 1024) + 1));
-            HISTOGRAM_OBSERVE(m_metrics, drive_read_latency, get_elapsed_time_us(start_time));
-            COUNTER_INCREMENT(m_metrics, drive_async_read_count, 1);
-            return ec;
-        });
+    return m_io_sched.submit(
+        [this, data, size, offset](bool batch) {
+            auto const start_time = get_current_time();
+            return m_drive_iface->async_read(m_iodev.get(), data, size, offset, batch)
+                .thenValue([this, start_time, size](std::error_code ec) {
+                    HISTOGRAM_OBSERVE(m_metrics, read_io_sizes, (((size - 1) / 1024) + 1));
+                    HISTOGRAM_OBSERVE(m_metrics, drive_read_latency, get_elapsed_time_us(start_time));
+                    COUNTER_INCREMENT(m_metrics, drive_async_read_count, 1);
+                    return ec;
+                });
+        },
+        part_of_batch);
 }
 
 folly::Future< std::error_code > PhysicalDev::async_readv(iovec* iov, int iovcnt, uint32_t size, uint64_t offset,
                                                           bool part_of_batch) {
-    auto const start_time = get_current_time();
-    return m_drive_iface->async_readv(m_iodev.get(), iov, iovcnt, size, offset, part_of_batch)
-        .thenValue([this, start_time, size](std::error_code ec) {
-            HISTOGRAM_OBSERVE(m_metrics, read_io_sizes, (((size - 1) / 1024) + 1));
-            HISTOGRAM_OBSERVE(m_metrics, drive_read_latency, get_elapsed_time_us(start_time));
-            COUNTER_INCREMENT(m_metrics, drive_async_read_count, 1);
-            return ec;
-        });
+    return m_io_sched.submit(
+        [this, iovs = folly::small_vector< iovec, 4 >(iov, iov + iovcnt), size, offset](bool batch) mutable {
+            auto const start_time = get_current_time();
+            return m_drive_iface->async_readv(m_iodev.get(), iovs.data(), int_cast(iovs.size()), size, offset, batch)
+                .thenValue([this, start_time, size](std::error_code ec) {
+                    HISTOGRAM_OBSERVE(m_metrics, read_io_sizes, (((size - 1) / 1024) + 1));
+                    HISTOGRAM_OBSERVE(m_metrics, drive_read_latency, get_elapsed_time_us(start_time));
+                    COUNTER_INCREMENT(m_metrics, drive_async_read_count, 1);
+                    return ec;
+                });
+        },
+        part_of_batch);
 }
 
 folly::Future< std::error_code > PhysicalDev::async_write_zero(uint64_t size, uint64_t offset) {
-    return m_drive_iface->async_write_zero(m_iodev.get(), size, offset);
+    return m_io_sched.submit(
+        [this, size, offset](bool) { return m_drive_iface->async_write_zero(m_iodev.get(), size, offset); },
+        false /* part_of_batch */);
 }
 
 #if 0
@@ -259,7 +280,8 @@ void PhysicalDev::format_chunks() {
 }
 
 std::vector< shared< Chunk > > PhysicalDev::create_chunks(const std::vector< uint32_t >& chunk_ids, uint32_t vdev_id,
-                                                          uint64_t size) {
+                                                          uint64_t size,
+                                                          const std::vector< uint32_t >& primary_chunk_ids) {
     std::vector< shared< Chunk > > ret_chunks;
     std::unique_lock lg{m_chunk_op_mtx};
     auto chunks_remaining = chunk_ids.size();
@@ -276,7 +298,8 @@ std::vector< shared< Chunk > > PhysicalDev::create_chunks(const std::vector< uin
             auto ptr = buf;
             for (auto cslot = b.start_bit; cslot < b.start_bit + b.nbits; ++cslot, ++cit, ptr += chunk_info::size) {
                 chunk_info* cinfo = new (ptr) chunk_info();
-                populate_chunk_info(cinfo, vdev_id, size, chunk_ids[cit], cit, {});
+                populate_chunk_info(cinfo, vdev_id, size, chunk_ids[cit], cit, {},
+                                    primary_chunk_ids.empty() ? chunk_ids[cit] : primary_chunk_ids[cit]);
 
                 auto chunk = std::make_shared< Chunk >(this, *cinfo, cslot);
                 ret_chunks.push_back(chunk);
@@ -323,7 +346,7 @@ shared< Chunk > PhysicalDev::create_chunk(uint32_t chunk_id, uint32_t vdev_id, u
     shared< Chunk > chunk;
 
     try {
-        populate_chunk_info(cinfo, vdev_id, size, chunk_id, ordinal, user_private);
+        populate_chunk_info(cinfo, vdev_id, size, chunk_id, ordinal, user_private, chunk_id);
 
         // Locate and write the chunk info in the super blk area
         write_super_block(buf, chunk_info::size, chunk_info_offset_nth(cslot));
@@ -444,7 +467,7 @@ uint64_t PhysicalDev::chunk_info_offset_nth(uint32_t slot) const {
 }
 
 void PhysicalDev::populate_chunk_info(chunk_info* cinfo, uint32_t vdev_id, uint64_t size, uint32_t chunk_id,
-                                      uint32_t ordinal, const sisl::blob& private_data) {
+                                      uint32_t ordinal, const sisl::blob& private_data, uint32_t primary_chunk_id) {
     // Find the free area for chunk data within between data_start_offset() and data_end_offset()
     auto ival = find_next_chunk_area(size);
     m_chunk_data_area.insert(ival);
@@ -454,6 +477,8 @@ void PhysicalDev::populate_chunk_info(chunk_info* cinfo, uint32_t vdev_id, uint6
     cinfo->vdev_id = vdev_id;
     cinfo->chunk_id = chunk_id;
     cinfo->chunk_ordinal = ordinal;
+    cinfo->primary_chunk_id = primary_chunk_id;
+    cinfo->primary_chunk_id_valid = 0x01;
     cinfo->set_allocated();
     cinfo->set_user_private(private_data);
     cinfo->compute_checksum();
@@ -13,6 +13,7 @@
  *
  *********************************************************************************/
 #pragma once
+#include <atomic>
 #include <vector>
 #include <string>
 #include "hs_super_blk.h"
@@ -31,6 +32,7 @@
 #include <homestore/homestore_decl.hpp>
 
 #include "hs_super_blk.h"
+#include "io_scheduler.hpp"
 SISL_LOGGING_DECL(device)
 
 namespace homestore {
@@ -47,9 +49,17 @@ public:
         REGISTER_COUNTER(drive_write_errors, "Total drive write errors");
         REGISTER_COUNTER(drive_spurios_events, "Total number of spurious events per drive");
         REGISTER_COUNTER(drive_skipped_chunk_bm_writes, "Total number of skipped writes for chunk bitmap");
+        REGISTER_COUNTER(io_sched_deadline_dispatch_count,
+                         "Number of queued IOs dispatched ahead of higher priority ones past their max wait");
+
+        REGISTER_GAUGE(io_sched_foreground_queued, "Foreground IOs queued in scheduler of the drive");
+        REGISTER_GAUGE(io_sched_journal_queued, "Journal IOs queued in scheduler of the drive");
+        REGISTER_GAUGE(io_sched_cp_flush_queued, "CP flush IOs queued in scheduler of the drive");
+        REGISTER_GAUGE(io_sched_background_queued, "Background IOs queued in scheduler of the drive");
 
         REGISTER_HISTOGRAM(drive_write_latency, "BlkStore drive write latency in us");
         REGISTER_HISTOGRAM(drive_read_latency, "BlkStore drive read latency in us");
+        REGISTER_HISTOGRAM(io_sched_queue_wait_latency, "Time IOs waited in scheduler queue of the drive in us");
 
         REGISTER_HISTOGRAM(write_io_sizes, "Write IO Sizes", "io_sizes", {"io_direction", "write"},
                            HistogramBucketsType(ExponentialOfTwoBuckets));
@@ -85,7 +95,10 @@ struct chunk_info {
     uint32_t chunk_ordinal{0};     // 32: Chunk ordinal within the vdev on this pdev
     uint8_t chunk_allocated{0x00}; // 36: Is chunk allocated or free
     uint16_t checksum{0};          // 37: checksum of this chunk info
-    uint8_t padding[25]{};         // 39: pad to make it 128 bytes total
+    uint32_t primary_chunk_id{0};  // 39: For mirrored vdev, id of the chunk whose replica this is (could be itself)
+    uint8_t primary_chunk_id_valid{0}; // 43: Chunks created before mirroring have it 0, they are their own primary
+    uint8_t mirror_stale{0};           // 44: Replica has missed writes and is to be resynced from other replicas
+    uint8_t padding[19]{};             // 45: pad to make it 128 bytes total
     uint8_t chunk_selector_private[selector_private_size]{}; // 64: Chunk selector private area
     uint8_t user_private[user_private_size]{};               // 128: Opaque user of the chunk information
 
@@ -137,6 +150,7 @@ private:
     std::unique_ptr< sisl::Bitset > m_chunk_info_slots; // Slots to write the chunk info
     uint32_t m_chunk_sb_size{0};                        // Total size of the chunk sb at present
     std::unordered_set< uint64_t > m_chunk_start;       // Store and verify start offset of all chunks for debugging.
+    IOScheduler m_io_sched;                             // Orders the async IOs on this device by priority
 
 public:
     PhysicalDev(const dev_info& dinfo, int oflags, const pdev_info_header& pinfo);
@@ -163,9 +177,11 @@ public:
     /// list, thus first chunk id is assigned with ordinal 0, then next with 1 etc..
     /// @param vdev_id: Vdev this chunk should be part of.
     /// @param size: Size of each chunk
+    /// @param primary_chunk_ids: For mirrored vdev, primary chunk (on the other pdev) each of these chunks is a
+    /// replica of, in the same order as chunk_ids. Empty means every chunk is its own primary.
     /// @return Vector of chunks that are created
     std::vector< shared< Chunk > > create_chunks(const std::vector< uint32_t >& chunk_ids, uint32_t vdev_id,
-                                                 uint64_t size);
+                                                 uint64_t size, const std::vector< uint32_t >& primary_chunk_ids = {});
 
     /// @brief Create a chunks on this device. In case of unavailable space it throws the std::out_of_range exception
     ///
@@ -197,6 +213,8 @@ public:
     iomgr::DriveInterface* drive_iface() const { return m_drive_iface; }
     uint32_t pdev_id() const { return m_pdev_info.pdev_id; }
     const std::string& get_devname() const { return m_devname; }
+    uint32_t outstanding_ios() const { return m_io_sched.outstanding_ios(); }
+    const IOScheduler& io_scheduler() const { return m_io_sched; }
 
     /////////////////////////////////////// IO Methods //////////////////////////////////////////
     folly::Future< std::error_code > async_write(const char* data, uint32_t size, uint64_t offset,
@@ -233,7 +251,7 @@ public:
 private:
     void do_remove_chunk(cshared< Chunk >& chunk);
     void populate_chunk_info(chunk_info* cinfo, uint32_t vdev_id, uint64_t size, uint32_t chunk_id, uint32_t ordinal,
-                             const sisl::blob& private_data);
+                             const sisl::blob& private_data, uint32_t primary_chunk_id);
     void free_chunk_info(chunk_info* cinfo);
     ChunkInterval find_next_chunk_area(uint64_t size) const;
 };
@@ -0,0 +1,55 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <random>
+
+#include "blkalloc/blk_allocator.h"
+#include "random_chunk_selector.h"
+
+namespace homestore {
+void RandomChunkSelector::add_chunk(cshared< Chunk >& chunk) {
+    std::unique_lock lg{m_chunks_mtx};
+    m_chunks.emplace_back(chunk);
+}
+
+void RandomChunkSelector::remove_chunk(cshared< Chunk >& chunk) {
+    std::unique_lock lg{m_chunks_mtx};
+    std::erase(m_chunks, chunk);
+}
+
+cshared< Chunk > RandomChunkSelector::select_chunk(blk_count_t nblks, const blk_alloc_hints&) {
+    static thread_local std::random_device s_rd{};
+    static thread_local std::default_random_engine s_re{s_rd()};
+
+    std::shared_lock lg{m_chunks_mtx};
+    if (m_chunks.empty()) { return nullptr; }
+    auto rand_chunk = std::uniform_int_distribution< size_t >(0, m_chunks.size() - 1);
+
+    // Walk from the random start to the first chunk which can fit the request, so that alloc does not waste its
+    // attempts on full chunks. If none of them can, leave it to allocator of the random pick to fail or partially alloc
+    auto const start = rand_chunk(s_re);
+    for (size_t i{0}; i < m_chunks.size(); ++i) {
+        auto const& chunk = m_chunks[(start + i) % m_chunks.size()];
+        if (chunk->blk_allocator()->available_blks() >= nblks) { return chunk; }
+    }
+    return m_chunks[start];
+}
+
+void RandomChunkSelector::foreach_chunks(std::function< void(cshared< Chunk >&) >&& cb) {
+    std::shared_lock lg{m_chunks_mtx};
+    for (auto& chunk : m_chunks) {
+        cb(chunk);
+    }
+}
+} // namespace homestore
@@ -0,0 +1,48 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <homestore/chunk_selector.h>
+
+#include <shared_mutex>
+#include <vector>
+#include <sisl/logging/logging.h>
+
+#include <homestore/vchunk.h>
+#include "device/chunk.h"
+
+namespace homestore {
+// Picks a chunk uniformly at random, skipping over the chunks which do not have enough free blks for the request.
+// Chunks could be added or removed while selection is in progress, so the chunk list is guarded by a shared lock.
+class RandomChunkSelector : public ChunkSelector {
+public:
+    RandomChunkSelector() = default;
+    RandomChunkSelector(const RandomChunkSelector&) = delete;
+    RandomChunkSelector(RandomChunkSelector&&) noexcept = delete;
+    RandomChunkSelector& operator=(const RandomChunkSelector&) = delete;
+    RandomChunkSelector& operator=(RandomChunkSelector&&) noexcept = delete;
+    ~RandomChunkSelector() = default;
+
+    void add_chunk(cshared< Chunk >&) override;
+    void remove_chunk(cshared< Chunk >&) override;
+    cshared< Chunk > select_chunk(blk_count_t nblks, const blk_alloc_hints& hints) override;
+    void foreach_chunks(std::function< void(cshared< Chunk >&) >&& cb) override;
+
+private:
+    mutable std::shared_mutex m_chunks_mtx;
+    std::vector< shared< Chunk > > m_chunks;
+};
+
+} // namespace homestore
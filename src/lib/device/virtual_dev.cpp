@@ -13,10 +13,12 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <limits>
@@ -26,12 +28,14 @@
 #include <string>
 #include <system_error>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <sisl/fds/buffer.hpp>
 #include <sisl/metrics/metrics.hpp>
 #include <sisl/logging/logging.h>
 #include <sisl/utility/atomic_counter.hpp>
+#include <iomgr/iomgr.hpp>
 #include <iomgr/iomgr_flip.hpp>
 #include <homestore/homestore_decl.hpp>
 
@@ -45,6 +49,8 @@
 #include "common/crash_simulator.hpp"
 #include "blkalloc/varsize_blk_allocator.h"
 #include "device/round_robin_chunk_selector.h"
+#include "device/random_chunk_selector.h"
+#include "device/most_available_space_chunk_selector.h"
 #include "blkalloc/append_blk_allocator.h"
 #include "blkalloc/fixed_blk_allocator.h"
 
@@ -100,6 +106,14 @@ VirtualDev::VirtualDev(DeviceManager& dmgr, vdev_info const& vinfo, vdev_event_c
         m_chunk_selector = std::make_shared< RoundRobinChunkSelector >(false /* dynamically add chunk */);
         break;
     }
+    case chunk_selector_type_t::RANDOM: {
+        m_chunk_selector = std::make_shared< RandomChunkSelector >();
+        break;
+    }
+    case chunk_selector_type_t::MOST_AVAILABLE_SPACE: {
+        m_chunk_selector = std::make_shared< MostAvailableSpaceChunkSelector >();
+        break;
+    }
     case chunk_selector_type_t::CUSTOM: {
         HS_REL_ASSERT(custom_chunk_selector, "Expected custom chunk selector to be passed with selector_type=CUSTOM");
         m_chunk_selector = std::move(custom_chunk_selector);
@@ -113,10 +127,25 @@ VirtualDev::VirtualDev(DeviceManager& dmgr, vdev_info const& vinfo, vdev_event_c
     }
 }
 
+VirtualDev::~VirtualDev() {
+    // Stale replicas which are not resynced yet, are resynced on next start
+    m_resync_stopped.store(true, std::memory_order_release);
+    std::move(m_resync_done).get();
+}
+
 // TODO: Have an additional parameter for vdev to check if dynamic add chunk. If so, we need to take do an rcu for
 // m_all_chunks.
 void VirtualDev::add_chunk(cshared< Chunk >& chunk, bool is_fresh_chunk) {
     std::unique_lock lg{m_mgmt_mutex};
+    if (is_mirrored()) {
+        m_mirror_chunks[chunk->primary_chunk_id()].chunks.push_back(chunk);
+        if (chunk->primary_chunk_id() != chunk->chunk_id()) {
+            // Replica only mirrors the data of its primary chunk, blks are allocated on the primary alone
+            m_pdevs.insert(chunk->physical_dev_mutable());
+            return;
+        }
+    }
+
     auto ba = create_blk_allocator(m_allocator_type, block_size(), chunk->physical_dev()->optimal_page_size(),
                                    chunk->physical_dev()->align_size(), chunk->size(), m_auto_recovery,
                                    chunk->chunk_id(), is_fresh_chunk, m_use_slab_in_blk_allocator);
@@ -130,6 +159,13 @@ void VirtualDev::add_chunk(cshared< Chunk >& chunk, bool is_fresh_chunk) {
 
 void VirtualDev::remove_chunk(cshared< Chunk >& chunk) {
     std::unique_lock lg{m_mgmt_mutex};
+    if (is_mirrored()) {
+        if (auto it = m_mirror_chunks.find(chunk->primary_chunk_id()); it != m_mirror_chunks.end()) {
+            std::erase(it->second.chunks, chunk);
+            if (it->second.chunks.empty()) { m_mirror_chunks.erase(it); }
+        }
+        if (chunk->primary_chunk_id() != chunk->chunk_id()) { return; }
+    }
     m_all_chunks.erase(chunk->chunk_id());
     m_total_chunk_num--;
     m_chunk_selector->remove_chunk(chunk);
@@ -139,11 +175,24 @@ folly::Future< std::error_code > VirtualDev::async_format() {
     static thread_local std::vector< folly::Future< std::error_code > > s_futs;
     s_futs.clear();
 
-    for (auto& [_, chunk] : m_all_chunks) {
+    // Zeroing the chunks should not come in the way of any foreground IO on the same device
+    IOPriorityGuard priority_guard{io_priority_t::BACKGROUND};
+    auto format_chunk = [](cshared< Chunk >& chunk) {
         auto* pdev = chunk->physical_dev_mutable();
         LOGINFO("writing zero for chunk: {}, size: {}, offset: {}", chunk->chunk_id(), in_bytes(chunk->size()),
                 chunk->start_offset());
         s_futs.emplace_back(pdev->async_write_zero(chunk->size(), chunk->start_offset()));
+    };
+
+    for (auto& [_, chunk] : m_all_chunks) {
+        format_chunk(chunk);
+    }
+
+    // Replicas of mirrored vdev are not part of all chunks
+    for (auto& [primary_chunk_id, mg] : m_mirror_chunks) {
+        for (auto& chunk : mg.chunks) {
+            if (chunk->chunk_id() != primary_chunk_id) { format_chunk(chunk); }
+        }
     }
     return folly::collectAllUnsafe(s_futs).thenTry([](auto&& t) {
         for (const auto& err_c : t.value()) {
@@ -286,6 +335,9 @@ BlkAllocStatus VirtualDev::alloc_blks_from_chunk(blk_count_t nblks, blk_alloc_hi
         out_blkid = MultiBlkId{};
         status = BlkAllocStatus::FAILED;
     }
+    if (m_chunk_selector && ((status == BlkAllocStatus::SUCCESS) || (status == BlkAllocStatus::PARTIAL))) {
+        m_chunk_selector->on_space_changed(chunk);
+    }
 
     return status;
 }
@@ -301,6 +353,7 @@ void VirtualDev::free_blk(BlkId const& bid, VDevCPContext* vctx) {
             if (!chunk) HS_DBG_ASSERT(false, "chunk is missing for blkid {}", b.to_string());
             BlkAllocator* allocator = chunk->blk_allocator_mutable();
             allocator->free(b);
+            if (m_chunk_selector) { m_chunk_selector->on_space_changed(chunk); }
         }
     };
 
@@ -334,6 +387,11 @@ folly::Future< std::error_code > VirtualDev::async_write(const char* buf, uint32
     if (hs()->crash_simulator().is_crashed()) { return folly::makeFuture< std::error_code >(std::error_code()); }
 #endif
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        iovec const iov{const_cast< char* >(buf), size};
+        return mirrored_async_write(*mirrors, uint64_cast(bid.blk_num()) * block_size(), &iov, 1, size, part_of_batch);
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -359,6 +417,11 @@ folly::Future< std::error_code > VirtualDev::async_write(const char* buf, uint32
     if (sisl_unlikely(!is_chunk_available(chunk))) {
         return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::resource_unavailable_try_again));
     }
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        iovec const iov{const_cast< char* >(buf), size};
+        return mirrored_async_write(*mirrors, offset_in_chunk, &iov, 1, size, false /* part_of_batch */);
+    }
+
     auto const dev_offset = chunk->start_offset() + offset_in_chunk;
     auto* pdev = chunk->physical_dev_mutable();
 
@@ -377,6 +440,11 @@ folly::Future< std::error_code > VirtualDev::async_writev(const iovec* iov, cons
     if (hs()->crash_simulator().is_crashed()) { return folly::makeFuture< std::error_code >(std::error_code()); }
 #endif
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        return mirrored_async_write(*mirrors, uint64_cast(bid.blk_num()) * block_size(), iov, iovcnt,
+                                    get_len(iov, iovcnt), part_of_batch);
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -404,6 +472,9 @@ folly::Future< std::error_code > VirtualDev::async_writev(const iovec* iov, cons
     }
     auto const dev_offset = chunk->start_offset() + offset_in_chunk;
     auto const size = get_len(iov, iovcnt);
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        return mirrored_async_write(*mirrors, offset_in_chunk, iov, iovcnt, size, false /* part_of_batch */);
+    }
     auto* pdev = chunk->physical_dev_mutable();
 
     HS_LOG(TRACE, device, "Writing in device: {}, offset = {}", pdev->pdev_id(), dev_offset);
@@ -422,6 +493,11 @@ std::error_code VirtualDev::sync_write(const char* buf, uint32_t size, BlkId con
 
     HS_DBG_ASSERT_EQ(bid.is_multi(), false, "sync_write needs individual pieces of blkid - not MultiBlkid");
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        iovec const iov{const_cast< char* >(buf), size};
+        return mirrored_sync_write(*mirrors, uint64_cast(bid.blk_num()) * block_size(), &iov, 1, size);
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     HS_LOG(TRACE, device, "Writing sync in device: {}, offset = {}", chunk->physical_dev_mutable()->pdev_id(),
@@ -444,6 +520,10 @@ std::error_code VirtualDev::sync_write(const char* buf, uint32_t size, cshared<
     if (sisl_unlikely(!is_chunk_available(chunk))) {
         return std::make_error_code(std::errc::resource_unavailable_try_again);
     }
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        iovec const iov{const_cast< char* >(buf), size};
+        return mirrored_sync_write(*mirrors, offset_in_chunk, &iov, 1, size);
+    }
     return chunk->physical_dev_mutable()->sync_write(buf, size, chunk->start_offset() + offset_in_chunk);
 }
 
@@ -454,6 +534,11 @@ std::error_code VirtualDev::sync_writev(const iovec* iov, int iovcnt, BlkId cons
     if (hs()->crash_simulator().is_crashed()) { return std::error_code{}; }
 #endif
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        return mirrored_sync_write(*mirrors, uint64_cast(bid.blk_num()) * block_size(), iov, iovcnt,
+                                   get_len(iov, iovcnt));
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -484,6 +569,9 @@ std::error_code VirtualDev::sync_writev(const iovec* iov, int iovcnt, cshared< C
 
     uint64_t const dev_offset = chunk->start_offset() + offset_in_chunk;
     auto const size = get_len(iov, iovcnt);
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        return mirrored_sync_write(*mirrors, offset_in_chunk, iov, iovcnt, size);
+    }
     auto* pdev = chunk->physical_dev_mutable();
 
     HS_LOG(TRACE, device, "Writing sync in device: {}, offset = {}", pdev->pdev_id(), dev_offset);
@@ -503,6 +591,11 @@ folly::Future< std::error_code > VirtualDev::async_read(char* buf, uint64_t size
                                                         bool part_of_batch) {
     HS_DBG_ASSERT_EQ(bid.is_multi(), false, "async_read needs individual pieces of blkid - not MultiBlkid");
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        iovec iov{buf, size};
+        return mirrored_async_read(*mirrors, uint64_cast(bid.blk_num()) * block_size(), &iov, 1, size, part_of_batch);
+    }
+
     Chunk* pchunk;
     uint64_t const dev_offset = to_dev_offset(bid, &pchunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -515,6 +608,11 @@ folly::Future< std::error_code > VirtualDev::async_readv(iovec* iovs, int iovcnt
                                                          bool part_of_batch) {
     HS_DBG_ASSERT_EQ(bid.is_multi(), false, "async_readv needs individual pieces of blkid - not MultiBlkid");
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        return mirrored_async_read(*mirrors, uint64_cast(bid.blk_num()) * block_size(), iovs, iovcnt, size,
+                                   part_of_batch);
+    }
+
     Chunk* pchunk;
     uint64_t const dev_offset = to_dev_offset(bid, &pchunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -527,6 +625,11 @@ folly::Future< std::error_code > VirtualDev::async_readv(iovec* iovs, int iovcnt
 std::error_code VirtualDev::sync_read(char* buf, uint32_t size, BlkId const& bid) {
     HS_DBG_ASSERT_EQ(bid.is_multi(), false, "sync_read needs individual pieces of blkid - not MultiBlkid");
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        iovec iov{buf, size};
+        return mirrored_sync_read(*mirrors, uint64_cast(bid.blk_num()) * block_size(), &iov, 1, size);
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -539,12 +642,33 @@ std::error_code VirtualDev::sync_read(char* buf, uint32_t size, cshared< Chunk >
     if (sisl_unlikely(!is_chunk_available(chunk))) {
         return std::make_error_code(std::errc::resource_unavailable_try_again);
     }
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        iovec iov{buf, size};
+        return mirrored_sync_read(*mirrors, offset_in_chunk, &iov, 1, size);
+    }
     return chunk->physical_dev_mutable()->sync_read(buf, size, chunk->start_offset() + offset_in_chunk);
 }
 
+folly::Future< std::error_code > VirtualDev::async_read(char* buf, uint64_t size, cshared< Chunk >& chunk,
+                                                        uint64_t offset_in_chunk) {
+    if (sisl_unlikely(!is_chunk_available(chunk))) {
+        return folly::makeFuture< std::error_code >(std::make_error_code(std::errc::resource_unavailable_try_again));
+    }
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        iovec iov{buf, size};
+        return mirrored_async_read(*mirrors, offset_in_chunk, &iov, 1, size, false /* part_of_batch */);
+    }
+    return chunk->physical_dev_mutable()->async_read(buf, size, chunk->start_offset() + offset_in_chunk);
+}
+
 std::error_code VirtualDev::sync_readv(iovec* iov, int iovcnt, BlkId const& bid) {
     HS_DBG_ASSERT_EQ(bid.is_multi(), false, "sync_readv needs individual pieces of blkid - not MultiBlkid");
 
+    if (auto const* mirrors = mirrors_of(bid.chunk_num())) {
+        return mirrored_sync_read(*mirrors, uint64_cast(bid.blk_num()) * block_size(), iov, iovcnt,
+                                  get_len(iov, iovcnt));
+    }
+
     Chunk* chunk;
     uint64_t const dev_offset = to_dev_offset(bid, &chunk);
     if (sisl_unlikely(dev_offset == INVALID_DEV_OFFSET)) {
@@ -567,6 +691,9 @@ std::error_code VirtualDev::sync_readv(iovec* iov, int iovcnt, cshared< Chunk >&
     }
     uint64_t const dev_offset = chunk->start_offset() + offset_in_chunk;
     auto const size = get_len(iov, iovcnt);
+    if (auto const* mirrors = mirrors_of(chunk->chunk_id())) {
+        return mirrored_sync_read(*mirrors, offset_in_chunk, iov, iovcnt, size);
+    }
     auto* pdev = chunk->physical_dev_mutable();
 
     COUNTER_INCREMENT(m_metrics, vdev_write_count, 1);
@@ -630,6 +757,28 @@ bool VirtualDev::is_blk_exist(MultiBlkId const& b) const {
     return m_all_chunks.contains(chunk_num);
 }
 
+bool VirtualDev::is_mirrored() const {
+    return (m_vdev_info.multi_pdev_choice == enum_value(vdev_multi_pdev_opts_t::ALL_PDEV_MIRRORED)) &&
+        (m_vdev_info.num_mirrors > 1);
+}
+
+std::vector< shared< Chunk > > VirtualDev::get_mirror_chunks(uint16_t chunk_id) const {
+    auto const* mirrors = mirrors_of(chunk_id);
+    return mirrors ? mirrors->chunks : std::vector< shared< Chunk > >{};
+}
+
+void VirtualDev::resync_stale_mirrors() {
+    for (auto const& [primary_chunk_id, mg] : m_mirror_chunks) {
+        for (auto const& chunk : mg.chunks) {
+            if (!chunk->is_mirror_stale()) { continue; }
+            if (m_resync_stopped.load(std::memory_order_acquire)) { return; }
+            HS_LOG(INFO, device, "Resyncing stale replica {} of chunk={} from leader", chunk->to_string(),
+                   primary_chunk_id);
+            if (resync_mirror(mg, chunk)) { COUNTER_INCREMENT(m_metrics, vdev_mirror_resync_count, 1); }
+        }
+    }
+}
+
 /* Get status for all chunks */
 nlohmann::json VirtualDev::get_status(int log_level) const {
     nlohmann::json j;
@@ -700,6 +849,7 @@ void VirtualDev::cp_flush(VDevCPContext* v_cp_ctx) {
         if (!chunk) HS_DBG_ASSERT(false, "chunk is missing for blkid {}", b.to_string());
         BlkAllocator* allocator = chunk->blk_allocator_mutable();
         allocator->free(b);
+        m_chunk_selector->on_space_changed(chunk);
     }
 }
 
@@ -708,8 +858,27 @@ int VirtualDev::cp_progress_percent() { return 100; }
 
 void VirtualDev::recovery_completed() {
     if (m_allocator_type != blk_allocator_type_t::append) {
-        m_chunk_selector->foreach_chunks(
-            [this](cshared< Chunk >& chunk) { chunk->blk_allocator_mutable()->recovery_completed(); });
+        // Selector holds its chunk lock across foreach, so report the space changes only after the walk
+        std::vector< shared< Chunk > > chunks;
+        m_chunk_selector->foreach_chunks([&chunks](cshared< Chunk >& chunk) {
+            chunk->blk_allocator_mutable()->recovery_completed();
+            chunks.push_back(chunk);
+        });
+        for (auto const& chunk : chunks) {
+            m_chunk_selector->on_space_changed(chunk.get());
+        }
+    }
+
+    // Replicas which missed writes prior to restart are brought back in sync in the background, they do not serve any
+    // read till then
+    if (is_mirrored() && std::any_of(m_mirror_chunks.cbegin(), m_mirror_chunks.cend(),
+                                     [](auto const& p) { return p.second.has_stale(); })) {
+        auto done = std::make_shared< folly::Promise< folly::Unit > >();
+        m_resync_done = done->getFuture();
+        iomanager.run_on_forget(iomgr::reactor_regex::random_worker, iomgr::fiber_regex::syncio_only, [this, done]() {
+            resync_stale_mirrors();
+            done->setValue();
+        });
     }
 }
 
@@ -724,4 +893,365 @@ bool VirtualDev::is_chunk_available(cshared< Chunk >& chunk) const {
     return m_dmgr.get_chunk(chunk->chunk_id()) != nullptr;
 }
 
+VirtualDev::mirror_group const* VirtualDev::mirrors_of(uint16_t chunk_id) const {
+    if (m_mirror_chunks.empty()) { return nullptr; }
+    auto const it = m_mirror_chunks.find(chunk_id);
+    return (it == m_mirror_chunks.cend()) ? nullptr : &(it->second);
+}
+
+uint32_t VirtualDev::mirror_group::leader_idx() const {
+    for (uint32_t i{0}; i < chunks.size(); ++i) {
+        if (!chunks[i]->is_mirror_stale()) { return i; }
+    }
+    return 0;
+}
+
+bool VirtualDev::mirror_group::has_stale() const {
+    return std::any_of(chunks.cbegin(), chunks.cend(), [](auto const& c) { return c->is_mirror_stale(); });
+}
+
+bool VirtualDev::mirror_group::begin_write(uint64_t offset, uint64_t size) const {
+    inflight_writes.fetch_add(1);
+    if (!has_stale()) { return false; }
+
+    std::unique_lock lg{resync_mtx};
+    inflight_ranges.emplace(offset, offset + size);
+    if ((offset < resync_seg.second) && (offset + size > resync_seg.first)) { ++resync_seg_writes; }
+    return true;
+}
+
+void VirtualDev::mirror_group::end_write(uint64_t offset, uint64_t size, bool tracked) const {
+    inflight_writes.fetch_sub(1);
+    if (!tracked) { return; }
+
+    std::function< void() > drained_cb;
+    {
+        std::unique_lock lg{resync_mtx};
+        inflight_ranges.erase(inflight_ranges.find(std::make_pair(offset, offset + size)));
+        if (on_resync_seg_drained && !resync_seg_has_inflight_writes()) {
+            drained_cb = std::exchange(on_resync_seg_drained, nullptr);
+        }
+    }
+    if (drained_cb) { drained_cb(); }
+}
+
+bool VirtualDev::mirror_group::resync_seg_has_inflight_writes() const {
+    for (auto const& [start, end] : inflight_ranges) {
+        if (start >= resync_seg.second) { break; }
+        if (end > resync_seg.first) { return true; }
+    }
+    return false;
+}
+
+void VirtualDev::mirror_group::fence_resync_seg(uint64_t offset, uint64_t size) const {
+    std::unique_lock lg{resync_mtx};
+    resync_seg = {offset, offset + size};
+    resync_seg_writes = 0;
+    if (!resync_seg_has_inflight_writes()) { return; }
+
+    iomgr::FiberManagerLib::Promise< bool > p;
+    auto f = p.get_future();
+    on_resync_seg_drained = [&p]() { p.set_value(true); };
+    lg.unlock();
+    f.get();
+}
+
+// Pick the replica whose pdev has the least number of IOs in flight. Ties are broken by rotating the replica we start
+// with, so that reads are spread across all pdevs even at low queue depth. Stale replicas are never picked and while
+// any write is yet to complete on all replicas, only the leader is guaranteed to have all acknowledged writes.
+uint32_t VirtualDev::select_read_mirror(mirror_group const& mg) const {
+    auto const leader = mg.leader_idx();
+    if (mg.inflight_writes.load(std::memory_order_acquire) != 0) { return leader; }
+
+    static thread_local uint32_t t_next_mirror{0};
+    auto const nmirrors = uint32_cast(mg.chunks.size());
+    auto const start = t_next_mirror++ % nmirrors;
+
+    uint32_t selected{leader};
+    uint32_t min_depth{std::numeric_limits< uint32_t >::max()};
+    for (uint32_t i{0}; i < nmirrors; ++i) {
+        auto const idx = (start + i) % nmirrors;
+        if (mg.chunks[idx]->is_mirror_stale()) { continue; }
+        auto const depth = mg.chunks[idx]->physical_dev()->outstanding_ios();
+        if (depth < min_depth) {
+            min_depth = depth;
+            selected = idx;
+        }
+    }
+    return selected;
+}
+
+uint32_t VirtualDev::mirror_write_quorum(uint32_t nmirrors) const {
+    auto const quorum = HS_DYNAMIC_CONFIG(device->mirror_write_quorum);
+    return ((quorum == 0) || (quorum > nmirrors)) ? nmirrors : quorum;
+}
+
+// Replica which failed a write is persisted as stale before the write is completed. Otherwise the write could be
+// acknowledged and after a restart, replica which missed it would be treated as in sync. It needs sync io.
+void VirtualDev::on_mirror_write_failed(cshared< Chunk >& chunk, std::error_code ec) {
+    COUNTER_INCREMENT(m_metrics, vdev_mirror_write_error_count, 1);
+    HS_LOG(ERROR, device, "Mirrored write failed on device: {} error={}, marking the replica chunk={} stale",
+           chunk->physical_dev()->pdev_id(), ec.message(), chunk->chunk_id());
+    chunk->mark_mirror_stale();
+    chunk->persist_mirror_state();
+}
+
+// Write is issued on all replicas in parallel, including the stale ones so that they do not fall further behind, but
+// only the replicas which are in sync count towards the quorum. Write completes once quorum number of replicas are
+// written and the leader is one of them. If leader fails, it completes only after all replicas are done, so that the
+// next leader has it. It fails once enough of them failed that quorum can't be reached.
+folly::Future< std::error_code > VirtualDev::mirrored_async_write(mirror_group const& mg, uint64_t offset_in_chunk,
+                                                                  const iovec* iov, int iovcnt, uint64_t size,
+                                                                  bool part_of_batch) {
+    struct mirror_write_ctx {
+        folly::Promise< std::error_code > promise;
+        std::atomic< bool > completed{false};
+        std::vector< iovec > iovs;
+        uint8_t* data_copy{nullptr};
+        uint32_t nmirrors{0};
+        uint32_t nsynced{0};
+        uint32_t quorum{0};
+        uint32_t leader{0};
+        std::atomic< bool > leader_written{false};
+        std::atomic< uint32_t > nsuccess{0};
+        std::atomic< uint32_t > nfailed{0};
+        std::atomic< uint32_t > ndone{0};
+        std::atomic< uint32_t > npersisting{0}; // Failed replicas yet to be persisted as stale
+        std::error_code last_err;
+
+        ~mirror_write_ctx() {
+            if (data_copy) { hs_utils::iobuf_free(data_copy, sisl::buftag::common); }
+        }
+
+        void complete(std::error_code ec) {
+            if (!completed.exchange(true)) { promise.setValue(ec); }
+        }
+    };
+
+    auto ctx = std::make_shared< mirror_write_ctx >();
+    ctx->nmirrors = uint32_cast(mg.chunks.size());
+    ctx->leader = mg.leader_idx();
+    std::vector< bool > synced(ctx->nmirrors);
+    for (uint32_t i{0}; i < ctx->nmirrors; ++i) {
+        synced[i] = !mg.chunks[i]->is_mirror_stale();
+        if (synced[i]) { ++ctx->nsynced; }
+    }
+    if (ctx->nsynced == 0) {
+        // None of the replicas are in sync, nothing better to do than to treat them all alike
+        synced.assign(ctx->nmirrors, true);
+        ctx->nsynced = ctx->nmirrors;
+    }
+    ctx->quorum = mirror_write_quorum(ctx->nsynced);
+    if (ctx->quorum < ctx->nmirrors) {
+        // Caller is free to reuse its buffer once quorum is reached, while rest of the replicas are still being
+        // written, so they need a copy of their own
+        ctx->data_copy = hs_utils::iobuf_alloc(sisl::round_up(size, align_size()), sisl::buftag::common, align_size());
+        uint64_t copied{0};
+        for (int i{0}; i < iovcnt; ++i) {
+            std::memcpy(ctx->data_copy + copied, iov[i].iov_base, iov[i].iov_len);
+            copied += iov[i].iov_len;
+        }
+        ctx->iovs.push_back(iovec{ctx->data_copy, size});
+    } else {
+        // Drive keeps referring to the iovec array until the io is completed, which could outlive caller's frame
+        ctx->iovs.assign(iov, iov + iovcnt);
+    }
+    auto f = ctx->promise.getFuture();
+
+    COUNTER_INCREMENT(m_metrics, vdev_write_count, 1);
+    bool const tracked = mg.begin_write(offset_in_chunk, size);
+    for (uint32_t i{0}; i < ctx->nmirrors; ++i) {
+        auto const& chunk = mg.chunks[i];
+        auto* pdev = chunk->physical_dev_mutable();
+        auto const dev_offset = chunk->start_offset() + offset_in_chunk;
+        HS_LOG(TRACE, device, "Writing mirror in device: {}, offset = {}, size = {}", pdev->pdev_id(), dev_offset,
+               size);
+        if (sisl_unlikely(!hs_utils::mod_aligned_sz(dev_offset, pdev->align_size()))) {
+            COUNTER_INCREMENT(m_metrics, unalign_writes, 1);
+        }
+
+        auto on_done = [ctx, &mg, i, counted = bool{synced[i]}, tracked, offset_in_chunk, size](std::error_code ec) {
+            if (ec) {
+                ctx->npersisting.fetch_sub(1);
+                if (counted) {
+                    auto const nfailed = ctx->nfailed.fetch_add(1) + 1;
+                    if (nfailed == 1) { ctx->last_err = ec; }
+                    if (nfailed == ctx->nsynced - ctx->quorum + 1) { ctx->complete(ec); }
+                }
+            } else if (counted) {
+                if (i == ctx->leader) { ctx->leader_written.store(true); }
+                ctx->nsuccess.fetch_add(1);
+            }
+
+            // Not acknowledged while any replica which failed the write is yet to be persisted as stale
+            if ((ctx->nsuccess.load() >= ctx->quorum) && ctx->leader_written.load() &&
+                (ctx->npersisting.load() == 0)) {
+                ctx->complete(std::error_code{});
+            }
+
+            if (ctx->ndone.fetch_add(1) + 1 == ctx->nmirrors) {
+                // Leader either failed or completed after the quorum, everyone is done now
+                ctx->complete((ctx->nsuccess.load() >= ctx->quorum) ? std::error_code{} : ctx->last_err);
+                mg.end_write(offset_in_chunk, size, tracked);
+            }
+        };
+
+        pdev->async_writev(ctx->iovs.data(), int_cast(ctx->iovs.size()), uint32_cast(size), dev_offset, part_of_batch)
+            .thenValue([this, ctx, chunk, on_done = std::move(on_done)](std::error_code ec) {
+                if (!ec) { return on_done(ec); }
+
+                // Replica is skipped by reads right away, but persisting it needs sync io which can't be done in the io
+                // completion
+                chunk->mark_mirror_stale();
+                ctx->npersisting.fetch_add(1);
+                iomanager.run_on_forget(iomgr::reactor_regex::random_worker, iomgr::fiber_regex::syncio_only,
+                                        [this, chunk, ec, on_done]() {
+                                            on_mirror_write_failed(chunk, ec);
+                                            on_done(ec);
+                                        });
+            });
+    }
+    return f;
+}
+
+std::error_code VirtualDev::mirrored_sync_write(mirror_group const& mg, uint64_t offset_in_chunk, const iovec* iov,
+                                                int iovcnt, uint64_t size) {
+    uint32_t nsynced{0};
+    for (auto const& chunk : mg.chunks) {
+        if (!chunk->is_mirror_stale()) { ++nsynced; }
+    }
+    bool const none_synced = (nsynced == 0);
+    auto const quorum = mirror_write_quorum(none_synced ? uint32_cast(mg.chunks.size()) : nsynced);
+    uint32_t nsuccess{0};
+    std::error_code err;
+
+    COUNTER_INCREMENT(m_metrics, vdev_write_count, 1);
+    bool const tracked = mg.begin_write(offset_in_chunk, size);
+    for (auto const& chunk : mg.chunks) {
+        bool const counted = none_synced || !chunk->is_mirror_stale();
+        auto* pdev = chunk->physical_dev_mutable();
+        auto const ec = pdev->sync_writev(iov, iovcnt, uint32_cast(size), chunk->start_offset() + offset_in_chunk);
+        if (ec) {
+            on_mirror_write_failed(chunk, ec);
+            if (counted) { err = ec; }
+        } else if (counted) {
+            ++nsuccess;
+        }
+    }
+    mg.end_write(offset_in_chunk, size, tracked);
+    return (nsuccess >= quorum) ? std::error_code{} : err;
+}
+
+folly::Future< std::error_code > VirtualDev::mirrored_async_read(mirror_group const& mg, uint64_t offset_in_chunk,
+                                                                 iovec* iov, int iovcnt, uint64_t size,
+                                                                 bool part_of_batch) {
+    // Drive keeps referring to the iovec array until the io is completed, which could outlive caller's frame
+    auto iovs = std::make_shared< std::vector< iovec > >(iov, iov + iovcnt);
+    return read_from_mirror(mg.chunks.front()->primary_chunk_id(), select_read_mirror(mg), 0 /* nattempts */,
+                            std::move(iovs), offset_in_chunk, size, part_of_batch);
+}
+
+// Read from the given replica and on failure, retry on the next replica which is not stale till all of them are
+// attempted
+folly::Future< std::error_code > VirtualDev::read_from_mirror(uint16_t primary_chunk_id, uint32_t mirror_idx,
+                                                              uint32_t nattempts, shared< std::vector< iovec > > iovs,
+                                                              uint64_t offset_in_chunk, uint64_t size,
+                                                              bool part_of_batch) {
+    auto const& mirrors = mirrors_of(primary_chunk_id)->chunks;
+    auto const nmirrors = uint32_cast(mirrors.size());
+    while ((nattempts + 1 < nmirrors) && mirrors[mirror_idx % nmirrors]->is_mirror_stale()) {
+        ++mirror_idx;
+        ++nattempts;
+    }
+    auto const& chunk = mirrors[mirror_idx % nmirrors];
+    auto* pdev = chunk->physical_dev_mutable();
+
+    auto f = pdev->async_readv(iovs->data(), int_cast(iovs->size()), uint32_cast(size),
+                               chunk->start_offset() + offset_in_chunk, part_of_batch);
+    return std::move(f).thenValue([this, primary_chunk_id, mirror_idx, nattempts, iovs, offset_in_chunk, size,
+                                   pdev](std::error_code ec) {
+        if (!ec || (nattempts + 1 >= mirrors_of(primary_chunk_id)->chunks.size())) {
+            return folly::makeFuture< std::error_code >(std::move(ec));
+        }
+        COUNTER_INCREMENT(m_metrics, vdev_mirror_read_retry_count, 1);
+        HS_LOG(ERROR, device, "Mirrored read failed on device: {} error={}, retrying on next replica", pdev->pdev_id(),
+               ec.message());
+        return read_from_mirror(primary_chunk_id, mirror_idx + 1, nattempts + 1, iovs, offset_in_chunk, size,
+                                false /* part_of_batch */);
+    });
+}
+
+std::error_code VirtualDev::mirrored_sync_read(mirror_group const& mg, uint64_t offset_in_chunk, iovec* iov,
+                                               int iovcnt, uint64_t size) {
+    auto const nmirrors = uint32_cast(mg.chunks.size());
+    auto const start = select_read_mirror(mg);
+
+    // Stale replicas are the last resort, only if none of the others could serve it
+    std::error_code ec;
+    for (bool const stale_pass : {false, true}) {
+        for (uint32_t i{0}; i < nmirrors; ++i) {
+            auto const& chunk = mg.chunks[(start + i) % nmirrors];
+            if (chunk->is_mirror_stale() != stale_pass) { continue; }
+
+            auto* pdev = chunk->physical_dev_mutable();
+            ec = pdev->sync_readv(iov, iovcnt, uint32_cast(size), chunk->start_offset() + offset_in_chunk);
+            if (!ec) { return ec; }
+
+            COUNTER_INCREMENT(m_metrics, vdev_mirror_read_retry_count, 1);
+            HS_LOG(ERROR, device, "Mirrored read failed on device: {} error={}, retrying on next replica",
+                   pdev->pdev_id(), ec.message());
+        }
+    }
+    return ec;
+}
+
+// Copy the entire chunk from the leader to the stale replica a segment at a time. Segment is fenced while it is copied,
+// copy is valid only if no write was issued to the segment meanwhile, else it could have overwritten the replica with
+// older data, so it is copied again.
+bool VirtualDev::resync_mirror(mirror_group const& mg, cshared< Chunk >& stale_chunk) {
+    auto const seg_size = uint64_cast(sisl::round_up(1024 * 1024, align_size()));
+    auto buf = hs_utils::iobuf_alloc(seg_size, sisl::buftag::common, align_size());
+
+    bool success{true};
+    uint64_t offset{0};
+    while (offset < stale_chunk->size()) {
+        if (m_resync_stopped.load(std::memory_order_acquire)) {
+            success = false;
+            break;
+        }
+
+        auto const sz = uint32_cast(std::min(seg_size, stale_chunk->size() - offset));
+        mg.fence_resync_seg(offset, sz);
+
+        auto const& leader = mg.chunks[mg.leader_idx()];
+        if (leader == stale_chunk) {
+            HS_LOG(ERROR, device, "No replica of chunk={} is in sync to resync from", stale_chunk->primary_chunk_id());
+            success = false;
+            break;
+        }
+
+        auto ec = leader->physical_dev_mutable()->sync_read(r_cast< char* >(buf), sz, leader->start_offset() + offset);
+        if (!ec) {
+            ec = stale_chunk->physical_dev_mutable()->sync_write(r_cast< const char* >(buf), sz,
+                                                                 stale_chunk->start_offset() + offset);
+        }
+        if (ec) {
+            HS_LOG(ERROR, device, "Resync of replica chunk={} failed at offset={} error={}, it remains stale",
+                   stale_chunk->chunk_id(), offset, ec.message());
+            success = false;
+            break;
+        }
+        std::unique_lock lg{mg.resync_mtx};
+        if (mg.resync_seg_writes == 0) { offset += sz; }
+    }
+    {
+        std::unique_lock lg{mg.resync_mtx};
+        mg.resync_seg = {0, 0};
+    }
+    hs_utils::iobuf_free(buf, sisl::buftag::common);
+
+    if (success) { stale_chunk->clear_mirror_stale(); }
+    return success;
+}
+
 } // namespace homestore
@@ -20,9 +20,11 @@
 #include <memory>
 #include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <system_error>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <sisl/metrics/metrics.hpp>
@@ -54,6 +56,9 @@ public:
         REGISTER_COUNTER(default_chunk_allocation_cnt, "default chunk allocation count");
         REGISTER_COUNTER(random_chunk_allocation_cnt,
                          "random chunk allocation count"); // ideally it should be zero for hdd
+        REGISTER_COUNTER(vdev_mirror_write_error_count, "vdev mirrored write failures on a replica");
+        REGISTER_COUNTER(vdev_mirror_read_retry_count, "vdev mirrored reads retried on another replica");
+        REGISTER_COUNTER(vdev_mirror_resync_count, "vdev stale replicas resynced from the leader replica");
         register_me_to_farm();
     }
 
@@ -94,12 +99,46 @@ protected:
     std::mutex m_mgmt_mutex;          // Any mutex taken for management operations (like adding/removing chunks).
     std::set< PhysicalDev* > m_pdevs; // PDevs this vdev is working on
     std::map< uint16_t, shared< Chunk > > m_all_chunks; // All chunks part of this vdev
+    // Replicas of a primary chunk of mirrored vdev (including the primary itself) and the state of writes on them
+    struct mirror_group {
+        std::vector< shared< Chunk > > chunks;
+        // Writes which are not yet completed on all replicas. A write could be acknowledged before it is completed on
+        // all replicas, but never before it is completed on the leader. So while there are any, reads go to leader.
+        mutable std::atomic< uint32_t > inflight_writes{0};
+
+        // While the group has stale replicas, writes are tracked by their range in chunk, so that resync of a replica
+        // can fence the segment it copies. It waits for the writes in flight on the segment and copies it again if any
+        // write to it was issued while it was being copied. Writes to rest of the chunk are not held up.
+        mutable std::mutex resync_mtx;
+        mutable std::multiset< std::pair< uint64_t, uint64_t > > inflight_ranges;
+        mutable std::pair< uint64_t, uint64_t > resync_seg{0, 0};
+        mutable uint64_t resync_seg_writes{0};
+        mutable std::function< void() > on_resync_seg_drained;
+
+        // Leader is the first replica which is not stale
+        uint32_t leader_idx() const;
+        bool has_stale() const;
+
+        // Returns whether the write is tracked by its range, to be passed on to end_write once all replicas are done
+        bool begin_write(uint64_t offset, uint64_t size) const;
+        void end_write(uint64_t offset, uint64_t size, bool tracked) const;
+
+        // Set the segment being resynced and wait for the writes in flight on it
+        void fence_resync_seg(uint64_t offset, uint64_t size) const;
+        bool resync_seg_has_inflight_writes() const;
+    };
+
+    // For mirrored vdev, replicas of every primary chunk, keyed on primary chunk id. Only primary chunks are part of
+    // m_all_chunks, since blks are allocated on them.
+    std::map< uint16_t, mirror_group > m_mirror_chunks;
     uint64_t m_total_chunk_num{0};                      // Total number of chunks
     std::shared_ptr< ChunkSelector > m_chunk_selector;  // Instance of chunk selector
     blk_allocator_type_t m_allocator_type;
     chunk_selector_type_t m_chunk_selector_type;
     bool m_auto_recovery;
     bool m_use_slab_in_blk_allocator;
+    std::atomic< bool > m_resync_stopped{false};
+    folly::Future< folly::Unit > m_resync_done{folly::makeFuture()}; // Resync of stale replicas in background
 
 public:
     VirtualDev(DeviceManager& dmgr, const vdev_info& vinfo, vdev_event_cb_t event_cb, bool is_auto_recovery,
@@ -109,7 +148,7 @@ public:
     VirtualDev& operator=(VirtualDev const& other) = delete;
     VirtualDev(VirtualDev&&) noexcept = delete;
     VirtualDev& operator=(VirtualDev&&) noexcept = delete;
-    virtual ~VirtualDev() = default;
+    virtual ~VirtualDev();
 
     /// @brief Run any initialization of the vdev after recovery or first time.
     virtual void init() {}
@@ -245,6 +284,10 @@ public:
     // TODO: This needs to be removed once Journal starting to use AppendBlkAllocator
     std::error_code sync_read(char* buf, uint32_t size, cshared< Chunk >& chunk, uint64_t offset_in_chunk);
 
+    // TODO: This needs to be removed once Journal starting to use AppendBlkAllocator
+    folly::Future< std::error_code > async_read(char* buf, uint64_t size, cshared< Chunk >& chunk,
+                                                uint64_t offset_in_chunk);
+
     /// @brief Synchronously read the data for a given BlkId to vector of buffers
     /// @param iov : Vector of buffer to write read to
     /// @param iovcnt : Count of buffer
@@ -285,7 +328,7 @@ public:
     virtual uint32_t block_size() const { return m_vdev_info.blk_size; }
     virtual vdev_info info() const { return m_vdev_info; }
     virtual void update_info(const vdev_info& info) { m_vdev_info = info; }
-    virtual uint32_t num_mirrors() const { return 0; }
+    virtual uint32_t num_mirrors() const { return m_vdev_info.num_mirrors; }
     virtual std::string to_string() const;
     virtual nlohmann::json get_status(int log_level) const;
     virtual uint64_t get_total_chunk_num() const { return m_total_chunk_num; }
@@ -300,11 +343,40 @@ public:
     shared< Chunk > get_next_chunk(cshared< Chunk >& chunk);
     bool is_blk_exist(MultiBlkId const& b) const;
 
+    /// @brief Whether the data of this vdev is mirrored on all of its pdevs
+    bool is_mirrored() const;
+
+    /// @brief Get all replicas of the given chunk of a mirrored vdev, primary chunk being one of them.
+    /// @return Replicas which are available, empty if vdev is not mirrored
+    std::vector< shared< Chunk > > get_mirror_chunks(uint16_t chunk_id) const;
+
+    /// @brief Copy the data of replicas which were marked stale because of a failed write, from the leader replica.
+    /// Replicas continue to be skipped by reads until they are resynced. Needs sync io and is done in the background
+    /// after recovery, but could be called directly as well.
+    void resync_stale_mirrors();
+
     ///////////////////////// Meta operations on vdev ////////////////////////
     void update_vdev_private(const sisl::blob& data);
 
 private:
     uint64_t to_dev_offset(BlkId const& b, Chunk** chunk) const;
+    mirror_group const* mirrors_of(uint16_t chunk_id) const;
+    uint32_t select_read_mirror(mirror_group const& mg) const;
+    uint32_t mirror_write_quorum(uint32_t nmirrors) const;
+    void on_mirror_write_failed(cshared< Chunk >& chunk, std::error_code ec);
+    folly::Future< std::error_code > mirrored_async_write(mirror_group const& mg, uint64_t offset_in_chunk,
+                                                          const iovec* iov, int iovcnt, uint64_t size,
+                                                          bool part_of_batch);
+    std::error_code mirrored_sync_write(mirror_group const& mg, uint64_t offset_in_chunk, const iovec* iov, int iovcnt,
+                                        uint64_t size);
+    folly::Future< std::error_code > mirrored_async_read(mirror_group const& mg, uint64_t offset_in_chunk, iovec* iov,
+                                                         int iovcnt, uint64_t size, bool part_of_batch);
+    folly::Future< std::error_code > read_from_mirror(uint16_t primary_chunk_id, uint32_t mirror_idx,
+                                                      uint32_t nattempts, shared< std::vector< iovec > > iovs,
+                                                      uint64_t offset_in_chunk, uint64_t size, bool part_of_batch);
+    std::error_code mirrored_sync_read(mirror_group const& mg, uint64_t offset_in_chunk, iovec* iov, int iovcnt,
+                                       uint64_t size);
+    bool resync_mirror(mirror_group const& mg, cshared< Chunk >& stale_chunk);
     bool is_chunk_available(cshared< Chunk >& chunk) const;
     BlkAllocStatus alloc_blks_from_chunk(blk_count_t nblks, blk_alloc_hints const& hints, MultiBlkId& out_blkid,
                                          Chunk* chunk);
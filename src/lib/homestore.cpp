@@ -247,7 +247,8 @@ void HomeStore::format_and_start(std::map< uint32_t, hs_format_params >&& format
 void HomeStore::do_start() {
     const auto& inp_params = HomeStoreStaticConfig::instance().input;
 
-    uint64_t cache_size = resource_mgr().get_cache_size();
+    // Data read cache takes its share out of the overall cache, the evictor is left with the rest for index cache
+    uint64_t cache_size = resource_mgr().get_cache_size() - resource_mgr().get_data_read_cache_size();
     m_evictor = std::make_shared< sisl::LRUEvictor >(cache_size, 1000);
 
     if (m_before_services_starting_cb) { m_before_services_starting_cb(); }
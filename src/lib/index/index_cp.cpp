@@ -1,3 +1,4 @@
+#include <limits>
 #include <stack>
 #include <unordered_map>
 
@@ -5,6 +6,7 @@
 #include "index/index_cp.hpp"
 #include "index/wb_cache.hpp"
 #include "common/homestore_assert.hpp"
+#include "common/homestore_utils.hpp"
 
 namespace homestore {
 IndexCPCallbacks::IndexCPCallbacks(IndexWBCache* wb_cache) : m_wb_cache{wb_cache} {}
@@ -31,19 +33,8 @@ void IndexCPContext::add_to_txn_journal(uint32_t index_ordinal, const IndexBuffe
     auto record_size = txn_record::size_for_num_ids(created_bufs.size() + freed_bufs.size() + (left_child_buf ? 1 : 0) +
                                                     (parent_buf ? 1 : 0));
     std::unique_lock< iomgr::FiberManagerLib::mutex > lg{m_txn_journal_mtx};
-    if (m_txn_journal_buf.bytes() == nullptr) {
-        m_txn_journal_buf =
-            std::move(sisl::io_blob_safe{std::max(sizeof(txn_journal), 512ul), 512, sisl::buftag::metablk});
-        txn_journal* tj = new (m_txn_journal_buf.bytes()) txn_journal();
-        tj->cp_id = id();
-    }
-
-    txn_journal* tj = r_cast< txn_journal* >(m_txn_journal_buf.bytes());
-    if (m_txn_journal_buf.size() < tj->size + record_size) {
-        m_txn_journal_buf.buf_realloc(m_txn_journal_buf.size() + std::max(tj->size + record_size, 512u), 512,
-                                      sisl::buftag::metablk);
-        tj = r_cast< txn_journal* >(m_txn_journal_buf.bytes());
-    }
+    txn_journal* tj = journal_for_append(record_size);
+    HS_DBG_ASSERT_EQ(tj->num_deltas, 0, "Txn record is added after delta records are journaled");
 
     {
         auto rec = tj->append_record(index_ordinal);
@@ -63,6 +54,32 @@ void IndexCPContext::add_to_txn_journal(uint32_t index_ordinal, const IndexBuffe
     }
 }
 
+// Deltas are added once the cp is switched over and flush is started, so they are always after all the txn records
+void IndexCPContext::add_delta_to_journal(std::vector< uint8_t > const& delta) {
+    std::unique_lock< iomgr::FiberManagerLib::mutex > lg{m_txn_journal_mtx};
+    txn_journal* tj = journal_for_append(delta.size());
+    std::memcpy(m_txn_journal_buf.bytes() + tj->size, delta.data(), delta.size());
+    tj->size += delta.size();
+    ++tj->num_deltas;
+}
+
+IndexCPContext::txn_journal* IndexCPContext::journal_for_append(uint32_t record_size) {
+    if (m_txn_journal_buf.bytes() == nullptr) {
+        m_txn_journal_buf =
+            std::move(sisl::io_blob_safe{std::max(sizeof(txn_journal), 512ul), 512, sisl::buftag::metablk});
+        txn_journal* tj = new (m_txn_journal_buf.bytes()) txn_journal();
+        tj->cp_id = id();
+    }
+
+    txn_journal* tj = r_cast< txn_journal* >(m_txn_journal_buf.bytes());
+    if (m_txn_journal_buf.size() < tj->size + record_size) {
+        m_txn_journal_buf.buf_realloc(m_txn_journal_buf.size() + std::max(tj->size + record_size, 512u), 512,
+                                      sisl::buftag::metablk);
+        tj = r_cast< txn_journal* >(m_txn_journal_buf.bytes());
+    }
+    return tj;
+}
+
 void IndexCPContext::add_to_dirty_list(const IndexBufferPtr& buf) {
     m_dirty_buf_list.push_back(buf);
     buf->set_state(index_buf_state_t::DIRTY);
@@ -221,8 +238,12 @@ std::map< BlkId, IndexBufferPtr > IndexCPContext::recover(sisl::byte_view sb) {
         HS_DBG_ASSERT_LT(tj->cp_id, id(), "Persisted cp in wb txn journal is more than current cp");
         return {};
     }
-    HS_DBG_ASSERT_GT(tj->num_txns, 0, "Invalid txn_journal, num_txns is zero");
     HS_DBG_ASSERT_GT(tj->size, 0, "Invalid txn_journal, size of records is zero");
+    if (tj->num_txns == 0) {
+        // Journal has only the leaf deltas, which are replayed by wb cache already
+        HS_DBG_ASSERT_GT(tj->num_deltas, 0, "Invalid txn_journal, has neither txns nor deltas");
+        return {};
+    }
 
     std::map< BlkId, IndexBufferPtr > buf_map;
     uint8_t const* cur_ptr = r_cast< uint8_t const* >(tj) + sizeof(txn_journal);
@@ -303,19 +324,111 @@ void IndexCPContext::process_txn_record(txn_record const* rec, std::map< BlkId,
     }
 }
 
+sisl::byte_view IndexCPContext::txn_journal::upgrade(sisl::byte_view sb) {
+    auto const tj = r_cast< txn_journal const* >(sb.bytes());
+    if ((sb.size() >= sizeof(txn_journal)) && (tj->magic == journal_magic)) {
+        HS_REL_ASSERT_LE(tj->version, journal_version, "Index cp journal is of newer version, can't downgrade");
+        return sb;
+    }
+
+    auto const old_tj = r_cast< txn_journal_v1 const* >(sb.bytes());
+    HS_REL_ASSERT_GE(sb.size(), sizeof(txn_journal_v1), "Index cp journal is neither current nor legacy layout");
+    HS_REL_ASSERT_LE(old_tj->size, sb.size(), "Legacy index cp journal size is beyond its superblock");
+
+    uint32_t const records_size = old_tj->size - sizeof(txn_journal_v1);
+    auto new_buf = hs_utils::make_byte_array(sizeof(txn_journal) + records_size, false, sisl::buftag::metablk, 0);
+    auto new_tj = new (new_buf->bytes()) txn_journal();
+    new_tj->cp_id = old_tj->cp_id;
+    new_tj->num_txns = old_tj->num_txns;
+    new_tj->size = sizeof(txn_journal) + records_size;
+    std::memcpy(new_buf->bytes() + sizeof(txn_journal), sb.bytes() + sizeof(txn_journal_v1), records_size);
+
+    LOGINFOMOD(wbcache, "Upgraded legacy index cp journal of cp={} with {} txns to version={}", new_tj->cp_id,
+               new_tj->num_txns, journal_version);
+    return sisl::byte_view{new_buf};
+}
+
 void IndexCPContext::txn_journal::log_records() const { LOGINFO("{}", to_string()); }
 
+void IndexCPContext::txn_journal::foreach_delta(std::function< void(delta_record const*) > const& cb) const {
+    uint8_t const* cur_ptr = r_cast< uint8_t const* >(this) + sizeof(txn_journal);
+    for (uint32_t t{0}; t < num_txns; ++t) {
+        cur_ptr += r_cast< txn_record const* >(cur_ptr)->size();
+    }
+
+    for (uint32_t d{0}; d < num_deltas; ++d) {
+        delta_record const* rec = r_cast< delta_record const* >(cur_ptr);
+        cb(rec);
+        cur_ptr += rec->size;
+    }
+}
+
 std::string IndexCPContext::txn_journal::to_string() const {
-    std::string str = fmt::format("cp_id={}, num_txns={}, size={}", cp_id, num_txns, size);
+    std::string str = fmt::format("cp_id={}, num_txns={}, num_deltas={}, size={}", cp_id, num_txns, num_deltas, size);
     uint8_t const* cur_ptr = r_cast< uint8_t const* >(this) + sizeof(txn_journal);
     for (uint32_t t{0}; t < num_txns; ++t) {
         txn_record const* rec = r_cast< txn_record const* >(cur_ptr);
         fmt::format_to(std::back_inserter(str), "\n  {}: {}", t, rec->to_string());
         cur_ptr += rec->size();
     }
+    foreach_delta([&str](delta_record const* rec) {
+        fmt::format_to(std::back_inserter(str), "\n  delta: {}", rec->to_string());
+    });
     return str;
 }
 
+std::vector< uint8_t > IndexCPContext::delta_record::make(BlkId const& blk, cp_id_t cpid, uint8_t const* base,
+                                                          uint8_t const* cur, uint32_t node_size, uint32_t max_size) {
+    // Unchanged gaps smaller than a range header are cheaper to carry along than to start a new range
+    static constexpr uint32_t min_gap = sizeof(delta_range);
+
+    std::vector< uint8_t > out(sizeof(delta_record));
+    uint16_t nranges{0};
+    uint32_t off{0};
+    while (off < node_size) {
+        if (base[off] == cur[off]) {
+            ++off;
+            continue;
+        }
+
+        uint32_t end{off + 1};
+        uint32_t same{0};
+        while ((end < node_size) && (same <= min_gap)) {
+            same = (base[end] == cur[end]) ? same + 1 : 0;
+            ++end;
+        }
+        end -= same;
+
+        auto const len = end - off;
+        if ((out.size() + sizeof(delta_range) + len > max_size) || (len > std::numeric_limits< uint16_t >::max())) {
+            return {};
+        }
+        delta_range const r{.offset = static_cast< uint16_t >(off), .len = static_cast< uint16_t >(len)};
+        out.insert(out.end(), r_cast< uint8_t const* >(&r), r_cast< uint8_t const* >(&r) + sizeof(delta_range));
+        out.insert(out.end(), cur + off, cur + end);
+        ++nranges;
+        off = end;
+    }
+
+    auto rec = new (out.data()) delta_record(blk, cpid);
+    rec->num_ranges = nranges;
+    rec->size = uint32_cast(out.size());
+    return out;
+}
+
+void IndexCPContext::delta_record::apply(uint8_t* node_bytes) const {
+    uint8_t const* cur_ptr = r_cast< uint8_t const* >(this) + sizeof(delta_record);
+    for (uint16_t i{0}; i < num_ranges; ++i) {
+        delta_range const* r = r_cast< delta_range const* >(cur_ptr);
+        std::memcpy(node_bytes + r->offset, cur_ptr + sizeof(delta_range), r->len);
+        cur_ptr += sizeof(delta_range) + r->len;
+    }
+}
+
+std::string IndexCPContext::delta_record::to_string() const {
+    return fmt::format("node={} cp_id={} num_ranges={} size={}", blk_id().to_integer(), cp_id, num_ranges, size);
+}
+
 std::string IndexCPContext::txn_record::to_string() const {
     auto add_to_string = [this](std::string& str, uint8_t& idx, uint8_t id_count) {
         if (id_count == 0) {
@@ -15,6 +15,9 @@
  *********************************************************************************/
 #pragma once
 #include <atomic>
+#include <functional>
+#include <unordered_set>
+#include <vector>
 #include <sisl/fds/concurrent_insert_vector.hpp>
 #include <homestore/blk.h>
 #include <homestore/index/index_internal.hpp>
@@ -106,10 +109,54 @@ public:
         std::string to_string() const;
     };
 
+    // Changed byte range of the node, followed by the bytes of the range
+    struct delta_range {
+        uint16_t offset;
+        uint16_t len;
+    };
+
+    // Delta of a leaf node (updated in place) against its image on disk. Ranges are absolute bytes of the node, so
+    // applying the delta on the disk image brings the node to its content as of cp_id. Delta is always taken against
+    // the last fully written image, so only the latest delta of a node is needed.
+    struct delta_record {
+        compact_blkid_t id;
+        cp_id_t cp_id;
+        uint16_t num_ranges{0};
+        uint16_t reserved{0};
+        uint32_t size{sizeof(delta_record)}; // Total size including the ranges
+
+        delta_record(BlkId const& blk, cp_id_t cpid) : id{blk.blk_num(), blk.chunk_num()}, cp_id{cpid} {}
+
+        BlkId blk_id() const { return BlkId{id.first, (blk_count_t)1u, id.second}; }
+        void apply(uint8_t* node_bytes) const;
+        std::string to_string() const;
+
+        // Build the delta of cur against base. Returns empty vector if the delta would exceed max_size.
+        static std::vector< uint8_t > make(BlkId const& blk, cp_id_t cpid, uint8_t const* base, uint8_t const* cur,
+                                           uint32_t node_size, uint32_t max_size);
+    };
+
+    // Journal layout prior to versioning, which had only the txn records. Kept to upgrade the journal persisted by
+    // older versions.
+    struct txn_journal_v1 {
+        cp_id_t cp_id;
+        uint32_t num_txns{0};
+        uint32_t size{sizeof(txn_journal_v1)};
+    };
+
     struct txn_journal {
+        // Magic is chosen to have the sign bit set, so that it can never match the cp_id which legacy journal started
+        // with.
+        static constexpr uint64_t journal_magic{0xB7E1D0C5DE17A5EBul};
+        static constexpr uint16_t journal_version{2};
+
+        uint64_t magic{journal_magic};
+        uint16_t version{journal_version};
+        uint16_t reserved{0};
         cp_id_t cp_id;
         uint32_t num_txns{0};
         uint32_t size{sizeof(txn_journal)}; // Total size including this header
+        uint32_t num_deltas{0};             // Number of delta_records which follow the txn records
 
         struct append_guard {
             txn_journal* m_journal;
@@ -128,8 +175,12 @@ public:
             return append_guard(this, ordinal);
         }
 
+        void foreach_delta(std::function< void(delta_record const*) > const& cb) const;
         std::string to_string() const;
         void log_records() const;
+
+        // Returns the journal in the current layout, upgrading it if it was persisted in an older layout
+        static sisl::byte_view upgrade(sisl::byte_view sb);
     };
 #pragma pack()
 
@@ -144,6 +195,10 @@ public:
     iomgr::FiberManagerLib::mutex m_txn_journal_mtx;
     sisl::io_blob_safe m_txn_journal_buf;
 
+    // Dirty leaf buffers of this cp whose delta is journaled instead of writing the node. Populated before flush
+    // starts and only read after.
+    std::unordered_set< IndexBuffer* > m_delta_bufs;
+
 public:
     IndexCPContext(CP* cp);
     virtual ~IndexCPContext() = default;
@@ -152,6 +207,8 @@ public:
     void add_to_txn_journal(uint32_t index_ordinal, const IndexBufferPtr& parent_buf,
                             const IndexBufferPtr& left_child_buf, const IndexBufferPtrList& created_bufs,
                             const IndexBufferPtrList& freed_buf);
+    void add_delta_to_journal(std::vector< uint8_t > const& delta);
+    bool is_delta_journaled(IndexBufferPtr const& buf) const { return m_delta_bufs.contains(buf.get()); }
     std::map< BlkId, IndexBufferPtr > recover(sisl::byte_view sb);
 
     sisl::io_blob_safe const& journal_buf() const { return m_txn_journal_buf; }
@@ -171,6 +228,7 @@ private:
     void check_wait_for_leaders();
     void log_dags();
 
+    txn_journal* journal_for_append(uint32_t record_size);
     void process_txn_record(txn_record const* rec, std::map< BlkId, IndexBufferPtr >& buf_map);
 };
 
@@ -13,17 +13,24 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
+#include <sys/uio.h>
+#include <utility>
+
 #include <sisl/fds/thread_vector.hpp>
+#include <sisl/fds/compress.hpp>
 #include <homestore/btree/detail/btree_node.hpp>
 #include <homestore/index_service.hpp>
 #include <homestore/homestore.hpp>
 #include "device/chunk.h"
 #include "common/homestore_assert.hpp"
+#include "common/homestore_config.hpp"
 #include "common/homestore_utils.hpp"
 
 #include "wb_cache.hpp"
 #include "index_cp.hpp"
 #include "device/virtual_dev.hpp"
+#include "device/io_scheduler.hpp"
 #include "common/resource_mgr.hpp"
 
 #ifdef _PRERELEASE
@@ -62,6 +69,13 @@ IndexWBCache::IndexWBCache(const std::shared_ptr< VirtualDev >& vdev, std::pair<
     cp_mgr().register_consumer(cp_consumer_t::INDEX_SVC, std::move(std::make_unique< IndexCPCallbacks >(this)));
 }
 
+IndexWBCache::~IndexWBCache() {
+    std::unique_lock lg{m_delta_mtx};
+    for (auto const& [_, dn] : m_delta_nodes) {
+        resource_mgr().dec_index_delta_mem(dn.mem_size());
+    }
+}
+
 void IndexWBCache::start_flush_threads() {
     // Start WBCache flush threads
     struct Context {
@@ -140,25 +154,166 @@ void IndexWBCache::write_buf(const BtreeNodePtr& node, const IndexBufferPtr& buf
 void IndexWBCache::read_buf(bnodeid_t id, BtreeNodePtr& node, node_initializer_t&& node_initializer) {
     auto const blkid = BlkId{id};
 
-retry:
+    if (m_in_recovery) {
+        // Recovery is single threaded and doesn't use cache, so no need to share the read with others
+        auto idx_buf = std::make_shared< IndexBuffer >(blkid, m_node_size, m_vdev->align_size());
+        m_vdev->sync_read(r_cast< char* >(idx_buf->raw_buffer()), m_node_size, blkid);
+        decompress_node(idx_buf->raw_buffer());
+        node = node_initializer(idx_buf);
+        return;
+    }
+
     // Check if the blkid is already in cache, if not load and put it into the cache
-    if (!m_in_recovery && m_cache.get(blkid, node)) { return; }
+    if (m_cache.get(blkid, node)) { return; }
+
+    // Either issue a read or join the read already in flight for this blkid and wait for it without blocking the
+    // reactor, so that other fibers can continue to make progress.
+    auto [pread, is_new] = register_read(blkid);
+    if (is_new) { issue_reads({std::make_pair(blkid, pread)}, std::move(node_initializer), false /* part_of_batch */); }
+
+    auto fut = pread->done.getFuture();
+    std::error_code err;
+    if (iomanager.am_i_io_reactor()) {
+        iomgr::FiberManagerLib::Promise< std::error_code > p;
+        auto fiber_fut = p.get_future();
+        std::move(fut).thenValue([&p](std::error_code e) { p.set_value(e); });
+        err = fiber_fut.get();
+    } else {
+        err = std::move(fut).get();
+    }
+    HS_REL_ASSERT(!err, "Failed to read index node blkid={} error={}", blkid.to_string(), err.message());
+    node = pread->node;
+}
 
-    // Read the buffer from virtual device
-    auto idx_buf = std::make_shared< IndexBuffer >(blkid, m_node_size, m_vdev->align_size());
-    m_vdev->sync_read(r_cast< char* >(idx_buf->raw_buffer()), m_node_size, blkid);
+bool IndexWBCache::get_cached_node(bnodeid_t id, BtreeNodePtr& node) {
+    if (m_in_recovery) { return false; }
+    return m_cache.get(BlkId{id}, node);
+}
 
-    // Create the btree node out of buffer
-    node = node_initializer(idx_buf);
+uint64_t IndexWBCache::enter_optimistic_read() {
+    while (true) {
+        auto const epoch = m_read_epoch.load(std::memory_order_acquire);
+        m_epoch_readers[epoch & 1].fetch_add(1, std::memory_order_seq_cst);
 
-    // Push the node into cache
-    if (!m_in_recovery) {
-        bool done = m_cache.insert(node);
-        if (!done) {
-            // There is a race between 2 concurrent reads from vdev and other party won the race. Re-read from cache
-            goto retry;
+        // Epoch moved on before we registered, whoever advanced it could have missed us in the count
+        if (m_read_epoch.load(std::memory_order_seq_cst) == epoch) { return epoch; }
+        m_epoch_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void IndexWBCache::exit_optimistic_read(uint64_t epoch) {
+    m_epoch_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+}
+
+void IndexWBCache::retire_buf(IndexBufferPtr buf) {
+    std::unique_lock lg{m_retired_mtx};
+    m_retired_bufs.emplace_back(m_read_epoch.load(std::memory_order_acquire), std::move(buf));
+}
+
+void IndexWBCache::reclaim_retired_bufs() {
+    std::unique_lock lg{m_retired_mtx};
+    if (m_retired_bufs.empty()) { return; }
+
+    // Readers of the previous epoch are counted in the same slot as the next epoch
+    auto epoch = m_read_epoch.load(std::memory_order_acquire);
+    if (m_epoch_readers[(epoch + 1) & 1].load(std::memory_order_seq_cst) == 0) {
+        m_read_epoch.store(++epoch, std::memory_order_seq_cst);
+    }
+    while (!m_retired_bufs.empty() && ((m_retired_bufs.front().first + 2) <= epoch)) {
+        m_retired_bufs.pop_front();
+    }
+}
+
+void IndexWBCache::prefetch_bufs(std::vector< bnodeid_t > const& ids, node_initializer_t const& node_initializer) {
+    if (m_in_recovery) { return; }
+
+    pending_read_list_t reads;
+    for (auto const id : ids) {
+        auto const blkid = BlkId{id};
+        BtreeNodePtr node;
+        if (m_cache.get(blkid, node)) { continue; }
+
+        auto [pread, is_new] = register_read(blkid);
+        if (is_new) { reads.emplace_back(blkid, std::move(pread)); }
+    }
+    if (reads.empty()) { return; }
+
+    // Nodes which are adjacent on the device are read in one io, rest of them are batched and submitted together
+    std::sort(reads.begin(), reads.end(), [](auto const& a, auto const& b) {
+        return (a.first.chunk_num() != b.first.chunk_num()) ? (a.first.chunk_num() < b.first.chunk_num())
+                                                            : (a.first.blk_num() < b.first.blk_num());
+    });
+
+    auto it = reads.begin();
+    while (it != reads.end()) {
+        auto run_end = std::next(it);
+        while ((run_end != reads.end()) && (uint32_t(run_end - it) < max_nodes_per_read) &&
+               (run_end->first.chunk_num() == it->first.chunk_num()) &&
+               (run_end->first.blk_num() == it->first.blk_num() + (run_end - it))) {
+            ++run_end;
+        }
+        issue_reads(pending_read_list_t{it, run_end}, node_initializer, true /* part_of_batch */);
+        it = run_end;
+    }
+    m_vdev->submit_batch();
+    LOGTRACEMOD(wbcache, "Prefetch requested for {} nodes, issued reads for {} nodes", ids.size(), reads.size());
+}
+
+std::pair< std::shared_ptr< IndexWBCache::pending_read_t >, bool > IndexWBCache::register_read(BlkId const& blkid) {
+    std::unique_lock lg{m_pending_reads_mtx};
+    auto [it, inserted] = m_pending_reads.try_emplace(blkid, nullptr);
+    if (inserted) { it->second = std::make_shared< pending_read_t >(); }
+    return std::make_pair(it->second, inserted);
+}
+
+void IndexWBCache::issue_reads(pending_read_list_t reads, node_initializer_t node_initializer, bool part_of_batch) {
+    for (auto& [blkid, pread] : reads) {
+        pread->buf = std::make_shared< IndexBuffer >(blkid, m_node_size, m_vdev->align_size());
+    }
+
+    folly::Future< std::error_code > fut = folly::makeFuture< std::error_code >(std::error_code{});
+    std::vector< iovec > iovs;
+    if (reads.size() == 1) {
+        fut = m_vdev->async_read(r_cast< char* >(reads[0].second->buf->raw_buffer()), m_node_size, reads[0].first,
+                                 part_of_batch);
+    } else {
+        iovs.reserve(reads.size());
+        for (auto& [blkid, pread] : reads) {
+            iovs.push_back(iovec{.iov_base = pread->buf->raw_buffer(), .iov_len = m_node_size});
+        }
+        auto const& first = reads[0].first;
+        fut = m_vdev->async_readv(iovs.data(), int_cast(iovs.size()), uint64_cast(m_node_size) * reads.size(),
+                                  BlkId{first.blk_num(), blk_count_t(reads.size()), first.chunk_num()},
+                                  part_of_batch);
+    }
+
+    // iovs need to be alive until the io is submitted (which could be later for batch), so hold it till completion
+    std::move(fut).thenValue([this, reads = std::move(reads), iovs = std::move(iovs),
+                              initializer = std::move(node_initializer)](std::error_code err) {
+        for (auto const& [blkid, pread] : reads) {
+            complete_read(blkid, *pread, initializer, err);
         }
+    });
+}
+
+void IndexWBCache::complete_read(BlkId const& blkid, pending_read_t& pread, node_initializer_t const& initializer,
+                                 std::error_code err) {
+    if (!err) {
+        decompress_node(pread.buf->raw_buffer());
+        apply_journaled_delta(blkid, pread.buf->raw_buffer());
+        pread.node = initializer(pread.buf);
+
+        // If someone has inserted the node into cache after our cache lookup, (say the read which completed just
+        // before we started), use the one in cache.
+        BtreeNodePtr cached_node;
+        if (!m_cache.insert(pread.node) && m_cache.get(blkid, cached_node)) { pread.node = cached_node; }
+    }
+
+    {
+        std::unique_lock lg{m_pending_reads_mtx};
+        m_pending_reads.erase(blkid);
     }
+    pread.done.setValue(err);
 }
 
 bool IndexWBCache::get_writable_buf(const BtreeNodePtr& node, CPContext* context) {
@@ -185,7 +340,10 @@ bool IndexWBCache::get_writable_buf(const BtreeNodePtr& node, CPContext* context
         LOGTRACEMOD(wbcache, "cp={} cur_buf={} for node={} is dirtied by cp={} copying new_buf={}", icp_ctx->id(),
                     static_cast< void* >(idx_buf.get()), node->node_id(), idx_buf->m_dirtied_cp_id,
                     static_cast< void* >(new_buf.get()));
-        idx_buf = std::move(new_buf);
+
+        // Optimistic readers could still be reading the old buffer, it is freed only once they are done
+        retire_buf(std::exchange(idx_buf, std::move(new_buf)));
+        reclaim_retired_bufs();
     }
     idx_buf->m_dirtied_cp_id = icp_ctx->id();
     return true;
@@ -435,6 +593,12 @@ void IndexWBCache::free_buf(const IndexBufferPtr& buf, CPContext* cp_ctx) {
         HS_REL_ASSERT_EQ(done, true, "Race on cache removal of btree blkid?");
     }
     buf->m_node_freed = true;
+    {
+        // Delta of the node has to be carried until the cp which frees it is flushed
+        std::unique_lock lg{m_delta_mtx};
+        auto it = m_delta_nodes.find(buf->m_blkid);
+        if (it != m_delta_nodes.end()) { it->second.freed_cp_id = cp_ctx->id(); }
+    }
     resource_mgr().inc_free_blk(m_node_size);
     m_vdev->free_blk(buf->m_blkid, s_cast< VDevCPContext* >(cp_ctx));
 }
@@ -444,6 +608,7 @@ void IndexWBCache::load_buf(IndexBufferPtr const& buf) {
     if (buf->m_bytes == nullptr) {
         buf->m_bytes = hs_utils::iobuf_alloc(m_node_size, sisl::buftag::btree_node, m_vdev->align_size());
         m_vdev->sync_read(r_cast< char* >(buf->m_bytes), m_node_size, buf->blkid());
+        decompress_node(buf->m_bytes);
         buf->m_dirtied_cp_id = BtreeNode::get_modified_cp_id(buf->m_bytes);
     }
 }
@@ -528,6 +693,11 @@ void IndexWBCache::recover(sisl::byte_view sb) {
     }
 
     m_in_recovery = true; // For entirity of this call, we should mark it as being recovered.
+    sb = IndexCPContext::txn_journal::upgrade(std::move(sb));
+
+    // Bring the leaves which were journaled as delta to their latest image first, so that the rest of the recovery
+    // sees them as they were prior to the crash.
+    replay_leaf_deltas(sb);
 
     // Recover the CP Context with the buf_map of all the buffers that were dirtied in the last cp with its
     // relationship (up/down buf links) as it was by the cp that was flushing the buffers prior to unclean shutdown.
@@ -706,6 +876,9 @@ folly::Future< bool > IndexWBCache::async_cp_flush(IndexCPContext* cp_ctx) {
     //     LOGTRACEMOD(wbcache, "Transact cp storing in file {}\n\n\n", filename);
     //     cp_ctx->to_string_dot(filename);
     // #endif
+    // Retired bufs are otherwise reclaimed only when more bufs are retired
+    reclaim_retired_bufs();
+
     if (!cp_ctx->any_dirty_buffers()) {
         if (cp_ctx->id() == 0) {
             // For the first CP, we need to flush the journal buffer to the meta blk
@@ -724,6 +897,9 @@ folly::Future< bool > IndexWBCache::async_cp_flush(IndexCPContext* cp_ctx) {
     }
 #endif
 
+    // Append the deltas of the leaves which need not be written in this cp, so that it is part of the journal
+    journal_leaf_deltas(cp_ctx);
+
     // First thing is to flush the journal created as part of the CP.
     auto const& journal_buf = cp_ctx->journal_buf();
     auto txn = r_cast< IndexCPContext::txn_journal const* >(journal_buf.cbytes());
@@ -782,10 +958,21 @@ void IndexWBCache::do_flush_one_buf(IndexCPContext* cp_ctx, IndexBufferPtr const
         LOGTRACEMOD(wbcache, "Not flushing buf {} as it was freed, its here for merely dependency", cp_ctx->id(),
                     buf->to_string());
         process_write_completion(cp_ctx, buf);
+    } else if (cp_ctx->is_delta_journaled(buf)) {
+        LOGTRACEMOD(wbcache, "Not flushing buf {} as its delta is journaled in cp {}", buf->to_string(),
+                    cp_ctx->id());
+        process_write_completion(cp_ctx, buf);
     } else {
         LOGTRACEMOD(wbcache, "Flushing cp {} buf {}", cp_ctx->id(), buf->to_string());
-        m_vdev->async_write(r_cast< const char* >(buf->raw_buffer()), m_node_size, buf->m_blkid, part_of_batch)
-            .thenValue([buf, cp_ctx](auto) {
+        track_written_leaf(cp_ctx, buf);
+        auto const cimage = compress_node(buf);
+        uint8_t* cbytes = cimage.first;
+        IOPriorityGuard priority_guard{io_priority_t::CP_FLUSH};
+        m_vdev
+            ->async_write(r_cast< const char* >(cbytes ? cbytes : buf->raw_buffer()),
+                          cbytes ? cimage.second : m_node_size, buf->m_blkid, part_of_batch)
+            .thenValue([buf, cp_ctx, cbytes](auto) {
+                if (cbytes) { hs_utils::iobuf_free(cbytes, sisl::buftag::compression); }
                 try {
                     auto& pthis = s_cast< IndexWBCache& >(wb_cache());
                     pthis.process_write_completion(cp_ctx, buf);
@@ -796,6 +983,225 @@ void IndexWBCache::do_flush_one_buf(IndexCPContext* cp_ctx, IndexBufferPtr const
     }
 }
 
+/* Compress the node into a separate aligned buffer, if compression is turned on and is worthwhile. Returns the buffer
+ * (which the caller needs to free after write) and the size to write or nullptr if node is to be written as is.
+ */
+std::pair< uint8_t*, uint32_t > IndexWBCache::compress_node(IndexBufferPtr const& buf) const {
+    if (!HS_DYNAMIC_CONFIG(btree.compress_index_nodes)) { return std::make_pair(nullptr, 0u); }
+
+    auto const align_size = m_vdev->align_size();
+    auto const max_size =
+        sisl::round_up(sizeof(compressed_node_hdr) + sisl::Compress::max_compress_len(m_node_size), align_size);
+    auto cbytes = hs_utils::iobuf_alloc(max_size, sisl::buftag::compression, align_size);
+
+    size_t compressed_size = max_size - sizeof(compressed_node_hdr);
+    auto const ret = sisl::Compress::compress(r_cast< const char* >(buf->raw_buffer()),
+                                              r_cast< char* >(cbytes + sizeof(compressed_node_hdr)), m_node_size,
+                                              &compressed_size);
+    auto const write_size = sisl::round_up(sizeof(compressed_node_hdr) + compressed_size, align_size);
+    auto const limit_size = (uint64_cast(m_node_size) * HS_DYNAMIC_CONFIG(btree.index_compress_ratio_limit)) / 100;
+    if ((ret != 0) || (write_size > limit_size)) {
+        LOGTRACEMOD(wbcache, "Not compressing buf {}, ret={} compressed_size={}", buf->to_string(), ret,
+                    compressed_size);
+        hs_utils::iobuf_free(cbytes, sisl::buftag::compression);
+        return std::make_pair(nullptr, 0u);
+    }
+
+    new (cbytes) compressed_node_hdr{.compressed_size = uint32_cast(compressed_size)};
+    std::memset(cbytes + sizeof(compressed_node_hdr) + compressed_size, 0,
+                write_size - sizeof(compressed_node_hdr) - compressed_size);
+    return std::make_pair(cbytes, uint32_cast(write_size));
+}
+
+/* Decompress the node image read from disk in place. Nodes which are written uncompressed are left as is. If
+ * decompression fails (say torn write), bytes are left as is, which would be treated as an invalid node.
+ */
+void IndexWBCache::decompress_node(uint8_t* bytes) const {
+    auto const hdr = r_cast< compressed_node_hdr const* >(bytes);
+    if ((hdr->magic != compressed_node_magic) ||
+        ((sizeof(compressed_node_hdr) + hdr->compressed_size) > m_node_size)) {
+        return;
+    }
+
+    auto dbytes = hs_utils::iobuf_alloc(m_node_size, sisl::buftag::compression, m_vdev->align_size());
+    size_t decompressed_size = m_node_size;
+    auto const ret = sisl::Compress::decompress(r_cast< const char* >(bytes + sizeof(compressed_node_hdr)),
+                                                r_cast< char* >(dbytes), hdr->compressed_size, &decompressed_size);
+    if ((ret == 0) && (decompressed_size == m_node_size)) {
+        std::memcpy(bytes, dbytes, m_node_size);
+    } else {
+        LOGERROR("Failed to decompress index node, ret={} compressed_size={} decompressed_size={}", ret,
+                 hdr->compressed_size, decompressed_size);
+    }
+    hs_utils::iobuf_free(dbytes, sisl::buftag::compression);
+}
+
+//////////////////// Leaf Delta Journaling section /////////////////////////////////
+/* A leaf which is only updated in place (not part of any structure change txn in this cp) and whose last written image
+ * is known can be journaled as the delta against the image, instead of writing the node.
+ */
+bool IndexWBCache::is_delta_candidate(IndexBufferPtr const& buf, IndexCPContext const* cp_ctx) const {
+    if (buf->is_meta_buf() || buf->m_node_freed || (buf->m_created_cp_id == cp_ctx->id())) { return false; }
+    if ((buf->m_up_buffer != nullptr) || !buf->m_wait_for_down_buffers.testz()) { return false; }
+    return (r_cast< persistent_hdr_t const* >(buf->m_bytes)->leaf == 0x1);
+}
+
+/* Called before the journal of the cp is written. It decides which of the dirty leaves of this cp are journaled as
+ * delta and appends them along with the deltas of the leaves from earlier cps, which are not yet written in full.
+ */
+void IndexWBCache::journal_leaf_deltas(IndexCPContext* cp_ctx) {
+    auto const max_count = HS_DYNAMIC_CONFIG(btree.index_leaf_delta_max_count);
+    auto const max_size = HS_DYNAMIC_CONFIG(btree.index_leaf_delta_max_size);
+    auto const journal_max_size = HS_DYNAMIC_CONFIG(btree.index_delta_journal_max_size);
+
+    std::unique_lock lg{m_delta_mtx};
+    if ((max_count == 0) && m_delta_nodes.empty()) { return; }
+
+    // Prior cp is completely flushed by now. Drop the nodes which it has freed. Images of the nodes which have no
+    // delta pending are dropped as well, least recently written first, if they are over the memory limit or delta
+    // journaling is turned off.
+    uint64_t journal_size{0};
+    std::vector< std::pair< cp_id_t, BlkId > > idle_nodes;
+    for (auto it = m_delta_nodes.begin(); it != m_delta_nodes.end();) {
+        auto& dn = it->second;
+        if ((dn.freed_cp_id != -1) && (dn.freed_cp_id < cp_ctx->id())) {
+            resource_mgr().dec_index_delta_mem(dn.mem_size());
+            it = m_delta_nodes.erase(it);
+            continue;
+        }
+        if (dn.journaled.empty()) { idle_nodes.emplace_back(dn.written_cp_id, it->first); }
+        journal_size += dn.journaled.size();
+        ++it;
+    }
+
+    if ((max_count == 0) || (resource_mgr().cur_index_delta_mem() > resource_mgr().get_index_delta_mem_limit())) {
+        std::sort(idle_nodes.begin(), idle_nodes.end(),
+                  [](auto const& a, auto const& b) { return a.first < b.first; });
+        uint32_t nevicted{0};
+        for (auto const& [_, blkid] : idle_nodes) {
+            if ((max_count != 0) &&
+                (resource_mgr().cur_index_delta_mem() <= resource_mgr().get_index_delta_mem_limit())) {
+                break;
+            }
+            auto it = m_delta_nodes.find(blkid);
+            resource_mgr().dec_index_delta_mem(it->second.mem_size());
+            m_delta_nodes.erase(it);
+            ++nevicted;
+        }
+        LOGDEBUGMOD(wbcache, "cp {} evicted {} leaf images kept for delta, memory used={} limit={}", cp_ctx->id(),
+                    nevicted, resource_mgr().cur_index_delta_mem(), resource_mgr().get_index_delta_mem_limit());
+    }
+
+    if ((max_count != 0) && (m_node_size <= std::numeric_limits< uint16_t >::max())) {
+        cp_ctx->m_dirty_buf_list.foreach_entry([&](IndexBufferPtr const& buf) {
+            if (!is_delta_candidate(buf, cp_ctx)) { return; }
+
+            auto it = m_delta_nodes.find(buf->m_blkid);
+            if ((it == m_delta_nodes.end()) || (it->second.freed_cp_id != -1)) { return; }
+            auto& dn = it->second;
+            if (dn.ndeltas >= max_count) { return; } // Time to write the full node
+
+            auto delta = IndexCPContext::delta_record::make(buf->m_blkid, cp_ctx->id(), dn.base.data(),
+                                                            buf->raw_buffer(), m_node_size, max_size);
+            if (delta.empty() || (journal_size - dn.journaled.size() + delta.size() > journal_max_size)) { return; }
+
+            journal_size = journal_size - dn.journaled.size() + delta.size();
+            resource_mgr().inc_index_delta_mem(s_cast< int64_t >(delta.size()) -
+                                               s_cast< int64_t >(dn.journaled.size()));
+            dn.journaled = std::move(delta);
+            ++dn.ndeltas;
+            cp_ctx->m_delta_bufs.insert(buf.get());
+        });
+    }
+
+    for (auto const& [_, dn] : m_delta_nodes) {
+        if (!dn.journaled.empty()) { cp_ctx->add_delta_to_journal(dn.journaled); }
+    }
+    if (!m_delta_nodes.empty()) {
+        LOGTRACEMOD(wbcache, "cp {} journaled {} leaf deltas in this cp, total delta size={} tracked nodes={}",
+                    cp_ctx->id(), cp_ctx->m_delta_bufs.size(), journal_size, m_delta_nodes.size());
+    }
+}
+
+/* Remember the image of the leaf being written in full, which subsequent cps can take delta against. Delta journaled
+ * for the leaf so far is retired, since the journal of this cp is already written and the subsequent ones don't need
+ * it anymore.
+ */
+void IndexWBCache::track_written_leaf(IndexCPContext* cp_ctx, IndexBufferPtr const& buf) {
+    if (r_cast< persistent_hdr_t const* >(buf->m_bytes)->leaf == 0x0) { return; }
+
+    bool tracked;
+    {
+        std::unique_lock lg{m_delta_mtx};
+        tracked = m_delta_nodes.contains(buf->m_blkid);
+    }
+    bool const keep_image = (HS_DYNAMIC_CONFIG(btree.index_leaf_delta_max_count) != 0) &&
+        (tracked || resource_mgr().can_add_index_delta_mem(m_node_size));
+    if (!tracked && !keep_image) { return; }
+
+    // Image is copied outside the lock, since it is on the flush path of every leaf
+    std::vector< uint8_t > image;
+    if (keep_image) { image.assign(buf->raw_buffer(), buf->raw_buffer() + m_node_size); }
+
+    std::unique_lock lg{m_delta_mtx};
+    auto it = m_delta_nodes.find(buf->m_blkid);
+    if (it != m_delta_nodes.end()) { resource_mgr().dec_index_delta_mem(it->second.mem_size()); }
+    if (image.empty()) {
+        if (it != m_delta_nodes.end()) { m_delta_nodes.erase(it); }
+        return;
+    }
+    if (it == m_delta_nodes.end()) { it = m_delta_nodes.emplace(buf->m_blkid, delta_node_t{}).first; }
+
+    auto& dn = it->second;
+    dn.base = std::move(image);
+    dn.journaled.clear();
+    dn.ndeltas = 0;
+    dn.written_cp_id = cp_ctx->id();
+    resource_mgr().inc_index_delta_mem(dn.mem_size());
+}
+
+/* Node read from disk could be missing the updates which are only in journaled delta */
+void IndexWBCache::apply_journaled_delta(BlkId const& blkid, uint8_t* bytes) {
+    std::unique_lock lg{m_delta_mtx};
+    if (m_delta_nodes.empty()) { return; }
+
+    auto it = m_delta_nodes.find(blkid);
+    if ((it == m_delta_nodes.end()) || it->second.journaled.empty()) { return; }
+
+    auto const rec = r_cast< IndexCPContext::delta_record const* >(it->second.journaled.data());
+    if (BtreeNode::get_modified_cp_id(bytes) < rec->cp_id) { rec->apply(bytes); }
+}
+
+/* Apply the leaf deltas in the journal on the nodes and write them in full. Delta is applied only if the node on disk
+ * is older than the delta, since the node could have been written in full after the delta was journaled.
+ */
+void IndexWBCache::replay_leaf_deltas(sisl::byte_view const& sb) {
+    auto const tj = r_cast< IndexCPContext::txn_journal const* >(sb.bytes());
+    if ((sb.size() < sizeof(IndexCPContext::txn_journal)) || (tj->num_deltas == 0)) { return; }
+
+    uint32_t nreplayed{0};
+    auto bytes = hs_utils::iobuf_alloc(m_node_size, sisl::buftag::btree_node, m_vdev->align_size());
+    tj->foreach_delta([this, bytes, &nreplayed](IndexCPContext::delta_record const* rec) {
+        auto const blkid = rec->blk_id();
+        m_vdev->sync_read(r_cast< char* >(bytes), m_node_size, blkid);
+        decompress_node(bytes);
+        if (!BtreeNode::is_valid_node(sisl::blob{bytes, m_node_size}) ||
+            (BtreeNode::get_modified_cp_id(bytes) >= rec->cp_id)) {
+            LOGTRACEMOD(wbcache, "Skipping replay of leaf delta {}, node is written after it", rec->to_string());
+            return;
+        }
+
+        rec->apply(bytes);
+        m_vdev->sync_write(r_cast< const char* >(bytes), m_node_size, blkid);
+        ++nreplayed;
+        LOGTRACEMOD(wbcache, "Replayed leaf delta {}", rec->to_string());
+    });
+    hs_utils::iobuf_free(bytes, sisl::buftag::btree_node);
+
+    LOGINFOMOD(wbcache, "Index recovery replayed {} out of {} leaf deltas from journal of cp={}", nreplayed,
+               tj->num_deltas, tj->cp_id);
+}
+
 void IndexWBCache::process_write_completion(IndexCPContext* cp_ctx, IndexBufferPtr const& buf) {
 #ifdef _PRERELEASE
     static std::once_flag flag;
@@ -14,8 +14,14 @@
  *
  *********************************************************************************/
 #pragma once
+#include <array>
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
+#include <folly/futures/SharedPromise.h>
 #include <iomgr/iomgr.hpp>
 #include <homestore/index/wb_cache_base.hpp>
 #include <homestore/index/index_internal.hpp>
@@ -34,21 +40,75 @@ class VirtualDev;
 
 class IndexWBCache : public IndexWBCacheBase {
 private:
+    // Read of a node from vdev which is in flight. Concurrent readers of the same blkid share this instead of issuing
+    // a read of their own. The node is set (and put into the cache) before the promise is fulfilled.
+    struct pending_read_t {
+        IndexBufferPtr buf;
+        BtreeNodePtr node;
+        folly::SharedPromise< std::error_code > done;
+    };
+    using pending_read_list_t = std::vector< std::pair< BlkId, std::shared_ptr< pending_read_t > > >;
+
+    // Maximum adjacent nodes which are coalesced into one device read while prefetching
+    static constexpr uint32_t max_nodes_per_read{32};
+
+    // Header of the compressed image of a node on disk. Magic is at the same offset as btree node magic, so that a
+    // read can tell them apart. Rest of the block beyond the compressed size is not written and is left stale.
+    static constexpr uint8_t compressed_node_magic{0xac};
+#pragma pack(1)
+    struct compressed_node_hdr {
+        uint8_t magic{compressed_node_magic};
+        uint8_t version{0x01};
+        uint16_t reserved{0};
+        uint32_t compressed_size{0};
+    };
+#pragma pack()
+
+    // Leaf node which is tracked for delta journaling. Base is the image of the node as last written to disk and
+    // journaled is the last delta record of the node in the cp journal (which has to be carried on to subsequent cp
+    // journals until the node is written in full). Memory of both is accounted in resource manager.
+    struct delta_node_t {
+        std::vector< uint8_t > base;
+        std::vector< uint8_t > journaled;
+        uint32_t ndeltas{0};
+        cp_id_t written_cp_id{-1};
+        cp_id_t freed_cp_id{-1};
+
+        int64_t mem_size() const { return s_cast< int64_t >(base.size() + journaled.size()); }
+    };
+
     std::shared_ptr< VirtualDev > m_vdev;
     sisl::SimpleCache< BlkId, BtreeNodePtr > m_cache;
     uint32_t m_node_size;
     std::vector< iomgr::io_fiber_t > m_cp_flush_fibers;
     std::mutex m_flush_mtx;
+    std::mutex m_pending_reads_mtx;
+    std::unordered_map< BlkId, std::shared_ptr< pending_read_t > > m_pending_reads;
     void* m_meta_blk;
     bool m_in_recovery{false};
+    std::mutex m_delta_mtx;
+    std::unordered_map< BlkId, delta_node_t > m_delta_nodes;
+
+    // Buffers replaced by get_writable_buf, which optimistic readers could still be reading, are reclaimed by epochs.
+    // Readers are counted in the slot of the epoch they entered and epoch is advanced only once no reader of the
+    // previous epoch remains, so a buffer retired in epoch e is unreachable once the epoch is e + 2.
+    std::atomic< uint64_t > m_read_epoch{0};
+    std::array< std::atomic< uint64_t >, 2 > m_epoch_readers{};
+    std::mutex m_retired_mtx;
+    std::deque< std::pair< uint64_t, IndexBufferPtr > > m_retired_bufs; // Protected by m_retired_mtx
 
 public:
     IndexWBCache(const std::shared_ptr< VirtualDev >& vdev, std::pair< meta_blk*, sisl::byte_view > sb,
                  const std::shared_ptr< sisl::Evictor >& evictor, uint32_t node_size);
+    ~IndexWBCache() override;
 
     BtreeNodePtr alloc_buf(node_initializer_t&& node_initializer) override;
     void write_buf(const BtreeNodePtr& node, const IndexBufferPtr& buf, CPContext* cp_ctx) override;
     void read_buf(bnodeid_t id, BtreeNodePtr& node, node_initializer_t&& node_initializer) override;
+    void prefetch_bufs(std::vector< bnodeid_t > const& ids, node_initializer_t const& node_initializer) override;
+    bool get_cached_node(bnodeid_t id, BtreeNodePtr& node) override;
+    uint64_t enter_optimistic_read() override;
+    void exit_optimistic_read(uint64_t epoch) override;
 
     bool get_writable_buf(const BtreeNodePtr& node, CPContext* context) override;
     void transact_bufs(uint32_t index_ordinal, IndexBufferPtr const& parent_buf, IndexBufferPtr const& child_buf,
@@ -64,10 +124,23 @@ public:
 
 private:
     void start_flush_threads();
+    std::pair< std::shared_ptr< pending_read_t >, bool > register_read(BlkId const& blkid);
+    void issue_reads(pending_read_list_t reads, node_initializer_t node_initializer, bool part_of_batch);
+    void complete_read(BlkId const& blkid, pending_read_t& pread, node_initializer_t const& initializer,
+                       std::error_code err);
     void recover_new_nodes(sisl::byte_view sb);
     void process_write_completion(IndexCPContext* cp_ctx, IndexBufferPtr const& pbuf);
     void do_flush_one_buf(IndexCPContext* cp_ctx, IndexBufferPtr const& buf, bool part_of_batch);
+    std::pair< uint8_t*, uint32_t > compress_node(IndexBufferPtr const& buf) const;
+    void decompress_node(uint8_t* bytes) const;
+    void journal_leaf_deltas(IndexCPContext* cp_ctx);
+    bool is_delta_candidate(IndexBufferPtr const& buf, IndexCPContext const* cp_ctx) const;
+    void track_written_leaf(IndexCPContext* cp_ctx, IndexBufferPtr const& buf);
+    void apply_journaled_delta(BlkId const& blkid, uint8_t* bytes);
+    void replay_leaf_deltas(sisl::byte_view const& sb);
     void link_buf(IndexBufferPtr const& up, IndexBufferPtr const& down, bool is_sibling_link, CPContext* cp_ctx);
+    void retire_buf(IndexBufferPtr buf);
+    void reclaim_retired_bufs();
 
     std::pair< IndexBufferPtr, bool > on_buf_flush_done(IndexCPContext* cp_ctx, IndexBufferPtr const& buf);
     std::pair< IndexBufferPtr, bool > on_buf_flush_done_internal(IndexCPContext* cp_ctx, IndexBufferPtr const& buf);
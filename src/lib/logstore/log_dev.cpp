@@ -18,6 +18,7 @@
 #include <cstring>
 #include <iterator>
 
+#include <sisl/fds/compress.hpp>
 #include <sisl/fds/vector_pool.hpp>
 #include <iomgr/iomgr_flip.hpp>
 
@@ -83,6 +84,7 @@ void LogDev::start(bool format, std::shared_ptr< JournalVirtualDev > vdev) {
         do_load(m_logdev_meta.get_start_dev_offset());
         m_log_records->reinit(m_log_idx);
         m_last_flush_idx = m_log_idx - 1;
+        m_last_issued_idx = m_last_flush_idx;
     }
 
     if (allow_timer_flush()) start_timer();
@@ -114,7 +116,10 @@ LogDev::~LogDev() {
     m_log_idx.store(0);
     m_pending_flush_size.store(0);
     m_last_flush_idx = -1;
+    m_last_issued_idx = -1;
     m_last_flush_ld_key = logdev_key{0, 0};
+    m_durable_upto_offset.store(0);
+    m_tail_cache.clear();
     m_last_truncate_idx = -1;
     m_last_crc = INVALID_CRC32_VALUE;
 
@@ -135,6 +140,7 @@ void LogDev::stop() {
     {
         std::unique_lock lg = flush_guard();
         // waiting under lock to make sure no new flush is started
+        wait_for_flush_completion();
         while (m_pending_callback.load() > 0) {
             THIS_LOGDEV_LOG(INFO, "Waiting for pending callbacks to complete, pending callbacks {}",
                             m_pending_callback.load());
@@ -175,7 +181,12 @@ void LogDev::stop_timer() {
 }
 
 void LogDev::do_load(off_t device_cursor) {
-    log_stream_reader lstream{device_cursor, m_vdev, m_vdev_jd, m_flush_size_multiple};
+    log_stream_reader lstream{device_cursor,
+                              m_vdev,
+                              m_vdev_jd,
+                              m_flush_size_multiple,
+                              true /* own_cursor */,
+                              HS_DYNAMIC_CONFIG(logstore.recovery_read_ahead_bufs)};
     logid_t loaded_from{-1};
     off_t group_dev_offset = 0;
 
@@ -185,6 +196,7 @@ void LogDev::do_load(off_t device_cursor) {
         const auto buf = lstream.next_group(&group_dev_offset);
         if (buf.size() == 0) {
             THIS_LOGDEV_LOG(INFO, "LogDev loaded log_idx in range of [{} - {}]", loaded_from, m_log_idx - 1);
+            if (!lstream.end_of_stream()) { assert_log_tail(lstream); }
             break;
         }
 
@@ -212,6 +224,7 @@ void LogDev::do_load(off_t device_cursor) {
             sisl::byte_view b = buf;
             b.move_forward(data_offset);
             b.set_size(rec->size);
+            b = record_data(rec, b);
             if (m_last_truncate_idx == -1) { m_last_truncate_idx = header->start_idx() + i; }
             // Validate if the id is present in rollback info
             if (m_logdev_meta.is_rolled_back(rec->store_id, header->start_idx() + i)) {
@@ -234,6 +247,7 @@ void LogDev::do_load(off_t device_cursor) {
     // Update the tail offset with where we finally end up loading, so that new append entries can be written from
     // here.
     m_vdev_jd->update_tail_offset(group_dev_offset);
+    m_durable_upto_offset.store(group_dev_offset, std::memory_order_release);
     THIS_LOGDEV_LOG(TRACE, "LogDev::do_load end {} ", m_logdev_id);
 }
 
@@ -253,6 +267,41 @@ void LogDev::assert_next_pages(log_stream_reader& lstream) {
     }
 }
 
+void LogDev::assert_log_tail(log_stream_reader& lstream) {
+    // Log groups are flushed in parallel, so the groups issued after the one which ended the log could have been
+    // completely written. None of them were acknowledged as the groups complete in order, but there can't be more of
+    // them than the groups allowed in flight. Otherwise the log was broken somewhere before its tail, which is a
+    // corruption.
+    auto const max_inflight = std::max(HS_DYNAMIC_CONFIG(logstore.max_inflight_log_groups), 1u);
+    uint32_t nskipped{0};
+    uint32_t ngroups{0};
+    logid_t next_idx{-1};
+    off_t dev_offset;
+
+    while (nskipped < HS_DYNAMIC_CONFIG(logstore->recovery_max_blks_read_for_additional_check)) {
+        const auto buf = lstream.next_group(&dev_offset);
+        if (buf.size() == 0) {
+            // Groups in flight are laid out back to back, so anything but a group after them is the end of them
+            if (lstream.end_of_stream() || (ngroups != 0)) { break; }
+            ++nskipped;
+            continue;
+        }
+
+        auto* header = r_cast< const log_group_header* >(buf.bytes());
+        if (header->start_idx() < m_log_idx.load(std::memory_order_acquire)) { break; } // Stale group from chunk reuse
+        if ((next_idx != -1) && (header->start_idx() != next_idx)) { break; }
+
+        ++ngroups;
+        next_idx = header->start_idx() + header->nrecords();
+        HS_REL_ASSERT_LT(ngroups, max_inflight,
+                         "Found more complete log groups after the end of log than the groups which could be in "
+                         "flight, log data is corrupted, logdev id {} offset {} Header: {}",
+                         m_logdev_id, dev_offset, *header);
+        THIS_LOGDEV_LOG(INFO, "Ignoring log group which was in flight with the torn tail group, offset={} header {}",
+                        dev_offset, *header);
+    }
+}
+
 int64_t LogDev::append_async(logstore_id_t store_id, logstore_seq_num_t seq_num, const sisl::io_blob& data,
                              void* cb_context) {
     if (is_stopping()) return -1;
@@ -266,13 +315,24 @@ int64_t LogDev::append_async(logstore_id_t store_id, logstore_seq_num_t seq_num,
 }
 
 log_buffer LogDev::read(const logdev_key& key) {
+    log_buffer b;
+    if (m_tail_cache.get(key.idx, b)) {
+        COUNTER_INCREMENT(logstore_service().m_metrics, logstore_tail_cache_hit_count, 1);
+        return b;
+    }
+    COUNTER_INCREMENT(logstore_service().m_metrics, logstore_tail_cache_miss_count, 1);
+    return read_from_device(key);
+}
+
+log_buffer LogDev::read_from_device(const logdev_key& key) {
     if (is_stopping()) return -1;
     incr_pending_request_num();
-    std::unique_lock lg = flush_guard();
+    assert_durable(key);
     auto buf = sisl::make_byte_array(initial_read_size, m_flush_size_multiple, sisl::buftag::logread);
     auto ec = m_vdev_jd->sync_pread(buf->bytes(), initial_read_size, key.dev_offset);
     if (ec) {
         LOGERROR("Failed to read from Journal vdev log_dev={} {} {}", m_logdev_id, ec.value(), ec.message());
+        decr_pending_request_num();
         return {};
     }
 
@@ -289,20 +349,105 @@ log_buffer LogDev::read(const logdev_key& key) {
         auto const rounded_size =
             sisl::round_up(record_header->size + data_offset - rounded_data_offset, m_vdev->align_size());
         auto new_buf = sisl::make_byte_array(rounded_size, m_vdev->align_size(), sisl::buftag::logread);
-        m_vdev_jd->sync_pread(new_buf->bytes(), rounded_size, key.dev_offset + rounded_data_offset);
+        ec = m_vdev_jd->sync_pread(new_buf->bytes(), rounded_size, key.dev_offset + rounded_data_offset);
+        if (ec) {
+            LOGERROR("Failed to read from Journal vdev log_dev={} {} {}", m_logdev_id, ec.value(), ec.message());
+            decr_pending_request_num();
+            return {};
+        }
         ret_view = sisl::byte_view{new_buf, s_cast< uint32_t >(data_offset - rounded_data_offset), record_header->size};
     }
+    ret_view = record_data(record_header, ret_view);
     decr_pending_request_num();
     return ret_view;
 }
 
+/* Returns the payload of the record given its data as stored in the log group. Compressed records are decompressed
+ * into a new buffer, rest are returned as is.
+ */
+log_buffer LogDev::record_data(const serialized_log_record* rec, const log_buffer& stored) const {
+    if (!rec->get_compressed()) { return stored; }
+
+    HS_REL_ASSERT_GE(stored.size(), sizeof(compressed_log_hdr), "Compressed log record is too small, log_dev={}",
+                     m_logdev_id);
+    auto const* chdr = r_cast< const compressed_log_hdr* >(stored.bytes());
+    auto dbuf = hs_utils::make_byte_array(chdr->uncompressed_size, false /* aligned */, sisl::buftag::compression, 0);
+    size_t decompressed_size = chdr->uncompressed_size;
+    auto const ret = sisl::Compress::decompress(r_cast< const char* >(stored.bytes() + sizeof(compressed_log_hdr)),
+                                                r_cast< char* >(dbuf->bytes()),
+                                                stored.size() - sizeof(compressed_log_hdr), &decompressed_size);
+    if ((ret != 0) || (decompressed_size != chdr->uncompressed_size)) {
+        LOGERROR("Failed to decompress log record, log_dev={} lsn={} ret={} compressed_size={} decompressed_size={}",
+                 m_logdev_id, rec->store_seq_num, ret, stored.size(), decompressed_size);
+        HS_REL_ASSERT(false, "failed to decompress log record");
+    }
+    return sisl::byte_view{dbuf};
+}
+
+log_buffer LogDev::read(const logdev_key& key, log_range_read_ctx& ctx) {
+    if ((ctx.group.size() == 0) || (ctx.group_offset != key.dev_offset)) {
+        // Records in the tail need not be streamed from device at all. Stream is left where it was, so that it can
+        // continue if the subsequent records are not in the cache.
+        log_buffer b;
+        if (m_tail_cache.get(key.idx, b)) {
+            COUNTER_INCREMENT(logstore_service().m_metrics, logstore_tail_cache_hit_count, 1);
+            return b;
+        }
+        COUNTER_INCREMENT(logstore_service().m_metrics, logstore_tail_cache_miss_count, 1);
+
+        if (is_stopping()) return {};
+        incr_pending_request_num();
+        auto const bulk_read_size = HS_DYNAMIC_CONFIG(logstore.bulk_read_size);
+        assert_durable(key);
+        {
+            // Start streaming afresh if the group is behind the stream or far enough ahead that reading through the
+            // groups in between costs more than a seek.
+            if (!ctx.stream || (key.dev_offset < ctx.stream->next_group_offset()) ||
+                (uint64_cast(key.dev_offset - ctx.stream->next_group_offset()) > bulk_read_size)) {
+                ctx.stream = std::make_unique< log_stream_reader >(key.dev_offset, m_vdev, m_vdev_jd,
+                                                                   m_flush_size_multiple, true /* own_cursor */);
+            }
+
+            // Bulk read should not go past the groups which are durable, the ones beyond could be in flight.
+            ctx.stream->set_read_limit(m_durable_upto_offset.load(std::memory_order_acquire));
+
+            do {
+                ctx.group = ctx.stream->next_group(&ctx.group_offset);
+            } while ((ctx.group.size() != 0) && (ctx.group_offset < key.dev_offset));
+        }
+        decr_pending_request_num();
+
+        if ((ctx.group.size() == 0) || (ctx.group_offset != key.dev_offset)) {
+            THIS_LOGDEV_LOG(DEBUG, "Log group at offset={} for log_idx={} not found in stream, reading it directly",
+                            key.dev_offset, key.idx);
+            ctx.stream.reset();
+            ctx.group = sisl::byte_view{};
+            return read_from_device(key);
+        }
+    }
+
+    auto const* header = r_cast< const log_group_header* >(ctx.group.bytes());
+    verify_log_group_header(key.idx, header);
+    auto const* record_header = header->nth_record(key.idx - header->start_log_idx);
+    uint32_t const data_offset = (record_header->offset + (record_header->get_inlined() ? 0 : header->oob_data_offset));
+
+    sisl::byte_view ret_view = ctx.group;
+    ret_view.move_forward(data_offset);
+    ret_view.set_size(record_header->size);
+    return record_data(record_header, ret_view);
+}
+
 void LogDev::read_record_header(const logdev_key& key, serialized_log_record& return_record_header) {
     if (is_stopping()) return;
     incr_pending_request_num();
-    std::unique_lock lg = flush_guard();
+    assert_durable(key);
     auto buf = sisl::make_byte_array(initial_read_size, m_flush_size_multiple, sisl::buftag::logread);
     auto ec = m_vdev_jd->sync_pread(buf->bytes(), initial_read_size, key.dev_offset);
-    if (ec) LOGERROR("Failed to read from Journal vdev log_dev={} {} {}", m_logdev_id, ec.value(), ec.message());
+    if (ec) {
+        LOGERROR("Failed to read from Journal vdev log_dev={} {} {}", m_logdev_id, ec.value(), ec.message());
+        decr_pending_request_num();
+        return;
+    }
 
     auto* header = r_cast< const log_group_header* >(buf->cbytes());
     verify_log_group_header(key.idx, header);
@@ -310,10 +455,15 @@ void LogDev::read_record_header(const logdev_key& key, serialized_log_record& re
     auto record_header = header->nth_record(key.idx - header->start_log_idx);
     return_record_header =
         serialized_log_record(record_header->size, record_header->offset, record_header->get_inlined(),
-                              record_header->store_seq_num, record_header->store_id);
+                              record_header->store_seq_num, record_header->store_id, record_header->get_compressed());
     decr_pending_request_num();
 }
 
+void LogDev::assert_durable(const logdev_key& key) const {
+    HS_REL_ASSERT_LT(key.dev_offset, m_durable_upto_offset.load(std::memory_order_acquire),
+                     "Reading log_idx={} from log group which is not flushed yet, log_dev={}", key.idx, m_logdev_id);
+}
+
 void LogDev::verify_log_group_header(const logid_t idx, const log_group_header* header) {
     HS_REL_ASSERT_EQ(header->magic_word(), LOG_GROUP_HDR_MAGIC, "Log header corrupted with magic mismatch! {} {}",
                      m_logdev_id, *header);
@@ -373,7 +523,7 @@ LogGroup* LogDev::prepare_flush(int32_t estimated_records) {
 
     assert(estimated_records > 0);
     auto* lg = make_log_group(static_cast< uint32_t >(estimated_records));
-    m_log_records->foreach_contiguous_active(m_last_flush_idx + 1,
+    m_log_records->foreach_contiguous_active(m_last_issued_idx + 1,
                                              [&](int64_t idx, int64_t, log_record& record) -> bool {
                                                  if (lg->add_record(record, idx)) {
                                                      flushing_upto_idx = idx;
@@ -385,7 +535,8 @@ LogGroup* LogDev::prepare_flush(int32_t estimated_records) {
 
     lg->finish(m_logdev_id, m_last_crc);
     if (sisl_unlikely(flushing_upto_idx == -1)) { return nullptr; }
-    lg->m_flush_log_idx_from = m_last_flush_idx + 1;
+    m_last_crc = lg->header()->cur_grp_crc; // Next group chains to this one, even before this group is completed
+    lg->m_flush_log_idx_from = m_last_issued_idx + 1;
     lg->m_flush_log_idx_upto = flushing_upto_idx;
     HS_DBG_ASSERT_GE(lg->m_flush_log_idx_upto, lg->m_flush_log_idx_from, "log indx upto is smaller then log indx from");
 
@@ -440,27 +591,50 @@ bool LogDev::flush_under_guard() {
     }
 #endif
 
-    return flush();
+    // Caller expects everything appended so far to be durable on return, so keep issuing the groups as the in-flight
+    // ones complete and wait for all of them.
+    bool ret = flush();
+    while (m_flush_deferred.load(std::memory_order_acquire)) {
+        wait_for_flush_completion();
+        ret = flush() || ret;
+    }
+    wait_for_flush_completion();
+    return ret;
 }
 
 bool LogDev::flush() {
     m_last_flush_time = Clock::now();
     // We were able to win the flushing competition and now we gather all the flush data and reserve a slot.
+    m_flush_deferred.store(false, std::memory_order_release);
     auto new_idx = m_log_idx.load(std::memory_order_acquire) - 1;
-    if (m_last_flush_idx >= new_idx) {
+    if (m_last_issued_idx >= new_idx) {
         THIS_LOGDEV_LOG(TRACE, "Log idx {} is just flushed", new_idx);
         return false;
     }
 
+    auto const max_inflight = std::clamp(HS_DYNAMIC_CONFIG(logstore.max_inflight_log_groups), 1u, max_log_group);
+
     // the amount of logs which one logGroup can flush has a upper limit. here we want to make sure all the logs
     // that need to be flushed will definitely be flushed to physical dev, so we need this loop to create multiple
-    // log groups if necessary
-    for (; m_last_flush_idx < new_idx;) {
+    // log groups if necessary. Groups are written asynchronously, with upto max_inflight groups outstanding on the
+    // device. Once that limit is reached, rest of the logs are flushed when the in-flight groups complete.
+    bool issued{false};
+    for (; m_last_issued_idx < new_idx;) {
+        {
+            std::unique_lock lk{m_inflight_mtx};
+            if (m_inflight_groups.size() >= max_inflight) {
+                THIS_LOGDEV_LOG(TRACE, "Log groups in flight={} reached the limit, deferring the flush of log_idx={}",
+                                m_inflight_groups.size(), new_idx);
+                m_flush_deferred.store(true, std::memory_order_release);
+                break;
+            }
+        }
+
         LogGroup* lg =
-            prepare_flush(new_idx - m_last_flush_idx + 4); // Estimate 4 more extra in case of parallel writes
+            prepare_flush(new_idx - m_last_issued_idx + 4); // Estimate 4 more extra in case of parallel writes
         if (sisl_unlikely(!lg)) {
-            THIS_LOGDEV_LOG(TRACE, "Log idx {} last_flush_idx {} prepare flush failed", new_idx, m_last_flush_idx);
-            return false;
+            THIS_LOGDEV_LOG(TRACE, "Log idx {} last_issued_idx {} prepare flush failed", new_idx, m_last_issued_idx);
+            return issued;
         }
         auto sz = m_pending_flush_size.fetch_sub(lg->actual_data_size(), std::memory_order_relaxed);
         HS_REL_ASSERT_GE((sz - lg->actual_data_size()), 0, "size {} lg size {}", sz, lg->actual_data_size());
@@ -474,18 +648,77 @@ bool LogDev::flush() {
         HISTOGRAM_OBSERVE(logstore_service().m_metrics, logdev_flush_records_distribution, lg->nrecords());
         HISTOGRAM_OBSERVE(logstore_service().m_metrics, logdev_flush_size_distribution, lg->actual_data_size());
 
-        // TODO:: add logic to handle this error in upper layer
-        auto error = m_vdev_jd->sync_pwritev(lg->iovecs().data(), int_cast(lg->iovecs().size()), lg->m_log_dev_offset);
-        if (error) {
-            THIS_LOGDEV_LOG(ERROR, "Fail to sync write to journal vde , error code {} : {}", error.value(),
-                            error.message());
-            return false;
+        issue_log_group(lg);
+        issued = true;
+    }
+
+    return issued;
+}
+
+void LogDev::issue_log_group(LogGroup* lg) {
+    m_last_issued_idx = lg->m_flush_log_idx_upto;
+    m_log_group_idx = (m_log_group_idx + 1) % max_log_group;
+    {
+        std::unique_lock lk{m_inflight_mtx};
+        m_inflight_groups.push_back(lg);
+    }
+
+    m_vdev_jd->async_pwritev(lg->iovecs().data(), int_cast(lg->iovecs().size()), lg->m_log_dev_offset)
+        .thenValue([this, lg](std::error_code err) { on_flush_io_done(lg, err); });
+}
+
+void LogDev::on_flush_io_done(LogGroup* lg, std::error_code err) {
+    // TODO:: add logic to handle this error in upper layer
+    HS_REL_ASSERT(!err, "Fail to write log group to journal vdev log_dev={}, error code {} : {}", m_logdev_id,
+                  err.value(), err.message());
+
+    std::unique_lock lk{m_inflight_mtx};
+    lg->m_io_done = true;
+
+    // Whoever is already processing the completions will pick this group up in its order
+    if (m_completion_in_progress) { return; }
+    m_completion_in_progress = true;
+    while (!m_inflight_groups.empty() && m_inflight_groups.front()->m_io_done) {
+        auto* done_lg = m_inflight_groups.front();
+        lk.unlock();
+        on_flush_completion(done_lg);
+        lk.lock();
+        m_inflight_groups.pop_front();
+
+        for (auto it = m_flush_waiters.begin(); it != m_flush_waiters.end();) {
+            if (it->first <= done_lg->m_flush_log_idx_upto) {
+                it->second.setValue();
+                it = m_flush_waiters.erase(it);
+            } else {
+                ++it;
+            }
         }
+    }
+    m_completion_in_progress = false;
+    lk.unlock();
+
+    // Slots are available now, flush whatever could not be issued earlier
+    if (m_flush_deferred.load(std::memory_order_acquire)) { flush_if_necessary(0); }
+}
 
-        on_flush_completion(lg);
+void LogDev::wait_for_flush_completion() {
+    folly::Future< folly::Unit > fut = folly::makeFuture();
+    {
+        std::unique_lock lk{m_inflight_mtx};
+        if (m_inflight_groups.empty()) { return; }
+        m_flush_waiters.emplace_back(m_inflight_groups.back()->m_flush_log_idx_upto, folly::Promise< folly::Unit >{});
+        fut = m_flush_waiters.back().second.getFuture();
     }
 
-    return true;
+    if (iomanager.am_i_io_reactor()) {
+        // Wait without blocking the reactor, since the completion could be delivered on this reactor itself
+        iomgr::FiberManagerLib::Promise< bool > p;
+        auto fiber_fut = p.get_future();
+        std::move(fut).thenValue([&p](folly::Unit) { p.set_value(true); });
+        fiber_fut.get();
+    } else {
+        std::move(fut).get();
+    }
 }
 
 void LogDev::on_flush_completion(LogGroup* lg) {
@@ -493,12 +726,22 @@ void LogDev::on_flush_completion(LogGroup* lg) {
     THIS_LOGDEV_LOG(TRACE, "Flush completed for logid[{} - {}]", lg->m_flush_log_idx_from, lg->m_flush_log_idx_upto);
 
     m_log_records->complete(lg->m_flush_log_idx_from, lg->m_flush_log_idx_upto);
-    m_last_crc = lg->header()->cur_grp_crc;
     std::unordered_map< logid_t, logstore_req* > req_map;
 
     auto from_indx = lg->m_flush_log_idx_from;
     auto upto_indx = lg->m_flush_log_idx_upto;
     auto dev_offset = lg->m_log_dev_offset;
+
+    // Publish the flushed group to the readers, before anyone gets to know about the keys within this group
+    m_durable_upto_offset.store(dev_offset + lg->header()->total_size(), std::memory_order_release);
+    {
+        std::vector< sisl::io_blob > datas;
+        datas.reserve(upto_indx - from_indx + 1);
+        for (auto idx = from_indx; idx <= upto_indx; ++idx) {
+            datas.push_back(m_log_records->at(idx).data);
+        }
+        m_tail_cache.add(from_indx, datas);
+    }
     for (auto idx = from_indx; idx <= upto_indx; ++idx) {
         auto& record = m_log_records->at(idx);
         logstore_req* req = s_cast< logstore_req* >(record.context);
@@ -513,10 +756,12 @@ void LogDev::on_flush_completion(LogGroup* lg) {
                       get_elapsed_time_us(m_last_flush_time, done_time));
     HISTOGRAM_OBSERVE(logstore_service().m_metrics, logdev_post_flush_processing_latency,
                       get_elapsed_time_us(done_time));
-    free_log_group(lg);
     m_log_records->truncate(upto_indx);
-    m_last_flush_idx = upto_indx;
-    m_last_flush_ld_key = logdev_key{from_indx, dev_offset};
+    {
+        std::unique_lock lk{m_inflight_mtx};
+        m_last_flush_idx = upto_indx;
+        m_last_flush_ld_key = logdev_key{from_indx, dev_offset};
+    }
 
     // since we support out-of-order lsn write, so no need to guarantee the order of logstore write completion
     for (auto const& [idx, req] : req_map) {
@@ -554,7 +799,10 @@ uint64_t LogDev::truncate() {
     }
 
     // All log stores are empty, we can truncate logs depends on the last flushed logdev_key
-    if (min_safe_ld_key == logdev_key::out_of_bound_ld_key()) { min_safe_ld_key = m_last_flush_ld_key; }
+    if (min_safe_ld_key == logdev_key::out_of_bound_ld_key()) {
+        std::unique_lock lk{m_inflight_mtx};
+        min_safe_ld_key = m_last_flush_ld_key;
+    }
 
     // There are no writes or no truncation called for any of the store, so we can't truncate anything
     if (min_safe_ld_key.idx <= 0 || min_safe_ld_key.idx <= m_last_truncate_idx) {
@@ -578,6 +826,7 @@ uint64_t LogDev::truncate() {
 
     // Update the start offset to be read upon restart
     m_last_truncate_idx = min_safe_ld_key.idx;
+    m_tail_cache.truncate(m_last_truncate_idx);
     m_logdev_meta.set_start_dev_offset(min_safe_ld_key.dev_offset, min_safe_ld_key.idx, stopping /* persist_now */);
 
     // When a logstore is removed, it unregisteres the store and keeps the store id in garbage list. We can capture
@@ -759,9 +1008,13 @@ nlohmann::json LogDev::get_status(int verbosity) const {
 
     // Logdev status
     js["current_log_idx"] = m_log_idx.load(std::memory_order_relaxed);
-    js["last_flush_log_idx"] = m_last_flush_idx;
+    {
+        std::unique_lock lk{m_inflight_mtx};
+        js["last_flush_log_idx"] = m_last_flush_idx;
+    }
     js["last_truncate_log_idx"] = m_last_truncate_idx;
     js["time_since_last_log_flush_ns"] = get_elapsed_time_ns(m_last_flush_time);
+    js["tail_cache_size"] = m_tail_cache.size();
     if (verbosity == 2) {
         js["logdev_stopped?"] = is_stopping();
         js["logdev_sb_start_offset"] = m_logdev_meta.get_start_dev_offset();
@@ -17,6 +17,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <limits>
 #include <map>
@@ -46,8 +47,9 @@ static constexpr uint32_t LOG_GROUP_HDR_MAGIC{0xF00D1E};
 static constexpr uint32_t LOG_GROUP_FOOTER_MAGIC{0xB00D1E};
 static constexpr uint32_t dma_address_boundary{512}; // Mininum size the dma/writes to be aligned with
 static constexpr uint32_t initial_read_size{4096};
-// logdev doesn't support concurrent writes. There can only be 2 active log groups.
-static constexpr uint32_t max_log_group{2};
+// Pool of log groups. Upto logstore.max_inflight_log_groups of them are written concurrently, while one is being
+// prepared for the next flush.
+static constexpr uint32_t max_log_group{16};
 
 // clang-format off
 /*
@@ -69,19 +71,24 @@ static constexpr uint32_t max_log_group{2};
 /* Each log record which is serialized to the persistent store in the following format */
 #pragma pack(1)
 struct serialized_log_record {
-    uint32_t size;                    // Size of this log record
-    uint32_t offset : 31;             // Offset within the log_group where data is residing
+    uint32_t size;                    // Size of this log record (as stored, if compressed)
+    uint32_t offset : 30;             // Offset within the log_group where data is residing
+    uint32_t is_compressed : 1;       // Is the log data compressed (always inlined and prefixed by compressed_log_hdr)
     uint32_t is_inlined : 1;          // Is the log data is inlined or out-of-band area
     logstore_seq_num_t store_seq_num; // Seqnum by the log store
     logstore_id_t store_id;           // ID of the store this log is associated with
 
     void set_inlined(bool inlined) { is_inlined = static_cast< uint32_t >(inlined ? 0x1 : 0x0); }
     bool get_inlined() const { return ((is_inlined == static_cast< uint32_t >(0x1)) ? true : false); }
+    void set_compressed(bool compressed) { is_compressed = static_cast< uint32_t >(compressed ? 0x1 : 0x0); }
+    bool get_compressed() const { return (is_compressed == static_cast< uint32_t >(0x1)); }
 
     serialized_log_record() = default;
-    serialized_log_record(uint32_t s, uint32_t o, bool inlined, logstore_seq_num_t sq, logstore_id_t id) :
+    serialized_log_record(uint32_t s, uint32_t o, bool inlined, logstore_seq_num_t sq, logstore_id_t id,
+                          bool compressed = false) :
             size{s}, offset{o}, store_seq_num{sq}, store_id{id} {
         set_inlined(inlined);
+        set_compressed(compressed);
     }
     serialized_log_record(const serialized_log_record&) = default;
     serialized_log_record& operator=(const serialized_log_record&) = default;
@@ -91,6 +98,13 @@ struct serialized_log_record {
 };
 #pragma pack()
 
+/* Header prefixed to the data of a compressed log record */
+#pragma pack(1)
+struct compressed_log_hdr {
+    uint32_t uncompressed_size; // Size of the log record before compression
+};
+#pragma pack()
+
 /* This structure represents the in-memory representation of a log record */
 struct log_record {
     sisl::io_blob data;
@@ -253,6 +267,7 @@ public:
     void reset(const uint32_t max_records);
     void create_overflow_buf(const uint32_t min_needed);
     bool add_record(log_record& record, const int64_t log_idx);
+    bool add_compressed_record(const log_record& record);
     bool can_accomodate(const log_record& record) const { return (m_nrecords <= m_max_records); }
 
     const iovec_array& finish(logdev_id_t logdev_id, const crc32_t prev_crc);
@@ -290,6 +305,7 @@ public:
     int64_t m_flush_log_idx_from;
     int64_t m_flush_log_idx_upto;
     off_t m_log_dev_offset;
+    bool m_io_done{false}; // Write to device is completed, but yet to be processed in the order of the flush
 
     uint64_t m_flush_multiple_size{0};
 
@@ -537,19 +553,46 @@ class JournalVirtualDev;
 
 class log_stream_reader {
 public:
+    // If own_cursor is set, stream is read with a cursor of its own (starting at device_cursor) instead of the seek
+    // cursor of the journal descriptor, so that it can be used while the logdev is appending.
+    //
+    // If read_ahead_bufs is non-zero, those many bulk reads are kept in flight ahead of the group being returned, so
+    // that the caller processing the groups overlaps with the device reads. It needs own_cursor to be set.
     log_stream_reader(off_t device_cursor, std::shared_ptr< JournalVirtualDev > vdev,
-                      shared< JournalVirtualDev::Descriptor > vdev_jd, uint64_t min_read_size);
+                      shared< JournalVirtualDev::Descriptor > vdev_jd, uint64_t min_read_size, bool own_cursor = false,
+                      uint32_t read_ahead_bufs = 0);
     log_stream_reader(const log_stream_reader&) = delete;
     log_stream_reader& operator=(const log_stream_reader&) = delete;
     log_stream_reader(log_stream_reader&&) noexcept = delete;
     log_stream_reader& operator=(log_stream_reader&&) noexcept = delete;
-    ~log_stream_reader() = default;
+    ~log_stream_reader();
 
     sisl::byte_view next_group(off_t* out_dev_offset);
     sisl::byte_view group_in_next_page();
 
+    // Device offset of the group which the next call to next_group() would return
+    off_t next_group_offset() const;
+
+    // Whether the stream has no more bytes to read, as against the stream ending at a group which is not valid
+    bool end_of_stream() const { return m_end_of_stream; }
+
+    // Stream is not read beyond this offset (rounded up to read size multiple), so that the reads do not see the
+    // groups which are not yet durable. Only supported with own_cursor.
+    void set_read_limit(off_t limit);
+
 private:
     sisl::byte_view read_next_bytes(uint64_t nbytes, bool& end_of_stream);
+    sisl::byte_view read_ahead_next_bytes(uint64_t nbytes, bool& end_of_stream);
+    void issue_read_ahead(uint64_t nbytes);
+    int64_t next_read(uint8_t* buf, uint64_t nbytes);
+    uint64_t limit_read_size(uint64_t nbytes) const;
+
+    struct read_ahead_buf {
+        sisl::byte_array buf;
+        off_t dev_offset;
+        uint64_t size;
+        folly::Future< std::error_code > fut;
+    };
 
 private:
     std::shared_ptr< JournalVirtualDev > m_vdev;
@@ -559,6 +602,55 @@ private:
     off_t m_cur_read_bytes{0};
     crc32_t m_prev_crc{0};
     uint64_t m_read_size_multiple;
+    bool m_own_cursor;
+    off_t m_cursor{0}; // Used only if own_cursor is set
+
+    uint32_t m_read_ahead_bufs{0};
+    std::deque< read_ahead_buf > m_read_ahead_q;
+    bool m_read_ahead_eos{false};
+    off_t m_buf_end_offset{0}; // Device offset past the last byte of m_cur_log_buf, used only if own_cursor is set
+    off_t m_read_limit{std::numeric_limits< off_t >::max()};
+    bool m_end_of_stream{false};
+};
+
+// State of a sequential read of records, which is carried across the LogDev::read calls, so that the log groups are
+// streamed with bulk reads instead of reading the group of every record.
+struct log_range_read_ctx {
+    std::unique_ptr< log_stream_reader > stream;
+    sisl::byte_view group;
+    off_t group_offset{-1};
+};
+
+/* Copy of the payloads of most recently flushed log records, indexed by log idx. Records are added a group at a time
+ * in the order of log idx as groups complete. Memory of the tail caches of all logdevs is accounted in resource
+ * manager and the oldest records of the cache which is adding are evicted once the total exceeds
+ * logstore.tail_cache_size */
+class LogTailCache {
+public:
+    LogTailCache() = default;
+    LogTailCache(const LogTailCache&) = delete;
+    LogTailCache& operator=(const LogTailCache&) = delete;
+    ~LogTailCache() = default;
+
+    /// @brief Add the records of a flushed group, starting at from_idx. Payloads are copied into a single buffer of
+    /// the group, which the cached records refer to.
+    void add(logid_t from_idx, const std::vector< sisl::io_blob >& datas);
+    bool get(logid_t idx, log_buffer& out_buf) const;
+
+    /// @brief Drop all records upto (including) the given log idx
+    void truncate(logid_t upto_idx);
+    void clear();
+    uint64_t size() const;
+
+private:
+    void evict_all_under_lock();
+    void pop_front_under_lock();
+
+private:
+    mutable folly::SharedMutexWritePriority m_mtx;
+    std::deque< log_buffer > m_records;
+    logid_t m_start_idx{0}; // Log idx of the first record in the cache
+    uint64_t m_size{0};
 };
 
 struct logstore_info {
@@ -641,6 +733,18 @@ public:
      */
     log_buffer read(const logdev_key& key);
 
+    /**
+     * @brief Read the log id as part of reading a range of records in increasing order of log id. Instead of reading
+     * the log group for each record, groups are streamed sequentially with bulk reads and all records of the group
+     * are served from the same read.
+     *
+     * @param logdev_key : log_id and dev_offset pair to read
+     * @param ctx : Context of the range read, which is to be passed on every read of the range
+     *
+     * @return log_buffer : Same as read(key)
+     */
+    log_buffer read(const logdev_key& key, log_range_read_ctx& ctx);
+
     /**
      * @brief Read the log id from the device offset
      *
@@ -731,7 +835,10 @@ private:
     bool allow_timer_flush() const { return uint32_cast(m_flush_mode) & uint32_cast(flush_mode_t::TIMER); }
     bool allow_explicit_flush() const { return uint32_cast(m_flush_mode) & uint32_cast(flush_mode_t::EXPLICIT); }
 
+    log_buffer read_from_device(const logdev_key& key);
+    log_buffer record_data(const serialized_log_record* rec, const log_buffer& stored) const;
     void verify_log_group_header(const logid_t idx, const log_group_header* header);
+    void assert_durable(const logdev_key& key) const;
 
     /**
      * @brief Reserve logstore id and persist if needed. It persists the entire map about the logstore id inside the
@@ -754,16 +861,21 @@ private:
     void on_logfound(logstore_id_t id, logstore_seq_num_t seq_num, logdev_key ld_key, logdev_key flush_ld_key,
                      log_buffer buf, uint32_t nremaining_in_batch);
 
+    // Groups complete in the order they are issued, so the pool is used as a ring and the slot next to the last issued
+    // group is always free as long as the in-flight groups are below the pool size.
     LogGroup* make_log_group(uint32_t estimated_records) {
         m_log_group_pool[m_log_group_idx].reset(estimated_records);
         return &m_log_group_pool[m_log_group_idx];
     }
 
-    void free_log_group(LogGroup* lg) { m_log_group_idx = !m_log_group_idx; }
+    void issue_log_group(LogGroup* lg);
+    void on_flush_io_done(LogGroup* lg, std::error_code err);
+    void wait_for_flush_completion();
 
     LogGroup* prepare_flush(int32_t estimated_record);
     void do_load(off_t offset);
     void assert_next_pages(log_stream_reader& lstream);
+    void assert_log_tail(log_stream_reader& lstream);
 
     /// @brief force to flush the log device
     /// @return whether real flush is done
@@ -788,19 +900,36 @@ private:
     std::multimap< logid_t, logstore_id_t > m_garbage_store_ids;
     Clock::time_point m_last_flush_time;
 
-    logid_t m_last_flush_idx{-1};         // Track last flushed, last device offset and truncated log idx
+    // Track last flushed, last device offset and truncated log idx. Flushed idx and key are updated on completion of
+    // the groups without the flush lock, so they are guarded by m_inflight_mtx.
+    logid_t m_last_flush_idx{-1};
+    logid_t m_last_issued_idx{-1};        // Log idx upto which log groups are issued to the device
     logdev_key m_last_flush_ld_key{0, 0}; // Left interval of the last flush, 0 indicates the very beginning of logdev
     logid_t m_last_truncate_idx{-1};      // Logdev truncate up to this idx
     crc32_t m_last_crc{INVALID_CRC32_VALUE};
 
+    // Device offset up to which log groups are flushed. Reads of the flushed groups go straight to the journal vdev
+    // without taking the flush mutex, this watermark is only to validate that reader never looks past it.
+    std::atomic< off_t > m_durable_upto_offset{0};
+
     // LogDev Info block related fields
     std::mutex m_meta_mutex;
     LogDevMetadata m_logdev_meta;
     uint64_t m_flush_size_multiple{0};
 
+    LogTailCache m_tail_cache;
+
     // Pool for creating log group
     LogGroup m_log_group_pool[max_log_group];
     uint32_t m_log_group_idx{0};
+
+    // Log groups issued to the device, in the order of issue. The completions are processed by only one thread at a
+    // time, strictly from the front of the queue, so that on_flush_completion() sees the groups in order.
+    mutable std::mutex m_inflight_mtx;
+    std::deque< LogGroup* > m_inflight_groups;
+    bool m_completion_in_progress{false};
+    std::vector< std::pair< logid_t, folly::Promise< folly::Unit > > > m_flush_waiters;
+    std::atomic< bool > m_flush_deferred{false}; // Flush had more to write than the in-flight groups allowed
     // Timer handle
     iomgr::timer_handle_t m_flush_timer_hdl{iomgr::null_timer_handle};
 
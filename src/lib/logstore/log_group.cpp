@@ -15,8 +15,11 @@
  *********************************************************************************/
 #include <cstring>
 
+#include <sisl/fds/compress.hpp>
 #include <homestore/logstore/log_store.hpp>
+#include <homestore/logstore_service.hpp>
 #include "common/homestore_assert.hpp"
+#include "common/homestore_config.hpp"
 #include "log_dev.hpp"
 
 namespace homestore {
@@ -53,6 +56,7 @@ void LogGroup::reset(const uint32_t max_records) {
     m_nrecords = 0;
     m_max_records = std::min(max_records, max_records_in_a_batch);
     m_actual_data_size = 0;
+    m_io_done = false;
 
     m_iovecs.clear();
     m_iovecs.emplace_back(static_cast< void* >(m_cur_log_buf), m_inline_data_pos);
@@ -94,6 +98,12 @@ bool LogGroup::add_record(log_record& record, const int64_t log_idx) {
     m_record_slots[m_nrecords].size = record.data.size();
     m_record_slots[m_nrecords].store_id = record.store_id;
     m_record_slots[m_nrecords].store_seq_num = record.seq_num;
+    m_record_slots[m_nrecords].set_compressed(false);
+    if (add_compressed_record(record)) {
+        ++m_nrecords;
+        return true;
+    }
+
     if (record.is_inlineable(m_flush_multiple_size)) {
         m_record_slots[m_nrecords].offset = m_inline_data_pos;
         m_record_slots[m_nrecords].set_inlined(true);
@@ -113,6 +123,42 @@ bool LogGroup::add_record(log_record& record, const int64_t log_idx) {
     return true;
 }
 
+/* Compress the record into the inline area, if it is large enough and compresses well. Returns false if the record is
+ * to be added uncompressed.
+ */
+bool LogGroup::add_compressed_record(const log_record& record) {
+    auto const min_size = HS_DYNAMIC_CONFIG(logstore.compress_min_record_size);
+    if ((min_size == 0) || (record.data.size() < min_size)) { return false; }
+
+    auto const max_needed = uint32_cast(m_inline_data_pos + sizeof(compressed_log_hdr) +
+                                        sisl::Compress::max_compress_len(record.data.size()));
+    if (max_needed >= m_cur_buf_len) { create_overflow_buf(max_needed); }
+
+    uint8_t* const dst = m_cur_log_buf + m_inline_data_pos;
+    size_t compressed_size = m_cur_buf_len - m_inline_data_pos - sizeof(compressed_log_hdr);
+    auto const ret = sisl::Compress::compress(r_cast< const char* >(record.data.cbytes()),
+                                              r_cast< char* >(dst + sizeof(compressed_log_hdr)), record.data.size(),
+                                              &compressed_size);
+    auto const stored_size = uint32_cast(sizeof(compressed_log_hdr) + compressed_size);
+    auto const ratio_percent = uint32_cast(uint64_cast(stored_size) * 100 / record.data.size());
+    if ((ret != 0) || (ratio_percent > HS_DYNAMIC_CONFIG(logstore.compress_ratio_limit))) {
+        LOGTRACEMOD(logstore, "Not compressing log record lsn={} size={}, ret={} compressed_size={}", record.seq_num,
+                    record.data.size(), ret, compressed_size);
+        return false;
+    }
+    COUNTER_INCREMENT(logstore_service().metrics(), logstore_compressed_record_count, 1);
+    HISTOGRAM_OBSERVE(logstore_service().metrics(), logstore_compress_ratio_percent, ratio_percent);
+
+    new (dst) compressed_log_hdr{.uncompressed_size = uint32_cast(record.data.size())};
+    m_record_slots[m_nrecords].size = stored_size;
+    m_record_slots[m_nrecords].offset = m_inline_data_pos;
+    m_record_slots[m_nrecords].set_inlined(true);
+    m_record_slots[m_nrecords].set_compressed(true);
+    m_inline_data_pos += stored_size;
+    m_iovecs[0].iov_len = m_inline_data_pos;
+    return true;
+}
+
 bool LogGroup::new_iovec_for_footer() const {
     return ((m_inline_data_pos + sizeof(log_group_footer)) >= m_cur_buf_len || m_oob_data_pos != 0);
 }
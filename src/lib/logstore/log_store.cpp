@@ -299,6 +299,7 @@ nlohmann::json HomeLogStore::dump_log_store(const log_dump_req& dump_req) {
                 json_val["size"] = uint32_cast(record_header.size);
                 json_val["offset"] = uint32_cast(record_header.offset);
                 json_val["is_inlined"] = uint32_cast(record_header.get_inlined());
+                json_val["is_compressed"] = uint32_cast(record_header.get_compressed());
                 json_val["lsn"] = uint64_cast(record_header.store_seq_num);
                 json_val["store_id"] = s_cast< logstore_id_t >(record_header.store_id);
             } catch (const std::exception& ex) { THIS_LOGSTORE_LOG(ERROR, "Exception in json dump- {}", ex.what()); }
@@ -321,8 +322,9 @@ nlohmann::json HomeLogStore::dump_log_store(const log_dump_req& dump_req) {
 bool HomeLogStore::foreach (int64_t start_idx, const std::function< bool(logstore_seq_num_t, log_buffer) >& cb) {
     if (is_stopping()) return false;
     incr_pending_request_num();
+    log_range_read_ctx rctx;
     m_records.foreach_all_completed(start_idx, [&](int64_t cur_idx, homestore::logstore_record& record) -> bool {
-        auto log_buf = m_logdev->read(record.m_dev_key);
+        auto log_buf = m_logdev->read(record.m_dev_key, rctx);
         return cb(cur_idx, log_buf);
     });
     decr_pending_request_num();
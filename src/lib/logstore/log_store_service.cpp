@@ -13,10 +13,13 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <string>
 
 #include <fmt/format.h>
+#include <folly/futures/Future.h>
 #include <iomgr/iomgr.hpp>
 #include <sisl/utility/thread_factory.hpp>
 
@@ -114,8 +117,59 @@ void LogStoreService::start(bool format) {
     // Create an truncate thread loop which handles truncation which does sync IO
     start_threads();
 
+    // Recovery of each logdev is independent of the others, but it does sync reads of its entire journal. Fan them out
+    // unless there is nothing to gain or we are in a reactor which can't block on them.
+    auto const max_parallel = HS_DYNAMIC_CONFIG(logstore.recovery_max_parallel_logdevs);
+    if (format || (max_parallel <= 1) || (m_id_logdev_map.size() <= 1) || iomanager.am_i_io_reactor()) {
+        for (auto& [logdev_id, logdev] : m_id_logdev_map) {
+            logdev->start(format, m_logdev_vdev);
+        }
+    } else {
+        start_logdevs_parallel(format, max_parallel);
+    }
+}
+
+void LogStoreService::start_logdevs_parallel(bool format, uint32_t max_parallel) {
+    struct Context {
+        std::vector< std::shared_ptr< LogDev > > logdevs;
+        std::vector< folly::Promise< folly::Unit > > promises;
+        std::atomic< size_t > next{0};
+    };
+    auto ctx = std::make_shared< Context >();
+    std::vector< folly::Future< folly::Unit > > futs;
     for (auto& [logdev_id, logdev] : m_id_logdev_map) {
-        logdev->start(format, m_logdev_vdev);
+        // Descriptor map of journal vdev is not thread safe, so open all of them upfront. Logdev start will then find
+        // its descriptor already opened.
+        m_logdev_vdev->open(logdev_id);
+        ctx->logdevs.push_back(logdev);
+        futs.emplace_back(ctx->promises.emplace_back().getFuture());
+    }
+
+    // Each worker fiber picks up the next logdev yet to be loaded, so atmost max_parallel logdevs load concurrently
+    auto const nworkers = std::min< size_t >(max_parallel, ctx->logdevs.size());
+    HS_LOG(INFO, logstore, "Loading {} logdevs with {} parallel workers", ctx->logdevs.size(), nworkers);
+    for (size_t w{0}; w < nworkers; ++w) {
+        iomanager.run_on_forget(iomgr::reactor_regex::random_worker, iomgr::fiber_regex::syncio_only,
+                                [this, ctx, format]() {
+                                    for (auto i = ctx->next.fetch_add(1); i < ctx->logdevs.size();
+                                         i = ctx->next.fetch_add(1)) {
+                                        try {
+                                            ctx->logdevs[i]->start(format, m_logdev_vdev);
+                                            ctx->promises[i].setValue();
+                                        } catch (...) {
+                                            ctx->promises[i].setException(
+                                                folly::exception_wrapper{std::current_exception()});
+                                        }
+                                    }
+                                });
+    }
+
+    auto results = folly::collectAllUnsafe(futs).get();
+    for (size_t i{0}; i < results.size(); ++i) {
+        if (results[i].hasException()) {
+            HS_REL_ASSERT(false, "Failed to load log_dev={} error={}", ctx->logdevs[i]->get_id(),
+                          results[i].exception().what().toStdString());
+        }
     }
 }
 
@@ -397,6 +451,11 @@ LogStoreServiceMetrics::LogStoreServiceMetrics() : sisl::MetricsGroup("LogStores
                      {"op", "write"});
     REGISTER_COUNTER(logstore_read_count, "Total number of read requests to log stores", "logstore_op_count",
                      {"op", "read"});
+    REGISTER_COUNTER(logstore_tail_cache_hit_count, "Total number of log reads served from tail cache",
+                     "logstore_tail_cache_count", {"result", "hit"});
+    REGISTER_COUNTER(logstore_tail_cache_miss_count, "Total number of log reads which missed the tail cache",
+                     "logstore_tail_cache_count", {"result", "miss"});
+    REGISTER_COUNTER(logstore_compressed_record_count, "Total number of log records written compressed");
     REGISTER_HISTOGRAM(logstore_append_latency, "Logstore append latency", "logstore_op_latency", {"op", "write"});
     REGISTER_HISTOGRAM(logstore_read_latency, "Logstore read latency", "logstore_op_latency", {"op", "read"});
     REGISTER_HISTOGRAM(logdev_flush_size_distribution, "Distribution of flush data size",
@@ -405,6 +464,8 @@ LogStoreServiceMetrics::LogStoreServiceMetrics() : sisl::MetricsGroup("LogStores
                        HistogramBucketsType(LinearUpto128Buckets));
     REGISTER_HISTOGRAM(logstore_record_size, "Distribution of log record size",
                        HistogramBucketsType(ExponentialOfTwoBuckets));
+    REGISTER_HISTOGRAM(logstore_compress_ratio_percent, "Compressed log record size as percentage of original size",
+                       HistogramBucketsType(LinearUpto128Buckets));
     REGISTER_HISTOGRAM(logdev_flush_done_msg_time_ns, "Logdev flush completion msg time in ns");
     REGISTER_HISTOGRAM(logdev_post_flush_processing_latency,
                        "Logdev post flush processing (including callbacks) latency");
@@ -13,6 +13,8 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <iomgr/iomgr.hpp>
+
 #include "device/chunk.h"
 #include "common/homestore_assert.hpp"
 #include "common/homestore_config.hpp"
@@ -23,15 +25,56 @@
 namespace homestore {
 SISL_LOGGING_DECL(logstore)
 
+static std::error_code wait_for_io(folly::Future< std::error_code >&& fut) {
+    if (iomanager.am_i_io_reactor()) {
+        // Yield to other fibers of the reactor instead of blocking it, since completion could be delivered to it
+        iomgr::FiberManagerLib::Promise< std::error_code > p;
+        auto fiber_fut = p.get_future();
+        std::move(fut).thenValue([&p](std::error_code e) { p.set_value(e); });
+        return fiber_fut.get();
+    }
+    return std::move(fut).get();
+}
+
 log_stream_reader::log_stream_reader(off_t device_cursor, shared< JournalVirtualDev > vdev,
-                                     shared< JournalVirtualDev::Descriptor > vdev_jd, uint64_t read_size_multiple) :
+                                     shared< JournalVirtualDev::Descriptor > vdev_jd, uint64_t read_size_multiple,
+                                     bool own_cursor, uint32_t read_ahead_bufs) :
         m_vdev{vdev},
         m_vdev_jd{std::move(vdev_jd)},
         m_first_group_cursor{device_cursor},
-        m_read_size_multiple{read_size_multiple} {
+        m_read_size_multiple{read_size_multiple},
+        m_own_cursor{own_cursor},
+        m_cursor{device_cursor},
+        m_read_ahead_bufs{read_ahead_bufs},
+        m_buf_end_offset{device_cursor} {
+    HS_DBG_ASSERT(m_own_cursor || (m_read_ahead_bufs == 0), "Read ahead of log stream needs its own cursor");
+
     // We set the journal descriptor seek_cursor here so that
     // sync_next_read reads from the seek_cursor.
-    m_vdev_jd->lseek(m_first_group_cursor);
+    if (!m_own_cursor) { m_vdev_jd->lseek(m_first_group_cursor); }
+}
+
+log_stream_reader::~log_stream_reader() {
+    // Buffers of the reads still in flight can't be released until device is done with them
+    for (auto& rbuf : m_read_ahead_q) {
+        wait_for_io(std::move(rbuf.fut));
+    }
+}
+
+off_t log_stream_reader::next_group_offset() const {
+    // Groups do not cross the chunk boundary, so the bytes yet to be consumed are always contiguous on device and end
+    // where the last read ended. Cursor itself could have moved past the unused end of chunk or be reading ahead.
+    return m_own_cursor ? (m_buf_end_offset - m_cur_log_buf.size()) : m_vdev_jd->dev_offset(m_cur_read_bytes);
+}
+
+void log_stream_reader::set_read_limit(off_t limit) {
+    HS_DBG_ASSERT(m_own_cursor, "Read limit of log stream needs its own cursor");
+    m_read_limit = limit;
+}
+
+uint64_t log_stream_reader::limit_read_size(uint64_t nbytes) const {
+    if (m_cursor >= m_read_limit) { return 0; }
+    return std::min(nbytes, uint64_cast(sisl::round_up(m_read_limit - m_cursor, m_read_size_multiple)));
 }
 
 sisl::byte_view log_stream_reader::next_group(off_t* out_dev_offset) {
@@ -39,7 +82,7 @@ sisl::byte_view log_stream_reader::next_group(off_t* out_dev_offset) {
         uint64_cast(sisl::round_up(HS_DYNAMIC_CONFIG(logstore.bulk_read_size), m_read_size_multiple));
     uint64_t min_needed{m_read_size_multiple};
     sisl::byte_view ret_buf;
-    *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+    *out_dev_offset = next_group_offset();
 
 read_again:
     if (m_cur_log_buf.size() < min_needed) {
@@ -48,6 +91,7 @@ read_again:
             m_cur_log_buf = read_next_bytes(std::max(min_needed, bulk_read_size), end_of_stream);
             if (end_of_stream) {
                 LOGDEBUGMOD(logstore, "Logdev reached end of stream {} {}", m_vdev_jd->to_string(), m_cur_read_bytes);
+                m_end_of_stream = true;
                 return ret_buf;
             }
             if (m_cur_log_buf.size() == 0) {
@@ -63,7 +107,7 @@ read_again:
     if (header->magic_word() != LOG_GROUP_HDR_MAGIC) {
         LOGDEBUGMOD(logstore, "Logdev data not seeing magic at pos {}, must have come to end of log_dev={}",
                     m_vdev_jd->dev_offset(m_cur_read_bytes), m_vdev_jd->logdev_id());
-        *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+        *out_dev_offset = next_group_offset();
         // move it by dma boundary if header is not valid
         m_prev_crc = 0;
         m_cur_read_bytes += m_read_size_multiple;
@@ -73,26 +117,24 @@ read_again:
     if (header->logdev_id != m_vdev_jd->logdev_id()) {
         LOGINFOMOD(logstore, "Entries found for different logdev {} at pos {}, must have come to end of log_dev={}",
                    header->logdev_id, m_vdev_jd->dev_offset(m_cur_read_bytes), m_vdev_jd->logdev_id());
-        *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+        *out_dev_offset = next_group_offset();
         // move it by dma boundary if header is not valid
         m_prev_crc = 0;
         m_cur_read_bytes += m_read_size_multiple;
         return ret_buf;
     }
 
-    // Because reuse chunks without cleaning up, we could get chunks used by other logdev's
-    // and it can happen that log group headers couldnt match. In that case check we dont error
-    // if its the last chunk or not with is_offset_at_last_chunk else raise assert.
-    // compare it with prev crc
+    // Because reuse chunks without cleaning up, we could get chunks used by other logdev's and it can happen that log
+    // group headers couldnt match. Since multiple log groups are written in parallel, the groups which were completely
+    // written after a torn group (possibly in the next chunk) could also remain. The group which breaks the crc chain
+    // is returned as end of log here, it is upto the caller to validate that it is only followed by the groups which
+    // could have been in flight with it (see LogDev::assert_log_tail).
     if (m_prev_crc != 0 && m_prev_crc != header->prev_grp_crc) {
         // we reached at the end
         LOGDEBUGMOD(logstore,
                     "we have reached the end. crc doesn't match offset {} prev crc {} header prev crc {} log_dev={}",
                     m_vdev_jd->dev_offset(m_cur_read_bytes), header->prev_grp_crc, m_prev_crc, m_vdev_jd->logdev_id());
-        *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
-        if (!m_vdev_jd->is_offset_at_last_chunk(*out_dev_offset)) {
-            HS_REL_ASSERT(0, "data is corrupted {}", m_vdev_jd->logdev_id());
-        }
+        *out_dev_offset = next_group_offset();
         // move it by dma boundary if header is not valid
         m_prev_crc = 0;
         m_cur_read_bytes += m_read_size_multiple;
@@ -116,16 +158,13 @@ read_again:
     // At this point data seems to be valid. Lets see if a data is written completely by comparing the footer
     const auto* footer = r_cast< log_group_footer* >((uint64_t)m_cur_log_buf.bytes() + header->footer_offset);
     if (footer->magic != LOG_GROUP_FOOTER_MAGIC || footer->start_log_idx != header->start_log_idx) {
-        LOGERROR("last write is not completely written. footer magic {} footer start_log_idx {} header log indx {} "
-                 "log_dev={}",
-                 footer->magic, footer->start_log_idx, header->start_log_idx, m_vdev_jd->logdev_id());
-        *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+        LOGWARN("last write is not completely written, possibly end of log. footer magic {} footer "
+                "start_log_idx {} header log indx {} log_dev={}",
+                footer->magic, footer->start_log_idx, header->start_log_idx, m_vdev_jd->logdev_id());
+        *out_dev_offset = next_group_offset();
         // move it by dma boundary if header is not valid
         m_prev_crc = 0;
         m_cur_read_bytes += m_read_size_multiple;
-        if (!m_vdev_jd->is_offset_at_last_chunk(*out_dev_offset)) {
-            HS_REL_ASSERT(0, "data is corrupted {}", m_vdev_jd->logdev_id());
-        }
         return ret_buf;
     }
 
@@ -136,10 +175,11 @@ read_again:
         crc32_ieee(init_crc32, s_cast< const uint8_t* >(m_cur_log_buf.bytes()) + sizeof(log_group_header),
                    (header->total_size() - sizeof(log_group_header)));
     if (cur_crc != header->cur_grp_crc) {
-        /* This is a valid entry so crc should match */
-        LOGERROR("crc doesn't match {} log_dev={}", m_vdev_jd->dev_offset(m_cur_read_bytes), m_vdev_jd->logdev_id());
-        HS_REL_ASSERT(0, "data is corrupted {}", m_vdev_jd->logdev_id());
-        *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+        // Header and footer made it to the device but not all of the data in between, so the group is torn and
+        // possibly the end of log
+        LOGWARN("crc doesn't match, possibly a torn group at the end of log {} log_dev={}",
+                m_vdev_jd->dev_offset(m_cur_read_bytes), m_vdev_jd->logdev_id());
+        *out_dev_offset = next_group_offset();
 
         // move it by dma boundary if header is not valid
         m_prev_crc = 0;
@@ -151,7 +191,7 @@ read_again:
     m_prev_crc = cur_crc;
 
     ret_buf = m_cur_log_buf;
-    *out_dev_offset = m_vdev_jd->dev_offset(m_cur_read_bytes);
+    *out_dev_offset = next_group_offset();
     m_cur_read_bytes += header->total_size();
     m_cur_log_buf.move_forward(header->total_size());
 
@@ -165,26 +205,104 @@ sisl::byte_view log_stream_reader::group_in_next_page() {
 }
 
 sisl::byte_view log_stream_reader::read_next_bytes(uint64_t nbytes, bool& end_of_stream) {
+    if (m_read_ahead_bufs) { return read_ahead_next_bytes(nbytes, end_of_stream); }
+
     // TODO: Might need to address alignment based on data or fast type
-    const auto prev_pos = m_vdev_jd->seeked_pos();
-    auto sz_to_read = m_vdev_jd->sync_next_read(nullptr, nbytes);
+    const auto prev_pos = m_own_cursor ? m_cursor : m_vdev_jd->seeked_pos();
+    if (m_own_cursor) {
+        nbytes = limit_read_size(nbytes);
+        if (nbytes == 0) {
+            end_of_stream = true;
+            return sisl::byte_view{m_cur_log_buf};
+        }
+    }
+    auto sz_to_read = next_read(nullptr, nbytes);
     if (sz_to_read == -1) {
         end_of_stream = true;
         return sisl::byte_view{m_cur_log_buf};
     }
 
     if (sz_to_read == 0) { return sisl::byte_view{m_cur_log_buf}; }
+    auto const read_start = m_own_cursor ? m_cursor : m_vdev_jd->seeked_pos();
 
     auto out_buf =
         hs_utils::make_byte_array(sz_to_read + m_cur_log_buf.size(), true, sisl::buftag::logread, m_vdev->align_size());
     if (m_cur_log_buf.size()) { memcpy(out_buf->bytes(), m_cur_log_buf.bytes(), m_cur_log_buf.size()); }
 
-    auto sz_read = m_vdev_jd->sync_next_read(out_buf->bytes() + m_cur_log_buf.size(), sz_to_read);
+    auto sz_read = next_read(out_buf->bytes() + m_cur_log_buf.size(), sz_to_read);
+    if (sz_read == -1) {
+        // Truncated while it was being read, there is nothing more to stream
+        end_of_stream = true;
+        return sisl::byte_view{m_cur_log_buf};
+    }
     assert(sz_read == sz_to_read);
+    m_buf_end_offset = read_start + sz_read;
 
     LOGTRACEMOD(logstore,
                 "LogStream read {} bytes req bytes {} from vdev prev offset {} and vdev cur offset {} log_dev={}",
-                sz_read, nbytes, prev_pos, m_vdev_jd->seeked_pos(), m_vdev_jd->logdev_id());
+                sz_read, nbytes, prev_pos, m_own_cursor ? m_cursor : m_vdev_jd->seeked_pos(), m_vdev_jd->logdev_id());
     return sisl::byte_view{out_buf};
 }
+
+sisl::byte_view log_stream_reader::read_ahead_next_bytes(uint64_t nbytes, bool& end_of_stream) {
+    issue_read_ahead(nbytes);
+    if (m_read_ahead_q.empty()) {
+        end_of_stream = true;
+        return sisl::byte_view{m_cur_log_buf};
+    }
+
+    auto rbuf = std::move(m_read_ahead_q.front());
+    m_read_ahead_q.pop_front();
+    auto const err = wait_for_io(std::move(rbuf.fut));
+    if (err == JournalVirtualDev::Descriptor::truncated_read_error()) {
+        end_of_stream = true;
+        return sisl::byte_view{m_cur_log_buf};
+    }
+    // TODO: Check if we can have tolerate this error and somehow start homestore without replaying or in degraded mode?
+    HS_REL_ASSERT(!err, "Error in reading next stream of bytes, proceeding could cause some inconsistency, exiting");
+
+    // Keep the device busy with the next read, while caller is processing this buffer
+    issue_read_ahead(nbytes);
+
+    LOGTRACEMOD(logstore, "LogStream consumed read ahead of {} bytes at vdev offset {}, in flight={} log_dev={}",
+                rbuf.size, rbuf.dev_offset, m_read_ahead_q.size(), m_vdev_jd->logdev_id());
+    m_buf_end_offset = rbuf.dev_offset + rbuf.size;
+    if (m_cur_log_buf.size() == 0) { return sisl::byte_view{rbuf.buf, 0, uint32_cast(rbuf.size)}; }
+
+    auto out_buf = hs_utils::make_byte_array(rbuf.size + m_cur_log_buf.size(), true, sisl::buftag::logread,
+                                             m_vdev->align_size());
+    memcpy(out_buf->bytes(), m_cur_log_buf.bytes(), m_cur_log_buf.size());
+    memcpy(out_buf->bytes() + m_cur_log_buf.size(), rbuf.buf->cbytes(), rbuf.size);
+    return sisl::byte_view{out_buf};
+}
+
+void log_stream_reader::issue_read_ahead(uint64_t nbytes) {
+    while (!m_read_ahead_eos && (m_read_ahead_q.size() < m_read_ahead_bufs)) {
+        auto const limited_nbytes = limit_read_size(nbytes);
+        if (limited_nbytes == 0) {
+            m_read_ahead_eos = true;
+            break;
+        }
+
+        // Get the size which could be read without crossing the chunk, 0 means cursor is moved to next chunk
+        auto const sz = m_vdev_jd->sync_next_read(nullptr, limited_nbytes, m_cursor);
+        if (sz == -1) {
+            m_read_ahead_eos = true;
+            break;
+        }
+        if (sz == 0) { continue; }
+
+        read_ahead_buf rbuf;
+        rbuf.buf = hs_utils::make_byte_array(sz, true, sisl::buftag::logread, m_vdev->align_size());
+        rbuf.dev_offset = m_cursor;
+        rbuf.size = sz;
+        [[maybe_unused]] auto const issued = m_vdev_jd->async_next_read(rbuf.buf->bytes(), sz, m_cursor, rbuf.fut);
+        HS_DBG_ASSERT_EQ(issued, sz, "Read ahead size mismatch log_dev={}", m_vdev_jd->logdev_id());
+        m_read_ahead_q.push_back(std::move(rbuf));
+    }
+}
+
+int64_t log_stream_reader::next_read(uint8_t* buf, uint64_t nbytes) {
+    return m_own_cursor ? m_vdev_jd->sync_next_read(buf, nbytes, m_cursor) : m_vdev_jd->sync_next_read(buf, nbytes);
+}
 } // namespace homestore
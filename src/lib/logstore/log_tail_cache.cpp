@@ -0,0 +1,110 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <cstring>
+
+#include "common/homestore_config.hpp"
+#include "common/resource_mgr.hpp"
+#include "log_dev.hpp"
+
+namespace homestore {
+
+void LogTailCache::add(logid_t from_idx, const std::vector< sisl::io_blob >& datas) {
+    uint64_t group_size{0};
+    for (auto const& d : datas) {
+        group_size += d.size();
+    }
+
+    // Payloads are copied outside of the lock, in one buffer for the group which all its records refer to.
+    sisl::byte_array buf;
+    auto const enabled = (resource_mgr().get_log_tail_cache_mem_limit() > 0);
+    if (enabled && (group_size != 0)) {
+        buf = sisl::make_byte_array(group_size, 0, sisl::buftag::logread);
+        uint64_t offset{0};
+        for (auto const& d : datas) {
+            std::memcpy(buf->bytes() + offset, d.cbytes(), d.size());
+            offset += d.size();
+        }
+    }
+
+    folly::SharedMutexWritePriority::WriteHolder holder(m_mtx);
+    if (!enabled) {
+        evict_all_under_lock();
+        return;
+    }
+
+    // Records are expected in the order of log idx, in case of any gap cache is no longer a contiguous tail, so start
+    // the cache afresh.
+    if (!m_records.empty() && (from_idx != m_start_idx + s_cast< logid_t >(m_records.size()))) {
+        evict_all_under_lock();
+    }
+
+    // Budget is shared by all the logdevs, make room for this group by evicting our own oldest records. If that is
+    // not enough, others are holding the budget and this group is not cached.
+    while (!m_records.empty() && !resource_mgr().can_add_log_tail_cache_mem(s_cast< int64_t >(group_size))) {
+        pop_front_under_lock();
+    }
+    if (!resource_mgr().can_add_log_tail_cache_mem(s_cast< int64_t >(group_size))) { return; }
+
+    if (m_records.empty()) { m_start_idx = from_idx; }
+    uint32_t offset{0};
+    for (auto const& d : datas) {
+        m_records.emplace_back(buf, offset, d.size());
+        offset += d.size();
+    }
+    m_size += group_size;
+    resource_mgr().inc_log_tail_cache_mem(s_cast< int64_t >(group_size));
+}
+
+bool LogTailCache::get(logid_t idx, log_buffer& out_buf) const {
+    folly::SharedMutexWritePriority::ReadHolder holder(m_mtx);
+    if (m_records.empty() || (idx < m_start_idx) || (idx >= m_start_idx + s_cast< logid_t >(m_records.size()))) {
+        return false;
+    }
+    out_buf = m_records[idx - m_start_idx];
+    return true;
+}
+
+void LogTailCache::truncate(logid_t upto_idx) {
+    folly::SharedMutexWritePriority::WriteHolder holder(m_mtx);
+    while (!m_records.empty() && (m_start_idx <= upto_idx)) {
+        pop_front_under_lock();
+    }
+}
+
+void LogTailCache::clear() {
+    folly::SharedMutexWritePriority::WriteHolder holder(m_mtx);
+    evict_all_under_lock();
+}
+
+uint64_t LogTailCache::size() const {
+    folly::SharedMutexWritePriority::ReadHolder holder(m_mtx);
+    return m_size;
+}
+
+void LogTailCache::evict_all_under_lock() {
+    while (!m_records.empty()) {
+        pop_front_under_lock();
+    }
+}
+
+void LogTailCache::pop_front_under_lock() {
+    auto const sz = m_records.front().size();
+    m_size -= sz;
+    resource_mgr().dec_log_tail_cache_mem(s_cast< int64_t >(sz));
+    m_records.pop_front();
+    ++m_start_idx;
+}
+} // namespace homestore
@@ -26,6 +26,15 @@ struct FixedLenBtree {
     static constexpr btree_node_type interior_node_type = btree_node_type::FIXED;
 };
 
+// Interior nodes above leaves buffer the blind upserts, before pushing them down to leaves
+struct FixedLenBufferedBtree {
+    using BtreeType = IndexTable< TestFixedKey, TestFixedValue >;
+    using KeyType = TestFixedKey;
+    using ValueType = TestFixedValue;
+    static constexpr btree_node_type leaf_node_type = btree_node_type::FIXED;
+    static constexpr btree_node_type interior_node_type = btree_node_type::BUFFERED;
+};
+
 struct VarKeySizeBtree {
     using BtreeType = IndexTable< TestVarLenKey, TestFixedValue >;
     using KeyType = TestVarLenKey;
@@ -62,6 +62,9 @@ struct BtreeTestHelper {
         m_operations["range_put"] = std::bind(&BtreeTestHelper::range_put_random, this);
         m_operations["range_remove"] = std::bind(&BtreeTestHelper::range_remove_existing_random, this);
         m_operations["query"] = std::bind(&BtreeTestHelper::query_random, this);
+        m_operations["get"] = std::bind(&BtreeTestHelper::get_random, this);
+        m_operations["batch_put"] = std::bind(&BtreeTestHelper::batch_put_random, this);
+        m_operations["batch_remove"] = std::bind(&BtreeTestHelper::batch_remove_random, this);
     }
 
     void TearDown() {}
@@ -80,6 +83,7 @@ protected:
     std::condition_variable m_test_done_cv;
     std::random_device m_re;
     std::atomic< uint32_t > m_num_ops{0};
+    std::atomic< uint64_t > m_num_keys{0}; // Keys processed by random put/remove ops, batch ops process many per op
 #ifdef _PRERELEASE
     flip::FlipClient m_fc{iomgr_flip::instance()};
 #endif
@@ -161,17 +165,28 @@ public:
     }
 
     uint32_t get_op_num() const { return m_num_ops.load(); }
+    uint64_t get_key_num() const { return m_num_keys.load(); }
 
     ////////////////////// All put operation variants ///////////////////////////////
     void put(uint64_t k, btree_put_type put_type, bool expect = true) {
         do_put(k, put_type, V::generate_rand(), expect);
     }
 
+    // Upsert which doesn't ask for existing value, so that btree is free to defer applying it to the leaf
+    void blind_put(uint64_t k) {
+        K key = K{k};
+        V value = V::generate_rand();
+        auto sreq = BtreeSinglePutRequest{&key, &value, btree_put_type::UPSERT};
+        ASSERT_EQ(m_bt->put(sreq), btree_status_t::success) << "Blind put failed for key=" << k;
+        m_shadow_map.force_put(key, value);
+    }
+
     void put_random() {
         auto [start_k, end_k] = m_shadow_map.pick_random_non_existing_keys(1);
         RELEASE_ASSERT_EQ(start_k, end_k, "Range scheduler pick_random_non_existing_keys issue");
 
         do_put(start_k, btree_put_type::INSERT, V::generate_rand());
+        m_num_keys.fetch_add(1);
     }
 
     void force_upsert(uint64_t k) {
@@ -216,6 +231,70 @@ public:
         range_put(start_k, end_k, V::generate_rand(), is_update);
     }
 
+    // Insert every stride'th key in [start_k, end_k] through one batch put request
+    void batch_put(uint32_t start_k, uint32_t end_k, uint32_t stride = 1) {
+        std::vector< std::pair< K, V > > kvs;
+        for (uint64_t k{start_k}; k <= end_k; k += stride) {
+            kvs.emplace_back(K{k}, V::generate_rand());
+        }
+
+        auto preq = BtreeBatchPutRequest< K, V >{kvs, btree_put_type::INSERT};
+        ASSERT_EQ(m_bt->put(preq), btree_status_t::success) << "batch_put failed for " << start_k << "-" << end_k;
+        ASSERT_EQ(preq.is_done(), true) << "batch_put didn't process all keys for " << start_k << "-" << end_k;
+
+        uint32_t expected_applied{0};
+        for (auto const& [k, v] : kvs) {
+            if (m_shadow_map.exists(k)) {
+                m_shadow_map.remove_keys_from_working(k.key(), k.key());
+            } else {
+                ++expected_applied;
+                m_shadow_map.put_and_check(k, v, v, true /* expected_success */);
+            }
+        }
+        ASSERT_EQ(preq.num_applied(), expected_applied) << "batch_put inserted count mismatch with shadow map";
+    }
+
+    // Batch put with keys out of order must be rejected without applying any of them
+    void batch_put_unsorted(uint32_t start_k, uint32_t end_k) {
+        std::vector< std::pair< K, V > > kvs;
+        for (uint64_t k{end_k}; k >= start_k && k <= end_k; --k) {
+            kvs.emplace_back(K{k}, V::generate_rand());
+        }
+
+        auto preq = BtreeBatchPutRequest< K, V >{kvs, btree_put_type::UPSERT};
+        ASSERT_EQ(m_bt->put(preq), btree_status_t::not_supported) << "Unsorted batch_put is expected to be rejected";
+        ASSERT_EQ(preq.num_applied(), 0) << "Unsorted batch_put is not expected to apply any key";
+
+        std::vector< K > keys;
+        for (auto const& kv : kvs) {
+            keys.push_back(kv.first);
+        }
+        auto rreq = BtreeBatchRemoveRequest< K >{keys};
+        ASSERT_EQ(m_bt->remove(rreq), btree_status_t::not_supported) << "Unsorted batch_remove is to be rejected";
+    }
+
+    void batch_put_random() {
+        static thread_local std::uniform_int_distribution< uint32_t > s_rand_range_generator{1, 100};
+
+        auto const [start_k, end_k] = m_shadow_map.pick_random_non_existing_keys(s_rand_range_generator(m_re));
+        batch_put(start_k, end_k);
+        m_num_keys.fetch_add(end_k - start_k + 1);
+    }
+
+    // Load every stride'th key in [start_k, end_k] into an empty btree
+    void bulk_load(uint32_t start_k, uint32_t end_k, uint32_t stride = 1) {
+        uint64_t next_k{start_k};
+        auto const ret = m_bt->bulk_load([this, &next_k, end_k, stride](K& key, V& value) {
+            if (next_k > end_k) { return false; }
+            key = K{next_k};
+            value = V::generate_rand();
+            m_shadow_map.force_put(key, value);
+            next_k += stride;
+            return true;
+        });
+        ASSERT_EQ(ret, btree_status_t::success) << "bulk_load failed for " << start_k << "-" << end_k;
+    }
+
     ////////////////////// All remove operation variants ///////////////////////////////
     void remove_one(uint32_t k, bool care_success = true) {
         auto existing_v = std::make_unique< V >();
@@ -242,6 +321,36 @@ public:
         RELEASE_ASSERT_EQ(start_k, end_k, "Range scheduler pick_random_existing_keys issue");
 
         remove_one(start_k);
+        m_num_keys.fetch_add(1);
+    }
+
+    // Remove every stride'th key in [start_k, end_k] through one batch remove request
+    void batch_remove(uint32_t start_k, uint32_t end_k, uint32_t stride = 1) {
+        std::vector< K > keys;
+        uint32_t expected_removed{0};
+        for (uint64_t k{start_k}; k <= end_k; k += stride) {
+            keys.emplace_back(k);
+            if (m_shadow_map.exists(keys.back())) { ++expected_removed; }
+        }
+
+        auto rreq = BtreeBatchRemoveRequest< K >{keys};
+        auto const ret = m_bt->remove(rreq);
+        ASSERT_EQ(rreq.num_applied(), expected_removed) << "batch_remove count mismatch with shadow map";
+        if (expected_removed) {
+            ASSERT_EQ(ret, btree_status_t::success) << "batch_remove failed for " << start_k << "-" << end_k;
+        }
+
+        for (auto const& k : keys) {
+            m_shadow_map.erase(k);
+        }
+    }
+
+    void batch_remove_random() {
+        static thread_local std::uniform_int_distribution< uint32_t > s_rand_range_generator{1, 100};
+
+        auto const [start_k, end_k] = m_shadow_map.pick_random_existing_keys(s_rand_range_generator(m_re));
+        batch_remove(start_k, end_k);
+        m_num_keys.fetch_add(end_k - start_k + 1);
     }
 
     void range_remove_existing(uint32_t start_k, uint32_t count) {
@@ -267,7 +376,7 @@ public:
         do_query(0u, SISL_OPTIONS["num_entries"].as< uint32_t >() - 1, batch_size);
     }
 
-    void do_query(uint32_t start_k, uint32_t end_k, uint32_t batch_size) {
+    void do_query(uint32_t start_k, uint32_t end_k, uint32_t batch_size, uint32_t read_ahead_depth = 0) {
         std::vector< std::pair< K, V > > out_vector;
         m_shadow_map.guard().lock();
         uint32_t remaining = m_shadow_map.num_elems_in_range(start_k, end_k);
@@ -275,6 +384,7 @@ public:
 
         BtreeQueryRequest< K > qreq{BtreeKeyRange< K >{K{start_k}, true, K{end_k}, true},
                                     BtreeQueryType::SWEEP_NON_INTRUSIVE_PAGINATION_QUERY, batch_size};
+        qreq.set_read_ahead_depth(read_ahead_depth);
         while (remaining > 0) {
             out_vector.clear();
             qreq.enable_route_tracing();
@@ -346,6 +456,14 @@ public:
         }
     }
 
+    void get_random() {
+        auto const [start_k, end_k] = m_shadow_map.pick_random_non_working_keys(1);
+        get_specific(start_k);
+        if (start_k < m_max_range_input) {
+            m_shadow_map.remove_keys_from_working(start_k, std::min(end_k, m_max_range_input - 1));
+        }
+    }
+
     void get_any(uint32_t start_k, uint32_t end_k) const {
         auto out_k = std::make_unique< K >();
         auto out_v = std::make_unique< V >();
@@ -133,6 +133,10 @@ public:
     bool operator==(const TestFixedKey& other) const { return (compare(other) == 0); }
 
     uint64_t key() const { return m_key; }
+
+    using integral_key_t = uint64_t;
+    integral_key_t integral_key() const { return m_key; }
+
     uint64_t start_key(const BtreeKeyRange< TestFixedKey >& range) const {
         const TestFixedKey& k = (const TestFixedKey&)(range.start_key());
         return k.m_key;
@@ -357,6 +361,10 @@ public:
     bool operator==(const TestIntervalKey& other) const { return (compare(other) == 0); }
 
     uint64_t key() const { return (uint64_cast(m_base) << 32) | m_offset; }
+
+    using integral_key_t = uint64_t;
+    integral_key_t integral_key() const { return key(); }
+
     uint64_t start_key(const BtreeKeyRange< TestIntervalKey >& range) const {
         const TestIntervalKey& k = (const TestIntervalKey&)(range.start_key());
         return k.key();
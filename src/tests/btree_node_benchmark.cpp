@@ -0,0 +1,141 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <benchmark/benchmark.h>
+
+#define StoreSpecificBtreeNode homestore::BtreeNode
+
+#include <sisl/options/options.h>
+#include <sisl/logging/logging.h>
+#include <homestore/btree/detail/simple_node.hpp>
+#include <homestore/btree/detail/varlen_node.hpp>
+#include <homestore/btree/detail/prefix_node.hpp>
+#include "btree_helpers/btree_test_kvs.hpp"
+
+using namespace homestore;
+SISL_LOGGING_DEF(btree)
+SISL_LOGGING_INIT(HOMESTORE_LOG_MODS)
+
+SISL_OPTIONS_ENABLE(logging, btree_node_benchmark)
+SISL_OPTION_GROUP(btree_node_benchmark,
+                  (node_size, "", "node_size", "size of the node to search on",
+                   ::cxxopts::value< uint32_t >()->default_value("4096"), "number"),
+                  (num_lookups, "", "num_lookups", "number of random lookup keys generated per benchmark",
+                   ::cxxopts::value< uint32_t >()->default_value("65536"), "number"))
+
+#define BTREE_NODE_BENCHMARK(NODE_TYPE, SEARCH_MODE)                                                                   \
+    BENCHMARK(run_lookup< NODE_TYPE, SEARCH_MODE >)->Name(#NODE_TYPE "/" #SEARCH_MODE);
+
+struct FixedLenNodeBench {
+    using NodeType = SimpleNode< TestFixedKey, TestFixedValue >;
+    using KeyType = TestFixedKey;
+    using ValueType = TestFixedValue;
+};
+
+struct PrefixIntervalNodeBench {
+    using NodeType = FixedPrefixNode< TestIntervalKey, TestIntervalValue >;
+    using KeyType = TestIntervalKey;
+    using ValueType = TestIntervalValue;
+};
+
+struct VarKeySizeNodeBench {
+    using NodeType = VarKeySizeNode< TestVarLenKey, TestFixedValue >;
+    using KeyType = TestVarLenKey;
+    using ValueType = TestFixedValue;
+};
+
+// generic: The baseline binary search which compares with virtual compare_nth_key() for every probe
+// scalar/avx2: Node specific search (vectorized for integral keys) with the isa forced to the given one
+ENUM(search_mode_t, uint8_t, generic, scalar, avx2)
+
+// Exposes the protected search methods of the node, so that we can compare baseline and specialized search
+template < typename NodeT >
+class SearchableNode : public NodeT {
+public:
+    using NodeT::NodeT;
+
+    std::pair< bool, uint32_t > generic_search(BtreeKey const& key) const {
+        return this->bsearch(-1, this->total_entries(), key);
+    }
+    std::pair< bool, uint32_t > specialized_search(BtreeKey const& key) const { return this->bsearch_node(key); }
+};
+
+template < typename TestType, search_mode_t Mode >
+void run_lookup(benchmark::State& state) {
+    using K = typename TestType::KeyType;
+    using V = typename TestType::ValueType;
+
+    auto const node_size = SISL_OPTIONS["node_size"].as< uint32_t >();
+    BtreeConfig cfg{node_size};
+    auto node_buf = std::unique_ptr< uint8_t[] >(new uint8_t[node_size]);
+    SearchableNode< typename TestType::NodeType > node{node_buf.get(), 1ul, true, true, cfg};
+
+    // Fill the node with every alternate key, so that roughly half of the random lookups are misses
+    uint32_t nkeys{0};
+    while (node.available_size() > (g_max_keysize + g_max_valsize + 32)) {
+        node.put(K{nkeys * 2}, V::generate_rand(), btree_put_type::INSERT, nullptr);
+        ++nkeys;
+    }
+
+    std::uniform_int_distribution< uint32_t > key_gen{0, nkeys * 2};
+    std::vector< K > lookup_keys;
+    auto const num_lookups = SISL_OPTIONS["num_lookups"].as< uint32_t >();
+    lookup_keys.reserve(num_lookups);
+    for (uint32_t i{0}; i < num_lookups; ++i) {
+        lookup_keys.emplace_back(key_gen(g_re));
+    }
+
+    auto const detected_isa = node_search::detect_isa();
+    if (Mode == search_mode_t::scalar) {
+        node_search::set_isa(node_search_isa_t::SCALAR);
+    } else if (Mode == search_mode_t::avx2) {
+        node_search::set_isa(node_search_isa_t::AVX2);
+    }
+
+    uint64_t nfound{0};
+    for (auto _ : state) {
+        for (auto const& k : lookup_keys) {
+            auto const [found, idx] =
+                (Mode == search_mode_t::generic) ? node.generic_search(k) : node.specialized_search(k);
+            nfound += found;
+            benchmark::DoNotOptimize(idx);
+        }
+    }
+    node_search::set_isa(detected_isa);
+
+    state.SetItemsProcessed(state.iterations() * lookup_keys.size());
+    state.counters["entries_in_node"] = node.total_entries();
+    state.counters["hit_pct"] = (state.iterations() == 0)
+        ? 0.0
+        : (100.0 * nfound) / (state.iterations() * lookup_keys.size());
+    state.counters["lookups"] =
+        benchmark::Counter(state.iterations() * lookup_keys.size(), benchmark::Counter::kIsRate);
+}
+
+BTREE_NODE_BENCHMARK(FixedLenNodeBench, search_mode_t::generic)
+BTREE_NODE_BENCHMARK(FixedLenNodeBench, search_mode_t::scalar)
+BTREE_NODE_BENCHMARK(FixedLenNodeBench, search_mode_t::avx2)
+BTREE_NODE_BENCHMARK(PrefixIntervalNodeBench, search_mode_t::generic)
+BTREE_NODE_BENCHMARK(PrefixIntervalNodeBench, search_mode_t::scalar)
+BTREE_NODE_BENCHMARK(PrefixIntervalNodeBench, search_mode_t::avx2)
+BTREE_NODE_BENCHMARK(VarKeySizeNodeBench, search_mode_t::generic)
+BTREE_NODE_BENCHMARK(VarKeySizeNodeBench, search_mode_t::scalar)
+
+int main(int argc, char** argv) {
+    SISL_OPTIONS_LOAD(argc, argv, logging, btree_node_benchmark);
+    sisl::logging::SetLogger("btree_node_benchmark");
+    ::benchmark::Initialize(&argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+}
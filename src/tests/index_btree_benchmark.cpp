@@ -31,12 +31,33 @@ using namespace homestore;
 
 #define INDEX_BTREE_BENCHMARK(BTREE_TYPE)                                                                              \
     BENCHMARK(run_benchmark< BTREE_TYPE >)                                                                             \
-        ->Setup(BM_Setup< BTREE_TYPE >)                                                                                \
+        ->Setup(BM_Setup< BTREE_TYPE, false >)                                                                         \
         ->Teardown(BM_Teardown< BTREE_TYPE >)                                                                          \
         ->UseRealTime()                                                                                                \
         ->Iterations(1)                                                                                                \
         ->Name(#BTREE_TYPE);
 
+// Same as above, except that all the puts and removes in operation list are issued as batch of sorted keys
+#define INDEX_BTREE_BATCH_BENCHMARK(BTREE_TYPE)                                                                        \
+    BENCHMARK(run_benchmark< BTREE_TYPE >)                                                                             \
+        ->Setup(BM_Setup< BTREE_TYPE, true >)                                                                          \
+        ->Teardown(BM_Teardown< BTREE_TYPE >)                                                                          \
+        ->UseRealTime()                                                                                                \
+        ->Iterations(1)                                                                                                \
+        ->Name(#BTREE_TYPE "/batch");
+
+// Random gets on preloaded keys from one fiber on each of the given number of threads, with interior nodes either lock
+// coupled or optimistically read. Threads beyond what iomgr is started with (num_threads) are skipped.
+#define INDEX_BTREE_GET_SCALING_BENCHMARK(BTREE_TYPE, OPTIMISTIC, MODE_NAME)                                           \
+    BENCHMARK(run_get_scaling< BTREE_TYPE >)                                                                           \
+        ->Setup(BM_GetScalingSetup< BTREE_TYPE, OPTIMISTIC >)                                                          \
+        ->Teardown(BM_Teardown< BTREE_TYPE >)                                                                          \
+        ->RangeMultiplier(2)                                                                                           \
+        ->Range(1, 64)                                                                                                 \
+        ->UseRealTime()                                                                                                \
+        ->Iterations(1)                                                                                                \
+        ->Name(#BTREE_TYPE "/get_scaling/" MODE_NAME);
+
 // this is used to splite the setup and teardown from the benchmark to get a more accurate result
 void* g_btree_helper{nullptr};
 
@@ -61,11 +82,11 @@ struct IndexBtreeBenchmark : public BtreeTestHelper< TestType > {
     using T = TestType;
     using K = typename TestType::KeyType;
     using V = typename TestType::ValueType;
-    IndexBtreeBenchmark() { SetUp(); }
+    IndexBtreeBenchmark(bool batch_mode, bool optimistic_reads = false) { SetUp(batch_mode, optimistic_reads); }
 
     ~IndexBtreeBenchmark() { TearDown(); }
 
-    void SetUp() {
+    void SetUp(bool batch_mode, bool optimistic_reads) {
         m_helper.start_homestore("index_btree_benchmark",
                                  {{HS_SERVICE::META, {.size_pct = 10.0}}, {HS_SERVICE::INDEX, {.size_pct = 70.0}}});
 
@@ -76,9 +97,15 @@ struct IndexBtreeBenchmark : public BtreeTestHelper< TestType > {
         auto parent_uuid = boost::uuids::random_generator()();
 
         BtreeTestHelper< TestType >::SetUp();
+        this->m_cfg.m_optimistic_reads = optimistic_reads;
         this->m_bt = std::make_shared< typename T::BtreeType >(uuid, parent_uuid, 0, this->m_cfg);
         hs()->index_service().add_index_table(this->m_bt);
         auto input_ops = SISL_OPTIONS["operation_list"].as< std::vector< std::string > >();
+        if (batch_mode) {
+            for (auto& op : input_ops) {
+                if (op.starts_with("put:") || op.starts_with("remove:")) { op = "batch_" + op; }
+            }
+        }
         m_op_list = this->build_op_list(input_ops);
     }
 
@@ -89,14 +116,56 @@ struct IndexBtreeBenchmark : public BtreeTestHelper< TestType > {
 
     void run_benchmark() { this->run_in_parallel(m_op_list); }
 
+    // Returns false if iomgr doesn't have as many threads
+    bool run_get_scaling(uint32_t nthreads) {
+        std::vector< iomgr::io_fiber_t > fibers;
+        std::mutex mtx;
+        iomanager.run_on_wait(iomgr::reactor_regex::all_worker, [&fibers, &mtx, nthreads]() {
+            auto fv = iomanager.sync_io_capable_fibers();
+            std::unique_lock lg(mtx);
+            if (fibers.size() < nthreads) { fibers.push_back(fv[0]); }
+        });
+        if (fibers.size() < nthreads) { return false; }
+
+        auto const num_gets = SISL_OPTIONS["num_iters"].as< uint32_t >();
+        auto const max_key = std::max(SISL_OPTIONS["preload_size"].as< uint32_t >(), 1u);
+        auto pending = fibers.size();
+        for (auto const& fiber : fibers) {
+            iomanager.run_on_forget(fiber, [this, &pending, num_gets, max_key]() {
+                std::default_random_engine re{std::random_device{}()};
+                std::uniform_int_distribution< uint32_t > key_gen{0, max_key - 1};
+                for (uint32_t i{0}; i < num_gets; ++i) {
+                    K key{key_gen(re)};
+                    V value;
+                    auto req = BtreeSingleGetRequest{&key, &value};
+                    this->m_bt->get(req);
+                    this->m_num_ops.fetch_add(1);
+                }
+                std::unique_lock lg(this->m_test_done_mtx);
+                if (--pending == 0) { this->m_test_done_cv.notify_one(); }
+            });
+        }
+
+        std::unique_lock< std::mutex > lk(this->m_test_done_mtx);
+        this->m_test_done_cv.wait(lk, [&pending]() { return pending == 0; });
+        return true;
+    }
+
 private:
     test_common::HSTestHelper m_helper;
     std::vector< std::pair< std::string, int > > m_op_list;
 };
 
-template < class BenchmarkType >
+template < class BenchmarkType, bool BatchMode >
 void BM_Setup(const benchmark::State& state) {
-    g_btree_helper = new IndexBtreeBenchmark< BenchmarkType >();
+    g_btree_helper = new IndexBtreeBenchmark< BenchmarkType >(BatchMode);
+    auto helper = s_cast< IndexBtreeBenchmark< BenchmarkType >* >(g_btree_helper);
+    helper->preload(SISL_OPTIONS["preload_size"].as< uint32_t >());
+}
+
+template < class BenchmarkType, bool Optimistic >
+void BM_GetScalingSetup(const benchmark::State& state) {
+    g_btree_helper = new IndexBtreeBenchmark< BenchmarkType >(false /* batch_mode */, Optimistic);
     auto helper = s_cast< IndexBtreeBenchmark< BenchmarkType >* >(g_btree_helper);
     helper->preload(SISL_OPTIONS["preload_size"].as< uint32_t >());
 }
@@ -111,12 +180,29 @@ template < class BenchmarkType >
 void add_custom_counter(benchmark::State& state) {
     auto helper = s_cast< IndexBtreeBenchmark< BenchmarkType >* >(g_btree_helper);
     auto totol_ops = helper->get_op_num();
+    auto total_keys = helper->get_key_num();
     state.counters["thread_num"] = SISL_OPTIONS["num_threads"].as< uint32_t >();
     state.counters["fiber_num"] = SISL_OPTIONS["num_fibers"].as< uint32_t >();
     state.counters["total_ops"] = totol_ops;
     state.counters["rate"] = benchmark::Counter(totol_ops, benchmark::Counter::kIsRate);
     state.counters["InvRate"] =
         benchmark::Counter(totol_ops, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["total_keys"] = total_keys;
+    state.counters["key_rate"] = benchmark::Counter(total_keys, benchmark::Counter::kIsRate);
+}
+
+template < class BenchmarkType >
+void run_get_scaling(benchmark::State& state) {
+    auto helper = s_cast< IndexBtreeBenchmark< BenchmarkType >* >(g_btree_helper);
+    auto const nthreads = uint32_cast(state.range(0));
+    for (auto _ : state) {
+        if (!helper->run_get_scaling(nthreads)) {
+            state.SkipWithError("Not enough iomgr threads, increase num_threads");
+            break;
+        }
+    }
+    add_custom_counter< BenchmarkType >(state);
+    state.counters["thread_num"] = nthreads;
 }
 
 template < class BenchmarkType >
@@ -132,6 +218,14 @@ INDEX_BTREE_BENCHMARK(FixedLenBtree)
 INDEX_BTREE_BENCHMARK(VarKeySizeBtree)
 INDEX_BTREE_BENCHMARK(VarValueSizeBtree)
 INDEX_BTREE_BENCHMARK(VarObjSizeBtree)
+INDEX_BTREE_BATCH_BENCHMARK(FixedLenBtree)
+INDEX_BTREE_BATCH_BENCHMARK(VarKeySizeBtree)
+INDEX_BTREE_BATCH_BENCHMARK(VarValueSizeBtree)
+INDEX_BTREE_BATCH_BENCHMARK(VarObjSizeBtree)
+INDEX_BTREE_GET_SCALING_BENCHMARK(FixedLenBtree, false, "locked")
+INDEX_BTREE_GET_SCALING_BENCHMARK(FixedLenBtree, true, "optimistic")
+INDEX_BTREE_GET_SCALING_BENCHMARK(VarValueSizeBtree, false, "locked")
+INDEX_BTREE_GET_SCALING_BENCHMARK(VarValueSizeBtree, true, "optimistic")
 // INDEX_BTREE_BENCHMARK(PrefixIntervalBtree)
 
 int main(int argc, char** argv) {
@@ -13,130 +13,149 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
-#include <condition_variable>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <filesystem>
-#include <fstream>
-#include <iostream>
-#include <mutex>
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <benchmark/benchmark.h>
+#include <iomgr/io_environment.hpp>
 #include <sisl/logging/logging.h>
 #include <sisl/options/options.h>
+#include <homestore/homestore.hpp>
+#include <homestore/logstore_service.hpp>
+#include "common/homestore_config.hpp"
+#include "test_common/homestore_test_common.hpp"
 
-#include "logstore/log_dev.hpp"
-
+using namespace homestore;
 SISL_LOGGING_INIT(HOMESTORE_LOG_MODS)
-RCU_REGISTER_INIT
-
-static constexpr size_t ITERATIONS{100000};
-static constexpr size_t THREADS{64};
-
-static std::vector< logdev_key > s_log_keys;
-static uint64_t first_offset{~static_cast< uint64_t >(0)};
 
-void test_append(benchmark::State& state) {
-    uint64_t counter{0};
-    for ([[maybe_unused]] auto current_state : state) { // Loops upto iteration count
-        my_request* req{nullptr};
-        benchmark::DoNotOptimize(req = new my_request());
-        LogDev::instance()->append();
+SISL_OPTIONS_ENABLE(logging, log_dev_benchmark, iomgr, test_common_setup)
+SISL_OPTION_GROUP(log_dev_benchmark,
+                  (num_logdevs, "", "num_logdevs", "number of logdevs (with one log store each)",
+                   ::cxxopts::value< uint32_t >()->default_value("1"), "number"),
+                  (num_records, "", "num_records", "number of log records written to each logdev",
+                   ::cxxopts::value< uint64_t >()->default_value("200000"), "number"),
+                  (record_size, "", "record_size", "size of each log record",
+                   ::cxxopts::value< uint32_t >()->default_value("512"), "number"),
+                  (batch_size, "", "batch_size", "number of records appended before each flush",
+                   ::cxxopts::value< uint32_t >()->default_value("64"), "number"));
+
+static test_common::HSTestHelper s_helper;
+
+struct bench_store {
+    logdev_id_t logdev_id;
+    logstore_id_t store_id;
+    std::shared_ptr< HomeLogStore > log_store;
+};
+static std::vector< bench_store > s_stores;
+
+static void append_records(bench_store& s, uint64_t nrecords) {
+    auto const batch_size = SISL_OPTIONS["batch_size"].as< uint32_t >();
+    std::string const data(SISL_OPTIONS["record_size"].as< uint32_t >(), 'x');
+    for (uint64_t i{0}; i < nrecords; ++i) {
+        s.log_store->append_async(sisl::io_blob{r_cast< const uint8_t* >(data.data()), uint32_cast(data.size()), false},
+                                  nullptr /* cookie */, nullptr /* cb */);
+        if ((i % batch_size) == (batch_size - 1)) { s.log_store->flush(); }
     }
-    std::cout << "Counter = " << counter << "\n";
+    s.log_store->flush();
 }
 
-[[nodiscard]] static std::shared_ptr< iomgr::ioMgr > start_homestore(const uint32_t ndevices, const uint64_t dev_size,
-                                                                     const uint32_t nthreads) {
-    std::vector< dev_info > device_info;
-    // these should be static so that they stay in scope in the lambda in case function ends before lambda completes
-    static std::mutex start_mutex;
-    static std::condition_variable cv;
-    static bool inited;
-
-    inited = false;
-    LOGINFO("creating {} device files with each of size {} ", ndevices, dev_size);
-    for (uint32_t i{0}; i < ndevices; ++i) {
-        const std::filesystem::path fpath{"/tmp/" + std::to_string(i + 1)};
-        std::ofstream ofs{fpath.string(), std::ios::binary | std::ios::out};
-        std::filesystem::resize_file(fpath, dev_size);
-        device_info.emplace_back(std::filesystem::canonical(fpath).string(), HSDevType::Data);
+// Append throughput of the logdev, with every batch_size records flushed together as a group
+static void test_append(benchmark::State& state) {
+    auto& s = s_stores[0];
+    auto const nrecords = SISL_OPTIONS["num_records"].as< uint64_t >();
+    for (auto _ : state) {
+        append_records(s, nrecords);
     }
+    state.SetItemsProcessed(state.iterations() * nrecords);
+    state.SetBytesProcessed(state.iterations() * nrecords * SISL_OPTIONS["record_size"].as< uint32_t >());
+}
 
-    LOGINFO("Creating iomgr with {} threads", nthreads);
-    auto iomgr_obj{std::make_shared< iomgr::ioMgr >(2, nthreads)};
-
-    const uint64_t app_mem_size{((ndevices * dev_size) * 15) / 100};
-    LOGINFO("Initialize and start HomeBlks with app_mem_size = {}", app_mem_size);
-
-    boost::uuids::string_generator gen;
-    init_params params;
-    params.open_flags = homestore::io_flag::DIRECT_IO;
-    params.min_virtual_page_size = 4096;
-    params.app_mem_size = app_mem_size;
-    params.devices = device_info;
-    params.iomgr = iomgr_obj;
-    params.init_done_cb = [&iomgr_obj, &tl_start_mutex = start_mutex, &tl_cv = cv,
-                           &tl_inited = inited](std::error_condition err, const out_params& params) {
-        iomgr_obj->start();
-        LOGINFO("HomeBlks Init completed");
-        {
-            std::unique_lock< std::mutex > lk{tl_start_mutex};
-            tl_inited = true;
+// Time taken to replay all the logdevs on restart, with given number of read ahead buffers in the log stream
+static void test_recovery(benchmark::State& state) {
+    HS_SETTINGS_FACTORY().modifiable_settings(
+        [&state](auto& s) { s.logstore.recovery_read_ahead_bufs = uint32_cast(state.range(0)); });
+    HS_SETTINGS_FACTORY().save();
+
+    uint64_t total_bytes{0};
+    uint64_t total_records{0};
+    for (auto _ : state) {
+        std::atomic< uint64_t > replayed_bytes{0};
+        std::atomic< uint64_t > replayed_records{0};
+        std::vector< std::promise< Clock::time_point > > replay_done(s_stores.size());
+        Clock::time_point start_time;
+
+        s_helper.change_start_cb([&]() {
+            start_time = Clock::now();
+            for (size_t i{0}; i < s_stores.size(); ++i) {
+                logstore_service().open_logdev(s_stores[i].logdev_id);
+                logstore_service()
+                    .open_log_store(
+                        s_stores[i].logdev_id, s_stores[i].store_id, true /* append_mode */,
+                        [&](logstore_seq_num_t, log_buffer buf, void*) {
+                            replayed_bytes.fetch_add(buf.size(), std::memory_order_relaxed);
+                            replayed_records.fetch_add(1, std::memory_order_relaxed);
+                        },
+                        [&replay_done, i](std::shared_ptr< HomeLogStore >, logstore_seq_num_t) {
+                            replay_done[i].set_value(Clock::now());
+                        })
+                    .thenValue([i](auto store) { s_stores[i].log_store = store; });
+            }
+        });
+        s_helper.restart_homestore(1 /* shutdown_delay_sec */);
+
+        Clock::time_point end_time{start_time};
+        for (auto& p : replay_done) {
+            end_time = std::max(end_time, p.get_future().get());
         }
-        tl_cv.notify_one();
-    };
-    params.vol_mounted_cb = [](const VolumePtr& vol_obj, vol_state state) {};
-    params.vol_state_change_cb = [](const VolumePtr& vol, vol_state old_state, vol_state new_state) {};
-    params.vol_found_cb = [](boost::uuids::uuid uuid) -> bool { return true; };
-    VolInterface::init(params);
-
-    {
-        std::unique_lock< std::mutex > lk{start_mutex};
-        cv.wait(lk, [] { return inited; });
+        state.SetIterationTime(std::chrono::duration< double >(end_time - start_time).count());
+        total_bytes += replayed_bytes.load();
+        total_records += replayed_records.load();
     }
-    return iomgr_obj;
-}
 
-static void on_append_completion(const logdev_key lkey, void* const ctx) {
-    s_log_keys.push_back(lkey);
-    LOGINFO("Append completed with log_idx = {} offset = {}", lkey.idx, lkey.dev_offset);
-    if (first_offset == ~static_cast< uint64_t >(0)) { first_offset = lkey.dev_offset; }
-}
-
-static void on_log_found(const logdev_key lkey, const log_buffer buf) {
-    s_log_keys.push_back(lkey);
-    LOGINFO("Found a log with log_idx = {} offset = {}", lkey.idx, lkey.dev_offset);
+    state.SetBytesProcessed(total_bytes);
+    state.SetItemsProcessed(total_records);
+    state.counters["replay_MBps"] =
+        benchmark::Counter(double(total_bytes) / (1024 * 1024), benchmark::Counter::kIsRate);
 }
 
 static void setup() {
-    auto iomgr_obj = start_homestore(SISL_OPTIONS["num_devs"].as< uint32_t >(),
-                                     SISL_OPTIONS["dev_size_mb"].as< uint64_t >() * 1024 * 1024,
-                                     SISL_OPTIONS["num_threads"].as< uint32_t >());
+    s_helper.start_homestore("test_log_dev_bench",
+                             {{HS_SERVICE::META, {.size_pct = 5.0}}, {HS_SERVICE::LOG, {.size_pct = 87.0}}});
+
+    auto const nrecords = SISL_OPTIONS["num_records"].as< uint64_t >();
+    for (uint32_t i{0}; i < SISL_OPTIONS["num_logdevs"].as< uint32_t >(); ++i) {
+        bench_store s;
+        s.logdev_id = logstore_service().create_new_logdev();
+        s.log_store = logstore_service().create_new_log_store(s.logdev_id, true /* append_mode */);
+        s.store_id = s.log_store->get_store_id();
+        s_stores.push_back(std::move(s));
+    }
 
-    LogDev::instance()->register_append_cb(on_append_completion);
-    LogDev::instance()->register_logfound_cb(on_log_found);
+    // Prefill the logdevs, so that there are enough records to replay even if only recovery is run
+    for (auto& s : s_stores) {
+        append_records(s, nrecords);
+    }
 }
 
-SISL_OPTIONS_ENABLE(logging, log_dev_benchmark)
-SISL_OPTION_GROUP(log_dev_benchmark,
-                  (num_threads, "", "num_threads", "number of threads",
-                   ::cxxopts::value< uint32_t >()->default_value("2"), "number"),
-                  (num_devs, "", "num_devs", "number of devices to create",
-                   ::cxxopts::value< uint32_t >()->default_value("2"), "number"),
-                  (dev_size_mb, "", "dev_size_mb", "size of each device in MB",
-                   ::cxxopts::value< uint64_t >()->default_value("5120"), "number"));
+static void teardown() { s_helper.shutdown_homestore(); }
 
-BENCHMARK(test_append)->Iterations(ITERATIONS)->Threads(THREADS);
+BENCHMARK(test_append)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(test_recovery)->Arg(0)->Arg(2)->Arg(4)->Iterations(3)->UseManualTime()->Unit(benchmark::kMillisecond);
 
-SISL_OPTIONS_ENABLE(logging)
 int main(int argc, char** argv) {
-    SISL_OPTIONS_LOAD(argc, argv, logging, log_dev_benchmark)
+    SISL_OPTIONS_LOAD(argc, argv, logging, log_dev_benchmark, iomgr, test_common_setup)
     sisl::logging::SetLogger("log_dev_benchmark");
     spdlog::set_pattern("[%D %T%z] [%^%l%$] [%n] [%t] %v");
 
     setup();
     ::benchmark::Initialize(&argc, argv);
     ::benchmark::RunSpecifiedBenchmarks();
+    LOGINFO("Metrics: {}", sisl::MetricsFarm::getInstance().get_result_in_json()["LogStores"].dump(4));
+    teardown();
 }
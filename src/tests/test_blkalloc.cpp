@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <iostream>
@@ -23,6 +24,7 @@
 #include <memory>
 #include <mutex>
 #include <random>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -35,6 +37,7 @@
 #include <sisl/options/options.h>
 #include <iomgr/iomgr_flip.hpp>
 
+#include "blkalloc/blk_bitmap.h"
 #include "blkalloc/blk_cache.h"
 #include "common/homestore_assert.hpp"
 #include "common/homestore_config.hpp"
@@ -611,27 +614,26 @@ TEST_F(FixedBlkAllocatorTest, alloc_free_fixed_size) {
     LOGINFO("Step 4: Validate if further allocation result in space full error");
     ASSERT_TRUE(alloc_blk(BlkAllocStatus::SPACE_FULL, bid, false));
 
-    LOGINFO("Step 5: Free up {} blocks ({} previously reserved and 2 new) and make sure 2 more alloc is successful and "
-            "do FIFO allocation",
+    LOGINFO("Step 5: Free up {} blocks ({} previously reserved and 2 new) and make sure exactly those blocks are "
+            "allocated again",
             nthreads + 2, nthreads);
 
+    std::set< blk_num_t > freed_blks;
     for (blk_num_t i = 0; i < nthreads; ++i) {
         ASSERT_TRUE(free_blk(reserved_blkids[i].blk_num()));
+        freed_blks.insert(reserved_blkids[i].blk_num());
     }
-    BlkId const free_bid1 = free_random_alloced_blk(false);
-    BlkId const free_bid2 = free_random_alloced_blk(false);
-
-    for (blk_num_t i = 0; i < nthreads; ++i) {
-        BlkId bid;
-        ASSERT_TRUE(alloc_blk(BlkAllocStatus::SUCCESS, bid, false));
-        ASSERT_EQ(BlkId::compare(bid, reserved_blkids[i]), 0) << "Order of block allocation not expected";
+    freed_blks.insert(free_random_alloced_blk(false).blk_num());
+    freed_blks.insert(free_random_alloced_blk(false).blk_num());
+
+    std::set< blk_num_t > realloced_blks;
+    for (blk_num_t i = 0; i < nthreads + 2; ++i) {
+        BlkId realloced_bid;
+        ASSERT_TRUE(alloc_blk(BlkAllocStatus::SUCCESS, realloced_bid, false));
+        realloced_blks.insert(realloced_bid.blk_num());
     }
-
-    BlkId bid1, bid2;
-    ASSERT_TRUE(alloc_blk(BlkAllocStatus::SUCCESS, bid1, false));
-    ASSERT_TRUE(alloc_blk(BlkAllocStatus::SUCCESS, bid2, false));
-    ASSERT_EQ(BlkId::compare(bid1, free_bid1), 0) << "Order of block allocation not expected";
-    ASSERT_EQ(BlkId::compare(bid2, free_bid2), 0) << "Order of block allocation not expected";
+    ASSERT_EQ(freed_blks, realloced_blks) << "Blocks allocated are not the ones freed";
+    ASSERT_TRUE(alloc_blk(BlkAllocStatus::SPACE_FULL, bid, false));
     validate_count();
 }
 
@@ -687,6 +689,25 @@ TEST_F(VarsizeBlkAllocatorTest, alloc_free_var_contiguous_unirandsize_without_sl
     alloc_free_var_contiguous_unirandsize(this, m_total_count);
 }
 
+TEST_F(VarsizeBlkAllocatorTest, alloc_from_other_arenas_without_slabs) {
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.blkallocator.num_alloc_arenas = 4; });
+    HS_SETTINGS_FACTORY().save();
+    create_allocator(false);
+
+    static constexpr blk_count_t nblks_per_alloc{256};
+    LOGINFO("Step 1: Allocate all {} blks from a single thread, which needs to steal from other arenas", m_total_count);
+    for (uint64_t i{0}; i < m_total_count / nblks_per_alloc; ++i) {
+        ASSERT_TRUE(alloc_rand_blk(BlkAllocStatus::SUCCESS, true /* is_contiguous */, nblks_per_alloc, false));
+    }
+    ASSERT_EQ(m_allocator->available_blks(), 0) << "Expected all arenas to be fully allocated";
+
+    LOGINFO("Step 2: Validate if further allocation fails");
+    ASSERT_TRUE(alloc_rand_blk(BlkAllocStatus::FAILED, true /* is_contiguous */, 1, false));
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.blkallocator.num_alloc_arenas = 0; });
+    HS_SETTINGS_FACTORY().save();
+}
+
 namespace {
 void alloc_free_var_contiguous_roundrandsize(VarsizeBlkAllocatorTest* const block_test_pointer) {
     const auto nthreads{
@@ -885,6 +906,107 @@ TEST_F(VarsizeBlkAllocatorTest, alloc_var_scatter_direct_unirandsize_without_sla
     alloc_var_scatter_direct_unirandsize(this);
 }
 #endif
+
+namespace {
+// Bitmap with all blks allocated except for nruns free runs of 1-64 blks at random positions
+std::unique_ptr< BlkBitmap > fragmented_bitmap(blk_num_t nbits, blk_num_t nruns) {
+    auto bm = std::make_unique< BlkBitmap >(nbits);
+    bm->set_bits(0, nbits);
+    std::uniform_int_distribution< blk_num_t > pos_gen{0, nbits - 1};
+    std::uniform_int_distribution< blk_num_t > len_gen{1, 64};
+    for (blk_num_t i{0}; i < nruns; ++i) {
+        auto const pos = pos_gen(g_re);
+        bm->reset_bits(pos, std::min(len_gen(g_re), nbits - pos));
+    }
+    return bm;
+}
+
+struct sweep_result {
+    uint64_t nruns{0};
+    uint64_t nblks{0};
+    uint64_t elapsed_us{0};
+};
+
+// Walk all the free runs of the bitmap the same way allocator sweeps a portion
+sweep_result sweep_bitmap(BlkBitmap const& bm) {
+    sweep_result res;
+    auto const start_time = std::chrono::steady_clock::now();
+    blk_num_t cur{0};
+    while (cur < bm.nbits()) {
+        auto const b = bm.get_next_contiguous_n_reset_bits(cur, bm.nbits() - 1, 1, bm.nbits() - cur);
+        if (b.nbits == 0) { break; }
+        ++res.nruns;
+        res.nblks += b.nbits;
+        cur = b.start_bit + b.nbits;
+    }
+    res.elapsed_us =
+        std::chrono::duration_cast< std::chrono::microseconds >(std::chrono::steady_clock::now() - start_time).count();
+    return res;
+}
+} // namespace
+
+TEST(BlkBitmapTest, contiguous_reset_bits_matches_bitset) {
+    static constexpr blk_num_t nbits{1000000 + 37};
+    auto const bm = fragmented_bitmap(nbits, nbits / 256);
+
+    sisl::Bitset ref{nbits};
+    ref.set_bits(0, nbits);
+    for (blk_num_t i{0}; i < nbits; ++i) {
+        if (bm->is_bits_reset(i, 1)) { ref.reset_bits(i, 1); }
+    }
+    ASSERT_EQ(bm->get_set_count(), ref.get_set_count()) << "Set count mismatch " << bm->to_string();
+
+    auto const detected_isa = BlkBitmap::detect_isa();
+    for (auto const isa : {bitmap_search_isa_t::SCALAR, bitmap_search_isa_t::AVX2}) {
+        LOGINFO("Validating run search with isa={}", enum_name(BlkBitmap::set_isa(isa)));
+        for (auto const [min_nbits, max_nbits] :
+             std::vector< std::pair< blk_num_t, blk_num_t > >{{1, 1}, {1, 16}, {8, 8}, {16, 64}, {33, 128}, {1, nbits}}) {
+            blk_num_t cur{0};
+            while (cur < nbits) {
+                auto const b = bm->get_next_contiguous_n_reset_bits(cur, nbits - 1, min_nbits, max_nbits);
+                auto const r = ref.get_next_contiguous_n_reset_bits(cur, nbits - 1, min_nbits, max_nbits);
+                ASSERT_EQ(b.nbits, r.nbits) << "Run size mismatch from bit=" << cur << " min=" << min_nbits
+                                            << " max=" << max_nbits;
+                if (b.nbits == 0) { break; }
+                ASSERT_EQ(b.start_bit, r.start_bit) << "Run start mismatch from bit=" << cur << " min=" << min_nbits
+                                                    << " max=" << max_nbits;
+                cur = b.start_bit + b.nbits;
+            }
+        }
+    }
+    BlkBitmap::set_isa(detected_isa);
+}
+
+// Benchmark sizes the bitmap for a 1TB device by default, so it is run only on demand with
+// --gtest_also_run_disabled_tests --gtest_filter=*fragmented_sweep_benchmark [--bitmap_bench_size_gb=<size>]
+TEST(BlkBitmapTest, DISABLED_fragmented_sweep_benchmark) {
+    auto const size_gb = SISL_OPTIONS["bitmap_bench_size_gb"].as< uint64_t >();
+    auto const nbits = blk_num_t(std::min< uint64_t >((size_gb * 1024 * 1024 * 1024) / 4096,
+                                                      std::numeric_limits< blk_num_t >::max() - 63));
+    // Roughly one free run in every 8 words, which is what an aged chunk looks like after random frees
+    auto const bm = fragmented_bitmap(nbits, nbits / 512);
+    auto const expected_free = uint64_t{nbits} - bm->get_set_count();
+
+    auto const detected_isa = BlkBitmap::detect_isa();
+    std::vector< sweep_result > results;
+    for (auto const isa : {bitmap_search_isa_t::SCALAR, bitmap_search_isa_t::AVX2}) {
+        auto const actual_isa = BlkBitmap::set_isa(isa);
+        if (actual_isa != isa) {
+            LOGINFO("Skipping sweep with isa={}, not supported by cpu", enum_name(isa));
+            continue;
+        }
+        auto const res = sweep_bitmap(*bm);
+        LOGINFO("Sweep of {} GB (4K blks) bitmap isa={} free_runs={} free_blks={} time={} ms", size_gb,
+                enum_name(isa), res.nruns, res.nblks, res.elapsed_us / 1000.0);
+        ASSERT_EQ(res.nblks, expected_free) << "Sweep did not find all free blks with isa=" << enum_name(isa);
+        results.push_back(res);
+    }
+    BlkBitmap::set_isa(detected_isa);
+
+    for (auto const& res : results) {
+        ASSERT_EQ(res.nruns, results[0].nruns) << "Different isa found different number of free runs";
+    }
+}
 template < typename T >
 std::shared_ptr< cxxopts::Value > opt_default(const char* val) {
     return ::cxxopts::value< T >()->default_value(val);
@@ -896,7 +1018,10 @@ SISL_OPTIONS_ENABLE(ENABLED_OPTIONS)
 SISL_OPTION_GROUP(test_blkalloc,
                   (num_blks, "", "num_blks", "number of blks", opt_default< uint32_t >("1000000"), "number"),
                   (iters, "", "iters", "number of iterations", opt_default< uint64_t >("100000"), "number"),
-                  (num_threads, "", "num_threads", "num_threads", opt_default< uint32_t >("8"), "number"))
+                  (num_threads, "", "num_threads", "num_threads", opt_default< uint32_t >("8"), "number"),
+                  (bitmap_bench_size_gb, "", "bitmap_bench_size_gb",
+                   "size (in GB of 4K blks) of the fragmented bitmap swept by the benchmark",
+                   opt_default< uint64_t >("1024"), "number"))
 
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
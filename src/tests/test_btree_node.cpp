@@ -433,6 +433,25 @@ TYPED_TEST(NodeTest, RandomInsertRemoveUpdate) {
     this->validate_get_all();
 }
 
+TYPED_TEST(NodeTest, SearchAcrossIsa) {
+    uint32_t num_inserted{0};
+    while (this->has_room()) {
+        this->put(g_randkey_generator(g_re), btree_put_type::INSERT);
+        ++num_inserted;
+    }
+    LOGDEBUG("Inserted {} random objects to validate search", num_inserted);
+
+    auto const detected_isa = node_search::detect_isa();
+    for (auto const isa : {node_search_isa_t::SCALAR, node_search_isa_t::SSE42, node_search_isa_t::AVX2}) {
+        LOGDEBUG("Validating search with isa={}", enum_name(node_search::set_isa(isa)));
+        for (uint32_t k{0}; k < g_max_keys; ++k) {
+            this->validate_specific(k);
+        }
+        this->validate_get_all();
+    }
+    node_search::set_isa(detected_isa);
+}
+
 TYPED_TEST(NodeTest, Move) {
     std::vector< uint32_t > list{0, 1, 2, g_max_keys / 2 - 1};
     this->put_list(list);
@@ -13,6 +13,8 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
+#include <cstring>
 #include <vector>
 #include <iostream>
 #include <filesystem>
@@ -39,6 +41,7 @@
 #include "common/homestore_config.hpp"
 #include "common/homestore_assert.hpp"
 #include "blkalloc/blk_allocator.h"
+#include "blkdata_svc/blk_read_cache.hpp"
 #include "test_common/bits_generator.hpp"
 #include "test_common/homestore_test_common.hpp"
 
@@ -241,6 +244,123 @@ public:
             });
     }
 
+    // read twice (second one is expected to be served from read cache), then free_blk which should drop it from cache
+    void write_read_cached_free_blk(const uint64_t io_size) {
+        auto sg_write_ptr = std::make_shared< sisl::sg_list >();
+        auto sg_read_ptr = std::make_shared< sisl::sg_list >();
+        auto test_blkid_ptr = std::make_shared< MultiBlkId >();
+        auto cache = inst().read_cache();
+        RELEASE_ASSERT(cache != nullptr, "Read cache is expected to be enabled");
+
+        auto read_blks = [this, sg_read_ptr, test_blkid_ptr]() {
+            free(*sg_read_ptr);
+            sg_read_ptr->iovs.clear();
+            struct iovec iov;
+            iov.iov_len = test_blkid_ptr->blk_count() * inst().get_blk_size();
+            iov.iov_base = iomanager.iobuf_alloc(512, iov.iov_len);
+            sg_read_ptr->iovs.push_back(iov);
+            sg_read_ptr->size = iov.iov_len;
+            return inst().async_read(*test_blkid_ptr, *sg_read_ptr, sg_read_ptr->size);
+        };
+
+        write_sgs(io_size, sg_write_ptr, 1 /* num_iovs */, *test_blkid_ptr)
+            .thenValue([read_blks](auto&& err) {
+                RELEASE_ASSERT(!err, "Write error");
+                return read_blks();
+            })
+            .thenValue([sg_write_ptr, sg_read_ptr, test_blkid_ptr, cache, read_blks](auto&& err) {
+                RELEASE_ASSERT(!err, "Read error");
+                RELEASE_ASSERT(test_common::HSTestHelper::compare(*sg_read_ptr, *sg_write_ptr),
+                               "Read after write data mismatch");
+                RELEASE_ASSERT_EQ(cache->cached_blks(), test_blkid_ptr->blk_count(), "Read blks are not cached");
+                return read_blks();
+            })
+            .thenValue([this, sg_write_ptr, sg_read_ptr, test_blkid_ptr](auto&& err) {
+                RELEASE_ASSERT(!err, "Cached read error");
+                RELEASE_ASSERT(test_common::HSTestHelper::compare(*sg_read_ptr, *sg_write_ptr),
+                               "Cached read data mismatch");
+                free(*sg_write_ptr);
+                free(*sg_read_ptr);
+                return inst().async_free_blk(*test_blkid_ptr);
+            })
+            .thenValue([this, cache](auto&& err) {
+                RELEASE_ASSERT(!err, "free_blk error");
+                RELEASE_ASSERT_EQ(cache->cached_blks(), 0, "Freed blks are still cached");
+                this->finish_and_notify();
+            });
+    }
+
+    // write with checksums, read verifying them, overwrite the same blks with checksums and read verifying them, then
+    // read again with one of the checksums altered which should fail. If io_size is not a multiple of blk size, last
+    // blk is expected to be written padded with zeros.
+    void write_read_verify_checksums(const uint64_t io_size) {
+        auto sg_write_ptr = std::make_shared< sisl::sg_list >();
+        auto sg_read_ptr = std::make_shared< sisl::sg_list >();
+        auto test_blkid_ptr = std::make_shared< MultiBlkId >();
+        auto csums_ptr = std::make_shared< blk_checksums_t >();
+
+        struct iovec iov;
+        iov.iov_len = io_size;
+        iov.iov_base = iomanager.iobuf_alloc(512, iov.iov_len);
+        test_common::HSTestHelper::fill_data_buf(r_cast< uint8_t* >(iov.iov_base), iov.iov_len);
+        sg_write_ptr->iovs.push_back(iov);
+        sg_write_ptr->size = io_size;
+
+        // Checksum verification needs the whole blks to be read
+        iov.iov_len = sisl::round_up(io_size, inst().get_blk_size());
+        iov.iov_base = iomanager.iobuf_alloc(512, iov.iov_len);
+        sg_read_ptr->iovs.push_back(iov);
+        sg_read_ptr->size = iov.iov_len;
+
+        auto fut = inst().async_alloc_write(*sg_write_ptr, blk_alloc_hints{}, *test_blkid_ptr, *csums_ptr);
+        inst().commit_blk(*test_blkid_ptr);
+        std::move(fut)
+            .thenValue([this, sg_read_ptr, test_blkid_ptr, csums_ptr](auto&& err) {
+                RELEASE_ASSERT(!err, "Write error");
+                RELEASE_ASSERT_EQ(csums_ptr->size(), test_blkid_ptr->blk_count(), "Expected checksum per blk");
+                return inst().async_read(*test_blkid_ptr, *sg_read_ptr, sg_read_ptr->size, *csums_ptr);
+            })
+            .thenValue([this, sg_write_ptr, sg_read_ptr, test_blkid_ptr, csums_ptr](auto&& err) {
+                RELEASE_ASSERT(!err, "Read with checksum verification failed");
+                verify_padded_read(*sg_write_ptr, *sg_read_ptr);
+
+                test_common::HSTestHelper::fill_data_buf(r_cast< uint8_t* >(sg_write_ptr->iovs[0].iov_base),
+                                                         sg_write_ptr->size, 0xdeadbeef);
+                return inst().async_write(*sg_write_ptr, *test_blkid_ptr, *csums_ptr);
+            })
+            .thenValue([this, sg_read_ptr, test_blkid_ptr, csums_ptr](auto&& err) {
+                RELEASE_ASSERT(!err, "Overwrite error");
+                RELEASE_ASSERT_EQ(csums_ptr->size(), test_blkid_ptr->blk_count(), "Expected checksum per blk");
+                return inst().async_read(*test_blkid_ptr, *sg_read_ptr, sg_read_ptr->size, *csums_ptr);
+            })
+            .thenValue([this, sg_write_ptr, sg_read_ptr, test_blkid_ptr, csums_ptr](auto&& err) {
+                RELEASE_ASSERT(!err, "Read of overwritten blks with checksum verification failed");
+                verify_padded_read(*sg_write_ptr, *sg_read_ptr);
+                csums_ptr->back() = ~csums_ptr->back();
+                return inst().async_read(*test_blkid_ptr, *sg_read_ptr, sg_read_ptr->size, *csums_ptr);
+            })
+            .thenValue([this, sg_write_ptr, sg_read_ptr, test_blkid_ptr](auto&& err) {
+                RELEASE_ASSERT(err == std::make_error_code(std::errc::bad_message),
+                               "Read is expected to fail with checksum mismatch");
+                free(*sg_write_ptr);
+                free(*sg_read_ptr);
+                return inst().async_free_blk(*test_blkid_ptr);
+            })
+            .thenValue([this](auto&& err) {
+                RELEASE_ASSERT(!err, "free_blk error");
+                this->finish_and_notify();
+            });
+    }
+
+    // Data read is expected to be what is written, followed by zeros upto the end of the last blk
+    static void verify_padded_read(sisl::sg_list const& written, sisl::sg_list const& read) {
+        auto const* wbuf = r_cast< uint8_t const* >(written.iovs[0].iov_base);
+        auto const* rbuf = r_cast< uint8_t const* >(read.iovs[0].iov_base);
+        RELEASE_ASSERT_EQ(std::memcmp(rbuf, wbuf, written.size), 0, "Read after write data mismatch");
+        RELEASE_ASSERT(std::all_of(rbuf + written.size, rbuf + read.size, [](uint8_t b) { return b == 0; }),
+                       "Tail of the last blk is expected to be read as zeros");
+    }
+
     void write_and_restart_with_missing_data_drive(const uint64_t io_size) {
         vdev_info vinfo;
         auto data_vdev = inst().open_vdev(vinfo, true);
@@ -925,6 +1045,49 @@ TEST_F(BlkDataServiceTest, TestWriteReadThenFreeBeforeReadComp) {
     LOGINFO("Step 5: I/O completed, do shutdown.");
 }
 
+TEST_F(BlkDataServiceTest, TestReadCacheHitThenFreeBlk) {
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.cache.data_read_cache_percent = 10; });
+    HS_SETTINGS_FACTORY().save();
+    m_helper.restart_homestore();
+
+    auto io_size = 64 * Ki;
+    LOGINFO("Step 1: Run on worker thread to schedule write for {} Bytes, read twice and free.", io_size);
+    iomanager.run_on_forget(iomgr::reactor_regex::random_worker,
+                            [this, io_size]() { this->write_read_cached_free_blk(io_size); });
+
+    LOGINFO("Step 2: Wait for I/O to complete.");
+    wait_for_all_io_complete();
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.cache.data_read_cache_percent = 0; });
+    HS_SETTINGS_FACTORY().save();
+    LOGINFO("Step 3: I/O completed, do shutdown.");
+}
+
+TEST_F(BlkDataServiceTest, TestWriteReadWithChecksums) {
+    auto io_size = 64 * Ki;
+    LOGINFO("Step 1: Run on worker thread to schedule write with checksums for {} Bytes and read verify.", io_size);
+    iomanager.run_on_forget(iomgr::reactor_regex::random_worker,
+                            [this, io_size]() { this->write_read_verify_checksums(io_size); });
+
+    LOGINFO("Step 2: Wait for I/O to complete.");
+    wait_for_all_io_complete();
+
+    LOGINFO("Step 3: I/O completed, do shutdown.");
+}
+
+TEST_F(BlkDataServiceTest, TestWriteReadWithChecksumsPartialBlk) {
+    // Size which ends within the last blk, which is written and checksummed padded with zeros
+    auto io_size = 64 * Ki + 512;
+    LOGINFO("Step 1: Run on worker thread to schedule write with checksums for {} Bytes and read verify.", io_size);
+    iomanager.run_on_forget(iomgr::reactor_regex::random_worker,
+                            [this, io_size]() { this->write_read_verify_checksums(io_size); });
+
+    LOGINFO("Step 2: Wait for I/O to complete.");
+    wait_for_all_io_complete();
+
+    LOGINFO("Step 3: I/O completed, do shutdown.");
+}
+
 /**
  * @brief Tests the random read-write-free load functionality of the BlkDataService.
  *  Random write, read-verify, free blks;
@@ -13,22 +13,28 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <random>
+#include <set>
 
 #include <gtest/gtest.h>
 #include <iomgr/io_environment.hpp>
 #include <sisl/logging/logging.h>
 #include <sisl/options/options.h>
 
+#include "common/homestore_utils.hpp"
+#include "blkalloc/blk_allocator.h"
 #include "device/chunk.h"
+#include "device/most_available_space_chunk_selector.h"
 
 #include "device/device.h"
 #include "device/physical_dev.hpp"
@@ -74,7 +80,9 @@ public:
             m_dev_infos, [this](const homestore::vdev_info& vinfo, bool load_existing) {
                 vdev_info vinfo_tmp = vinfo;
                 vinfo_tmp.alloc_type = s_cast< uint8_t >(homestore::blk_allocator_type_t::fixed);
-                vinfo_tmp.chunk_sel_type = s_cast< uint8_t >(homestore::chunk_selector_type_t::ROUND_ROBIN);
+                if (vinfo_tmp.chunk_sel_type == s_cast< uint8_t >(homestore::chunk_selector_type_t::NONE)) {
+                    vinfo_tmp.chunk_sel_type = s_cast< uint8_t >(homestore::chunk_selector_type_t::ROUND_ROBIN);
+                }
 
                 return std::make_shared< homestore::VirtualDev >(*m_dmgr, vinfo_tmp, nullptr /* event_cb */, false);
             });
@@ -139,6 +147,104 @@ public:
             }
         }
     }
+
+    void validate_mirrored_vdev(cshared< VirtualDev >& vdev) {
+        ASSERT_EQ(vdev->is_mirrored(), true) << "Expected vdev to be mirrored";
+        ASSERT_EQ(vdev->num_mirrors(), m_pdevs.size()) << "Expected vdev to be mirrored on all pdevs";
+
+        auto const primary_chunks = vdev->get_chunks();
+        ASSERT_GT(primary_chunks.size(), 0) << "Expected vdev to have primary chunks";
+        std::map< const PhysicalDev*, uint32_t > chunks_in_pdev_count;
+        for (const auto& [chunk_id, chunk] : primary_chunks) {
+            ASSERT_EQ(chunk->primary_chunk_id(), chunk_id) << "Chunk in vdev is expected to be a primary";
+
+            auto const mirrors = vdev->get_mirror_chunks(chunk_id);
+            ASSERT_EQ(mirrors.size(), m_pdevs.size()) << "Every primary chunk should have a replica on each pdev";
+            std::set< const PhysicalDev* > mirror_pdevs;
+            for (const auto& m : mirrors) {
+                ASSERT_EQ(m->size(), chunk->size()) << "Replicas are not equally sized";
+                ASSERT_EQ(m->pdev_ordinal(), chunk->pdev_ordinal()) << "Replicas should have same ordinal in pdev";
+                mirror_pdevs.insert(m->physical_dev());
+                ++chunks_in_pdev_count[m->physical_dev()];
+            }
+            ASSERT_EQ(mirror_pdevs.size(), m_pdevs.size()) << "Replicas of a chunk should be on distinct pdevs";
+        }
+
+        for (const auto& [pdev, count] : chunks_in_pdev_count) {
+            ASSERT_EQ(count, primary_chunks.size()) << "Every pdev should have a replica of every chunk";
+        }
+    }
+
+    // Write (if asked) a distinct pattern on one blk of every chunk and validate that it can be read back through vdev
+    // as well as directly from every replica
+    void validate_mirrored_io(cshared< VirtualDev >& vdev, bool do_write) {
+        auto const blk_size = vdev->block_size();
+        auto buf = hs_utils::iobuf_alloc(blk_size, sisl::buftag::common, vdev->align_size());
+
+        for (const auto& [chunk_id, chunk] : vdev->get_chunks()) {
+            BlkId const bid{1u /* blk_num */, 1u /* nblks */, chunk_id};
+            auto const pattern = uint8_t(chunk_id + 1);
+            if (do_write) {
+                std::memset(buf, pattern, blk_size);
+                ASSERT_EQ(vdev->sync_write(r_cast< const char* >(buf), blk_size, bid), std::error_code{})
+                    << "Mirrored write failed";
+            }
+
+            // Read it multiple times, so that reads are balanced across all the replicas
+            for (uint32_t i{0}; i < 2 * m_pdevs.size(); ++i) {
+                std::memset(buf, 0, blk_size);
+                ASSERT_EQ(vdev->sync_read(r_cast< char* >(buf), blk_size, bid), std::error_code{})
+                    << "Mirrored read failed";
+                ASSERT_EQ(buf[0], pattern) << "Data mismatch reading through vdev";
+                ASSERT_EQ(buf[blk_size - 1], pattern) << "Data mismatch reading through vdev";
+            }
+
+            for (const auto& m : vdev->get_mirror_chunks(chunk_id)) {
+                std::memset(buf, 0, blk_size);
+                ASSERT_EQ(m->physical_dev_mutable()->sync_read(r_cast< char* >(buf), blk_size,
+                                                               m->start_offset() + blk_size),
+                          std::error_code{});
+                ASSERT_EQ(buf[0], pattern) << "Replica on pdev=" << m->physical_dev()->pdev_id() << " has stale data";
+                ASSERT_EQ(buf[blk_size - 1], pattern)
+                    << "Replica on pdev=" << m->physical_dev()->pdev_id() << " has stale data";
+            }
+        }
+        hs_utils::iobuf_free(buf, sisl::buftag::common);
+    }
+
+    // Make one replica of every chunk stale by wiping the blk written by validate_mirrored_io and marking it, then
+    // validate that reads never see the wiped data and resync brings the replica back in sync
+    void validate_stale_mirror_resync(cshared< VirtualDev >& vdev) {
+        auto const blk_size = vdev->block_size();
+        auto buf = hs_utils::iobuf_alloc(blk_size, sisl::buftag::common, vdev->align_size());
+
+        std::vector< shared< Chunk > > stale_chunks;
+        for (const auto& [chunk_id, chunk] : vdev->get_chunks()) {
+            auto const mirrors = vdev->get_mirror_chunks(chunk_id);
+            auto const& stale = mirrors[chunk_id % mirrors.size()];
+            std::memset(buf, 0, blk_size);
+            ASSERT_EQ(stale->physical_dev_mutable()->sync_write(r_cast< const char* >(buf), blk_size,
+                                                                stale->start_offset() + blk_size),
+                      std::error_code{});
+            ASSERT_TRUE(stale->mark_mirror_stale()) << "Replica is not expected to be stale already";
+            stale_chunks.push_back(stale);
+
+            BlkId const bid{1u /* blk_num */, 1u /* nblks */, chunk_id};
+            for (uint32_t i{0}; i < 2 * m_pdevs.size(); ++i) {
+                ASSERT_EQ(vdev->sync_read(r_cast< char* >(buf), blk_size, bid), std::error_code{});
+                ASSERT_EQ(buf[0], uint8_t(chunk_id + 1)) << "Read is served by the stale replica";
+            }
+        }
+
+        vdev->resync_stale_mirrors();
+        for (const auto& stale : stale_chunks) {
+            ASSERT_FALSE(stale->is_mirror_stale()) << "Replica is expected to be resynced";
+        }
+        hs_utils::iobuf_free(buf, sisl::buftag::common);
+
+        // Resynced replicas have to have the data as well
+        validate_mirrored_io(vdev, false /* do_write */);
+    }
 };
 
 TEST_F(DeviceMgrTest, StripedVDevCreation) {
@@ -204,6 +310,95 @@ TEST_F(DeviceMgrTest, SmallStripedVDevCreation) {
     ASSERT_EQ(vdev->get_chunks().size(), m_pdevs.size()) << "Expected vdev to be created with 1 chunk per pdev";
 }
 
+TEST_F(DeviceMgrTest, MirroredVDevCreation) {
+    uint64_t avail_size{0};
+    for (auto& pdev : m_pdevs) {
+        avail_size += pdev->data_size();
+    }
+
+    LOGINFO("Step 1: Creating mirrored vdev with size={} across {} pdevs", in_bytes(avail_size / 4), m_pdevs.size());
+    auto vdev =
+        m_dmgr->create_vdev(homestore::vdev_parameters{.vdev_name = "test_mirrored_vdev",
+                                                       .vdev_size = avail_size / 4,
+                                                       .num_chunks = 2,
+                                                       .blk_size = 4096,
+                                                       .dev_type = HSDevType::Data,
+                                                       .alloc_type = blk_allocator_type_t::fixed,
+                                                       .chunk_sel_type = chunk_selector_type_t::ROUND_ROBIN,
+                                                       .multi_pdev_opts = vdev_multi_pdev_opts_t::ALL_PDEV_MIRRORED,
+                                                       .context_data = sisl::blob{}});
+
+    LOGINFO("Step 2: Validate every chunk is replicated on all pdevs");
+    this->validate_mirrored_vdev(vdev);
+
+    LOGINFO("Step 3: Write through mirrored vdev and validate data on all replicas");
+    this->validate_mirrored_io(vdev, true /* do_write */);
+
+    LOGINFO("Step 3a: Validate stale replicas are skipped by reads and are resynced");
+    this->validate_stale_mirror_resync(vdev);
+
+    LOGINFO("Step 4: Restarting homestore");
+    vdev.reset();
+    this->restart();
+
+    LOGINFO("Step 5: Post restart validate replicas are loaded and have the data written before restart");
+    ASSERT_EQ(m_vdevs.size(), 1) << "Expected mirrored vdev to be loaded";
+    this->validate_mirrored_vdev(m_vdevs[0]);
+    this->validate_mirrored_io(m_vdevs[0], false /* do_write */);
+}
+
+TEST_F(DeviceMgrTest, MostAvailableSpaceChunkSelection) {
+    uint64_t avail_size{0};
+    for (auto& pdev : m_pdevs) {
+        avail_size += pdev->data_size();
+    }
+
+    uint32_t const num_chunks = 2 * m_pdevs.size();
+    LOGINFO("Step 1: Creating vdev with {} chunks selected by most available space", num_chunks);
+    auto vdev =
+        m_dmgr->create_vdev(homestore::vdev_parameters{.vdev_name = "test_space_aware_vdev",
+                                                       .vdev_size = avail_size / 8,
+                                                       .num_chunks = num_chunks,
+                                                       .blk_size = 4096,
+                                                       .dev_type = HSDevType::Data,
+                                                       .alloc_type = blk_allocator_type_t::fixed,
+                                                       .chunk_sel_type = chunk_selector_type_t::MOST_AVAILABLE_SPACE,
+                                                       .multi_pdev_opts = vdev_multi_pdev_opts_t::ALL_PDEV_STRIPED,
+                                                       .context_data = sisl::blob{}});
+    auto const chunks = vdev->get_chunks();
+    ASSERT_GT(chunks.size(), 1) << "Expected vdev to have multiple chunks";
+
+    LOGINFO("Step 2: Fill up one of the chunks completely by allocating on it explicitly");
+    auto const full_chunk_id = chunks.begin()->first;
+    auto const chunk_blks = chunks.begin()->second->blk_allocator()->get_total_blks();
+    blk_alloc_hints hints;
+    hints.chunk_id_hint = full_chunk_id;
+    for (blk_num_t i{0}; i < chunk_blks; ++i) {
+        MultiBlkId bid;
+        ASSERT_EQ(vdev->alloc_blks(1, hints, bid), BlkAllocStatus::SUCCESS) << "Alloc on chunk with free blks failed";
+    }
+    ASSERT_EQ(chunks.begin()->second->blk_allocator()->available_blks(), 0) << "Expected chunk to be full";
+
+    LOGINFO("Step 3: Allocate without hint and validate they are spread evenly on chunks other than the full one");
+    uint32_t const num_allocs = 500 * (chunks.size() - 1);
+    std::map< uint16_t, uint32_t > allocs_per_chunk;
+    std::map< const PhysicalDev*, uint32_t > allocs_per_pdev;
+    for (uint32_t i{0}; i < num_allocs; ++i) {
+        MultiBlkId bid;
+        ASSERT_EQ(vdev->alloc_blks(1, blk_alloc_hints{}, bid), BlkAllocStatus::SUCCESS) << "Alloc failed";
+        ASSERT_NE(bid.chunk_num(), full_chunk_id) << "Full chunk was selected for allocation";
+        ++allocs_per_chunk[bid.chunk_num()];
+        ++allocs_per_pdev[chunks.at(bid.chunk_num())->physical_dev()];
+    }
+
+    ASSERT_EQ(allocs_per_chunk.size(), chunks.size() - 1) << "Every chunk with space should be allocated from";
+    ASSERT_EQ(allocs_per_pdev.size(), m_pdevs.size()) << "Every pdev should have received allocations";
+    auto const [min_it, max_it] = std::minmax_element(allocs_per_chunk.begin(), allocs_per_chunk.end(),
+                                                      [](auto const& a, auto const& b) { return a.second < b.second; });
+    ASSERT_LE(max_it->second - min_it->second, chunk_blks / (MostAvailableSpaceChunkSelector::num_buckets - 1) + 1)
+        << "Allocations are skewed across chunks beyond the free space granularity of the selector";
+}
+
 TEST_F(DeviceMgrTest, CreateChunk) {
     // Create dynamically chunks and verify no two chunks ahve same start offset.
     uint64_t avail_size{0};
@@ -192,6 +192,75 @@ TYPED_TEST(BtreeTest, RandomInsert) {
     this->get_all();
 }
 
+TYPED_TEST(BtreeTest, BatchPutRemove) {
+    LOGINFO("BatchPutRemove test start");
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    LOGINFO("Step 1: Batch insert every alternate key of {} entries", num_entries);
+    this->batch_put(0, num_entries - 1, 2 /* stride */);
+    this->get_all();
+
+    LOGINFO("Step 2: Batch insert all keys, which should insert only the missing ones");
+    this->batch_put(0, num_entries - 1);
+    this->query_all();
+
+    LOGINFO("Step 3: Batch remove every 3rd key and validate");
+    this->batch_remove(0, num_entries - 1, 3 /* stride */);
+    this->get_all();
+    this->query_all_paginate(80);
+
+    LOGINFO("Step 4: Batch remove all keys and validate");
+    this->batch_remove(0, num_entries - 1);
+    this->query_all();
+
+    LOGINFO("Step 5: Batch put and remove of keys out of order are rejected");
+    this->batch_put_unsorted(0, std::min(num_entries - 1, 100u));
+    this->query_all();
+    LOGINFO("BatchPutRemove test end");
+}
+
+TYPED_TEST(BtreeTest, BulkLoad) {
+    LOGINFO("BulkLoad test start");
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    LOGINFO("Step 1: Bulk load every alternate key of {} entries", num_entries);
+    this->bulk_load(0, num_entries - 1, 2 /* stride */);
+    this->get_all();
+    this->query_all_paginate(80);
+
+    LOGINFO("Step 2: Insert the missing keys on top of the loaded btree and remove some");
+    for (uint32_t i{1}; i < num_entries; i += 2) {
+        this->put(i, btree_put_type::INSERT);
+    }
+    for (uint32_t i{0}; i < num_entries; i += 10) {
+        this->remove_one(i);
+    }
+    this->query_all();
+
+    LOGINFO("Step 3: Trigger cp flush and validate after restart");
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+    this->restart_homestore();
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    this->query_all();
+    LOGINFO("BulkLoad test end");
+}
+
+TYPED_TEST(BtreeTest, BulkLoadMultiLevel) {
+    LOGINFO("BulkLoadMultiLevel test start");
+    // Enough keys to need interior nodes above the leaves' parents, so that loaded parents link to loaded parents
+    uint32_t const num_entries = 200000;
+    LOGINFO("Step 1: Bulk load {} entries", num_entries);
+    this->bulk_load(0, num_entries - 1);
+    ASSERT_GE(this->m_bt->depth(), 3u) << "Bulk load was expected to build at least 3 levels";
+    this->do_query(0, num_entries - 1, 1000);
+
+    LOGINFO("Step 2: Trigger cp flush and validate after restart");
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+    this->restart_homestore();
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    ASSERT_GE(this->m_bt->depth(), 3u) << "Btree depth is not retained after restart";
+    this->do_query(0, num_entries - 1, 1000);
+    LOGINFO("BulkLoadMultiLevel test end");
+}
+
 TYPED_TEST(BtreeTest, SequentialRemove) {
     LOGINFO("SequentialRemove test start");
     // Forward sequential insert
@@ -298,6 +367,10 @@ TYPED_TEST(BtreeTest, CpFlush) {
     std::this_thread::sleep_for(std::chrono::seconds{1});
     LOGINFO("Restarted homestore with index recovered");
 
+    // Nodes are not yet in cache after restart, so this query reads the leaves through read ahead
+    LOGINFO("Query {} entries with read ahead of 8 nodes", num_entries);
+    this->do_query(0, num_entries - 1, 1000, 8 /* read_ahead_depth */);
+
     this->dump_to_file(std::string("after.txt"));
 
     LOGINFO("Query {} entries", num_entries);
@@ -307,6 +380,79 @@ TYPED_TEST(BtreeTest, CpFlush) {
     LOGINFO("CpFlush test end");
 }
 
+TYPED_TEST(BtreeTest, CompressedCpFlush) {
+    LOGINFO("CompressedCpFlush test start");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.btree.compress_index_nodes = true;
+        HS_SETTINGS_FACTORY().save();
+    });
+
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    LOGINFO("Insert {} entries and remove every 3rd of them, so that nodes are partially filled", num_entries);
+    for (uint32_t i = 0; i < num_entries; ++i) {
+        this->put(i, btree_put_type::INSERT);
+    }
+    for (uint32_t i = 0; i < num_entries; i += 3) {
+        this->remove_one(i);
+    }
+
+    LOGINFO("Trigger checkpoint flush with compression on");
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+    this->dump_to_file(std::string("before.txt"));
+
+    // Nodes written compressed are to be readable even after compression is turned off
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.btree.compress_index_nodes = false;
+        HS_SETTINGS_FACTORY().save();
+    });
+    this->restart_homestore();
+    LOGINFO("Restarted homestore with index recovered");
+
+    this->get_all();
+    this->do_query(0, num_entries - 1, 1000);
+    this->dump_to_file(std::string("after.txt"));
+    this->compare_files("before.txt", "after.txt");
+    LOGINFO("CompressedCpFlush test end");
+}
+
+TYPED_TEST(BtreeTest, LeafDeltaCpFlush) {
+    LOGINFO("LeafDeltaCpFlush test start");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.btree.index_leaf_delta_max_count = 3;
+        HS_SETTINGS_FACTORY().save();
+    });
+
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    LOGINFO("Insert {} entries and flush, so that all leaves are written in full", num_entries);
+    for (uint32_t i = 0; i < num_entries; ++i) {
+        this->put(i, btree_put_type::INSERT);
+    }
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+
+    LOGINFO("Update few entries in place across multiple cps, so that leaves are journaled as deltas");
+    for (uint32_t iter = 0; iter < 5; ++iter) {
+        for (uint32_t i = iter; i < num_entries; i += 50) {
+            this->force_upsert(i);
+        }
+        test_common::HSTestHelper::trigger_cp(true /* wait */);
+    }
+    this->get_all();
+    this->dump_to_file(std::string("before.txt"));
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.btree.index_leaf_delta_max_count = 0;
+        HS_SETTINGS_FACTORY().save();
+    });
+    this->restart_homestore();
+    LOGINFO("Restarted homestore with index recovered");
+
+    this->get_all();
+    this->do_query(0, num_entries - 1, 1000);
+    this->dump_to_file(std::string("after.txt"));
+    this->compare_files("before.txt", "after.txt");
+    LOGINFO("LeafDeltaCpFlush test end");
+}
+
 TYPED_TEST(BtreeTest, MultipleCpFlush) {
     LOGINFO("MultipleCpFlush test start");
 
@@ -417,6 +563,90 @@ TYPED_TEST(BtreeTest, ThreadedCpFlush) {
     LOGINFO("ThreadedCpFlush test end");
 }
 
+template < typename TestType >
+struct BtreeBufferedTest : public BtreeTest< TestType > {};
+
+using BufferedBtreeTypes = testing::Types< FixedLenBufferedBtree >;
+TYPED_TEST_SUITE(BtreeBufferedTest, BufferedBtreeTypes);
+
+TYPED_TEST(BtreeBufferedTest, BlindPutWithReads) {
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    std::vector< uint32_t > vec(num_entries);
+    iota(vec.begin(), vec.end(), 0);
+    std::random_shuffle(vec.begin(), vec.end());
+
+    LOGINFO("Step 1: Blind put {} entries in random order and validate with gets, served partly from buffers",
+            num_entries);
+    for (uint32_t i{0}; i < num_entries; ++i) {
+        this->blind_put(vec[i]);
+    }
+    this->get_all();
+
+    LOGINFO("Step 2: Overwrite half of them and validate with query, which flushes the buffers in its range");
+    for (uint32_t i{0}; i < num_entries / 2; ++i) {
+        this->blind_put(vec[i]);
+    }
+    this->query_all();
+
+    LOGINFO("Step 3: Blind put again and remove every 3rd key, mostly as tombstones in the buffers");
+    for (uint32_t i{num_entries / 2}; i < num_entries; ++i) {
+        this->blind_put(vec[i]);
+    }
+    for (uint32_t k{0}; k < num_entries; k += 3) {
+        this->remove_one(k);
+    }
+    this->get_all();
+    this->query_all_paginate(80);
+
+    LOGINFO("Step 4: Blind put and validate after cp flush and restart, with messages persisted in the buffers");
+    for (uint32_t k{0}; k < num_entries; k += 3) {
+        this->blind_put(k);
+    }
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+    this->restart_homestore();
+    this->get_all();
+    this->query_all();
+}
+
+TYPED_TEST(BtreeBufferedTest, RemovesWithMerge) {
+    const auto num_entries = SISL_OPTIONS["num_entries"].as< uint32_t >();
+    std::vector< uint32_t > vec(num_entries);
+    iota(vec.begin(), vec.end(), 0);
+    std::random_shuffle(vec.begin(), vec.end());
+
+    LOGINFO("Step 1: Blind put {} entries and remove half of them right away, which removes them in the buffers",
+            num_entries);
+    for (uint32_t i{0}; i < num_entries; ++i) {
+        this->blind_put(vec[i]);
+        if (i % 2 == 1) { this->remove_one(vec[i - 1]); }
+    }
+    this->get_all();
+    this->query_all();
+
+    LOGINFO("Step 2: Remove the keys again, which are either tombstones in the buffers or absent in the leaves");
+    for (uint32_t i{0}; i < num_entries; i += 2) {
+        this->remove_one(vec[i]);
+    }
+    this->get_all();
+
+    LOGINFO("Step 3: Range remove most of the keys, which merges the leaves, while level 1 nodes are left unmerged");
+    for (uint32_t k{0}; k < num_entries; k += 100) {
+        this->blind_put(k);
+        this->range_remove_any(k, std::min(k + 94, num_entries - 1));
+    }
+    this->get_all();
+    this->query_all_paginate(80);
+
+    LOGINFO("Step 4: Blind put them back and validate after cp flush and restart");
+    for (uint32_t i{0}; i < num_entries; ++i) {
+        this->blind_put(vec[i]);
+    }
+    test_common::HSTestHelper::trigger_cp(true /* wait */);
+    this->restart_homestore();
+    this->get_all();
+    this->query_all();
+}
+
 template < typename TestType >
 struct BtreeConcurrentTest : public BtreeTestHelper< TestType >, public ::testing::Test {
     using T = TestType;
@@ -432,6 +662,7 @@ struct BtreeConcurrentTest : public BtreeTestHelper< TestType >, public ::testin
             m_test->m_cfg = BtreeConfig(hs()->index_service().node_size());
             m_test->m_cfg.m_leaf_node_type = T::leaf_node_type;
             m_test->m_cfg.m_int_node_type = T::interior_node_type;
+            m_test->m_cfg.m_optimistic_reads = true;
             m_test->m_bt = std::make_shared< typename T::BtreeType >(std::move(sb), m_test->m_cfg);
             return m_test->m_bt;
         }
@@ -469,6 +700,7 @@ struct BtreeConcurrentTest : public BtreeTestHelper< TestType >, public ::testin
 
         // Create index table and attach to index service.
         BtreeTestHelper< TestType >::SetUp();
+        this->m_cfg.m_optimistic_reads = true;
         if (this->m_bt == nullptr || SISL_OPTIONS["init_device"].as< bool >()) {
             this->m_bt = std::make_shared< typename T::BtreeType >(uuid, parent_uuid, 0, this->m_cfg);
         } else {
@@ -512,7 +744,8 @@ private:
 TYPED_TEST_SUITE(BtreeConcurrentTest, BtreeTypes);
 TYPED_TEST(BtreeConcurrentTest, ConcurrentAllOps) {
     // range put is not supported for non-extent keys
-    std::vector< std::string > input_ops = {"put:18", "remove:14", "range_put:20", "range_remove:2", "query:10"};
+    std::vector< std::string > input_ops = {"put:18",   "remove:14", "range_put:20", "range_remove:2",
+                                            "query:10", "get:10"};
     if (SISL_OPTIONS.count("operation_list")) {
         input_ops = SISL_OPTIONS["operation_list"].as< std::vector< std::string > >();
     }
@@ -286,6 +286,232 @@ TEST_F(LogDevTest, WriteSyncThenRead) {
     }
 }
 
+TEST_F(LogDevTest, ForeachAcrossGroups) {
+    LOGINFO("Step 1: Create 2 log stores on same logdev");
+    auto logdev_id = logstore_service().create_new_logdev();
+    s_max_flush_multiple = logstore_service().get_logdev(logdev_id)->get_flush_size_multiple();
+    auto store1 = logstore_service().create_new_log_store(logdev_id, false);
+    auto store2 = logstore_service().create_new_log_store(logdev_id, false);
+
+    LOGINFO("Step 2: Insert batches to both stores alternately, so that groups of both stores are interleaved");
+    logstore_seq_num_t lsn1{0};
+    logstore_seq_num_t lsn2{0};
+    for (uint32_t i{0}; i < 20; ++i) {
+        insert_batch_sync(store1, lsn1, 10);
+        insert_batch_sync(store2, lsn2, 5);
+    }
+
+    LOGINFO("Step 3: Iterate through each store from different start lsns and validate the records");
+    auto const foreach_validate = [this](std::shared_ptr< HomeLogStore > log_store, logstore_seq_num_t start_lsn,
+                                         logstore_seq_num_t tail_lsn) {
+        logstore_seq_num_t expected_lsn{start_lsn};
+        log_store->foreach (start_lsn, [&](logstore_seq_num_t lsn, const log_buffer& b) -> bool {
+            EXPECT_EQ(lsn, expected_lsn);
+            auto const* d = r_cast< test_log_data const* >(b.bytes());
+            EXPECT_EQ(d->total_size(), b.size()) << "Size Mismatch for lsn=" << log_store->get_store_id() << ":" << lsn;
+            validate_data(log_store, d, lsn);
+            ++expected_lsn;
+            return true;
+        });
+        ASSERT_EQ(expected_lsn, tail_lsn + 1) << "Not all records are iterated for store=" << log_store->get_store_id();
+    };
+
+    foreach_validate(store1, 0, lsn1 - 1);
+    foreach_validate(store1, 73, lsn1 - 1);
+    foreach_validate(store2, 0, lsn2 - 1);
+    foreach_validate(store2, 42, lsn2 - 1);
+
+    logstore_service().remove_log_store(logdev_id, store1->get_store_id());
+    logstore_service().remove_log_store(logdev_id, store2->get_store_id());
+}
+
+TEST_F(LogDevTest, PipelinedFlush) {
+    LOGINFO("Step 1: Limit the log groups in flight, so that a single flush has to wait for the groups to complete");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.max_inflight_log_groups = 2; });
+    HS_SETTINGS_FACTORY().save();
+
+    auto logdev_id = logstore_service().create_new_logdev();
+    s_max_flush_multiple = logstore_service().get_logdev(logdev_id)->get_flush_size_multiple();
+    auto log_store = logstore_service().create_new_log_store(logdev_id, false);
+    auto store_id = log_store->get_store_id();
+
+    auto restart = [&]() {
+        std::promise< bool > p;
+        auto starting_cb = [&]() {
+            logstore_service().open_logdev(logdev_id);
+            logstore_service().open_log_store(logdev_id, store_id, false /* append_mode */).thenValue([&](auto store) {
+                log_store = store;
+                p.set_value(true);
+            });
+        };
+        start_homestore(true /* restart */, starting_cb);
+        p.get_future().get();
+    };
+
+    LOGINFO("Step 2: Insert batches large enough to need many more log groups than allowed in flight");
+    logstore_seq_num_t cur_lsn{0};
+    for (uint32_t i{0}; i < 5; ++i) {
+        insert_batch_sync(log_store, cur_lsn, 1000, 64 /* fixed_size */);
+        ASSERT_EQ(log_store->tail_lsn(), cur_lsn - 1) << "Flush returned before all the log groups are completed";
+    }
+
+    LOGINFO("Step 3: Read and verify all entries");
+    read_all_verify(log_store);
+
+    LOGINFO("Step 4: Restart and verify the groups are chained correctly on recovery");
+    restart();
+    ASSERT_EQ(log_store->tail_lsn(), cur_lsn - 1);
+    read_all_verify(log_store);
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.max_inflight_log_groups = 4; });
+    HS_SETTINGS_FACTORY().save();
+}
+
+TEST_F(LogDevTest, TailCacheRead) {
+    LOGINFO("Step 1: Shrink the tail cache, so that only the most recent records are served from memory");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.tail_cache_size = 16 * 1024; });
+    HS_SETTINGS_FACTORY().save();
+
+    auto logdev_id = logstore_service().create_new_logdev();
+    s_max_flush_multiple = logstore_service().get_logdev(logdev_id)->get_flush_size_multiple();
+    auto log_store = logstore_service().create_new_log_store(logdev_id, false);
+    auto store_id = log_store->get_store_id();
+
+    auto restart = [&]() {
+        std::promise< bool > p;
+        auto starting_cb = [&]() {
+            logstore_service().open_logdev(logdev_id);
+            logstore_service().open_log_store(logdev_id, store_id, false /* append_mode */).thenValue([&](auto store) {
+                log_store = store;
+                p.set_value(true);
+            });
+        };
+        start_homestore(true /* restart */, starting_cb);
+        p.get_future().get();
+    };
+    auto const tail_cache_size = [&]() {
+        return s_cast< uint64_t >(logstore_service().get_logdev(logdev_id)->get_status(0)["tail_cache_size"]);
+    };
+
+    LOGINFO("Step 2: Insert 200 entries, which are much more than what the tail cache could hold");
+    logstore_seq_num_t cur_lsn{0};
+    for (uint32_t i{0}; i < 4; ++i) {
+        insert_batch_sync(log_store, cur_lsn, 50);
+    }
+    ASSERT_GT(tail_cache_size(), 0);
+    ASSERT_LE(tail_cache_size(), 16 * 1024);
+
+    LOGINFO("Step 3: Read and verify all entries, older ones from device and the tail from the cache");
+    read_all_verify(log_store);
+
+    LOGINFO("Step 4: Truncate half of the entries and validate the rest are still read correctly");
+    logstore_seq_num_t trunc_lsn{99};
+    truncate_validate(log_store, &trunc_lsn);
+
+    LOGINFO("Step 5: Insert more entries and restart, so that reads are served from device with empty cache");
+    insert_batch_sync(log_store, cur_lsn, 50);
+    restart();
+    ASSERT_EQ(tail_cache_size(), 0);
+    read_all_verify(log_store);
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.tail_cache_size = 67108864; });
+    HS_SETTINGS_FACTORY().save();
+}
+
+TEST_F(LogDevTest, CompressedRecords) {
+    LOGINFO("Step 1: Turn on compression of larger records and turn off tail cache, so that reads hit the device");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.logstore.compress_min_record_size = 256;
+        s.logstore.tail_cache_size = 0;
+    });
+    HS_SETTINGS_FACTORY().save();
+
+    auto logdev_id = logstore_service().create_new_logdev();
+    s_max_flush_multiple = logstore_service().get_logdev(logdev_id)->get_flush_size_multiple();
+    auto log_store = logstore_service().create_new_log_store(logdev_id, false);
+    auto store_id = log_store->get_store_id();
+
+    auto restart = [&]() {
+        std::promise< bool > p;
+        auto starting_cb = [&]() {
+            logstore_service().open_logdev(logdev_id);
+            logstore_service().open_log_store(logdev_id, store_id, false /* append_mode */).thenValue([&](auto store) {
+                log_store = store;
+                p.set_value(true);
+            });
+        };
+        start_homestore(true /* restart */, starting_cb);
+        p.get_future().get();
+    };
+
+    LOGINFO("Step 2: Insert entries of random sizes, so that a group has both compressed and uncompressed records");
+    logstore_seq_num_t cur_lsn{0};
+    for (uint32_t i{0}; i < 4; ++i) {
+        insert_batch_sync(log_store, cur_lsn, 50);
+    }
+    read_all_verify(log_store);
+
+    LOGINFO("Step 3: Turn off compression and insert more, records written compressed are still to be readable");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.compress_min_record_size = 0; });
+    HS_SETTINGS_FACTORY().save();
+    insert_batch_sync(log_store, cur_lsn, 50);
+    read_all_verify(log_store);
+
+    LOGINFO("Step 4: Restart and validate the records are decompressed during recovery as well");
+    restart();
+    read_all_verify(log_store);
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.tail_cache_size = 67108864; });
+    HS_SETTINGS_FACTORY().save();
+}
+
+TEST_F(LogDevTest, ParallelRecovery) {
+    LOGINFO("Step 1: Create multiple logdevs with a logstore each and insert entries to all of them");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.recovery_max_parallel_logdevs = 3; });
+    HS_SETTINGS_FACTORY().save();
+
+    static constexpr uint32_t num_logdevs{8};
+    std::vector< logdev_id_t > logdev_ids;
+    std::vector< logstore_id_t > store_ids;
+    std::vector< std::shared_ptr< HomeLogStore > > log_stores;
+    std::vector< logstore_seq_num_t > lsns(num_logdevs, 0);
+    for (uint32_t i{0}; i < num_logdevs; ++i) {
+        logdev_ids.push_back(logstore_service().create_new_logdev());
+        s_max_flush_multiple = logstore_service().get_logdev(logdev_ids[i])->get_flush_size_multiple();
+        log_stores.push_back(logstore_service().create_new_log_store(logdev_ids[i], false));
+        store_ids.push_back(log_stores[i]->get_store_id());
+        for (uint32_t b{0}; b < 5; ++b) {
+            insert_batch_sync(log_stores[i], lsns[i], 10 * (i + 1));
+        }
+    }
+
+    LOGINFO("Step 2: Restart, so that logdevs are loaded in parallel and validate all the entries");
+    std::vector< std::promise< bool > > promises(num_logdevs);
+    auto starting_cb = [&]() {
+        for (uint32_t i{0}; i < num_logdevs; ++i) {
+            logstore_service().open_logdev(logdev_ids[i]);
+            logstore_service()
+                .open_log_store(logdev_ids[i], store_ids[i], false /* append_mode */)
+                .thenValue([&, i](auto store) {
+                    log_stores[i] = store;
+                    promises[i].set_value(true);
+                });
+        }
+    };
+    start_homestore(true /* restart */, starting_cb);
+    for (auto& p : promises) {
+        p.get_future().get();
+    }
+
+    for (uint32_t i{0}; i < num_logdevs; ++i) {
+        ASSERT_EQ(log_stores[i]->tail_lsn(), lsns[i] - 1) << "Tail mismatch on log_dev=" << logdev_ids[i];
+        read_all_verify(log_stores[i]);
+    }
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.logstore.recovery_max_parallel_logdevs = 8; });
+    HS_SETTINGS_FACTORY().save();
+}
+
 TEST_F(LogDevTest, Rollback) {
     LOGINFO("Step 1: Create a single logstore to start rollback test");
     auto logdev_id = logstore_service().create_new_logdev();
@@ -22,15 +22,18 @@
 #include <memory>
 #include <mutex>
 #include <random>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <iomgr/io_environment.hpp>
 #include <sisl/logging/logging.h>
 #include <sisl/options/options.h>
 
+#include "common/homestore_config.hpp"
 #include "device/chunk.h"
 
 #include "device/device.h"
+#include "device/io_scheduler.hpp"
 #include "device/physical_dev.hpp"
 
 using namespace homestore;
@@ -262,6 +265,91 @@ TEST_F(PDevTest, RandomChunkOpsWithRestart) {
             num_removed, available_size);
 }
 
+TEST_F(PDevTest, IOSchedulerPriority) {
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.device.io_sched_queue_depth = 4;
+        s.device.io_sched_bg_depth_pct = 50;
+        s.device.io_sched_max_wait_us = 60 * 1000 * 1000;
+    });
+    HS_SETTINGS_FACTORY().save();
+
+    // IOs are simulated with promises which the test completes, to control the order of completions
+    IOScheduler sched{m_first_data_pdev->metrics()};
+    std::vector< folly::Promise< std::error_code > > ios(16);
+    std::vector< uint32_t > dispatched;
+    auto submit = [&](uint32_t id, io_priority_t priority) {
+        return sched.submit(
+            [&, id](bool) {
+                dispatched.push_back(id);
+                return ios[id].getFuture();
+            },
+            false /* part_of_batch */, priority);
+    };
+    std::vector< folly::Future< std::error_code > > futs;
+
+    LOGINFO("Step 1: CP flush IOs beyond their share of the queue depth are queued");
+    for (uint32_t id{0}; id < 4; ++id) {
+        futs.push_back(submit(id, io_priority_t::CP_FLUSH));
+    }
+    ASSERT_EQ(dispatched, (std::vector< uint32_t >{0, 1})) << "Only 50% of depth should be given to cp flush IOs";
+    ASSERT_EQ(sched.queued_ios(io_priority_t::CP_FLUSH), 2);
+
+    LOGINFO("Step 2: Foreground IOs go ahead of queued cp flush IOs");
+    futs.push_back(submit(4, io_priority_t::FOREGROUND));
+    futs.push_back(submit(5, io_priority_t::FOREGROUND));
+    ASSERT_EQ(dispatched, (std::vector< uint32_t >{0, 1, 4, 5})) << "Foreground IOs should use the rest of the depth";
+
+    LOGINFO("Step 3: On completion, queued IOs are dispatched highest class first");
+    futs.push_back(submit(6, io_priority_t::BACKGROUND));
+    futs.push_back(submit(7, io_priority_t::JOURNAL));
+    futs.push_back(submit(8, io_priority_t::FOREGROUND));
+    ASSERT_EQ(sched.outstanding_ios(), 9);
+
+    ios[4].setValue(std::error_code{});
+    ASSERT_EQ(dispatched.back(), 8) << "Foreground IO should be dispatched first";
+    ios[5].setValue(std::error_code{});
+    ASSERT_EQ(dispatched.back(), 7) << "Journal IO should be dispatched next";
+    ios[8].setValue(std::error_code{});
+    ASSERT_EQ(dispatched.size(), 6) << "Cp flush IO should not be dispatched beyond its share of depth";
+    ios[0].setValue(std::error_code{});
+    ASSERT_EQ(dispatched.back(), 2) << "Oldest cp flush IO should be dispatched on cp flush completion";
+
+    LOGINFO("Step 4: Complete all of them and validate every IO is completed");
+    for (uint32_t id{0}; id < 9; ++id) {
+        if (!ios[id].isFulfilled()) { ios[id].setValue(std::error_code{}); }
+    }
+    ASSERT_EQ(dispatched.size(), 9) << "Every IO should be dispatched";
+    for (auto& f : futs) {
+        ASSERT_EQ(f.isReady(), true) << "IO not completed";
+        ASSERT_EQ(f.value(), std::error_code{});
+    }
+    ASSERT_EQ(sched.outstanding_ios(), 0);
+
+    LOGINFO("Step 5: IO waiting beyond max wait time goes ahead of higher classes");
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) { s.device.io_sched_max_wait_us = 0; });
+    HS_SETTINGS_FACTORY().save();
+    dispatched.clear();
+    futs.clear();
+    for (uint32_t id{9}; id < 13; ++id) {
+        futs.push_back(submit(id, io_priority_t::JOURNAL));
+    }
+    futs.push_back(submit(13, io_priority_t::BACKGROUND));
+    futs.push_back(submit(14, io_priority_t::FOREGROUND));
+    ios[9].setValue(std::error_code{});
+    ASSERT_EQ(dispatched.back(), 13) << "Background IO which was queued earlier should be dispatched first";
+    for (uint32_t id{10}; id < 15; ++id) {
+        if (!ios[id].isFulfilled()) { ios[id].setValue(std::error_code{}); }
+    }
+    ASSERT_EQ(sched.outstanding_ios(), 0);
+
+    HS_SETTINGS_FACTORY().modifiable_settings([](auto& s) {
+        s.device.io_sched_queue_depth = 128;
+        s.device.io_sched_bg_depth_pct = 25;
+        s.device.io_sched_max_wait_us = 20000;
+    });
+    HS_SETTINGS_FACTORY().save();
+}
+
 int main(int argc, char* argv[]) {
     SISL_OPTIONS_LOAD(argc, argv, logging, test_pdev, iomgr);
     ::testing::InitGoogleTest(&argc, argv);